@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	/*!
+	@brief The instruction set extensions of the CPU the kernels can use.
+	@details On x86, they are detected with CPUID (and XGETBV to check that the
+			 OS saves the wide registers). On other architectures, no extension
+			 is reported and the kernels fall back to portable C++.
+	*/
+	struct CPUFeatures
+	{
+		/*!
+		@brief Whether SSE2 is supported (always true on x86-64).
+		*/
+		bool sse2 = false;
+
+		/*!
+		@brief Whether AVX2 is supported and enabled by the OS.
+		*/
+		bool avx2 = false;
+
+		/*!
+		@brief Whether FMA3 is supported and enabled by the OS.
+		*/
+		bool fma = false;
+
+		/*!
+		@brief Whether AVX-512 Foundation is supported and enabled by the OS.
+		*/
+		bool avx512f = false;
+
+		/*!
+		@brief The brand string of the CPU, or "Unknown CPU".
+		*/
+		char brand[49] = {0};
+
+		/*!
+		@brief Returns the features of the CPU the process runs on.
+		@details They are detected once, on the first call.
+		*/
+		PROFILE_API static const CPUFeatures& Get();
+	};
+
+	/*!
+	@brief The instruction sets the memory kernels can be run with.
+	@details KernelISA_Scalar uses 8 bytes loads and stores of the general purpose
+			 registers on every architecture.
+	@see Profile::Kernels
+	*/
+	enum KernelISA : u8
+	{
+		KernelISA_Scalar = 0,
+		KernelISA_SSE2,
+		KernelISA_AVX2,
+		KernelISA_AVX512,
+		KernelISA_Count,
+
+		/*!
+		@brief Selects the widest instruction set supported at runtime.
+		*/
+		KernelISA_Best = 0xFF
+	};
+
+	/*!
+	@brief A set of small kernels stressing the memory subsystem or the floating
+			point units, used to measure the peaks of the machine.
+	@details Every kernel uses the widest SIMD instructions available at runtime
+			 (see Profile::CPUFeatures) unless stated otherwise. The memory kernels
+			 can be given an explicit Profile::KernelISA instead; an instruction set
+			 the CPU does not support falls back to the widest supported one. The
+			 buffers given to the memory kernels must be aligned on 64 bytes and
+			 their size must be a multiple of 256 bytes.
+	@see Profile::MachinePeaks, Profile::SequentialMemoryTest
+	*/
+	struct Kernels
+	{
+		/*!
+		@brief Returns the widest instruction set supported at runtime.
+		*/
+		PROFILE_API static KernelISA GetBestISA();
+
+		/*!
+		@brief Returns a printable name of an instruction set ("Scalar", "SSE2", "AVX2", "AVX-512").
+		*/
+		PROFILE_API static const char* GetISAName(KernelISA _isa);
+
+		/*!
+		@brief Whether the kernels can run with an instruction set on this CPU.
+		*/
+		PROFILE_API static bool IsSupported(KernelISA _isa);
+
+		/*!
+		@brief Reads a buffer.
+		@param _data The buffer to read.
+		@param _byteCount The size of the buffer in bytes.
+		@param _isa The instruction set of the loads.
+		@return A checksum of the buffer, so that the reads cannot be optimized away.
+		*/
+		PROFILE_API static u64 Read(const void* _data, u64 _byteCount, KernelISA _isa = KernelISA_Best);
+
+		/*!
+		@brief Writes a value in a buffer.
+		@param _data The buffer to write.
+		@param _byteCount The size of the buffer in bytes.
+		@param _value The value written in every 8 bytes word of the buffer.
+		@param _isa The instruction set of the stores.
+		*/
+		PROFILE_API static void Write(void* _data, u64 _byteCount, u64 _value, KernelISA _isa = KernelISA_Best);
+
+		/*!
+		@brief Writes a value in a buffer with non-temporal (streaming) stores.
+		@details The stores bypass the caches and do not read the destination
+				 lines first, so the bandwidth can exceed the one of ::Write on
+				 buffers larger than the last level cache. On other architectures
+				 than x86, it falls back to regular stores.
+		@param _data The buffer to write.
+		@param _byteCount The size of the buffer in bytes.
+		@param _value The value written in every 8 bytes word of the buffer.
+		@param _isa The instruction set of the stores.
+		*/
+		PROFILE_API static void WriteNonTemporal(void* _data, u64 _byteCount, u64 _value, KernelISA _isa = KernelISA_Best);
+
+		/*!
+		@brief Copies a buffer into another one.
+		@param _destination The buffer to write.
+		@param _source The buffer to read.
+		@param _byteCount The size of the buffers in bytes.
+		@param _isa The instruction set of the loads and stores.
+		*/
+		PROFILE_API static void Copy(void* _destination, const void* _source, u64 _byteCount, KernelISA _isa = KernelISA_Best);
+
+		/*!
+		@brief Links the slots of a buffer in a single cycle of pointers for ::PointerChase.
+		@details The buffer is split in slots of @p _stride bytes and the first
+				 bytes of every slot receive the address of the next slot to visit.
+		@param _buffer The buffer to link. It must be aligned on 8 bytes.
+		@param _byteCount The size of the buffer in bytes (the working set of the chase).
+		@param _stride The size of a slot in bytes. At least 8 bytes.
+		@param _seed 0 to visit the slots in order (a strided access pattern the
+				hardware prefetchers can follow), or the seed of a random order
+				defeating them.
+		@return The address to start the chase from.
+		*/
+		PROFILE_API static const void* BuildPointerChain(void* _buffer, u64 _byteCount, u64 _stride, u64 _seed);
+
+		/*!
+		@brief Follows a chain of pointers built by ::BuildPointerChain.
+		@details Every load depends on the previous one, so the time of a step
+				 is the latency of the memory level the working set fits in.
+		@param _start The address to start from.
+		@param _stepCount The number of pointers to follow.
+		@return The address reached, so that the loads cannot be optimized away.
+		*/
+		PROFILE_API static const void* PointerChase(const void* _start, u64 _stepCount);
+
+		/*!
+		@brief Runs a chain of scalar double precision multiply-adds.
+		@details It uses several independent accumulators to hide the latency of
+				 the floating point units, and scalar instructions only.
+		@param _iterationCount The number of iterations.
+		@return The result of the computation (to prevent the compiler from
+				optimizing it away). It executes ::ScalarFlopsPerIteration
+				floating point operations per iteration.
+		*/
+		PROFILE_API static f64 ScalarFlops(u64 _iterationCount);
+
+		/*!
+		@brief The number of floating point operations of one iteration of ::ScalarFlops.
+		*/
+		PROFILE_API static u64 ScalarFlopsPerIteration();
+
+		/*!
+		@brief Runs a chain of SIMD double precision multiply-adds.
+		@details It uses several independent accumulators to hide the latency of
+				 the floating point units, and fused multiply-adds when available.
+		@param _iterationCount The number of iterations.
+		@return The result of the computation (to prevent the compiler from
+				optimizing it away). It executes ::SIMDFlopsPerIteration
+				floating point operations per iteration.
+		*/
+		PROFILE_API static f64 SIMDFlops(u64 _iterationCount);
+
+		/*!
+		@brief The number of floating point operations of one iteration of ::SIMDFlops.
+		@details It depends on the instruction set selected at runtime.
+		*/
+		PROFILE_API static u64 SIMDFlopsPerIteration();
+	};
+}
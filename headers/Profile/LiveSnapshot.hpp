@@ -0,0 +1,336 @@
+#pragma once
+
+#include <atomic> // for the sequence number of the seqlock
+#include <vector> // for the copy of the snapshot in the reader
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	struct Profiler;
+	struct ProfileTrack;
+
+	/*!
+	@brief The header of the shared memory segment written by a
+			Profile::LiveSnapshotPublisher.
+	@details The segment is laid out as the header followed by ::trackCount
+			 tracks, each made of a Profile::LiveTrackSnapshot followed by
+			 ::blockCapacity Profile::LiveBlockSnapshot (see ::GetTrackOffset).
+			 The layout only depends on the values stored in the header, so a
+			 reader does not need to be built with the same NB_TRACKS and
+			 NB_TIMINGS as the instrumented process. Since the size of the
+			 segment is fixed when it is created, only the NB_TRACKS static
+			 tracks are published, not the ones registered at runtime (see
+			 Profile::Profiler::RegisterTrack).
+	*/
+	struct LiveSnapshotHeader
+	{
+		/*!
+		@brief The value of ::magic in a valid segment ("PROFSNAP").
+		*/
+		static constexpr u64 magicValue = 0x50414E53464F5250ull;
+
+		/*!
+		@brief The version of the layout, incremented on every incompatible change.
+		*/
+		static constexpr u32 layoutVersion = 1;
+
+		u64 magic = magicValue;
+		u32 version = layoutVersion;
+
+		/*!
+		@brief The number of tracks in the segment.
+		*/
+		u32 trackCount = 0;
+
+		/*!
+		@brief The maximal number of blocks per track in the segment.
+		*/
+		u32 blockCapacity = 0;
+
+		u32 reserved = 0;
+
+		/*!
+		@brief The sequence number of the seqlock. It is odd while the publisher
+				writes the segment and incremented twice per publication.
+		*/
+		std::atomic<u64> sequence = 0;
+
+		/*!
+		@brief The number of publications since the segment was opened.
+		*/
+		u64 publishCount = 0;
+
+		/*!
+		@brief The estimated frequency of the CPU timer of the publisher, to
+				convert the elapsed times in seconds.
+		*/
+		u64 cpuFreq = 0;
+
+		/*!
+		@brief The time of the publication on the CPU timer of the publisher.
+		*/
+		u64 publishTime = 0;
+
+		/*!
+		@brief The time elapsed between the initialization of the profiler and
+				the publication.
+		*/
+		u64 elapsed = 0;
+
+		/*!
+		@brief The name of the profiler.
+		*/
+		char profilerName[64] = {0};
+
+		/*!
+		@brief Returns the size in bytes of a segment.
+		*/
+		static constexpr u64 GetByteCount(u32 _trackCount, u32 _blockCapacity) noexcept;
+
+		/*!
+		@brief Returns the offset in bytes of a track from the start of the segment.
+		*/
+		static constexpr u64 GetTrackOffset(u32 _trackIdx, u32 _blockCapacity) noexcept;
+	};
+
+	static_assert(std::atomic<u64>::is_always_lock_free, "The seqlock of the live snapshot must be lock-free to be shared between processes.");
+
+	/*!
+	@brief The state of a track in a live snapshot.
+	*/
+	struct LiveTrackSnapshot
+	{
+		/*!
+		@brief The name of the track.
+		*/
+		char name[64] = {0};
+
+		/*!
+		@brief The accumulated time from all blocks of the track.
+		@details Mirrors ProfileTrack::elapsed.
+		*/
+		u64 elapsed = 0;
+
+		/*!
+		@brief The number of blocks that follow the track in the segment.
+		*/
+		u32 blockCount = 0;
+
+		u32 reserved = 0;
+	};
+
+	/*!
+	@brief The state of a block in a live snapshot.
+	@details The blocks are packed: only the blocks hit at least once are published.
+	*/
+	struct LiveBlockSnapshot
+	{
+		/*!
+		@brief The name of the block, truncated to 63 characters.
+		*/
+		char name[64] = {0};
+
+		/*!
+		@brief The index of the block in ProfileTrack::timings. It identifies
+				the block between two publications.
+		*/
+		u32 recorderIdx = 0;
+
+		u32 reserved = 0;
+
+		u64 hitCount = 0;
+		u64 elapsed = 0;
+		u64 processedByteCount = 0;
+		u64 flopCount = 0;
+		u64 allocationCount = 0;
+		u64 allocatedByteCount = 0;
+		u64 pageFaultCount = 0;
+	};
+
+	constexpr u64 LiveSnapshotHeader::GetByteCount(u32 _trackCount, u32 _blockCapacity) noexcept
+	{
+		return GetTrackOffset(_trackCount, _blockCapacity);
+	}
+
+	constexpr u64 LiveSnapshotHeader::GetTrackOffset(u32 _trackIdx, u32 _blockCapacity) noexcept
+	{
+		return sizeof(LiveSnapshotHeader) + (u64)_trackIdx * (sizeof(LiveTrackSnapshot) + (u64)_blockCapacity * sizeof(LiveBlockSnapshot));
+	}
+
+	/*!
+	@brief Publishes the tables of a profiler in a named shared memory segment
+			so that other processes can monitor it while it runs.
+	@details The publication only copies memory: there is no system call nor
+			 I/O after ::Open. The segment is updated in place under a seqlock,
+			 so readers (see Profile::LiveSnapshotReader) never block the publisher
+			 and retry when they raced with a publication.
+			 ::Publish copies every track with ProfileTrack::CaptureConsistent,
+			 so it can be called from any thread (e.g., at the end of every
+			 iteration of a service loop, or periodically from a thread of its
+			 own), but only from one thread at a time.
+			 On POSIX systems, the segment is created with shm_open (the name
+			 must start with a '/'), on Windows with a named file mapping.
+	*/
+	struct LiveSnapshotPublisher
+	{
+		/*!
+		@brief The default name of the segment.
+		*/
+		static constexpr const char* defaultSegmentName = "/CppProfiler";
+
+		/*!
+		@brief The name of the open segment.
+		*/
+		char segmentName[64] = {0};
+
+		/*!
+		@brief The mapping of the segment, or nullptr when it is not open.
+		*/
+		u8* ptr_mapping = nullptr;
+
+		/*!
+		@brief The size in bytes of ::ptr_mapping.
+		*/
+		u64 mappingByteCount = 0;
+
+		/*!
+		@brief The handle of the file mapping on Windows.
+		*/
+		void* ptr_osHandle = nullptr;
+
+		/*!
+		@brief The consistent copy of the track being published.
+		@details Allocated by ::Open so that ::Publish does not allocate.
+		*/
+		ProfileTrack* ptr_trackCopy = nullptr;
+
+		LiveSnapshotPublisher() = default;
+		LiveSnapshotPublisher(const LiveSnapshotPublisher&) = delete;
+		LiveSnapshotPublisher& operator=(const LiveSnapshotPublisher&) = delete;
+
+		/*!
+		@brief Closes the segment if it is open.
+		*/
+		PROFILE_API ~LiveSnapshotPublisher();
+
+		/*!
+		@brief Creates (or recreates) the segment sized for NB_TRACKS tracks of
+				NB_TIMINGS blocks.
+		@param _segmentName The name of the segment.
+		@return Whether the segment could be created and mapped.
+		*/
+		PROFILE_API bool Open(const char* _segmentName = defaultSegmentName) noexcept;
+
+		/*!
+		@brief Unmaps and removes the segment.
+		@details Readers still attached keep their mapping until they detach.
+		*/
+		PROFILE_API void Close() noexcept;
+
+		/*!
+		@brief Whether the segment is open.
+		*/
+		inline bool IsOpen() const noexcept
+		{
+			return ptr_mapping != nullptr;
+		}
+
+		/*!
+		@brief Copies the current tables of a profiler in the segment.
+		@details Does nothing if the segment is not open. The blocks still open
+				 are published with their time up to the publication.
+				 A track that could not be copied consistently (its owning
+				 thread kept updating it) keeps the tables it was last
+				 published with.
+		@param _profiler The profiler to publish.
+		@return Whether the segment is open and every track was published.
+		*/
+		PROFILE_API bool Publish(const Profiler& _profiler) noexcept;
+	};
+
+	/*!
+	@brief Attaches to a segment written by a Profile::LiveSnapshotPublisher
+			and takes consistent copies of it.
+	*/
+	struct LiveSnapshotReader
+	{
+		/*!
+		@brief The read-only mapping of the segment, or nullptr when detached.
+		*/
+		const u8* ptr_mapping = nullptr;
+
+		/*!
+		@brief The size in bytes of ::ptr_mapping.
+		*/
+		u64 mappingByteCount = 0;
+
+		/*!
+		@brief The handle of the file mapping on Windows.
+		*/
+		void* ptr_osHandle = nullptr;
+
+		/*!
+		@brief The last consistent copy of the segment taken by ::Read.
+		*/
+		std::vector<u8> snapshot;
+
+		LiveSnapshotReader() = default;
+		LiveSnapshotReader(const LiveSnapshotReader&) = delete;
+		LiveSnapshotReader& operator=(const LiveSnapshotReader&) = delete;
+
+		/*!
+		@brief Detaches from the segment if attached.
+		*/
+		PROFILE_API ~LiveSnapshotReader();
+
+		/*!
+		@brief Maps a segment in read-only mode.
+		@param _segmentName The name given to LiveSnapshotPublisher::Open.
+		@return Whether the segment exists and has a valid header.
+		*/
+		PROFILE_API bool Attach(const char* _segmentName = LiveSnapshotPublisher::defaultSegmentName) noexcept;
+
+		/*!
+		@brief Unmaps the segment.
+		*/
+		PROFILE_API void Detach() noexcept;
+
+		/*!
+		@brief Copies the segment into ::snapshot.
+		@details Retries while the copy overlaps a publication.
+		@param _maxRetryCount The maximal number of attempts.
+		@return Whether a consistent copy was taken. ::snapshot is left
+				unchanged otherwise.
+		*/
+		PROFILE_API bool Read(u32 _maxRetryCount = 1000);
+
+		/*!
+		@brief Returns the header of the last copy, or nullptr if none was taken.
+		*/
+		inline const LiveSnapshotHeader* GetHeader() const noexcept
+		{
+			return snapshot.empty() ? nullptr : (const LiveSnapshotHeader*)snapshot.data();
+		}
+
+		/*!
+		@brief Returns a track of the last copy.
+		@param _trackIdx The index of the track, less than LiveSnapshotHeader::trackCount.
+		*/
+		inline const LiveTrackSnapshot* GetTrack(u32 _trackIdx) const noexcept
+		{
+			return (const LiveTrackSnapshot*)(snapshot.data() + LiveSnapshotHeader::GetTrackOffset(_trackIdx, GetHeader()->blockCapacity));
+		}
+
+		/*!
+		@brief Returns a block of a track of the last copy.
+		@param _trackIdx The index of the track.
+		@param _blockIdx The index of the block, less than LiveTrackSnapshot::blockCount.
+		*/
+		inline const LiveBlockSnapshot* GetBlock(u32 _trackIdx, u32 _blockIdx) const noexcept
+		{
+			return (const LiveBlockSnapshot*)(GetTrack(_trackIdx) + 1) + _blockIdx;
+		}
+	};
+}
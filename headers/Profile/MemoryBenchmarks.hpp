@@ -0,0 +1,177 @@
+#pragma once
+
+#include "Kernels.hpp"
+#include "Profiler.hpp" // for Profile::RepetitionTest
+
+namespace Profile
+{
+	/*!
+	@brief The operations of a Profile::SequentialMemoryTest.
+	*/
+	enum MemoryOperation : u8
+	{
+		MemoryOperation_Read = 0,
+		MemoryOperation_Write,
+		MemoryOperation_Copy,
+		MemoryOperation_WriteNonTemporal,
+		MemoryOperation_Count
+	};
+
+	/*!
+	@brief A ready-made repetition test streaming through a buffer with one of
+			the memory kernels (see Profile::Kernels).
+	@details The test owns its buffers: they are allocated aligned on 64 bytes
+			 and touched in the constructor, so that the page faults are not part
+			 of the repetitions. The kernel is profiled as a block of track 0 with
+			 PROFILE_FUNCTION_TIME_BANDWIDTH, the bandwidth of a copy counting both
+			 the bytes read and the bytes written.
+			 Keep in mind the memory held by the tests when many of them are pushed
+			 at once in a Profile::RepetitionProfiler.
+	*/
+	struct SequentialMemoryTest : public RepetitionTest
+	{
+		/*!
+		@brief The operation the test runs.
+		*/
+		MemoryOperation operation = MemoryOperation_Read;
+
+		/*!
+		@brief The instruction set of the kernel.
+		@details Resolved at construction: an instruction set the CPU does not
+				 support is replaced by the widest supported one.
+		*/
+		KernelISA isa = KernelISA_Best;
+
+		/*!
+		@brief The size of the buffers in bytes.
+		*/
+		u64 byteCount = 0;
+
+		/*!
+		@brief The buffer read by the test (only allocated for reads and copies).
+		*/
+		u8* ptr_source = nullptr;
+
+		/*!
+		@brief The buffer written by the test (only allocated for writes and copies).
+		*/
+		u8* ptr_destination = nullptr;
+
+		/*!
+		@brief The accumulated checksums of the reads, so that they cannot be
+				optimized away.
+		*/
+		u64 checksum = 0;
+
+		/*!
+		@brief The name of the test, e.g. "Read AVX2 256MB".
+		*/
+		char label[64] = {0};
+
+		/*!
+		@brief Allocates the buffers of the test.
+		@param _operation The operation to run.
+		@param _isa The instruction set of the kernel.
+		@param _byteCount The size of the buffers in bytes. It is rounded down
+				to a multiple of 256 bytes.
+		*/
+		PROFILE_API SequentialMemoryTest(MemoryOperation _operation, KernelISA _isa, u64 _byteCount);
+		SequentialMemoryTest(const SequentialMemoryTest&) = delete;
+		SequentialMemoryTest& operator=(const SequentialMemoryTest&) = delete;
+		PROFILE_API ~SequentialMemoryTest();
+
+		/*!
+		@brief Returns a printable name of an operation.
+		*/
+		PROFILE_API static const char* GetOperationName(MemoryOperation _operation);
+
+		/*!
+		@brief Runs the kernel once over the whole buffers.
+		*/
+		PROFILE_API void operator()() override;
+	};
+
+	/*!
+	@brief A ready-made repetition test measuring the latency of the memory level
+			a working set fits in by chasing pointers through it.
+	@details The chain of pointers is built in the constructor with
+			 Profile::Kernels::BuildPointerChain. Every repetition follows
+			 ::stepCount pointers in a block of track 0 profiled with
+			 PROFILE_FUNCTION_TIME_BANDWIDTH; the bytes of the block are the 8 bytes
+			 of every pointer loaded, so the latency of a load is
+			 8 / bandwidth (see ::GetLatencyInNs).
+	*/
+	struct PointerChaseTest : public RepetitionTest
+	{
+		/*!
+		@brief The default number of pointers followed per repetition.
+		*/
+		static constexpr u64 defaultStepCount = 1 << 20;
+
+		/*!
+		@brief The size in bytes of the working set.
+		*/
+		u64 workingSetByteCount = 0;
+
+		/*!
+		@brief The distance in bytes between two consecutive slots of the chain.
+		*/
+		u64 stride = 0;
+
+		/*!
+		@brief The number of pointers followed per repetition.
+		*/
+		u64 stepCount = 0;
+
+		/*!
+		@brief Whether the slots are visited in a random order rather than in order.
+		*/
+		bool randomOrder = false;
+
+		/*!
+		@brief The working set.
+		*/
+		u8* ptr_buffer = nullptr;
+
+		/*!
+		@brief The address the next repetition starts from.
+		@details Every repetition continues where the previous one stopped.
+		*/
+		const void* ptr_current = nullptr;
+
+		/*!
+		@brief The name of the test, e.g. "Random chase 32KB (64B stride)".
+		*/
+		char label[64] = {0};
+
+		/*!
+		@brief Allocates the working set and links its slots.
+		@param _workingSetByteCount The size in bytes of the working set.
+		@param _stride The distance in bytes between two slots. 64 bytes (a cache
+				line) measures the latency of a load missing the previous level;
+				4096 bytes (a page) also stresses the TLB.
+		@param _randomOrder Whether the slots are visited in a random order,
+				defeating the hardware prefetchers.
+		@param _stepCount The number of pointers followed per repetition.
+		*/
+		PROFILE_API PointerChaseTest(u64 _workingSetByteCount, u64 _stride, bool _randomOrder, u64 _stepCount = defaultStepCount);
+		PointerChaseTest(const PointerChaseTest&) = delete;
+		PointerChaseTest& operator=(const PointerChaseTest&) = delete;
+		PROFILE_API ~PointerChaseTest();
+
+		/*!
+		@brief Converts the elapsed time of one repetition in the latency of one load.
+		@param _elapsedSec The time of one repetition in seconds (e.g., from
+				RepetitionProfiler::minResults).
+		*/
+		inline f64 GetLatencyInNs(f64 _elapsedSec) const noexcept
+		{
+			return stepCount ? 1e9 * _elapsedSec / (f64)stepCount : 0.0;
+		}
+
+		/*!
+		@brief Follows ::stepCount pointers of the chain.
+		*/
+		PROFILE_API void operator()() override;
+	};
+}
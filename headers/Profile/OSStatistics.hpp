@@ -15,11 +15,169 @@
 #include <unistd.h> //for getpagesize
 #endif
 
+#if __linux__
+#include <pthread.h> //for pthread_setaffinity_np
+#include <sched.h> //for cpu_set_t
+#endif
+
+#if __APPLE__
+#include <mach/mach.h> //for task_info
+#endif
+
 #include "Export.hpp"
 #include "Types.hpp"
 
 namespace Profile
 {
+	/*!
+	@brief The flags to select the OS metrics captured by Profile::Surveyor::CaptureOSMetrics.
+	@details Combine them in a mask. Only the metrics of the mask are queried, so
+			 the ones that are not enabled cost nothing.
+	*/
+	enum OSMetric : u32
+	{
+		/*!
+		@brief No metric.
+		*/
+		OSMetric_None = 0,
+
+		/*!
+		@brief The minor and major page faults.
+		*/
+		OSMetric_PageFaults = 1 << 0,
+
+		/*!
+		@brief The voluntary and involuntary context switches.
+		*/
+		OSMetric_ContextSwitches = 1 << 1,
+
+		/*!
+		@brief The user and system CPU time.
+		*/
+		OSMetric_CPUTime = 1 << 2,
+
+		/*!
+		@brief The current and peak resident set size.
+		@remarks On Linux, reading the current resident set size costs a read of
+				 /proc/self/statm, so it is noticeably more expensive than the others.
+		*/
+		OSMetric_ResidentSetSize = 1 << 3,
+
+		/*!
+		@brief The CPU time of the calling thread with a nanosecond resolution.
+		@details Compared to the wall time of a block, it tells how long the block
+				 was off-CPU (blocked in a syscall, waiting on a lock, preempted...).
+				 It uses clock_gettime with CLOCK_THREAD_CPUTIME_ID, which does not
+				 enter the kernel on recent Linux kernels (vDSO), or GetThreadTimes on Windows.
+		*/
+		OSMetric_ThreadCPUTime = 1 << 4,
+
+		/*!
+		@brief All the metrics.
+		*/
+		OSMetric_All = OSMetric_PageFaults | OSMetric_ContextSwitches | OSMetric_CPUTime | OSMetric_ResidentSetSize | OSMetric_ThreadCPUTime
+	};
+
+	/*!
+	@brief A snapshot of the OS metrics of the process or of the calling thread.
+	@details Depending on its use, it holds either the values at a given time
+			 (see Profile::Surveyor::CaptureOSMetrics) or the values accumulated over
+			 the executions of a block (see ::Accumulate). The counters and times are
+			 then the sums of the increments, while the resident set sizes are the
+			 highest values seen when the block closed.
+	*/
+	struct OSMetricsSnapshot
+	{
+		/*!
+		@brief The metrics captured in this snapshot (a combination of Profile::OSMetric).
+		*/
+		u32 mask = OSMetric_None;
+
+		/*!
+		@brief The number of page faults serviced without any I/O activity.
+		*/
+		u64 minorPageFaultCount = 0;
+
+		/*!
+		@brief The number of page faults that required I/O activity.
+		*/
+		u64 majorPageFaultCount = 0;
+
+		/*!
+		@brief The number of context switches because the thread waited for a
+				resource (I/O, lock, sleep...).
+		*/
+		u64 voluntaryContextSwitchCount = 0;
+
+		/*!
+		@brief The number of context switches because the thread was preempted
+				(time slice expired or a higher priority thread became runnable).
+		*/
+		u64 involuntaryContextSwitchCount = 0;
+
+		/*!
+		@brief The CPU time spent in user mode in microseconds.
+		*/
+		u64 userTimeInUs = 0;
+
+		/*!
+		@brief The CPU time spent in kernel mode in microseconds.
+		*/
+		u64 systemTimeInUs = 0;
+
+		/*!
+		@brief The resident set size in bytes.
+		*/
+		u64 residentSetSizeInB = 0;
+
+		/*!
+		@brief The peak resident set size of the process in bytes.
+		*/
+		u64 peakResidentSetSizeInB = 0;
+
+		/*!
+		@brief The CPU time of the thread in nanoseconds.
+		*/
+		u64 threadCPUTimeInNs = 0;
+
+		/*!
+		@brief Accumulates the difference between two snapshots into this one.
+		@details The counters and times are incremented by their difference; the
+				 resident set sizes keep the highest value of @p _end.
+		@param _start The snapshot taken when the block opened.
+		@param _end The snapshot taken when the block closed.
+		*/
+		inline void Accumulate(const OSMetricsSnapshot& _start, const OSMetricsSnapshot& _end) noexcept
+		{
+			mask |= _end.mask;
+			minorPageFaultCount += _end.minorPageFaultCount - _start.minorPageFaultCount;
+			majorPageFaultCount += _end.majorPageFaultCount - _start.majorPageFaultCount;
+			voluntaryContextSwitchCount += _end.voluntaryContextSwitchCount - _start.voluntaryContextSwitchCount;
+			involuntaryContextSwitchCount += _end.involuntaryContextSwitchCount - _start.involuntaryContextSwitchCount;
+			userTimeInUs += _end.userTimeInUs - _start.userTimeInUs;
+			systemTimeInUs += _end.systemTimeInUs - _start.systemTimeInUs;
+			residentSetSizeInB = _end.residentSetSizeInB > residentSetSizeInB ? _end.residentSetSizeInB : residentSetSizeInB;
+			peakResidentSetSizeInB = _end.peakResidentSetSizeInB > peakResidentSetSizeInB ? _end.peakResidentSetSizeInB : peakResidentSetSizeInB;
+			threadCPUTimeInNs += _end.threadCPUTimeInNs - _start.threadCPUTimeInNs;
+		}
+
+		/*!
+		@brief Clears all the values of the snapshot, including ::mask.
+		*/
+		inline void Clear() noexcept
+		{
+			*this = OSMetricsSnapshot();
+		}
+
+		/*!
+		@brief Returns the total number of page faults (minor and major).
+		*/
+		inline u64 PageFaultCount() const noexcept
+		{
+			return minorPageFaultCount + majorPageFaultCount;
+		}
+	};
+
 	/*!
 	@brief A struct to give access to internal statistics such memory or
 			performance related
@@ -43,6 +201,37 @@ namespace Profile
 		*/
 		static os_metrics GlobalMetrics;
 
+		/*!
+		@brief The OS metrics captured by the profile blocks (a combination of Profile::OSMetric).
+		@details The default is Profile::OSMetric_PageFaults.
+		@see ::SetOSMetricsMask, ::GetOSMetricsMask
+		*/
+		static u32 s_osMetricsMask;
+
+		/*!
+		@brief Captures the OS metrics selected by a mask in one call.
+		@details The page faults, context switches and CPU times are the ones of
+				 the calling thread on Linux (getrusage with RUSAGE_THREAD) and Windows
+				 (GetThreadTimes; page faults are the ones of the process and context
+				 switches are not available), and the ones of the process on MacOS.
+				 The resident set sizes are always the ones of the process.
+		@param _snapshot The snapshot to fill. Its ::mask is set to @p _mask.
+		@param _mask The metrics to capture (a combination of Profile::OSMetric).
+		*/
+		PROFILE_API static void CaptureOSMetrics(OSMetricsSnapshot& _snapshot, u32 _mask);
+
+		/*!
+		@brief Gets the OS metrics captured by the profile blocks.
+		*/
+		PROFILE_API static u32 GetOSMetricsMask();
+
+		/*!
+		@brief Sets the OS metrics captured by the profile blocks.
+		@details Blocks already open keep the metrics they were opened with.
+		@param _mask A combination of Profile::OSMetric.
+		*/
+		PROFILE_API static void SetOSMetricsMask(u32 _mask);
+
 		/*!
 		@brief Gets the number of page faults that have occurred since the start
 				of the process.
@@ -54,6 +243,25 @@ namespace Profile
 		*/
 		PROFILE_API static u64 GetOSPageSize();
 
+		/*!
+		@brief Gets the number of logical cores available to the process.
+		*/
+		PROFILE_API static u32 GetOSLogicalCoreCount();
+
+		/*!
+		@brief Pins the calling thread to a logical core the process may run on.
+		@details The cores are the ones of the affinity mask of the process (e.g.,
+				 restricted by taskset or a cgroup cpuset), read with
+				 GetProcessAffinityMask on Windows (only the first 64 cores can be
+				 targeted) and sched_getaffinity on Linux. The thread is then pinned
+				 with SetThreadAffinityMask or pthread_setaffinity_np. On MacOS,
+				 there is no such API and the function does nothing.
+		@param _coreIdx The index of the core among the allowed ones. It wraps around
+				their number.
+		@return Whether the thread was pinned.
+		*/
+		PROFILE_API static bool PinCurrentThreadToCore(u32 _coreIdx);
+
 		/*!
 		@brief On windows, it initializes the process handle to query memory statistics
 			   (see ::GlobalMetrics::ProcessHandle). On linux or mac, it does nothing.
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic> // for the dump counters and the stop flag
+#include <condition_variable> // to wake up the dumping thread
+#include <mutex> // for the condition variable
+#include <thread> // for the dumping thread
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	struct Profiler;
+	struct ProfilerResults;
+
+	/*!
+	@brief Dumps the statistics of a running profiler to CSV files on demand,
+			without stopping nor redeploying the instrumented process.
+	@details A dedicated thread, running at the lowest priority, waits for a
+			 dump to be requested and then captures the profiler with
+			 ProfilerResults::CaptureLive and writes it with
+			 ProfilerResults::ExportToCSV in ::directory, in a file named after
+			 the profiler, the time of the dump and its index (e.g.,
+			 "Service_20240131-142501-250_3.csv").
+			 A dump is requested:
+			 - by sending a signal to the process (SIGUSR1 by default; POSIX only),
+			 - every ::periodInMs milliseconds if it is not 0,
+			 - or by calling ::RequestDump.
+			 The signal handler only increments a lock-free atomic counter, which
+			 is async-signal-safe, and the instrumented threads are never involved.
+			 The signal handler is process-wide: only one dumper at a time can
+			 listen to a signal.
+	*/
+	struct ProfileDumper
+	{
+		/*!
+		@brief The profiler to dump.
+		*/
+		const Profiler* ptr_profiler = nullptr;
+
+		/*!
+		@brief The directory the files are written in.
+		*/
+		char directory[256] = {0};
+
+		/*!
+		@brief The signal requesting a dump, or 0 if dumps are not requested by signal.
+		*/
+		int signalNumber = 0;
+
+		/*!
+		@brief The period of the automatic dumps in milliseconds, or 0 if there are none.
+		*/
+		u32 periodInMs = 0;
+
+		/*!
+		@brief The number of dumps taken since ::Start.
+		*/
+		std::atomic<u64> dumpCount = 0;
+
+		/*!
+		@brief The path of the last file written.
+		@details Only valid once ::dumpCount was read non-zero. Written under
+				 ::dumpMutex.
+		*/
+		char lastDumpPath[512] = {0};
+
+		/*!
+		@brief The results the profiler is captured in before being written.
+		@details Allocated by ::Start since they are too large for the stack.
+		*/
+		ProfilerResults* ptr_results = nullptr;
+
+		/*!
+		@brief Serializes the dumps of the dumping thread and of the direct
+				calls to ::Dump.
+		*/
+		std::mutex dumpMutex;
+
+		/*!
+		@brief The thread capturing and writing the dumps.
+		*/
+		std::thread thread;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		bool stopRequested = false;
+		bool dumpRequested = false;
+
+		ProfileDumper() = default;
+		ProfileDumper(const ProfileDumper&) = delete;
+		ProfileDumper& operator=(const ProfileDumper&) = delete;
+
+		/*!
+		@brief Stops the dumping thread if it runs.
+		*/
+		PROFILE_API ~ProfileDumper();
+
+		/*!
+		@brief The signal used when none is specified (SIGUSR1 on POSIX, 0 on Windows).
+		*/
+		PROFILE_API static int GetDefaultSignal() noexcept;
+
+		/*!
+		@brief Creates the directory, installs the signal handler and starts the
+				dumping thread.
+		@param _profiler The profiler to dump. It must outlive the dumper.
+		@param _directory The directory the files are written in. It is created
+				if it does not exist.
+		@param _signalNumber The signal requesting a dump, or 0 for none.
+		@param _periodInMs The period of the automatic dumps, or 0 for none.
+		@return Whether the directory could be created and the signal handler
+				installed. The dumper is not started otherwise, in particular
+				if another dumper already listens to a signal.
+		*/
+		PROFILE_API bool Start(const Profiler* _profiler, const char* _directory, int _signalNumber = GetDefaultSignal(), u32 _periodInMs = 0);
+
+		/*!
+		@brief Stops the dumping thread and restores the previous handler of the signal.
+		@details A dump in progress is completed first.
+		*/
+		PROFILE_API void Stop();
+
+		/*!
+		@brief Requests a dump from the code.
+		*/
+		PROFILE_API void RequestDump();
+
+		/*!
+		@brief Captures the profiler and writes it in a new file immediately,
+				on the calling thread.
+		@details Called by the dumping thread; it may also be called directly
+				 from any thread, the dumps are then taken one after the other.
+		@return Whether the file could be written.
+		*/
+		PROFILE_API bool Dump();
+	};
+}
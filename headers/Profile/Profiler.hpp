@@ -1,14 +1,23 @@
 #pragma once
 
 #include <array> // for the timings and tracks arrays
+#include <atomic> // for the seqlock of the tracks
+#include <bit> // for std::bit_ceil in CallTree
+#include <cstddef> // for std::max_align_t in RepetitionTestFunction
 #include <cstdio> // for printf
 #include <cstdarg> // for va_list
+#include <limits> // for the saturation in AccumulateSquaredDifference
+#include <new> // for the placement new in RepetitionTestFunction
+#include <utility> // for std::forward and std::move in RepetitionTestFunction
 #include <vector> // for storing the functions that will undergo the repetition testing
-#include <type_traits> // for std::conditional_t in U_SIZE_ADAPTER
+#include <type_traits> // for std::conditional_t in USizeAdapter
 
 //#include "Export.hpp"
 #include "OSStatistics.hpp" // also includes Types.hpp and Export.hpp
 //#include "Types.hpp"
+#include "Statistics.hpp" // for the robust statistics of the repeated profiling
+#include "Roofline.hpp" // for comparing the blocks with the peaks of the machine
+#include "Spans.hpp" // for the spans of the coroutines
 
 namespace Profile
 {
@@ -28,44 +37,155 @@ namespace Profile
 	#define PROFILER_NAME_LENGTH 32
 #endif // !PROFILER_NAME_LENGTH
 
+#ifndef PROFILER_TRACK_ALLOCATIONS //Possibly defined as compilation variable
+	#define PROFILER_TRACK_ALLOCATIONS 0
+#endif // !PROFILER_TRACK_ALLOCATIONS
+
+#ifndef NB_CALL_NODES //Possibly defined as compilation variable
+	#define NB_CALL_NODES 512
+#endif // !NB_CALL_NODES
+
+#ifndef NB_SPANS //Possibly defined as compilation variable
+	#define NB_SPANS 64
+#endif // !NB_SPANS
+
+#ifndef NB_ASYNC_SPAN_EVENTS //Possibly defined as compilation variable
+	#define NB_ASYNC_SPAN_EVENTS 4096
+#endif // !NB_ASYNC_SPAN_EVENTS
+
+#ifndef NB_DYNAMIC_TRACKS //Possibly defined as compilation variable
+	#define NB_DYNAMIC_TRACKS 256
+#endif // !NB_DYNAMIC_TRACKS
+
+#ifndef NB_TAIL_EVENTS //Possibly defined as compilation variable
+	#define NB_TAIL_EVENTS 256
+#endif // !NB_TAIL_EVENTS
+
+#ifndef NB_TAIL_CAPTURES //Possibly defined as compilation variable
+	#define NB_TAIL_CAPTURES 64
+#endif // !NB_TAIL_CAPTURES
+
+#ifndef NB_BLOCK_KEYS //Possibly defined as compilation variable
+	#define NB_BLOCK_KEYS 16
+#endif // !NB_BLOCK_KEYS
+
+/*!
+@brief The smallest unsigned integer type among u8, u16, u32 and u64 that can
+		represent @p MaxValue.
+@details For example, if 0 <= MaxValue < 256, ::type is u8; if 256 <= MaxValue < 65536
+		 it is u16; and so on.
+*/
+template<u64 MaxValue>
+struct USizeAdapter
+{
+	using type = std::conditional_t<(MaxValue < (1ULL << 8)), u8,
+		std::conditional_t<(MaxValue < (1ULL << 16)), u16,
+		std::conditional_t<(MaxValue < (1ULL << 32)), u32, u64>>>;
+};
+
+template<u64 MaxValue>
+using USizeAdapter_t = typename USizeAdapter<MaxValue>::type;
+
+/*!
+@brief The sizes of a profiler and the integer types they call for.
+@details Gathers in one type what the size macros (NB_TRACKS, NB_TIMINGS,
+		 PROFILER_NAME_LENGTH, PROFILE_TRACK_NAME_LENGTH and NB_CALL_NODES)
+		 define, so that the code can depend on the sizes through a type
+		 rather than through the macros. Profile::DefaultProfilerSizes, the
+		 one of the macros, is the only one the profiling library is compiled
+		 with: Profile::CheckLibraryConfiguration reports a program compiled
+		 with other sizes.
+*/
+template<u64 Tracks, u64 Timings, u64 NameLength, u64 TrackNameLength, u64 CallNodes>
+struct ProfilerSizes
+{
+	static_assert(Tracks > 0 && Timings > 0, "A profiler needs at least one track and one block per track.");
+
+	static constexpr u64 trackCount = Tracks;
+	static constexpr u64 timingCount = Timings;
+	static constexpr u64 nameLength = NameLength;
+	static constexpr u64 trackNameLength = TrackNameLength;
+	static constexpr u64 callNodeCount = CallNodes;
+
+	/*!
+	@brief The type of the integers used to iterate over the blocks of a track.
+	*/
+	using TimingIt = USizeAdapter_t<Timings>;
+
+	/*!
+	@brief The type of the integers used to iterate over the static tracks.
+	*/
+	using TrackIt = USizeAdapter_t<Tracks>;
+
+	/*!
+	@brief The type of the index of a block in a track.
+	@details -1 because it is an index, not a number of elements.
+	*/
+	using TimingIdx = USizeAdapter_t<Timings - 1>;
+
+	/*!
+	@brief The type of the index of a static track.
+	@details -1 because it is an index, not a number of elements.
+	*/
+	using TrackIdx = USizeAdapter_t<Tracks - 1>;
+
+	/*!
+	@brief The type of the index of a node of a call tree.
+	@details Not -1 because CallNodes itself is used as the index of the root.
+	*/
+	using CallNodeIdx = USizeAdapter_t<CallNodes>;
+
+	/*!
+	@brief A hash of the sizes, to detect two binaries compiled with different ones.
+	*/
+	static constexpr u64 hash = ((((Tracks * 0x100000001B3ull ^ Timings) * 0x100000001B3ull ^ NameLength)
+		* 0x100000001B3ull ^ TrackNameLength) * 0x100000001B3ull ^ CallNodes) * 0x100000001B3ull;
+};
+
+/*!
+@brief The sizes set by the size macros, the ones of the profiler.
+*/
+using DefaultProfilerSizes = ProfilerSizes<NB_TRACKS, NB_TIMINGS, PROFILER_NAME_LENGTH, PROFILE_TRACK_NAME_LENGTH, NB_CALL_NODES>;
+
 /*!
 @brief Expands to adapt the type of the unsigned integer to be
 		u8, u16, u32, or u64 depending on the value of @p x.
-		@details For example, if 0 <= x < 256, it will return u8; if 256 <= x < 65532
-		it will return u16; and so on.
+@see Profile::USizeAdapter
 */
-#define U_SIZE_ADAPTER(x) \
-	std::conditional_t<(x < (1<<8)), Profile::u8, \
-	std::conditional_t<(x < (1<<16)), Profile::u16, \
-	std::conditional_t<(x < (1ULL<<32)), Profile::u32, Profile::u64>>>
+#define U_SIZE_ADAPTER(x) Profile::USizeAdapter_t<(x)>
 
 /*!
 @brief The macro used to adapt the type of the integer used to iterate over the
 		Profile Blocks based on the value of the max number of profile blocks (NB_TIMINGS).
 */
-#define IT_TIMINGS_TYPE U_SIZE_ADAPTER(NB_TIMINGS)
+#define IT_TIMINGS_TYPE Profile::DefaultProfilerSizes::TimingIt
 
 /*!
 @brief The macro used to adapt the type of the integer used to iterate over the
 		Profile Tracks based on the value of the max number of profile tracks (NB_TRACKS).
 */
-#define IT_TRACKS_TYPE U_SIZE_ADAPTER(NB_TRACKS)
+#define IT_TRACKS_TYPE Profile::DefaultProfilerSizes::TrackIt
 
 /*!
 @brief The macro used to adapt the type of the different variables used to
 		represent the number or index of Profile Blocks based on the value of the 
 		max number of profile blocks (NB_TIMINGS).
-@details -1 because U_SIZE_ADAPTER is 0 indexed and NB_TIMINGS is a number of elements, not an index.
 */
-#define NB_TIMINGS_TYPE U_SIZE_ADAPTER(NB_TIMINGS-1)
+#define NB_TIMINGS_TYPE Profile::DefaultProfilerSizes::TimingIdx
 
 /*!
 @brief The macro used to adapt the type of the different variables used to
 		represent the number or index of Profile Tracks based on the value of the
 		max number of profile tracks (NB_TRACKS).
-@details -1 because U_SIZE_ADAPTER is 0 indexed and NB_TIMINGS is a number of elements, not an index.
 */
-#define NB_TRACKS_TYPE U_SIZE_ADAPTER(NB_TRACKS-1)
+#define NB_TRACKS_TYPE Profile::DefaultProfilerSizes::TrackIdx
+
+/*!
+@brief The macro used to adapt the type of the different variables used to
+		represent the index of a node of a call tree based on the value of the
+		max number of nodes per call tree (NB_CALL_NODES).
+*/
+#define CALL_NODES_TYPE Profile::DefaultProfilerSizes::CallNodeIdx
 
 
 #if PROFILER_ENABLED
@@ -110,6 +230,36 @@ namespace Profile
 */
 #define PROFILE_FUNCTION_TIME_BANDWIDTH(trackIdx, byteCount) PROFILE_BLOCK_TIME_BANDWIDTH_(__FUNCTION__, trackIdx, __LINE__, byteCount)
 
+/*!
+@brief DO NOT USE in code. Prefer using PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS or
+		PROFILE_FUNCTION_TIME_BANDWIDTH_FLOPS. The equivalent of PROFILE_BLOCK_TIME_BANDWIDTH__
+		that also forwards a number of floating point operations to the profile block.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS__(blockName, trackIdx, profileBlockRecorderIdx, byteCount, flopCount, file, line)\
+	static NB_TIMINGS_TYPE profileBlockRecorder_##profileBlockRecorderIdx = Profile::Profiler::GetProfileBlockRecorderIndex(trackIdx, file, line, blockName); \
+	Profile::ProfileBlock ProfiledBlock_##profileBlockRecorderIdx(trackIdx, profileBlockRecorder_##profileBlockRecorderIdx, byteCount, flopCount)
+
+/*!
+@brief DO NOT USE in code. The intermediate macro expanding PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS__
+		with the values of __FILE__ and __LINE__.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS_(blockName, trackIdx, profileBlockRecorderIdx, byteCount, flopCount) PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS__(blockName, trackIdx, profileBlockRecorderIdx, byteCount, flopCount, __FILE__, __LINE__)
+
+/*!
+@brief USE in code. The macro to profile an arbitrary block of code with a name
+		you can choose, the number of bytes it processes and the number of floating
+		point operations it executes. With the machine peaks set (see Profile::SetMachinePeaks),
+		the reports place the block on the roofline of the machine.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS(blockName, trackIdx, byteCount, flopCount) PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS_(blockName, trackIdx, __LINE__, byteCount, flopCount)
+
+/*!
+@brief USE in code. The macro to profile a function with the number of bytes it
+		processes and the number of floating point operations it executes.
+@see PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS
+*/
+#define PROFILE_FUNCTION_TIME_BANDWIDTH_FLOPS(trackIdx, byteCount, flopCount) PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS_(__FUNCTION__, trackIdx, __LINE__, byteCount, flopCount)
+
 /*!
 @brief USE in code. The macro to profile a function. This expands to PROFILE_FUNCTION_TIME_BANDWIDTH
 		with byteCount=0. So, you this when you only wish to profile processing time
@@ -117,6 +267,192 @@ namespace Profile
 */
 #define PROFILE_FUNCTION_TIME(trackIdx,...) PROFILE_FUNCTION_TIME_BANDWIDTH(trackIdx, 0)
 
+/*!
+@brief DO NOT USE in code. Prefer using PROFILE_COUNTER_ADD, PROFILE_COUNTER_INCREMENT
+		or PROFILE_GAUGE_SET. The final macro expanding to register the counter or
+		gauge in its track once and to record a value in it.
+*/
+#define PROFILE_VALUE__(valueName, trackIdx, value, kind)\
+	do { \
+		static NB_TIMINGS_TYPE valueRecorderIdx = Profile::Profiler::GetValueRecorderIndex(trackIdx, __FILE__, __LINE__, valueName, kind); \
+		if (Profile::RuntimeSwitch::IsTrackActive(trackIdx)) \
+		{ \
+			Profile::RecordValue(trackIdx, valueRecorderIdx, value); \
+		} \
+	} while (0)
+
+/*!
+@brief USE in code. The macro to add an increment to a counter of domain events
+		(e.g., cache misses or retries). A counter is identified by its name in
+		its track, so it can be incremented from several places.
+*/
+#define PROFILE_COUNTER_ADD(counterName, trackIdx, increment) PROFILE_VALUE__(#counterName, trackIdx, increment, Profile::RecorderKind_Counter)
+
+/*!
+@brief USE in code. The macro to increment a counter by one.
+@see PROFILE_COUNTER_ADD
+*/
+#define PROFILE_COUNTER_INCREMENT(counterName, trackIdx) PROFILE_COUNTER_ADD(counterName, trackIdx, 1)
+
+/*!
+@brief USE in code. The macro to set the value of a gauge (e.g., the depth of a
+		queue). The gauge keeps its last value as well as the minimum, the maximum
+		and the mean of the values it was set to.
+*/
+#define PROFILE_GAUGE_SET(gaugeName, trackIdx, value) PROFILE_VALUE__(#gaugeName, trackIdx, value, Profile::RecorderKind_Gauge)
+
+/*!
+@brief DO NOT USE in code. Prefer using PROFILE_BLOCK_TIME_IN_TRACK, PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK
+		or PROFILE_FUNCTION_TIME_IN_TRACK. The equivalent of PROFILE_BLOCK_TIME_BANDWIDTH__
+		for a track registered at runtime: the index cached at the call site is only
+		the preferred slot of the block, since the same call site may be used with
+		several tracks.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK__(blockName, track, profileBlockRecorderIdx, byteCount, file, line)\
+	static const NB_TIMINGS_TYPE profileBlockRecorder_##profileBlockRecorderIdx = (NB_TIMINGS_TYPE)(Profile::Hash(file, line) % NB_TIMINGS); \
+	Profile::ProfileBlock ProfiledBlock_##profileBlockRecorderIdx(track, profileBlockRecorder_##profileBlockRecorderIdx, blockName, file, line, byteCount)
+
+/*!
+@brief DO NOT USE in code. The intermediate macro expanding PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK__
+		with the values of __FILE__ and __LINE__.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK_(blockName, track, profileBlockRecorderIdx, byteCount) PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK__(blockName, track, profileBlockRecorderIdx, byteCount, __FILE__, __LINE__)
+
+/*!
+@brief USE in code. The macro to profile an arbitrary block of code in a track
+		registered at runtime (see Profile::Profiler::RegisterTrack), with a name
+		you can choose and a number of bytes to monitor data throughput as well.
+@param track The Profile::TrackHandle of the track.
+*/
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK(blockName, track, byteCount) PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK_(blockName, track, __LINE__, byteCount)
+
+/*!
+@brief USE in code. The macro to profile an arbitrary block of code in a track
+		registered at runtime. This expands to PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK
+		with byteCount=0.
+*/
+#define PROFILE_BLOCK_TIME_IN_TRACK(blockName, track) PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK(#blockName, track, 0)
+
+/*!
+@brief USE in code. The macro to profile a function in a track registered at
+		runtime, with the function's name as the blockName (i.e., using __FUNCTION__).
+*/
+#define PROFILE_FUNCTION_TIME_IN_TRACK(track) PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK_(__FUNCTION__, track, __LINE__, 0)
+
+/*!
+@brief USE in code. The macro to profile a span of a coroutine that may be
+		suspended, and resumed on another thread, before it ends (see Profile::ProfileSpan).
+		It declares the span as a variable named spanVariable, so that the co_await
+		expressions can be wrapped with spanVariable.Await(...) to pause it while
+		the coroutine is suspended.
+*/
+#define PROFILE_SPAN(spanVariable, spanName)\
+	static Profile::u32 spanVariable##RecorderIdx = Profile::Profiler::GetSpanRecorderIndex(__FILE__, __LINE__, spanName); \
+	Profile::ProfileSpan spanVariable(spanVariable##RecorderIdx)
+
+/*!
+@brief USE in code. The macro to profile a coroutine as a span named after the
+		function (i.e., using __FUNCTION__).
+@see PROFILE_SPAN
+*/
+#define PROFILE_FUNCTION_SPAN(spanVariable) PROFILE_SPAN(spanVariable, __FUNCTION__)
+
+/*!
+@brief USE in code. The macro to begin an asynchronous span of type spanName,
+		identified by a 64-bit id, that may end on another thread with
+		PROFILE_ASYNC_SPAN_END(id) (see Profile::BeginAsyncSpan).
+*/
+#define PROFILE_ASYNC_SPAN_BEGIN(spanName, id)\
+	do { \
+		static Profile::u32 asyncSpanRecorderIdx = Profile::Profiler::GetSpanRecorderIndex(__FILE__, __LINE__, spanName); \
+		Profile::BeginAsyncSpan(asyncSpanRecorderIdx, id); \
+	} while (0)
+
+/*!
+@brief USE in code. The macro to end the asynchronous span begun with
+		PROFILE_ASYNC_SPAN_BEGIN and the same id (see Profile::EndAsyncSpan).
+*/
+#define PROFILE_ASYNC_SPAN_END(id) Profile::EndAsyncSpan(id)
+
+/*!
+@brief DO NOT USE in code. Prefer using PROFILE_BLOCK_TIME_TAIL_CAPTURE or
+		PROFILE_FUNCTION_TIME_TAIL_CAPTURE. The final macro expanding to the tail
+		capture scope and the profile block it watches. The scope is declared
+		first so that the block is closed, and recorded, before the scope ends.
+*/
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE__(blockName, trackIdx, profileBlockRecorderIdx, thresholdInUs)\
+	static const Profile::u64 tailCaptureThreshold_##profileBlockRecorderIdx = (Profile::u64)((Profile::f64)Profile::Timer::GetEstimatedCPUFreq() * (thresholdInUs) / 1e6); \
+	Profile::TailCaptureScope TailCaptureScope_##profileBlockRecorderIdx(blockName, trackIdx, tailCaptureThreshold_##profileBlockRecorderIdx); \
+	PROFILE_BLOCK_TIME_BANDWIDTH_(blockName, trackIdx, profileBlockRecorderIdx, 0)
+
+/*!
+@brief DO NOT USE in code. The intermediate macro expanding the line number
+		before PROFILE_BLOCK_TIME_TAIL_CAPTURE__ pastes it in the names of its variables.
+*/
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE_(blockName, trackIdx, profileBlockRecorderIdx, thresholdInUs) PROFILE_BLOCK_TIME_TAIL_CAPTURE__(blockName, trackIdx, profileBlockRecorderIdx, thresholdInUs)
+
+/*!
+@brief USE in code. The macro to profile a block of code (e.g., a request handler)
+		and to keep the blocks executed by the thread during it when it lasts
+		more than thresholdInUs microseconds (see Profile::TailCaptureScope).
+*/
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE(blockName, trackIdx, thresholdInUs) PROFILE_BLOCK_TIME_TAIL_CAPTURE_(#blockName, trackIdx, __LINE__, thresholdInUs)
+
+/*!
+@brief USE in code. The macro to profile a function and to keep the blocks it
+		executed when it lasts more than thresholdInUs microseconds.
+@see PROFILE_BLOCK_TIME_TAIL_CAPTURE
+*/
+#define PROFILE_FUNCTION_TIME_TAIL_CAPTURE(trackIdx, thresholdInUs) PROFILE_BLOCK_TIME_TAIL_CAPTURE_(__FUNCTION__, trackIdx, __LINE__, thresholdInUs)
+
+/*!
+@brief DO NOT USE in code. Prefer using PROFILE_BLOCK_TIME_KEYED, PROFILE_FUNCTION_TIME_KEYED,
+		PROFILE_BLOCK_TIME_KEYED_NAME or PROFILE_FUNCTION_TIME_KEYED_NAME. The final
+		macro expanding to the call site of the keyed block (see Profile::BlockKeySite)
+		and to the profile block recording the key it is executed with.
+*/
+#define PROFILE_BLOCK_TIME_KEYED__(blockName, trackIdx, profileBlockRecorderIdx, key, keyName)\
+	static Profile::BlockKeySite blockKeySite_##profileBlockRecorderIdx(blockName, __FILE__, __LINE__); \
+	Profile::ProfileBlock ProfiledBlock_##profileBlockRecorderIdx(trackIdx, blockKeySite_##profileBlockRecorderIdx, (Profile::u64)(key), keyName)
+
+/*!
+@brief DO NOT USE in code. The intermediate macro expanding the line number
+		before PROFILE_BLOCK_TIME_KEYED__ pastes it in the names of its variables.
+*/
+#define PROFILE_BLOCK_TIME_KEYED_(blockName, trackIdx, profileBlockRecorderIdx, key, keyName) PROFILE_BLOCK_TIME_KEYED__(blockName, trackIdx, profileBlockRecorderIdx, key, keyName)
+
+/*!
+@brief USE in code. The macro to profile an arbitrary block of code with a name
+		you can choose, with separate statistics for each value of a key known
+		at runtime (e.g., an enum of request types or a bucket of input sizes).
+		The reports group the keys of the block. Beyond NB_BLOCK_KEYS keys, the
+		other keys share the statistics of a single "other keys" entry.
+@param key An integer or an enum.
+*/
+#define PROFILE_BLOCK_TIME_KEYED(blockName, trackIdx, key) PROFILE_BLOCK_TIME_KEYED_(#blockName, trackIdx, __LINE__, key, nullptr)
+
+/*!
+@brief USE in code. The macro to profile a function with separate statistics for
+		each value of a key, with the function's name as the blockName.
+@see PROFILE_BLOCK_TIME_KEYED
+*/
+#define PROFILE_FUNCTION_TIME_KEYED(trackIdx, key) PROFILE_BLOCK_TIME_KEYED_(__FUNCTION__, trackIdx, __LINE__, key, nullptr)
+
+/*!
+@brief USE in code. The equivalent of PROFILE_BLOCK_TIME_KEYED with a string
+		as the key, which also names the key in the reports. The string must be
+		interned (e.g., a literal or a name living as long as the profiler),
+		since the keys are told apart by its address.
+*/
+#define PROFILE_BLOCK_TIME_KEYED_NAME(blockName, trackIdx, keyName) PROFILE_BLOCK_TIME_KEYED_(#blockName, trackIdx, __LINE__, keyName, keyName)
+
+/*!
+@brief USE in code. The equivalent of PROFILE_FUNCTION_TIME_KEYED with an
+		interned string as the key.
+@see PROFILE_BLOCK_TIME_KEYED_NAME
+*/
+#define PROFILE_FUNCTION_TIME_KEYED_NAME(trackIdx, keyName) PROFILE_BLOCK_TIME_KEYED_(__FUNCTION__, trackIdx, __LINE__, keyName, keyName)
+
 #else // PROFILER_ENABLED
 
 //In case the profiler is disabled, the macros are defined as empty.
@@ -128,6 +464,35 @@ namespace Profile
 #define PROFILE_BLOCK_TIME(...)
 #define PROFILE_FUNCTION_TIME_BANDWIDTH(...)
 #define PROFILE_FUNCTION_TIME(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS__(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS_(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS(...)
+#define PROFILE_FUNCTION_TIME_BANDWIDTH_FLOPS(...)
+#define PROFILE_VALUE__(...)
+#define PROFILE_COUNTER_ADD(...)
+#define PROFILE_COUNTER_INCREMENT(...)
+#define PROFILE_GAUGE_SET(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK__(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK_(...)
+#define PROFILE_BLOCK_TIME_BANDWIDTH_IN_TRACK(...)
+#define PROFILE_BLOCK_TIME_IN_TRACK(...)
+#define PROFILE_FUNCTION_TIME_IN_TRACK(...)
+
+//The spans are still declared so that the code using them compiles.
+#define PROFILE_SPAN(spanVariable, ...) Profile::NullProfileSpan spanVariable
+#define PROFILE_FUNCTION_SPAN(spanVariable) Profile::NullProfileSpan spanVariable
+#define PROFILE_ASYNC_SPAN_BEGIN(...)
+#define PROFILE_ASYNC_SPAN_END(...)
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE__(...)
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE_(...)
+#define PROFILE_BLOCK_TIME_TAIL_CAPTURE(...)
+#define PROFILE_FUNCTION_TIME_TAIL_CAPTURE(...)
+#define PROFILE_BLOCK_TIME_KEYED__(...)
+#define PROFILE_BLOCK_TIME_KEYED_(...)
+#define PROFILE_BLOCK_TIME_KEYED(...)
+#define PROFILE_FUNCTION_TIME_KEYED(...)
+#define PROFILE_BLOCK_TIME_KEYED_NAME(...)
+#define PROFILE_FUNCTION_TIME_KEYED_NAME(...)
 
 #endif // PROFILER_ENABLED
 
@@ -150,669 +515,2440 @@ static u64 Hash(const char* _fileName, u32 _lineNumber)
 	return res;
 }
 
+struct Profiler;
+struct ProfileBlockRecorder;
+struct ProfileTrack;
+
 /*!
-@brief An object that will live and die within the scope of a target block
-		of code to profile.
-@details The object will open the block upon construction and close it upon
-		destruction. The result of the profiling will be forwarded to the
-		profile track with the index ::trackIdx in the profiler. The index
-		in the track that will actually store the profiling statistics is
-		::profileBlockRecorderIdx.
+@brief Identifies a track registered at runtime (see Profile::Profiler::RegisterTrack).
+@details It only holds the index of the track in the profiler, so a handle stays
+		 valid in the copies of the profiler (e.g., the profilers of the threads
+		 initialized as copies of the global one, see Profile::SetThreadProfiler).
 */
-struct PROFILE_API ProfileBlock
+struct TrackHandle
 {
 	/*!
-	@brief The index of the profiling track this block belongs to.
+	@brief The ::trackIdx of a handle that does not identify a track.
 	*/
-	NB_TIMINGS_TYPE trackIdx = 0;
+	static constexpr u32 invalidIdx = ~0u;
 
 	/*!
-	@brief The index of this block in the profiling track.
+	@brief The index of the track, NB_TRACKS or more, as in Profile::Profiler::GetTrack.
 	*/
-	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+	u32 trackIdx = invalidIdx;
 
-	ProfileBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount);
-
-	~ProfileBlock();
+	/*!
+	@brief Whether the handle identifies a track.
+	*/
+	inline bool IsValid() const noexcept
+	{
+		return trackIdx != invalidIdx;
+	}
 };
 
 /*!
-@brief A struct to store the profiling statistics of a profiled block.
+@brief Switches the profiling on and off at runtime, globally or per track.
+@details PROFILER_ENABLED removes the profiling at compile time; this switch
+		 keeps the blocks compiled in but skips them at runtime. A block checks
+		 a single byte, ::trackFlags[trackIdx], which is 0 only if the profiling
+		 is enabled both globally and for its track: when it is not, the block
+		 reads no timer and makes no system call. The flags of all the tracks
+		 fit in one cache line, which stays in the cache of the threads that
+		 check it since it is only written when the switch is toggled.
+		 The switch can be toggled:
+		 - from the code with ::SetEnabled and ::SetTrackEnabled,
+		 - with the PROFILER_RUNTIME environment variable, read when the program
+		   starts (see ::ConfigureFromEnvironment),
+		 - with a signal (POSIX only, see ::InstallToggleSignal).
+		 The blocks open when the switch is toggled are closed normally.
+		 The spans (see Profile::ProfileSpan and Profile::BeginAsyncSpan) only
+		 follow the global switch.
 */
-struct ProfileBlockRecorder
+struct RuntimeSwitch
 {
 	/*!
-	@brief The name of the block.
+	@brief The bit of ::trackFlags set when the track is disabled.
 	*/
-	const char* blockName = nullptr;
+	static constexpr u8 trackDisabledFlag = 1;
 
 	/*!
-	@brief The start time of the block.
+	@brief The bit of ::trackFlags set when the profiling is disabled globally.
 	*/
-	u64 start = 0;
+	static constexpr u8 globallyDisabledFlag = 2;
 
 	/*!
-	@brief The accumulated time the block was executed.
+	@brief The flags of every track: the blocks of a track are only recorded
+			if its flags are 0.
+	@details The bits are set and cleared atomically, so that the global and
+			 the per-track switches can be toggled concurrently. The global
+			 bits are set again until they match ::enabled, so that they
+			 follow the last of concurrent global toggles.
 	*/
-	u64 elapsed = 0;
+	alignas(64) PROFILE_API static std::array<std::atomic<u8>, NB_TRACKS> trackFlags;
 
 	/*!
-	@brief The number of times the block was executed.
+	@brief Whether the profiling is enabled globally.
 	*/
-	u64 hitCount = 0;
+	PROFILE_API static std::atomic<bool> enabled;
 
 	/*!
-	@brief The number of page faults at the start of the block.
-	*/
-	u64 pageFaultCountStart = 0;
-
-	/*
-	@brief The total number of page faults over all executions of the block.
+	@brief Whether the blocks of a track are recorded.
+	@details The single branch a disabled block pays for.
+	@param _trackIdx The index of the track.
 	*/
-	u64 pageFaultCountTotal = 0;
+	static inline bool IsTrackActive(NB_TRACKS_TYPE _trackIdx) noexcept
+	{
+		return trackFlags[_trackIdx].load(std::memory_order_relaxed) == 0;
+	}
 
 	/*!
-	@brief The number of bytes processed by the block.
+	@brief Whether the profiling is enabled globally.
 	*/
-	u64 processedByteCount = 0;
+	static inline bool IsEnabled() noexcept
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
 
 	/*!
-	@brief Clears the values of the block.
-	@remarks There is no difference between this and ::Reset. We are keeping
-			 both for consistency with the other structs.
+	@brief Whether a track is enabled, regardless of the global switch.
+	@param _trackIdx The index of the track.
 	*/
-	PROFILE_API void Clear() noexcept;
+	PROFILE_API static bool IsTrackEnabled(NB_TRACKS_TYPE _trackIdx) noexcept;
 
 	/*!
-	@brief Update the profiling statistics of the block upon completion.
-	@return The time increment since the block was opened.
+	@brief Enables or disables the profiling globally.
+	@details The switches of the tracks are kept: enabling the profiling again
+			 only records the tracks that are enabled.
 	*/
-	inline u64 Close()
-	{
-		u64 increment = Timer::GetCPUTimer() - start;
-		elapsed += increment;
-		pageFaultCountTotal += (Surveyor::GetOSPageFaultCount() - pageFaultCountStart);
-		return increment;
-	}
+	PROFILE_API static void SetEnabled(bool _enabled) noexcept;
 
 	/*!
-	@brief Update the profiling statistics of the block upon execution.
-	@param _byteCount The number of bytes processed by the block.
+	@brief Enables or disables the profiling of one track.
+	@param _trackIdx The index of the track.
+	@param _enabled Whether the blocks of the track are recorded.
 	*/
-	inline void Open(u64 _byteCount)
-	{
-		start = Timer::GetCPUTimer();
-		pageFaultCountStart = Surveyor::GetOSPageFaultCount();
-		hitCount++;
-		processedByteCount += _byteCount;
-	}
+	PROFILE_API static void SetTrackEnabled(NB_TRACKS_TYPE _trackIdx, bool _enabled) noexcept;
 
 	/*!
-	@brief Resets the values of the block.
-	@remarks There is no difference between this and ::Clear. We are keeping
-			 both for consistency with the other structs.
+	@brief Enables the profiling globally if it is disabled, and disables it otherwise.
+	@details ::enabled is flipped with a single atomic read-modify-write, so
+			 two concurrent toggles cancel out. Only uses lock-free atomic
+			 operations, so it can be called from a signal handler.
 	*/
-	PROFILE_API void Reset() noexcept;
-};
+	PROFILE_API static void Toggle() noexcept;
 
-/*!
-@brief A mirror of the ProfileBlockRecorder struct to store statistics
-		matching  a profiled block and a few more to help with the reporting.
-*/
-struct ProfileBlockResult
-{
 	/*!
-	@brief The index of the profiling track this block belongs to.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief Configures the switch from an environment variable.
+	@details The value of the variable is either:
+			 - "0", "off" or "false" to disable the profiling globally,
+			 - "1", "on" or "true" to enable it globally, with all the tracks,
+			 - or a comma-separated list of track indices (e.g., "0,2") to enable
+			   the profiling of these tracks only.
+			 Called with PROFILER_RUNTIME when the program starts.
+	@param _variableName The name of the environment variable.
+	@return Whether the variable was set to a valid value. The switch is
+			unchanged otherwise.
 	*/
-	NB_TRACKS_TYPE trackIdx = 0;
+	PROFILE_API static bool ConfigureFromEnvironment(const char* _variableName = "PROFILER_RUNTIME") noexcept;
 
 	/*!
-	@brief The index of this block in the profiling track.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief The signal used by ::InstallToggleSignal when none is specified
+			(SIGUSR2 on POSIX, 0 on Windows).
 	*/
-	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+	PROFILE_API static int GetDefaultSignal() noexcept;
 
 	/*!
-	@brief The name of the block.
-	@details Mirrors ProfileBlockRecorder::blockName.
+	@brief Installs a handler calling ::Toggle when a signal is received.
+	@param _signalNumber The signal toggling the profiling.
+	@return Whether the handler could be installed. Always false on Windows.
 	*/
-	const char* blockName = nullptr;
+	PROFILE_API static bool InstallToggleSignal(int _signalNumber = GetDefaultSignal()) noexcept;
+};
 
+/*!
+@brief The kind of key of a slot recording a keyed block (see PROFILE_BLOCK_TIME_KEYED).
+*/
+enum BlockKeyKind : u8
+{
 	/*!
-	@brief The accumulated time the block was executed.
-	@details Mirrors ProfileBlockRecorder::elapsed.
+	@brief The slot is not keyed.
 	*/
-	u64 elapsed = 0;
+	BlockKeyKind_None = 0,
 
 	/*!
-	@brief The converted ::elapsed in seconds.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief The key is an integer (or an enum).
 	*/
-	f64 elapsedSec = 0.0;
+	BlockKeyKind_Integer,
 
 	/*!
-	@brief The number of times the block was executed.
-	@details Mirrors ProfileBlockRecorder::hitCount.
+	@brief The key is the address of an interned string, which names it.
 	*/
-	u64 hitCount = 0;
+	BlockKeyKind_String,
 
 	/*!
-	@brief The total number of page faults over all executions of the block.
-	@details Mirrors ProfileBlockRecorder::pageFaultCountTotal.
+	@brief The slot gathers the keys beyond the NB_BLOCK_KEYS first ones.
 	*/
-	u64 pageFaultCountTotal = 0;
+	BlockKeyKind_Overflow
+};
+
+/*!
+@brief The call site of a keyed block, which maps the keys it was executed with
+		to their slot in its track.
+@details The keys are kept in a bounded open-addressed table of NB_BLOCK_KEYS
+		 entries. As for the other blocks, the slots are claimed once for all
+		 the profilers (see Profile::Profiler::GetKeyedBlockRecorderIndex), so
+		 the table is shared by the threads while each one records in the
+		 tracks of its own profiler. Once the table is full, the other keys
+		 share one overflow slot.
+		 The entries are only added, under the lock of the registration, and
+		 published with ::BlockKeyEntry::isUsed so that the lookups take no lock.
+*/
+struct BlockKeySite
+{
+	struct BlockKeyEntry
+	{
+		u64 key = 0;
+		NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+		std::atomic<bool> isUsed = false;
+	};
+
+	const char* blockName = nullptr;
+	const char* fileName = nullptr;
+	u32 lineNumber = 0;
 
 	/*!
-	@brief The number of bytes processed by the block.
-	@details Mirrors ProfileBlockRecorder::processedByteCount.
+	@brief The open-addressed table of the keys.
 	*/
-	u64 processedByteCount = 0;
+	BlockKeyEntry entries[NB_BLOCK_KEYS];
 
 	/*!
-	@brief The proportion of the block's time in its track's time.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief The number of keys in ::entries.
+	@details Only accessed under the lock of the registration.
 	*/
-	f32 proportionInTrack = 0.f;
+	u32 keyCount = 0;
 
 	/*!
-	@brief The proportion of the block's time in the total time of the profiler.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief Whether ::overflowRecorderIdx is set, which happens once ::entries is full.
 	*/
-	f32 proportionInTotal = 0.f;
+	std::atomic<bool> hasOverflow = false;
 
 	/*!
-	@brief The bandwidth in bytes per second.
-	@details No equivalent in ProfileBlockRecorder.
+	@brief The slot of the keys that did not fit in ::entries.
 	*/
-	f32 bandwidthInB = 0.f;
+	NB_TIMINGS_TYPE overflowRecorderIdx = 0;
 
-	ProfileBlockResult() = default;
+	BlockKeySite(const char* _blockName, const char* _fileName, u32 _lineNumber) :
+		blockName(_blockName), fileName(_fileName), lineNumber(_lineNumber)
+	{
+
+	}
 
 	/*!
-	@brief Captures the statistics of a Profile::ProfileBlockRecorder.
-	@details It will effectively assign or compute the values of all the
-				member variables of this struct.
+	@brief The entry of ::entries to look a key up from.
 	*/
-	PROFILE_API void Capture(ProfileBlockRecorder& _record, NB_TRACKS_TYPE _trackIdx,
-				NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _trackElapsedReference, u64 _totalElapsedReference) noexcept;
+	static inline u32 GetPreferredEntryIdx(u64 _key) noexcept
+	{
+		//Fibonacci hashing, so that consecutive keys are spread
+		return (u32)((_key * 11400714819323198485ull) >> 32) % NB_BLOCK_KEYS;
+	}
 
 	/*!
-	@brief Clears the values of the block.
-	@remarks This resets even the ::blockName.
-			 If you are looking to reset the values without changing the name,
-			 use ::Reset.
-
-	*/
-	PROFILE_API void Clear() noexcept;
-
-	/*!
-	@brief Outputs the profiling statistics of the block.
-	*/
-	PROFILE_API void Report() noexcept;
-
-	/*!
-	@brief Resets the values of this struct.
-	@details Resetting do not change the ::blockName.
+	@brief Looks up the slot of a key.
+	@param _key The key.
+	@param _profileBlockRecorderIdx Receives the slot of the key, or the overflow
+			slot if the key is not in the full table.
+	@return Whether a slot was found. If not, the key must be registered with
+			Profile::Profiler::GetKeyedBlockRecorderIndex.
 	*/
-	PROFILE_API void Reset() noexcept;
+	inline bool FindRecorderIndex(u64 _key, NB_TIMINGS_TYPE& _profileBlockRecorderIdx) const noexcept
+	{
+		u32 preferredEntryIdx = GetPreferredEntryIdx(_key);
+		for (u32 i = 0; i < NB_BLOCK_KEYS; ++i)
+		{
+			const BlockKeyEntry& entry = entries[(preferredEntryIdx + i) % NB_BLOCK_KEYS];
+			if (!entry.isUsed.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			if (entry.key == _key)
+			{
+				_profileBlockRecorderIdx = entry.profileBlockRecorderIdx;
+				return true;
+			}
+		}
+		if (hasOverflow.load(std::memory_order_acquire))
+		{
+			_profileBlockRecorderIdx = overflowRecorderIdx;
+			return true;
+		}
+		return false;
+	}
 };
 
 /*!
-@brief A container for several profiling blocks.
-@details The goal is to profile a series of blocks that are related to each other.
+@brief An object that will live and die within the scope of a target block
+		of code to profile.
+@details The object will open the block upon construction and close it upon
+		destruction. The result of the profiling will be forwarded to the
+		profile track with the index ::trackIdx in the profiler. The index
+		in the track that will actually store the profiling statistics is
+		::profileBlockRecorderIdx.
 */
-struct ProfileTrack
+struct PROFILE_API ProfileBlock
 {
 	/*!
-	@brief Whether the track is used for at least one block.
-	@details This is might be set to true only once a block is added to the track.
-			 This is used to avoid outputting the track's statistics, or reseting its data
-			 if it has none.
-	@see Profile::Profiler::GetProfileBlockRecorderIndex(...)
+	@brief The track the block was opened in.
+	@details It belongs to the profiler of the current thread at the time of the
+			 construction (see Profile::SetThreadProfiler), or to the global one
+			 (see Profile::SetProfiler).
 	*/
-	bool hasBlock = false;
+	ProfileTrack* ptr_track = nullptr;
 
 	/*!
-	@brief The name of the track.
+	@brief The block that was the innermost open block of the thread when this
+			one was opened.
+	@details Only used when PROFILER_TRACK_ALLOCATIONS is enabled to restore the
+			 block the allocations are attributed to once this one closes.
 	*/
-	char name[PROFILE_TRACK_NAME_LENGTH] = {0};
+	ProfileBlockRecorder* ptr_parentRecorder = nullptr;
 
 	/*!
-	@brief The accumulated time from all blocks in the track.
+	@brief The index of the profiling track this block belongs to.
 	*/
-	u64 elapsed = 0;
+	NB_TIMINGS_TYPE trackIdx = 0;
 
 	/*!
-	@brief The profiling statistics of the blocks in the track.
+	@brief The index of this block in the profiling track.
 	*/
-	std::array<ProfileBlockRecorder, NB_TIMINGS> timings;
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
 
-	/*
-	@brief Clears the values of the track and its blocks.
-	@remarks This resets even the ::name and ::elapsed.
-			 If you are looking to reset the values without changing the name,
-			 use ::Reset.
-			 If you are looking to reset the timings only, use ::ResetTimings.
+	/*!
+	@brief Opens the block if its track is active (see Profile::RuntimeSwitch).
+	@details Inline so that a block skipped at runtime only costs the check.
 	*/
-	PROFILE_API void Clear() noexcept;
+	inline ProfileBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount, u64 _flopCount = 0) :
+		trackIdx(_trackIdx), profileBlockRecorderIdx(_profileBlockRecorderIdx)
+	{
+		if (RuntimeSwitch::IsTrackActive(_trackIdx))
+		{
+			Open(_byteCount, _flopCount);
+		}
+	}
 
-	/*
-	@brief Clears the values of all blocks in ::timings.
-	@remarks This also resets ::hasBlock to false.
+	/*!
+	@brief Opens the block in a track registered at runtime if the profiling is
+			enabled globally (see Profile::RuntimeSwitch::IsEnabled).
+	@param _track The track, looked up in the profiler of the current thread.
+	@param _preferredRecorderIdx The slot of the block in the track if it is free.
 	*/
-	PROFILE_API void ClearTimings() noexcept;
+	inline ProfileBlock(TrackHandle _track, NB_TIMINGS_TYPE _preferredRecorderIdx, const char* _blockName,
+		const char* _fileName, u32 _lineNumber, u64 _byteCount, u64 _flopCount = 0)
+	{
+		if (RuntimeSwitch::IsEnabled())
+		{
+			Open(_track, _preferredRecorderIdx, _blockName, _fileName, _lineNumber, _byteCount, _flopCount);
+		}
+	}
 
 	/*!
-	@brief Closes a block and updates the track's elapsed time.
-	@param _profileBlockRecorderIdx The index of block timing in the track.
-	@see Profile::ProfileBlockRecorder::Close()
+	@brief Opens a keyed block if its track is active (see PROFILE_BLOCK_TIME_KEYED).
+	@param _site The call site of the block.
+	@param _key The key the block is executed with.
+	@param _keyName The name of the key if it is an interned string, nullptr otherwise.
 	*/
-	PROFILE_API inline void CloseBlock(NB_TIMINGS_TYPE _profileBlockRecorderIdx)
+	inline ProfileBlock(NB_TRACKS_TYPE _trackIdx, BlockKeySite& _site, u64 _key, const char* _keyName) :
+		trackIdx(_trackIdx)
 	{
-		elapsed += timings[_profileBlockRecorderIdx].Close();
+		if (RuntimeSwitch::IsTrackActive(_trackIdx))
+		{
+			Open(_site, _key, _keyName);
+		}
 	}
 
 	/*!
-	@brief Opens a block of the track.
-	@param _profileBlockRecorderIdx The index of the block timing in the track.
-	@param _byteCount The number of bytes processed by the block.
-	@see Profile::ProfileBlockRecorder::Open(Profile::u64 _byteCount)
+	@brief Closes the block if it was opened.
 	*/
-	PROFILE_API inline void OpenBlock(NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount)
+	inline ~ProfileBlock()
 	{
-		timings[_profileBlockRecorderIdx].Open(_byteCount);
+		if (ptr_track)
+		{
+			Close();
+		}
 	}
 
 	/*!
-	@brief Outputs the profiling statistics of all blocks in the track.
+	@brief Opens the block in the track ::trackIdx of the profiler of the current thread.
+	@param _byteCount The number of bytes processed by the block.
+	@param _flopCount The number of floating point operations executed by the block.
 	*/
-	PROFILE_API void Report(u64 _totalElapsedReference) noexcept;
+	void Open(u64 _byteCount, u64 _flopCount);
 
 	/*!
-	@brief Resets the values of the track and its blocks.
-	@details Resetting do not change the names.
-	@see ::ResetTimings
+	@brief Opens the block in a track registered at runtime, in the profiler of
+			the current thread.
+	@details The block is not opened if the profiler has no such track.
+	@see Profile::ProfileTrack::GetBlockRecorderIndex
 	*/
-	PROFILE_API void Reset() noexcept;
+	void Open(TrackHandle _track, NB_TIMINGS_TYPE _preferredRecorderIdx, const char* _blockName,
+		const char* _fileName, u32 _lineNumber, u64 _byteCount, u64 _flopCount);
 
 	/*!
-	@brief Resets the values of all blocks in the track that have a name.
-	@details Resetting do not change the names.
+	@brief Opens the slot of a key of a keyed block in the track ::trackIdx of
+			the profiler of the current thread.
+	@see Profile::BlockKeySite::FindRecorderIndex
 	*/
-	PROFILE_API void ResetTimings() noexcept;
+	void Open(BlockKeySite& _site, u64 _key, const char* _keyName);
+
+	/*!
+	@brief Opens the block ::profileBlockRecorderIdx of a track.
+	*/
+	void OpenInTrack(ProfileTrack* _track, u64 _byteCount, u64 _flopCount);
+
+	/*!
+	@brief Closes the block in the profiler it was opened in.
+	*/
+	void Close();
 };
 
 /*!
-@brief A mirror of the ProfileTrack struct to store statistics matching a profiled
-		track and the blocks it contains (thanks to Profile::ProfileBlockResult).
-@details In this mirror, the blocks are packed at the beginning of the array to
-		avoid having to iterate over all the blocks that might not have been used.
-		The number of blocks used in the track is stored in ::blockCount.
+@brief What a slot of a track records.
 */
-struct ProfileTrackResult
+enum RecorderKind : u8
 {
 	/*!
-	@brief The name of the track.
-	@details Mirrors ProfileTrack::name.
+	@brief A block of code, timed when it is executed (see Profile::ProfileBlock).
 	*/
-	const char* name = nullptr;
+	RecorderKind_Block = 0,
 
 	/*!
-	@brief The accumulated time from all blocks in the track.
-	@details Mirrors ProfileTrack::elapsed.
+	@brief A counter of events, which adds up the values it records (see PROFILE_COUNTER_ADD).
 	*/
-	u64 elapsed = 0;
+	RecorderKind_Counter,
 
 	/*!
-	@brief The converted ::elapsed in seconds.
-	@details No equivalent in ProfileTrack.
+	@brief A gauge, which keeps the last value it records (see PROFILE_GAUGE_SET).
 	*/
-	f64 elapsedSec = 0.0;
+	RecorderKind_Gauge
+};
+
+/*!
+@brief Gets the name of a kind of slot, as written in the exports.
+*/
+extern PROFILE_API const char* GetRecorderKindName(RecorderKind _kind) noexcept;
 
+/*!
+@brief A struct to store the profiling statistics of a profiled block.
+@details A slot may also hold a counter or a gauge (see ::kind), in which case
+		 only ::hitCount (the number of values recorded) and the value
+		 statistics are used.
+*/
+struct ProfileBlockRecorder
+{
 	/*!
-	@brief The proportion of the track's time in the total time of the profiler.
-	@details No equivalent in ProfileTrack.
+	@brief The name of the block.
 	*/
-	f64 proportionInTotal = 0.0;
+	const char* blockName = nullptr;
 
 	/*!
-	@brief The number of blocks used in the track.
+	@brief The source file the block was registered from (i.e., __FILE__ at
+			the profiling macro).
 	*/
-	NB_TIMINGS_TYPE blockCount = 0;
+	const char* fileName = nullptr;
 
 	/*!
-	@brief The array of mirrors to the Profile::ProfileBlockRecorder structs originally
-			stored in the track.
-	@details The mirrored blocks are packed at the beginning of the array to
-			avoid having to iterate over all the blocks that might not have
-			been used.
+	@brief The line the block was registered from (i.e., __LINE__ at the
+			profiling macro).
 	*/
-	std::array<ProfileBlockResult, NB_TIMINGS> timings;
+	u32 lineNumber = 0;
 
-	ProfileTrackResult() = default;
+	/*!
+	@brief The start time of the block.
+	*/
+	u64 start = 0;
 
 	/*!
-	@brief Captures the statistics of a Profile::ProfileTrack.
-	@details It will effectively assign or compute the values of all the
-			 member variables of this struct. In particular, it will fill the
-			 ::timings array with the statistics of the Profile::ProfileBlockRecorders
-			 of the track that have been used.
+	@brief The accumulated time the block was executed.
 	*/
-	PROFILE_API void Capture(ProfileTrack& _track, u64 _trackIdx, u64 _totalElapsedReference) noexcept;
+	u64 elapsed = 0;
 
 	/*!
-	@brief Clears the values of member variables of this struct and up to
-			::blockCount Profile::ProfileBlockResults in the ::timings array.
-	@remarks This resets even the ::name. 
-			 If you are looking to reset the values without changing the name,
-			 use ::Reset.
+	@brief The number of times the block was executed.
 	*/
-	PROFILE_API void Clear() noexcept;
+	u64 hitCount = 0;
 
 	/*!
-	@brief Outputs the profiling statistics of the track.
+	@brief The number of executions of the block in progress.
+	@details A block still open has a ::start but its current execution is not
+			 in ::elapsed yet. Lets the concurrent captures account for it.
+	@see Profile::ProfileTrack::CaptureConsistent
 	*/
-	PROFILE_API void Report() noexcept;
+	u64 openCount = 0;
 
 	/*!
-	@brief Resets the values of member variables of this struct and up to
-			::blockCount Profile::ProfileBlockResults in the ::timings array.
-	@details Resetting do not change the name.
+	@brief The number of page faults at the start of the block.
 	*/
-	PROFILE_API void Reset() noexcept;
-};
+	u64 pageFaultCountStart = 0;
+
+	/*
+	@brief The total number of page faults over all executions of the block.
+	@details Only counted when Profile::OSMetric_PageFaults is in the mask of
+			 Profile::Surveyor::SetOSMetricsMask (the default).
+	*/
+	u64 pageFaultCountTotal = 0;
 
-/*!
-@brief A struct to manage the profiling of a program.
-*/
-struct Profiler
-{
 	/*!
-	@brief The name of the profiler.
+	@brief The OS metrics at the start of the block.
+	@details Its mask is the one of Profile::Surveyor::GetOSMetricsMask when
+			 the block opened.
 	*/
-	char name[PROFILER_NAME_LENGTH] = { 0 };
+	OSMetricsSnapshot osMetricsStart;
 
 	/*!
-	@brief The time when the profiler was initialized (when ::Initialize
-			was called).
+	@brief The OS metrics accumulated over all executions of the block.
+	@see Profile::OSMetricsSnapshot::Accumulate
 	*/
-	u64 start = 0;
+	OSMetricsSnapshot osMetricsTotal;
 
 	/*!
-	@brief The time since the profiler was initialized.
-	@details This is updated only when ::End is called.
+	@brief The number of heap allocations made while the block was the innermost
+			open block of its thread.
+	@details Only recorded when PROFILER_TRACK_ALLOCATIONS is enabled.
+	@see Profile::RecordAllocation
 	*/
-	u64 elapsed = 0;
+	u64 allocationCount = 0;
 
 	/*!
-	@brief The tracks in the profiler.
+	@brief The number of bytes allocated by the allocations counted in ::allocationCount.
+	@details The size of an allocated block is the one reported by the allocator,
+			 the same as the one ::freedByteCount records when it is released.
 	*/
-	std::array<ProfileTrack, NB_TRACKS> tracks;
+	u64 allocatedByteCount = 0;
 
-	Profiler() = default;
+	/*!
+	@brief The number of bytes released while the block was the innermost open
+			block of its thread.
+	@details Only recorded when PROFILER_TRACK_ALLOCATIONS is enabled.
+	@see Profile::RecordDeallocation
+	*/
+	u64 freedByteCount = 0;
 
 	/*!
-	@brief Gets an index for a profile result.
-	@details The index is determined by the hash of the file name and line number.
-	@param _trackIdx The index of the track the profile result belongs to.
-	@param _fileName The name of the file where the block is located.
-	@param _lineNumber The line number in the file where the block is located.
-	@param _blockName The name of the block.
-	@return The index of the profile result.
+	@brief The number of bytes processed by the block.
 	*/
-	PROFILE_API static NB_TIMINGS_TYPE GetProfileBlockRecorderIndex(NB_TRACKS_TYPE _trackIdx, const char* _fileName, u32 _lineNumber, const char* _blockName);
+	u64 processedByteCount = 0;
 
 	/*!
-	@brief Sets the name of the profiler.
-	@param _name The name of the profiler.
+	@brief The number of floating point operations executed by the block.
 	*/
-	PROFILE_API inline void SetProfilerName(const char* _name) noexcept
-	{
-		SetProfilerNameFmt(_name);
-	}
+	u64 flopCount = 0;
 
-	PROFILE_API void SetProfilerNameFmt(const char* _fmt, ...);
+	/*!
+	@brief Whether the slot is a timed block, a counter or a gauge.
+	*/
+	RecorderKind kind = RecorderKind_Block;
 
 	/*!
-	@brief Sets the name of a track.
-	@param _trackIdx The index of the track.
-	@param _name The name of the track.
-	@remarks The name will be truncated if it is longer than 31 characters.
+	@brief Whether the block is keyed, and how its key is named in the reports.
+	@see PROFILE_BLOCK_TIME_KEYED
 	*/
-	PROFILE_API inline void SetTrackName(NB_TRACKS_TYPE _trackIdx, const char* _name) noexcept
-	{
-		if (_trackIdx < NB_TRACKS)
-		{
-			SetTrackNameFmt(_trackIdx, _name);
-		}
-	}
-	
+	BlockKeyKind keyKind = BlockKeyKind_None;
+
 	/*!
-	@brief Sets the name of a track with a format string.
-	@param _trackIdx The index of the track.
-	@param _fmt The format string of the name of the track.
-	@param ... The arguments to the format string.
-	@remarks The name will be truncated if it is longer than 31 characters.
+	@brief The key of a keyed block. The slots of the keys of a call site share
+			its ::fileName and ::lineNumber.
 	*/
-	PROFILE_API void SetTrackNameFmt(NB_TRACKS_TYPE _trackIdx, const char* _fmt, ...);
+	u64 key = 0;
 
 	/*!
-	@brief Clears the profiler's values as well as all its initialized tracks.
-	@remarks This resets even the ::name.
-			 If you are looking to reset the values without changing the name,
-			 use ::Reset.
-			 If you are looking to reset the tracks only, use ::ClearTracks.
+	@brief The name of the key of a keyed block if it is an interned string.
 	*/
-	PROFILE_API void Clear() noexcept;
+	const char* keyName = nullptr;
 
 	/*!
-	@brief Clears all used blocks of all used tracks in the profiler.
-	@remarks If you are looking to reset the values without changing the names,
-			 use ::ResetTracks.
+	@brief The total of a counter, or the last value of a gauge.
 	*/
-	PROFILE_API void ClearTracks() noexcept;
+	s64 value = 0;
 
 	/*!
-	@brief Closes a block.
-	@param _trackIdx The index of the track the block belongs to.
-	@param _profileBlockRecorderIdx The index of the profile result.
+	@brief The sum of the values recorded, to compute their mean over ::hitCount.
 	*/
-	PROFILE_API inline void CloseBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx)
-	{
-		tracks[_trackIdx].CloseBlock(_profileBlockRecorderIdx);
-	}
+	s64 valueSum = 0;
 
 	/*!
-	@brief Ends the profiler.
-	@details Sets ::elapsed to the time since ::Initialize was called.
+	@brief The minimal value recorded (an increment for a counter).
 	*/
-	PROFILE_API void End() noexcept;
+	s64 minValue = 0;
 
-	
 	/*!
-	@brief Exports the profiling statistics of the profiler to a CSV file.
-	@details The logic to create the directories where the file is stored MUST be handled outside
-			 before calling this function. The file will be overwritten if it already exists.
-			 The file starts with two lines giving the headers for statistics of the profiler
-			 followed by the associated numbers. Then, a line defines new headers for the
-			 statistics of the blocks in the tracks. The following lines give the statistics
-			 of the blocks in the tracks. The statistics of the blocks are ordered by the
-			 order of the tracks in the profiler, and then by the order of the blocks in the tracks.
-	@param _path The path of the CSV file.
+	@brief The maximal value recorded (an increment for a counter).
+	*/
+	s64 maxValue = 0;
+
+	/*!
+	@brief Clears the values of the block.
+	@remarks There is no difference between this and ::Reset. We are keeping
+			 both for consistency with the other structs.
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*!
+	@brief Captures the OS metrics at the start of the block.
+	@details Called before ::Open. It is kept apart from ::Open because it may
+			 make a system call, which should not happen while the track is
+			 being updated (see Profile::ProfileTrack::BeginUpdate).
+	*/
+	inline void CaptureOSMetricsStart()
+	{
+		osMetricsStart.mask = Surveyor::GetOSMetricsMask();
+		if (osMetricsStart.mask)
+		{
+			Surveyor::CaptureOSMetrics(osMetricsStart, osMetricsStart.mask);
+			pageFaultCountStart = osMetricsStart.PageFaultCount();
+		}
+	}
+
+	/*!
+	@brief Captures the OS metrics at the end of the block.
+	@details Called before ::Close, for the same reason as ::CaptureOSMetricsStart.
+	@param _osMetricsEnd Receives the metrics selected when the block opened.
+	*/
+	inline void CaptureOSMetricsEnd(OSMetricsSnapshot& _osMetricsEnd) const
+	{
+		if (osMetricsStart.mask)
+		{
+			Surveyor::CaptureOSMetrics(_osMetricsEnd, osMetricsStart.mask);
+		}
+	}
+
+	/*!
+	@brief Update the profiling statistics of the block upon completion.
+	@param _end The time the block completed.
+	@param _osMetricsEnd The OS metrics captured by ::CaptureOSMetricsEnd.
+	@return The time increment since the block was opened.
+	*/
+	inline u64 Close(u64 _end, const OSMetricsSnapshot& _osMetricsEnd)
+	{
+		u64 increment = _end - start;
+		elapsed += increment;
+		openCount--;
+		if (osMetricsStart.mask)
+		{
+			osMetricsTotal.Accumulate(osMetricsStart, _osMetricsEnd);
+			pageFaultCountTotal += _osMetricsEnd.PageFaultCount() - pageFaultCountStart;
+		}
+		return increment;
+	}
+
+	/*!
+	@brief Update the profiling statistics of the block upon execution.
+	@details Called after ::CaptureOSMetricsStart.
+	@param _byteCount The number of bytes processed by the block.
+	@param _flopCount The number of floating point operations executed by the block.
+	*/
+	inline void Open(u64 _byteCount, u64 _flopCount = 0)
+	{
+		hitCount++;
+		openCount++;
+		processedByteCount += _byteCount;
+		flopCount += _flopCount;
+		start = Timer::GetCPUTimer();
+	}
+
+	/*!
+	@brief Records a value of a counter or a gauge.
+	@param _value The increment of a counter, or the new value of a gauge.
+	*/
+	inline void RecordValue(s64 _value)
+	{
+		minValue = hitCount == 0 || _value < minValue ? _value : minValue;
+		maxValue = hitCount == 0 || _value > maxValue ? _value : maxValue;
+		hitCount++;
+		valueSum += _value;
+		value = kind == RecorderKind_Counter ? value + _value : _value;
+	}
+
+	/*!
+	@brief Resets the values of the block.
+	@remarks There is no difference between this and ::Clear. We are keeping
+			 both for consistency with the other structs.
+	*/
+	PROFILE_API void Reset() noexcept;
+};
+
+/*!
+@brief A mirror of the ProfileBlockRecorder struct to store statistics
+		matching  a profiled block and a few more to help with the reporting.
+*/
+struct ProfileBlockResult
+{
+	/*!
+	@brief The index of the profiling track this block belongs to.
+	@details No equivalent in ProfileBlockRecorder. It is NB_TRACKS or more for
+			 the tracks registered at runtime (see Profile::Profiler::GetTrack).
+	*/
+	u32 trackIdx = 0;
+
+	/*!
+	@brief The index of this block in the profiling track.
+	@details No equivalent in ProfileBlockRecorder.
+	*/
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+
+	/*!
+	@brief The name of the block.
+	@details Mirrors ProfileBlockRecorder::blockName.
+	*/
+	const char* blockName = nullptr;
+
+	/*!
+	@brief The source file the block was registered from.
+	@details Mirrors ProfileBlockRecorder::fileName.
+	*/
+	const char* fileName = nullptr;
+
+	/*!
+	@brief The line the block was registered from.
+	@details Mirrors ProfileBlockRecorder::lineNumber.
+	*/
+	u32 lineNumber = 0;
+
+	/*!
+	@brief The accumulated time the block was executed.
+	@details Mirrors ProfileBlockRecorder::elapsed.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The converted ::elapsed in seconds.
+	@details No equivalent in ProfileBlockRecorder.
+	*/
+	f64 elapsedSec = 0.0;
+
+	/*!
+	@brief The number of times the block was executed.
+	@details Mirrors ProfileBlockRecorder::hitCount.
+	*/
+	u64 hitCount = 0;
+
+	/*!
+	@brief The total number of page faults over all executions of the block.
+	@details Mirrors ProfileBlockRecorder::pageFaultCountTotal.
+	*/
+	u64 pageFaultCountTotal = 0;
+
+	/*!
+	@brief The OS metrics accumulated over all executions of the block.
+	@details Mirrors ProfileBlockRecorder::osMetricsTotal.
+	*/
+	OSMetricsSnapshot osMetricsTotal;
+
+	/*!
+	@brief The number of heap allocations made by the block.
+	@details Mirrors ProfileBlockRecorder::allocationCount.
+	*/
+	u64 allocationCount = 0;
+
+	/*!
+	@brief The number of bytes allocated by the block.
+	@details Mirrors ProfileBlockRecorder::allocatedByteCount.
+	*/
+	u64 allocatedByteCount = 0;
+
+	/*!
+	@brief The number of bytes freed by the block.
+	@details Mirrors ProfileBlockRecorder::freedByteCount.
+	*/
+	u64 freedByteCount = 0;
+
+	/*!
+	@brief The number of bytes processed by the block.
+	@details Mirrors ProfileBlockRecorder::processedByteCount.
+	*/
+	u64 processedByteCount = 0;
+
+	/*!
+	@brief The number of floating point operations executed by the block.
+	@details Mirrors ProfileBlockRecorder::flopCount.
+	*/
+	u64 flopCount = 0;
+
+	/*!
+	@brief Whether the slot is a timed block, a counter or a gauge.
+	@details Mirrors ProfileBlockRecorder::kind.
+	*/
+	RecorderKind kind = RecorderKind_Block;
+
+	/*!
+	@brief Whether the block is keyed.
+	@details Mirrors ProfileBlockRecorder::keyKind.
+	*/
+	BlockKeyKind keyKind = BlockKeyKind_None;
+
+	/*!
+	@brief The key of a keyed block.
+	@details Mirrors ProfileBlockRecorder::key.
+	*/
+	u64 key = 0;
+
+	/*!
+	@brief The name of the key of a keyed block.
+	@details Mirrors ProfileBlockRecorder::keyName.
+	*/
+	const char* keyName = nullptr;
+
+	/*!
+	@brief The total of a counter, or the last value of a gauge.
+	@details Mirrors ProfileBlockRecorder::value.
+	*/
+	s64 value = 0;
+
+	/*!
+	@brief The sum of the values recorded.
+	@details Mirrors ProfileBlockRecorder::valueSum.
+	*/
+	s64 valueSum = 0;
+
+	/*!
+	@brief The minimal value recorded.
+	@details Mirrors ProfileBlockRecorder::minValue.
+	*/
+	s64 minValue = 0;
+
+	/*!
+	@brief The maximal value recorded.
+	@details Mirrors ProfileBlockRecorder::maxValue.
+	*/
+	s64 maxValue = 0;
+
+	/*!
+	@brief The proportion of the block's time in its track's time.
+	@details No equivalent in ProfileBlockRecorder.
+	*/
+	f32 proportionInTrack = 0.f;
+
+	/*!
+	@brief The proportion of the block's time in the total time of the profiler.
+	@details No equivalent in ProfileBlockRecorder.
+	*/
+	f32 proportionInTotal = 0.f;
+
+	/*!
+	@brief The bandwidth in bytes per second.
+	@details No equivalent in ProfileBlockRecorder.
+	*/
+	f32 bandwidthInB = 0.f;
+
+	ProfileBlockResult() = default;
+
+	/*!
+	@brief Captures the statistics of a Profile::ProfileBlockRecorder.
+	@details It will effectively assign or compute the values of all the
+				member variables of this struct.
+	*/
+	PROFILE_API void Capture(ProfileBlockRecorder& _record, u32 _trackIdx,
+				NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _trackElapsedReference, u64 _totalElapsedReference) noexcept;
+
+	/*!
+	@brief Clears the values of the block.
+	@remarks This resets even the ::blockName.
+			 If you are looking to reset the values without changing the name,
+			 use ::Reset.
+
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*!
+	@brief Outputs the profiling statistics of the block.
+	*/
+	PROFILE_API void Report() noexcept;
+
+	/*!
+	@brief Resets the values of this struct.
+	@details Resetting do not change the ::blockName.
+	*/
+	PROFILE_API void Reset() noexcept;
+};
+
+/*!
+@brief A node of a Profile::CallTree: one block reached through one call path.
+*/
+struct CallTreeNode
+{
+	/*!
+	@brief The index of the block in ProfileTrack::timings.
+	*/
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+
+	/*!
+	@brief The index of the node of the enclosing block, or CallTree::rootIdx
+			if the block was opened while no other block of the track was open.
+	*/
+	CALL_NODES_TYPE parentIdx = 0;
+
+	/*!
+	@brief The number of times the block was executed through this path.
+	*/
+	u64 hitCount = 0;
+
+	/*!
+	@brief The accumulated time of the block through this path, including
+			the time of the blocks it encloses.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The time the block was last opened through this path.
+	@details It is the ProfileBlockRecorder::start of the block, so that the
+			 call tree does not read the timer.
+	*/
+	u64 start = 0;
+
+	/*!
+	@brief The number of executions of the block through this path in progress.
+	*/
+	u64 openCount = 0;
+};
+
+/*!
+@brief Aggregates the blocks of a track by call path.
+@details Every combination of a block and the node of its enclosing block is
+		 interned once as a node; the node of the innermost open block is the
+		 ::currentNodeIdx. Finding the node of a block being opened is a lookup
+		 in an open-addressing table of twice as many slots as there can be
+		 nodes, so opening and closing a block stays O(1) on average.
+		 Like the rest of the track, the tree is updated by the thread owning
+		 the track only. The blocks of other tracks do not appear in the paths.
+		 Once NB_CALL_NODES nodes exist, the blocks opened in new paths (and
+		 the blocks they enclose) are not recorded in the tree and counted in
+		 ::droppedCount instead.
+*/
+struct CallTree
+{
+	/*!
+	@brief The index standing for the root of the tree, above the outermost blocks.
+	*/
+	static constexpr CALL_NODES_TYPE rootIdx = NB_CALL_NODES;
+
+	/*!
+	@brief The number of slots of ::table.
+	*/
+	static constexpr u64 tableSize = std::bit_ceil((u64)2 * NB_CALL_NODES);
+
+	/*!
+	@brief The number of nodes in ::nodes.
+	*/
+	CALL_NODES_TYPE nodeCount = 0;
+
+	/*!
+	@brief The node of the innermost open block, or ::rootIdx if none is open.
+	*/
+	CALL_NODES_TYPE currentNodeIdx = rootIdx;
+
+	/*!
+	@brief The number of open blocks that could not be recorded because the
+			tree is full.
+	*/
+	u32 droppedDepth = 0;
+
+	/*!
+	@brief The number of executions of blocks that could not be recorded
+			because the tree is full.
+	*/
+	u64 droppedCount = 0;
+
+	/*!
+	@brief The nodes of the tree, in the order they were first reached.
+	@details A node is always after its parent.
+	*/
+	std::array<CallTreeNode, NB_CALL_NODES> nodes;
+
+	/*!
+	@brief The open-addressing table mapping a parent node and a block to their
+			node. A slot holds the index of the node + 1, or 0 when empty.
+	*/
+	std::array<CALL_NODES_TYPE, tableSize> table = {};
+
+	/*!
+	@brief Records the opening of a block under the innermost open one.
+	@param _profileBlockRecorderIdx The index of the block in the track.
+	@param _start The time the block was opened.
+	*/
+	inline void Enter(NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _start) noexcept
+	{
+		if (droppedDepth)
+		{
+			droppedDepth++;
+			droppedCount++;
+			return;
+		}
+
+		u64 slot = (((u64)currentNodeIdx << 16 | _profileBlockRecorderIdx) * 0x9E3779B97F4A7C15ull >> 40) & (tableSize - 1);
+		CALL_NODES_TYPE nodeIdx;
+		while (true)
+		{
+			CALL_NODES_TYPE entry = table[slot];
+			if (entry == 0)
+			{
+				if (nodeCount == NB_CALL_NODES)
+				{
+					droppedDepth = 1;
+					droppedCount++;
+					return;
+				}
+				nodeIdx = nodeCount++;
+				table[slot] = nodeIdx + 1;
+				nodes[nodeIdx].profileBlockRecorderIdx = _profileBlockRecorderIdx;
+				nodes[nodeIdx].parentIdx = currentNodeIdx;
+				break;
+			}
+			const CallTreeNode& node = nodes[entry - 1];
+			if (node.parentIdx == currentNodeIdx && node.profileBlockRecorderIdx == _profileBlockRecorderIdx)
+			{
+				nodeIdx = entry - 1;
+				break;
+			}
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		CallTreeNode& node = nodes[nodeIdx];
+		node.hitCount++;
+		node.openCount++;
+		node.start = _start;
+		currentNodeIdx = nodeIdx;
+	}
+
+	/*!
+	@brief Records the closing of the innermost open block.
+	@param _increment The time the block was open.
+	*/
+	inline void Exit(u64 _increment) noexcept
+	{
+		if (droppedDepth)
+		{
+			droppedDepth--;
+			return;
+		}
+		if (currentNodeIdx == rootIdx)
+		{
+			return;
+		}
+
+		CallTreeNode& node = nodes[currentNodeIdx];
+		node.elapsed += _increment;
+		node.openCount--;
+		currentNodeIdx = node.parentIdx;
+	}
+
+	/*!
+	@brief Returns the time of a node not spent in the blocks it encloses.
+	*/
+	PROFILE_API u64 GetSelfElapsed(CALL_NODES_TYPE _nodeIdx) const noexcept;
+
+	/*!
+	@brief Prints the tree indented by depth, the children of a node sorted
+			by decreasing elapsed time.
+	@param _timings The blocks of the track the tree belongs to, for their names.
+	@param _trackElapsed The elapsed time of the track, for the proportions.
+	*/
+	PROFILE_API void Report(const std::array<ProfileBlockRecorder, NB_TIMINGS>& _timings, u64 _trackElapsed) const;
+
+	/*!
+	@brief Writes one line per node in Brendan Gregg's folded stacks format
+			("Root;Parent;Block value"), as read by flamegraph.pl and speedscope.
+	@details The value of a node is its self time in nanoseconds.
+	@param _file The file to write to.
+	@param _rootName The name of the first frame of every stack (e.g., the
+			name of the track), or nullptr for none.
+	@param _timings The blocks of the track the tree belongs to, for their names.
+	*/
+	PROFILE_API void WriteFoldedStacks(FILE* _file, const char* _rootName, const std::array<ProfileBlockRecorder, NB_TIMINGS>& _timings) const;
+
+	/*!
+	@brief Zeroes the statistics of the nodes, keeping the paths and the open blocks.
+	*/
+	PROFILE_API void Reset() noexcept;
+
+	/*!
+	@brief Removes all the nodes.
+	*/
+	PROFILE_API void Clear() noexcept;
+};
+
+/*!
+@brief A container for several profiling blocks.
+@details The goal is to profile a series of blocks that are related to each other.
+*/
+struct ProfileTrack
+{
+	/*!
+	@brief Whether the track is used for at least one block.
+	@details This is might be set to true only once a block is added to the track.
+			 This is used to avoid outputting the track's statistics, or reseting its data
+			 if it has none.
+	@see Profile::Profiler::GetProfileBlockRecorderIndex(...)
+	*/
+	bool hasBlock = false;
+
+	/*!
+	@brief The name of the track.
+	*/
+	char name[PROFILE_TRACK_NAME_LENGTH] = {0};
+
+	/*!
+	@brief The accumulated time from all blocks in the track.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The sequence number of the seqlock protecting the track from the
+			concurrent captures.
+	@details It is odd while the thread owning the track updates a block. It
+			 is only accessed through std::atomic_ref so that the track stays
+			 trivially copyable.
+	@see ::BeginUpdate, ::EndUpdate, ::CaptureConsistent
+	*/
+	alignas(std::atomic_ref<u64>::required_alignment) u64 sequence = 0;
+
+	/*!
+	@brief The profiling statistics of the blocks in the track.
+	*/
+	std::array<ProfileBlockRecorder, NB_TIMINGS> timings;
+
+	/*!
+	@brief The number of indices in ::usedTimings.
+	*/
+	IT_TIMINGS_TYPE usedTimingCount = 0;
+
+	/*!
+	@brief The indices of the ::timings named after a block, a counter or a
+			gauge, in the order they were named.
+	@details A slot is named before it first records in the track and keeps
+			 its name when the track is cleared, so the readers of the track
+			 (e.g., ::CaptureConsistent or Profile::FrameProfiler) only visit
+			 these slots.
+	*/
+	std::array<NB_TIMINGS_TYPE, NB_TIMINGS> usedTimings;
+
+	/*!
+	@brief The statistics of the blocks in the track by call path.
+	*/
+	CallTree callTree;
+
+	/*!
+	@brief Marks the start of an update of the track by its owning thread.
+	@details Costs two plain stores and a compiler barrier on x86.
+	*/
+	inline void BeginUpdate() noexcept
+	{
+		std::atomic_ref<u64> sequenceRef(sequence);
+		sequenceRef.store(sequenceRef.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	/*!
+	@brief Marks the end of an update started with ::BeginUpdate.
+	*/
+	inline void EndUpdate() noexcept
+	{
+		std::atomic_ref<u64> sequenceRef(sequence);
+		sequenceRef.store(sequenceRef.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/*!
+	@brief Appends a slot of ::timings that was just named to ::usedTimings.
+	@details Must be called during an update (see ::BeginUpdate), along with
+			 the naming of the slot.
+	@param _profileBlockRecorderIdx The index of the slot.
+	*/
+	inline void AddUsedTiming(NB_TIMINGS_TYPE _profileBlockRecorderIdx) noexcept
+	{
+		if (usedTimingCount < NB_TIMINGS)
+		{
+			usedTimings[usedTimingCount++] = _profileBlockRecorderIdx;
+		}
+	}
+
+	/*!
+	@brief Copies the track while its owning thread may keep opening and
+			closing blocks.
+	@details Can be called from any thread. The copy is retried until it does
+			 not overlap an update of the track. The blocks still open in the
+			 copy get the time elapsed since they opened added to their
+			 ::elapsed (and to the ::elapsed of the copied track), as if they
+			 closed at the time of the copy; their OS metrics are the ones of
+			 their previous executions.
+			 Only the ::usedTimings and the call tree nodes are copied, the
+			 other slots are left cleared. The table of the call tree is not
+			 copied: the copy is meant to be read, not to record blocks.
+	@param _copy Receives the copy.
+	@param _maxRetryCount The maximal number of attempts.
+	@return Whether a consistent copy was taken.
+	*/
+	PROFILE_API bool CaptureConsistent(ProfileTrack& _copy, u32 _maxRetryCount = 1000) const noexcept;
+
+	/*
+	@brief Clears the values of the track and its blocks.
+	@remarks This resets even the ::name and ::elapsed.
+			 If you are looking to reset the values without changing the name,
+			 use ::Reset.
+			 If you are looking to reset the timings only, use ::ResetTimings.
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*
+	@brief Clears the values of all blocks in ::timings.
+	@remarks This also resets ::hasBlock to false.
+	*/
+	PROFILE_API void ClearTimings() noexcept;
+
+	/*!
+	@brief Closes a block and updates the track's elapsed time.
+	@param _profileBlockRecorderIdx The index of block timing in the track.
+	@see Profile::ProfileBlockRecorder::Close()
+	*/
+	PROFILE_API inline void CloseBlock(NB_TIMINGS_TYPE _profileBlockRecorderIdx)
+	{
+		ProfileBlockRecorder& record = timings[_profileBlockRecorderIdx];
+		u64 end = Timer::GetCPUTimer();
+		OSMetricsSnapshot osMetricsEnd;
+		record.CaptureOSMetricsEnd(osMetricsEnd);
+
+		BeginUpdate();
+		u64 increment = record.Close(end, osMetricsEnd);
+		elapsed += increment;
+		callTree.Exit(increment);
+		EndUpdate();
+	}
+
+	/*!
+	@brief Gets the index of the statistics of a block in ::timings, registering
+			the block in a free slot if it has none yet.
+	@details Used by the blocks of the tracks registered at runtime, which cannot
+			 cache their index at the call site. The block is identified by its
+			 file name and line number, and found in O(1) when it sits in its
+			 preferred slot. Called by the thread owning the track only.
+	@param _preferredRecorderIdx The slot to try first (the hash of the call site).
+	@param _blockName The name of the block.
+	@param _fileName The name of the file where the block is located.
+	@param _lineNumber The line number in the file where the block is located.
+	@return The index of the block, or _preferredRecorderIdx if ::timings is full.
+	*/
+	inline NB_TIMINGS_TYPE GetBlockRecorderIndex(NB_TIMINGS_TYPE _preferredRecorderIdx, const char* _blockName,
+		const char* _fileName, u32 _lineNumber) noexcept
+	{
+		const ProfileBlockRecorder& record = timings[_preferredRecorderIdx];
+		if (record.lineNumber == _lineNumber && record.fileName == _fileName)
+		{
+			return _preferredRecorderIdx;
+		}
+		return RegisterBlockRecorder(_preferredRecorderIdx, _blockName, _fileName, _lineNumber);
+	}
+
+	/*!
+	@brief Opens a block of the track.
+	@param _profileBlockRecorderIdx The index of the block timing in the track.
+	@param _byteCount The number of bytes processed by the block.
+	@param _flopCount The number of floating point operations executed by the block.
+	@see Profile::ProfileBlockRecorder::Open(Profile::u64 _byteCount, Profile::u64 _flopCount)
+	*/
+	PROFILE_API inline void OpenBlock(NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount, u64 _flopCount = 0)
+	{
+		ProfileBlockRecorder& record = timings[_profileBlockRecorderIdx];
+		record.CaptureOSMetricsStart();
+
+		BeginUpdate();
+		record.Open(_byteCount, _flopCount);
+		callTree.Enter(_profileBlockRecorderIdx, record.start);
+		EndUpdate();
+	}
+
+	/*!
+	@brief The slow path of ::GetBlockRecorderIndex: probes ::timings from the
+			preferred slot for the block, or a free slot to register it in.
+	*/
+	PROFILE_API NB_TIMINGS_TYPE RegisterBlockRecorder(NB_TIMINGS_TYPE _preferredRecorderIdx, const char* _blockName,
+		const char* _fileName, u32 _lineNumber) noexcept;
+
+	/*!
+	@brief Records a value of a counter or a gauge of the track.
+	@param _profileBlockRecorderIdx The index of the counter or gauge in the track.
+	@param _value The increment of a counter, or the new value of a gauge.
+	@see Profile::ProfileBlockRecorder::RecordValue
+	*/
+	PROFILE_API inline void RecordValue(NB_TIMINGS_TYPE _profileBlockRecorderIdx, s64 _value)
+	{
+		BeginUpdate();
+		timings[_profileBlockRecorderIdx].RecordValue(_value);
+		EndUpdate();
+	}
+
+	/*!
+	@brief Outputs the profiling statistics of all blocks in the track.
+	*/
+	PROFILE_API void Report(u64 _totalElapsedReference) noexcept;
+
+	/*!
+	@brief Resets the values of the track and its blocks.
+	@details Resetting do not change the names.
+	@see ::ResetTimings
+	*/
+	PROFILE_API void Reset() noexcept;
+
+	/*!
+	@brief Resets the values of all blocks in the track that have a name.
+	@details Resetting do not change the names.
+	*/
+	PROFILE_API void ResetTimings() noexcept;
+};
+
+/*!
+@brief A mirror of the ProfileTrack struct to store statistics matching a profiled
+		track and the blocks it contains (thanks to Profile::ProfileBlockResult).
+@details In this mirror, the blocks are packed at the beginning of the array to
+		avoid having to iterate over all the blocks that might not have been used.
+		The number of blocks used in the track is stored in ::blockCount.
+*/
+struct ProfileTrackResult
+{
+	/*!
+	@brief The name of the track.
+	@details Mirrors ProfileTrack::name.
+	*/
+	const char* name = nullptr;
+
+	/*!
+	@brief The accumulated time from all blocks in the track.
+	@details Mirrors ProfileTrack::elapsed.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The converted ::elapsed in seconds.
+	@details No equivalent in ProfileTrack.
+	*/
+	f64 elapsedSec = 0.0;
+
+	/*!
+	@brief The proportion of the track's time in the total time of the profiler.
+	@details No equivalent in ProfileTrack.
+	*/
+	f64 proportionInTotal = 0.0;
+
+	/*!
+	@brief The number of blocks used in the track.
+	*/
+	NB_TIMINGS_TYPE blockCount = 0;
+
+	/*!
+	@brief The array of mirrors to the Profile::ProfileBlockRecorder structs originally
+			stored in the track.
+	@details The mirrored blocks are packed at the beginning of the array to
+			avoid having to iterate over all the blocks that might not have
+			been used.
+	*/
+	std::array<ProfileBlockResult, NB_TIMINGS> timings;
+
+	/*!
+	@brief The mirror of the ProfileTrack::callTree of the track.
+	@details Only the nodes are mirrored, not the lookup table, and the
+			 CallTreeNode::profileBlockRecorderIdx of a node is the index of
+			 its block in ::timings rather than in the track.
+	*/
+	CallTree callTree;
+
+	ProfileTrackResult() = default;
+
+	/*!
+	@brief Captures the statistics of a Profile::ProfileTrack.
+	@details It will effectively assign or compute the values of all the
+			 member variables of this struct. In particular, it will fill the
+			 ::timings array with the statistics of the Profile::ProfileBlockRecorders
+			 of the track that have been used, and ::callTree with its call paths.
+	*/
+	PROFILE_API void Capture(ProfileTrack& _track, u64 _trackIdx, u64 _totalElapsedReference) noexcept;
+
+	/*!
+	@brief Clears the values of member variables of this struct and up to
+			::blockCount Profile::ProfileBlockResults in the ::timings array.
+	@remarks This resets even the ::name. 
+			 If you are looking to reset the values without changing the name,
+			 use ::Reset.
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*!
+	@brief Outputs the profiling statistics of the track.
+	*/
+	PROFILE_API void Report() noexcept;
+
+	/*!
+	@brief Resets the values of member variables of this struct and up to
+			::blockCount Profile::ProfileBlockResults in the ::timings array.
+	@details Resetting do not change the name.
+	*/
+	PROFILE_API void Reset() noexcept;
+};
+
+/*!
+@brief The tracks registered at runtime in a profiler (see Profile::Profiler::RegisterTrack).
+@details The tracks are allocated by chunks of ::chunkSize when needed, and a
+		 chunk never moves: a track keeps its address while other tracks are
+		 registered, so it can be reached without a lock. The pointer of a
+		 chunk is written before ::count is published, so ::Get is safe to
+		 call from any thread. Copying copies the tracks, like the copy of the
+		 static Profile::Profiler::tracks.
+*/
+struct DynamicTracks
+{
+	/*!
+	@brief The number of tracks per chunk.
+	*/
+	static constexpr u32 chunkSize = 8;
+
+	/*!
+	@brief The maximal number of chunks.
+	*/
+	static constexpr u32 chunkCount = (NB_DYNAMIC_TRACKS + chunkSize - 1) / chunkSize;
+
+	/*!
+	@brief The chunks of tracks; the ones after the last track are nullptr.
+	*/
+	std::array<ProfileTrack*, chunkCount> chunks = {};
+
+	/*!
+	@brief The number of tracks registered.
+	*/
+	std::atomic<u32> count = 0;
+
+	DynamicTracks() = default;
+	PROFILE_API DynamicTracks(const DynamicTracks& _other);
+	PROFILE_API DynamicTracks& operator=(const DynamicTracks& _other);
+	PROFILE_API ~DynamicTracks();
+
+	/*!
+	@brief Adds a track.
+	@details The calls must not be concurrent (see Profile::Profiler::RegisterTrack).
+	@return The new track, or nullptr if NB_DYNAMIC_TRACKS tracks already exist.
+	*/
+	PROFILE_API ProfileTrack* Add();
+
+	/*!
+	@brief Gets a track.
+	@param _idx The index of the track among the dynamic tracks.
+	@return The track, or nullptr if it does not exist.
+	*/
+	inline ProfileTrack* Get(u32 _idx) const noexcept
+	{
+		return _idx < count.load(std::memory_order_acquire) ? &chunks[_idx / chunkSize][_idx % chunkSize] : nullptr;
+	}
+
+	/*!
+	@brief Gets the number of tracks registered.
+	*/
+	inline u32 GetCount() const noexcept
+	{
+		return count.load(std::memory_order_acquire);
+	}
+};
+
+/*!
+@brief A struct to manage the profiling of a program.
+*/
+struct Profiler
+{
+	/*!
+	@brief The name of the profiler.
+	*/
+	char name[PROFILER_NAME_LENGTH] = { 0 };
+
+	/*!
+	@brief The time when the profiler was initialized (when ::Initialize
+			was called).
+	*/
+	u64 start = 0;
+
+	/*!
+	@brief The time since the profiler was initialized.
+	@details This is updated only when ::End is called.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The tracks in the profiler.
+	*/
+	std::array<ProfileTrack, NB_TRACKS> tracks;
+
+	/*!
+	@brief The tracks registered at runtime, after ::tracks.
+	@see ::RegisterTrack, ::GetTrack
+	*/
+	DynamicTracks dynamicTracks;
+
+	/*!
+	@brief The statistics of the spans of the coroutines (see Profile::ProfileSpan).
+	@details Shared by all the threads, unlike the tracks.
+	*/
+	std::array<SpanRecorder, NB_SPANS> spans;
+
+	Profiler() = default;
+
+	/*!
+	@brief Gets an index for a profile result.
+	@details The index is determined by the hash of the file name and line number.
+			 The slot is claimed for the call site in all the profilers, so the
+			 index is valid in any of them.
+	@param _trackIdx The index of the track the profile result belongs to.
+	@param _fileName The name of the file where the block is located.
+	@param _lineNumber The line number in the file where the block is located.
+	@param _blockName The name of the block.
+	@return The index of the profile result.
+	*/
+	PROFILE_API static NB_TIMINGS_TYPE GetProfileBlockRecorderIndex(NB_TRACKS_TYPE _trackIdx, const char* _fileName, u32 _lineNumber, const char* _blockName);
+
+	/*!
+	@brief Gets an index for the statistics of a span in ::spans.
+	@details The index is determined by the hash of the file name and line
+			 number. Safe to call concurrently from several threads.
+	@param _fileName The name of the file where the span is located.
+	@param _lineNumber The line number in the file where the span is located.
+	@param _spanName The name of the span.
+	@return The index of the statistics of the span.
+	*/
+	PROFILE_API static u32 GetSpanRecorderIndex(const char* _fileName, u32 _lineNumber, const char* _spanName);
+
+	/*!
+	@brief Gets a track, static or registered at runtime.
+	@param _trackIdx The index of the track: less than NB_TRACKS for the tracks
+			in ::tracks, and NB_TRACKS or more for the ones in ::dynamicTracks.
+	@return The track, or nullptr if it does not exist.
+	*/
+	inline ProfileTrack* GetTrack(u32 _trackIdx) noexcept
+	{
+		return _trackIdx < NB_TRACKS ? &tracks[_trackIdx] : dynamicTracks.Get(_trackIdx - NB_TRACKS);
+	}
+
+	inline const ProfileTrack* GetTrack(u32 _trackIdx) const noexcept
+	{
+		return _trackIdx < NB_TRACKS ? &tracks[_trackIdx] : dynamicTracks.Get(_trackIdx - NB_TRACKS);
+	}
+
+	/*!
+	@brief Gets the number of tracks, static and registered at runtime.
+	@details The tracks can be iterated with ::GetTrack up to this number.
+	*/
+	inline u32 GetTrackCount() const noexcept
+	{
+		return NB_TRACKS + dynamicTracks.GetCount();
+	}
+
+	/*!
+	@brief Gets an index for a counter or a gauge.
+	@details Unlike the blocks, the index is determined by the hash of the name,
+			 so that all the call sites using the same name share the counter.
+	@param _trackIdx The index of the track the counter belongs to.
+	@param _fileName The name of the file where the counter is first used.
+	@param _lineNumber The line number in the file where the counter is first used.
+	@param _name The name of the counter.
+	@param _kind RecorderKind_Counter or RecorderKind_Gauge.
+	@return The index of the counter in the track.
+	*/
+	PROFILE_API static NB_TIMINGS_TYPE GetValueRecorderIndex(NB_TRACKS_TYPE _trackIdx, const char* _fileName, u32 _lineNumber, const char* _name, RecorderKind _kind);
+
+	/*!
+	@brief Gets the index for a key of a keyed block, registering the key in
+			its call site if it has none yet.
+	@details The slow path of Profile::BlockKeySite::FindRecorderIndex. The key
+			 is given the overflow slot of the call site once NB_BLOCK_KEYS
+			 keys are registered.
+	@param _trackIdx The index of the track the block belongs to.
+	@param _site The call site of the block.
+	@param _key The key.
+	@param _keyName The name of the key if it is an interned string, nullptr otherwise.
+	@return The index of the key in the track.
+	*/
+	PROFILE_API static NB_TIMINGS_TYPE GetKeyedBlockRecorderIndex(NB_TRACKS_TYPE _trackIdx, BlockKeySite& _site, u64 _key, const char* _keyName);
+
+	/*!
+	@brief Sets the name of the profiler.
+	@param _name The name of the profiler.
+	*/
+	PROFILE_API inline void SetProfilerName(const char* _name) noexcept
+	{
+		SetProfilerNameFmt(_name);
+	}
+
+	PROFILE_API void SetProfilerNameFmt(const char* _fmt, ...);
+
+	/*!
+	@brief Sets the name of a track.
+	@param _trackIdx The index of the track.
+	@param _name The name of the track.
+	@remarks The name will be truncated if it is longer than 31 characters.
+	*/
+	PROFILE_API inline void SetTrackName(NB_TRACKS_TYPE _trackIdx, const char* _name) noexcept
+	{
+		if (_trackIdx < NB_TRACKS)
+		{
+			SetTrackNameFmt(_trackIdx, _name);
+		}
+	}
+	
+	/*!
+	@brief Sets the name of a track with a format string.
+	@param _trackIdx The index of the track.
+	@param _fmt The format string of the name of the track.
+	@param ... The arguments to the format string.
+	@remarks The name will be truncated if it is longer than 31 characters.
+	*/
+	PROFILE_API void SetTrackNameFmt(NB_TRACKS_TYPE _trackIdx, const char* _fmt, ...);
+
+	/*!
+	@brief Clears the profiler's values as well as all its initialized tracks.
+	@remarks This resets even the ::name.
+			 If you are looking to reset the values without changing the name,
+			 use ::Reset.
+			 If you are looking to reset the tracks only, use ::ClearTracks.
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*!
+	@brief Clears all used blocks of all used tracks in the profiler.
+	@remarks If you are looking to reset the values without changing the names,
+			 use ::ResetTracks.
+	*/
+	PROFILE_API void ClearTracks() noexcept;
+
+	/*!
+	@brief Closes a block.
+	@param _trackIdx The index of the track the block belongs to.
+	@param _profileBlockRecorderIdx The index of the profile result.
+	*/
+	PROFILE_API inline void CloseBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx)
+	{
+		tracks[_trackIdx].CloseBlock(_profileBlockRecorderIdx);
+	}
+
+	/*!
+	@brief Ends the profiler.
+	@details Sets ::elapsed to the time since ::Initialize was called.
+	*/
+	PROFILE_API void End() noexcept;
+
+	/*!
+	@brief Exports the call trees of all the used tracks in Brendan Gregg's
+			folded stacks format, to draw flame graphs with flamegraph.pl or
+			speedscope.
+	@details The first frame of every stack is the name of its track and the
+			 values are the self times of the blocks in nanoseconds. The logic
+			 to create the directories where the file is stored MUST be handled
+			 outside before calling this function.
+	@param _path The path of the file.
+	@see Profile::CallTree::WriteFoldedStacks
+	*/
+	PROFILE_API void ExportFoldedStacks(const char* _path) noexcept;
+
+	/*!
+	@brief Exports the most recent asynchronous spans of the profiler (see
+			Profile::BeginAsyncSpan) as a timeline in the Chrome trace event
+			format, to open in Perfetto or chrome://tracing.
+	@details Every span is an async slice from its beginning to its end, with a
+			 flow linking the thread it began on to the one it ended on. Only the
+			 last NB_ASYNC_SPAN_EVENTS spans that ended are kept. The blocks of
+			 the tail captures of the profiler (see Profile::TailCaptureScope)
+			 are added as slices on the thread they were executed by. The times are
+			 in microseconds since ::start. The logic to create the directories
+			 where the file is stored MUST be handled outside before calling
+			 this function.
+	@param _path The path of the JSON file.
+	*/
+	PROFILE_API void ExportTimeline(const char* _path) noexcept;
+	
+	/*!
+	@brief Exports the profiling statistics of the profiler to a CSV file.
+	@details The logic to create the directories where the file is stored MUST be handled outside
+			 before calling this function. The file will be overwritten if it already exists.
+			 The file starts with two lines giving the headers for statistics of the profiler
+			 followed by the associated numbers. Then, a line defines new headers for the
+			 statistics of the blocks in the tracks. The following lines give the statistics
+			 of the blocks in the tracks. The statistics of the blocks are ordered by the
+			 order of the tracks in the profiler, and then by the order of the blocks in the tracks.
+	@param _path The path of the CSV file.
+	*/
+	PROFILE_API void ExportToCSV(const char* _path) noexcept;
+
+	/*!
+	@brief Starts the profiler.
+	@details Sets ::start to the current time.
+	*/
+	PROFILE_API void Initialize() noexcept;
+
+	/*!
+	@brief Opens a block.
+	@param _trackIdx The index of the track the block belongs to.
+	@param _profileBlockRecorderIdx The index of the profile result.
+	@param _byteCount The number of bytes processed by the block.
+	@param _flopCount The number of floating point operations executed by the block.
+	*/
+	PROFILE_API inline void OpenBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount, u64 _flopCount = 0)
+	{
+		//The track is used if a block is added.
+		//This is used to avoid outputting the track's statistics, or reseting its data if it has none.
+		//But it is a WRITE operation wasted for every time that is not the first time.
+		tracks[_trackIdx].hasBlock = true;
+
+		tracks[_trackIdx].OpenBlock(_profileBlockRecorderIdx, _byteCount, _flopCount);
+	}
+
+	/*!
+	@brief Registers a track at runtime, beyond the NB_TRACKS static ones.
+	@details Meant for the tracks whose number is only known at runtime (e.g.,
+			 one per worker of a pool). The blocks of the track are profiled with
+			 PROFILE_BLOCK_TIME_IN_TRACK and the likes, which take the returned
+			 handle, and appear in the reports and the exports like the others.
+			 Registering a name twice returns the same track. Safe to call from
+			 several threads, but it takes a lock: register the tracks up front,
+			 not on the hot path. Like the static tracks, a track must only be
+			 profiled by one thread at a time. The tracks only follow the global
+			 switch of Profile::RuntimeSwitch.
+	@param _name The name of the track. It is truncated if it does not fit in
+			PROFILE_TRACK_NAME_LENGTH characters.
+	@return The handle of the track, invalid if NB_DYNAMIC_TRACKS tracks were
+			already registered.
+	*/
+	PROFILE_API TrackHandle RegisterTrack(const char* _name);
+
+	/*!
+	@brief Outputs the profiling statistics of all tracks in the profiler.
+	*/
+	PROFILE_API void Report() noexcept;
+
+	/*!
+	@brief Outputs the call trees of all the used tracks: every block is
+			reported once per call path it was reached through.
+	@see Profile::CallTree::Report
+	*/
+	PROFILE_API void ReportCallTree() noexcept;
+
+	/*!
+	@brief Outputs the statistics of the spans that ended at least once:
+			their active and suspended times and the percentiles of their durations.
+	*/
+	PROFILE_API void ReportSpans() noexcept;
+
+	/*!
+	@brief Outputs the tail captures of the profiler (see Profile::TailCaptureScope):
+			for every capture, the duration of the watched block and the blocks
+			executed during it by decreasing time.
+	*/
+	PROFILE_API void ReportTailCaptures() noexcept;
+
+	/*!
+	@brief Resets the profiler's values as well as all its initialized tracks.
+	@details Resetting do not change the names.
+	*/
+	PROFILE_API void Reset() noexcept;
+
+	/*!
+	@brief Resets the values of all blocks in all tracks that have a name.
+	@details Resetting do not change the names.
+	*/
+	PROFILE_API void ResetTracks() noexcept;
+};
+
+/*!
+@brief A global function to set the pointer to the global profiler.
+*/
+extern PROFILE_API void SetProfiler(Profiler* _profiler);
+
+/*!
+@brief A global function to get the pointer to the profiler of the current thread.
+@details This is the profiler set with ::SetThreadProfiler on the current thread,
+		 or the global profiler set with ::SetProfiler otherwise. The profiler must
+		 be set with either before calling this function.
+@remarks Mainly useful to get the profiler in functions defined in the header, given
+		 that the profiler is defined in the source file.
+@return The pointer to the profiler of the current thread.
+*/
+extern PROFILE_API Profiler* GetProfiler();
+
+/*!
+@brief A global function to set the pointer to the profiler of the current thread.
+@details Blocks opened on the current thread are recorded in this profiler instead
+		 of the global one. Passing nullptr makes the thread use the global profiler
+		 again.
+@remarks The block indices are cached per call site and shared by all the
+		 profilers: any profiler, including one created after the blocks were
+		 first executed, records a block in the same slot.
+@see Profile::ProfilerScope
+*/
+extern PROFILE_API void SetThreadProfiler(Profiler* _profiler);
+
+/*!
+@brief A global function to get the profiler set on the current thread with
+		::SetThreadProfiler or a Profile::ProfilerScope.
+@return The profiler of the current thread, or nullptr if the thread uses the
+		global one.
+*/
+extern PROFILE_API Profiler* GetThreadProfiler();
+
+/*!
+@brief Records the blocks of the current thread in a profiler for the lifetime
+		of the scope, then restores the profiler the thread used before.
+@details Allows independent profiling sessions in one program (e.g., one
+		 profiler per tenant, or a microbenchmark nested in a profiled
+		 application). The scopes can be nested. Opening a block reads the
+		 profiler of the thread once, so binding one costs nothing more.
+*/
+struct ProfilerScope
+{
+	/*!
+	@brief The profiler of the thread before the scope, nullptr for the global one.
+	*/
+	Profiler* ptr_previousProfiler = nullptr;
+
+	/*!
+	@brief Binds a profiler to the current thread.
+	@param _profiler The profiler to record the blocks in. nullptr makes the
+			thread use the global profiler.
+	*/
+	PROFILE_API explicit ProfilerScope(Profiler* _profiler) noexcept;
+	ProfilerScope(const ProfilerScope&) = delete;
+	ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+	/*!
+	@brief Binds the previous profiler to the current thread again.
+	*/
+	PROFILE_API ~ProfilerScope() noexcept;
+};
+
+/*!
+@brief Attributes a heap allocation to the innermost open block of the current thread.
+@details Called by the allocation hooks (see AllocationHooks.cpp) when
+		 PROFILER_TRACK_ALLOCATIONS is enabled. Does nothing if no block is open
+		 on the current thread. It never allocates itself.
+@param _byteCount The number of bytes allocated, as reported by the allocator.
+*/
+extern PROFILE_API void RecordAllocation(u64 _byteCount) noexcept;
+
+/*!
+@brief Attributes a heap deallocation to the innermost open block of the current thread.
+@details Called by the allocation hooks (see AllocationHooks.cpp) when
+		 PROFILER_TRACK_ALLOCATIONS is enabled. Does nothing if no block is open
+		 on the current thread.
+@param _byteCount The number of bytes released, as reported by the allocator.
+*/
+extern PROFILE_API void RecordDeallocation(u64 _byteCount) noexcept;
+
+/*!
+@brief Records a value of a counter or a gauge in the profiler of the current thread.
+@details Called by PROFILE_COUNTER_ADD and PROFILE_GAUGE_SET. Like the blocks,
+		 it only writes in the track of the calling thread, without atomic
+		 read-modify-write operations.
+@param _trackIdx The index of the track of the counter.
+@param _profileBlockRecorderIdx The index of the counter in the track.
+@param _value The increment of a counter, or the new value of a gauge.
+*/
+extern PROFILE_API void RecordValue(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, s64 _value) noexcept;
+
+/*!
+@brief A mirror of the Profiler struct to store all the statistics of a profiler
+		and the tracks it contains (thanks to Profile::ProfileTrackResult).
+@details In this mirror, the tracks are packed at the beginning of the array to
+		avoid having to iterate over all the tracks that might not have been used.
+*/
+struct ProfilerResults
+{
+	/*!
+	@brief The name of the profiler.
+	@details Mirrors Profiler::name.
+	*/
+	const char* name = nullptr;
+
+	/*!
+	@brief The time between the initialization (when Profiler::Initialize was called)
+			and the end (when Profiler::End was called).
+	@details Mirrors Profiler::elapsed.
+	*/
+	u64 elapsed = 0;
+
+	/*!
+	@brief The converted ::elapsed in seconds.
+	@details No equivalent in Profile::Profiler.
+	*/
+	f64 elapsedSec = 0.0;
+
+	/*!
+	@brief The number of tracks used in the profiler (i.e, which have at least
+			one used block).
+	@details No equivalent in Profile::Profiler.
+	*/
+	u32 trackCount = 0;
+
+	/*!
+	@brief The array of mirrors to the Profile::ProfileTrack structs originally
+			stored in the profiler.
+	@details The mirrored tracks are packed at the beginning of the array to
+			avoid having to iterate over all the tracks that might not have
+			been used. It holds NB_TRACKS tracks and only grows to capture the
+			tracks registered at runtime (see ::ReserveTracks).
+	*/
+	std::vector<ProfileTrackResult> tracks = std::vector<ProfileTrackResult>(NB_TRACKS);
+
+	ProfilerResults() = default;
+
+	/*!
+	@brief Captures the statistics of a Profile::Profiler.
+	@details It will effectively assign or compute the values of all the
+			 member variables of this struct. In particular, it will fill the
+			 ::tracks array with the statistics of the Profile::ProfileTracks
+			 of the profiler that have been used.
+	*/
+	PROFILE_API void Capture(Profiler* _profiler) noexcept;
+
+	/*!
+	@brief Captures the statistics of a Profile::Profiler while its threads
+			keep profiling.
+	@details Unlike ::Capture, it can be called from any thread at any time:
+			 every track is copied with Profile::ProfileTrack::CaptureConsistent,
+			 so the statistics of a track are consistent with each other, and
+			 the blocks still open are accounted up to the time of the capture.
+			 The total elapsed time is the time since the profiler was initialized.
+			 The tracks are copied one after the other, so two tracks may be a
+			 few microseconds apart.
+	@param _profiler The profiler to capture.
+	@param _maxRetryCount The maximal number of attempts per track.
+	@return Whether all the tracks were copied consistently. The tracks that
+			could not be are captured from their last attempt.
+	*/
+	PROFILE_API bool CaptureLive(const Profiler* _profiler, u32 _maxRetryCount = 1000) noexcept;
+
+	/*!
+	@brief Clears the values of member variables of this struct and up to
+			::trackCount Profile::ProfileTrackResults in the ::tracks array.
+	@remarks This resets even the ::name.
+			 If you are looking to reset the values without changing the name,
+			 use ::Reset.
+	*/
+	PROFILE_API void Clear() noexcept;
+
+	/*!
+	@brief Exports the profiling statistics of the profiler to a CSV file.
+	@details The logic to create the directories where the file is stored MUST be handled outside
+			 before calling this function. The file will be overwritten if it already exists.
+			 The file starts with two lines giving the headers for statistics of the profiler
+			 followed by the associated numbers. Then, a line defines new headers for the
+			 statistics of the blocks in the tracks. The following lines give the statistics
+			 of the blocks in the tracks. The statistics of the blocks are ordered by the
+			 order of the tracks in the profiler, and then by the order of the blocks in the tracks.
+	@param _path The path of the CSV file.
+	@remarks This is equivalent to calling ::ExportToCSV on the profiler if you have captured
+			 the statistics with ::Capture.
+	*/
+	PROFILE_API void ExportToCSV(const char* _path) noexcept;
+
+	/*!
+	@brief Exports the profiling statistics as a gzip-compressed pprof profile
+			(profile.proto), to be read by `go tool pprof` and its web UI.
+	@details The profile has two sample types: the wall time in cycles of the
+			 CPU timer and the hit count. Every node of the call tree of a
+			 track (see ProfileTrackResult::callTree) is one sample whose stack
+			 is its call path: the blocks (functions named after the blocks, at
+			 the file and line of their profiling macros) called from the
+			 track (a function named after the track). The time of a sample is
+			 the self time of its node (see CallTree::GetSelfElapsed), so the
+			 flame graph does not count a nested block twice. The processed
+			 bytes and the page faults are not known per call path and are
+			 not exported, nor are the executions beyond NB_CALL_NODES call
+			 paths (see CallTree::droppedCount).
+			 The protobuf message and the gzip container are encoded by hand; the
+			 deflate stream uses stored blocks, so the file is not smaller than
+			 the message. The logic to create the directories where the file is
+			 stored MUST be handled outside before calling this function.
+	@param _path The path of the file, conventionally ending with ".pb.gz".
+	*/
+	PROFILE_API void ExportToPprof(const char* _path) noexcept;
+
+	/*!
+	@brief Outputs the profiling statistics of the profiler.
+	*/
+	PROFILE_API void Report() noexcept;
+
+	/*!
+	@brief Makes room for at least _trackCount tracks in ::tracks.
+	@param _trackCount The number of tracks, NB_TRACKS or more when tracks
+			were registered at runtime (see Profile::Profiler::GetTrackCount).
+	*/
+	inline void ReserveTracks(u32 _trackCount)
+	{
+		if (tracks.size() < _trackCount)
+		{
+			tracks.resize(_trackCount);
+		}
+	}
+
+	/*!
+	@brief Resets the values of member variables of this struct and up to
+			::trackCount Profile::ProfileTrackResults in the ::tracks array.
+	@details Resetting do not change the name.
+	*/
+	PROFILE_API void Reset() noexcept;
+};
+
+/*!
+@brief A functor to wrap around code that will be profiled multiple times
+		via the Profile::RepetitionProfiler.
+@see ::RepetitionProfiler::FixedCountRepetitionTesting
+*/
+struct RepetitionTest
+{	
+	const char* name = nullptr;
+
+	RepetitionTest() = default;
+
+	/*!
+	@brief Constructs a RepetitionTest with a name.
+	@param _name The name of the test.
+	*/
+	RepetitionTest(const char* _name) : name(_name){}
+	~RepetitionTest() = default;
+
+	/*!
+	@brief The operator to override to wrap around the code to profile.
+	*/
+	PROFILE_API virtual void operator()() = 0;
+};
+
+/*!
+@brief A callable doing nothing. It is the default setup and teardown of a
+		Profile::RepetitionTestFunction.
+*/
+struct RepetitionTestNoOperation
+{
+	inline void operator()() const noexcept {}
+};
+
+/*!
+@brief A type-erased container of the code to profile multiple times via the
+		Profile::RepetitionProfiler.
+@details It can hold any callable (e.g., a lambda with captures) together with
+		 a setup and a teardown callables. The callables are moved (or copied)
+		 into the container: in a small buffer inside it when they fit (see
+		 ::smallBufferSize) and on the heap otherwise. The container owns them,
+		 so temporaries can be given; only what they capture by reference or
+		 by pointer must outlive the container.
+		 Contrary to Profile::RepetitionTest, the only indirect call happens
+		 outside of the timed region: the function pointer ::runTimed is
+		 instantiated for the exact type of the callables, so the call to the
+		 body between Profiler::Initialize and Profiler::End is direct and can be
+		 inlined. The setup and the teardown are run before Profiler::Initialize
+		 and after Profiler::End respectively, so they are never timed.
+		 Each callable may either take no argument or the index of the thread
+		 running it (a u32), which is always 0 except in
+		 RepetitionProfiler::ScalingRepetitionTesting.
+@see ::RepetitionProfiler::PushBackRepetitionTest
+*/
+struct RepetitionTestFunction
+{
+	/*!
+	@brief The size of the buffer storing the callables inside the container.
+	*/
+	static constexpr u64 smallBufferSize = 64;
+
+	/*!
+	@brief The name of the test.
+	*/
+	const char* name = nullptr;
+
+	RepetitionTestFunction() = default;
+
+	/*!
+	@brief Constructs a test from a body, a setup and a teardown callables.
+	@param _name The name of the test.
+	@param _body The code to profile.
+	@param _setup The code to run before each repetition, outside of the timed region.
+	@param _teardown The code to run after each repetition, outside of the timed region.
+	*/
+	template<typename Body, typename Setup, typename Teardown>
+	RepetitionTestFunction(const char* _name, Body&& _body, Setup&& _setup, Teardown&& _teardown) : name(_name)
+	{
+		using CallablesType = Callables<std::decay_t<Body>, std::decay_t<Setup>, std::decay_t<Teardown>>;
+		if constexpr (Operations<CallablesType>::isInline)
+		{
+			ptr_callables = new (buffer) CallablesType{ std::forward<Body>(_body), std::forward<Setup>(_setup), std::forward<Teardown>(_teardown) };
+		}
+		else
+		{
+			ptr_callables = new CallablesType{ std::forward<Body>(_body), std::forward<Setup>(_setup), std::forward<Teardown>(_teardown) };
+		}
+		ptr_operations = &Operations<CallablesType>::table;
+	}
+
+	RepetitionTestFunction(const RepetitionTestFunction&) = delete;
+	RepetitionTestFunction& operator=(const RepetitionTestFunction&) = delete;
+
+	RepetitionTestFunction(RepetitionTestFunction&& _other) noexcept
+	{
+		MoveFrom(_other);
+	}
+
+	RepetitionTestFunction& operator=(RepetitionTestFunction&& _other) noexcept
+	{
+		if (this != &_other)
+		{
+			Destroy();
+			MoveFrom(_other);
+		}
+		return *this;
+	}
+
+	~RepetitionTestFunction()
+	{
+		Destroy();
+	}
+
+	/*!
+	@brief Runs one repetition of the test: the setup, the body between
+			Profiler::Initialize and Profiler::End, and the teardown.
+	@param _profiler The profiler timing the body.
+	*/
+	inline void Run(Profiler* _profiler)
+	{
+		ptr_operations->setup(ptr_callables, 0);
+		ptr_operations->runTimed(ptr_callables, _profiler, 0);
+		ptr_operations->teardown(ptr_callables, 0);
+	}
+
+	/*!
+	@brief Runs the setup of the test.
+	@param _threadIdx The index of the thread running the setup.
+	*/
+	inline void Setup(u32 _threadIdx)
+	{
+		ptr_operations->setup(ptr_callables, _threadIdx);
+	}
+
+	/*!
+	@brief Runs the body of the test between Profiler::Initialize and Profiler::End.
+	@param _profiler The profiler timing the body.
+	@param _threadIdx The index of the thread running the body.
+	*/
+	inline void RunTimed(Profiler* _profiler, u32 _threadIdx)
+	{
+		ptr_operations->runTimed(ptr_callables, _profiler, _threadIdx);
+	}
+
+	/*!
+	@brief Runs the teardown of the test.
+	@param _threadIdx The index of the thread running the teardown.
+	*/
+	inline void Teardown(u32 _threadIdx)
+	{
+		ptr_operations->teardown(ptr_callables, _threadIdx);
+	}
+
+private:
+
+	/*!
+	@brief The aggregate of the callables of a test.
+	*/
+	template<typename Body, typename Setup, typename Teardown>
+	struct Callables
+	{
+		Body body;
+		Setup setup;
+		Teardown teardown;
+	};
+
+	/*!
+	@brief Calls a callable with the thread index if it accepts one, without
+			argument otherwise.
+	*/
+	template<typename Callable>
+	static inline void Invoke(Callable& _callable, u32 _threadIdx)
+	{
+		if constexpr (std::is_invocable_v<Callable&, u32>)
+		{
+			_callable(_threadIdx);
+		}
+		else
+		{
+			(void)_threadIdx;
+			_callable();
+		}
+	}
+
+	/*!
+	@brief The table of the functions manipulating the type-erased callables.
+	*/
+	struct OperationsTable
+	{
+		void (*setup)(void*, u32);
+		void (*runTimed)(void*, Profiler*, u32);
+		void (*teardown)(void*, u32);
+		void (*moveTo)(void*, void*);
+		void (*destroy)(void*);
+		bool isInline;
+	};
+
+	/*!
+	@brief The instantiation of the OperationsTable for a given type of callables.
+	*/
+	template<typename CallablesType>
+	struct Operations
+	{
+		static void Setup(void* _callables, u32 _threadIdx)
+		{
+			Invoke(static_cast<CallablesType*>(_callables)->setup, _threadIdx);
+		}
+
+		static void RunTimed(void* _callables, Profiler* _profiler, u32 _threadIdx)
+		{
+			CallablesType& callables = *static_cast<CallablesType*>(_callables);
+			_profiler->Initialize();
+			Invoke(callables.body, _threadIdx);
+			_profiler->End();
+		}
+
+		static void Teardown(void* _callables, u32 _threadIdx)
+		{
+			Invoke(static_cast<CallablesType*>(_callables)->teardown, _threadIdx);
+		}
+
+		static void MoveTo(void* _callables, void* _buffer)
+		{
+			new (_buffer) CallablesType(std::move(*static_cast<CallablesType*>(_callables)));
+		}
+
+		static void Destroy(void* _callables)
+		{
+			if constexpr (isInline)
+			{
+				static_cast<CallablesType*>(_callables)->~CallablesType();
+			}
+			else
+			{
+				delete static_cast<CallablesType*>(_callables);
+			}
+		}
+
+		static constexpr bool isInline = sizeof(CallablesType) <= smallBufferSize && alignof(CallablesType) <= alignof(std::max_align_t);
+
+		static constexpr OperationsTable table = { &Setup, &RunTimed, &Teardown, &MoveTo, &Destroy, isInline };
+	};
+
+	/*!
+	@brief Takes over the callables of another container, leaving it empty.
+	*/
+	inline void MoveFrom(RepetitionTestFunction& _other) noexcept
+	{
+		name = _other.name;
+		ptr_operations = _other.ptr_operations;
+		if (ptr_operations == nullptr)
+		{
+			ptr_callables = nullptr;
+		}
+		else if (ptr_operations->isInline)
+		{
+			ptr_operations->moveTo(_other.ptr_callables, buffer);
+			ptr_operations->destroy(_other.ptr_callables);
+			ptr_callables = buffer;
+		}
+		else
+		{
+			ptr_callables = _other.ptr_callables;
+		}
+		_other.ptr_operations = nullptr;
+		_other.ptr_callables = nullptr;
+	}
+
+	/*!
+	@brief Destroys the callables, if any.
+	*/
+	inline void Destroy() noexcept
+	{
+		if (ptr_operations)
+		{
+			ptr_operations->destroy(ptr_callables);
+			ptr_operations = nullptr;
+			ptr_callables = nullptr;
+		}
+	}
+
+	/*!
+	@brief The buffer storing the callables when they are small enough.
 	*/
-	PROFILE_API void ExportToCSV(const char* _path) noexcept;
+	alignas(std::max_align_t) unsigned char buffer[smallBufferSize];
 
 	/*!
-	@brief Starts the profiler.
-	@details Sets ::start to the current time.
+	@brief The pointer to the callables (either in ::buffer or on the heap).
 	*/
-	PROFILE_API void Initialize() noexcept;
+	void* ptr_callables = nullptr;
 
 	/*!
-	@brief Opens a block.
-	@param _trackIdx The index of the track the block belongs to.
-	@param _profileBlockRecorderIdx The index of the profile result.
-	@param _byteCount The number of bytes processed by the block.
+	@brief The pointer to the functions manipulating the callables.
 	*/
-	PROFILE_API inline void OpenBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount)
-	{
-		//The track is used if a block is added.
-		//This is used to avoid outputting the track's statistics, or reseting its data if it has none.
-		//But it is a WRITE operation wasted for every time that is not the first time.
-		tracks[_trackIdx].hasBlock = true;
+	const OperationsTable* ptr_operations = nullptr;
+};
 
-		tracks[_trackIdx].OpenBlock(_profileBlockRecorderIdx, _byteCount);
-	}
 
+/*!
+@brief The paired comparison of a repetition test against a baseline test.
+@details Filled by Profile::RepetitionProfiler::InterleavedRepetitionTesting. For every
+		 round, the speedup is the ratio of the elapsed time of the baseline over the
+		 elapsed time of the test in that same round. A speedup greater than 1 means
+		 the test is faster than the baseline.
+*/
+struct RepetitionComparison
+{
 	/*!
-	@brief Outputs the profiling statistics of all tracks in the profiler.
+	@brief The index of the compared test in the repetition tests.
 	*/
-	PROFILE_API void Report() noexcept;
+	u16 testIdx = 0;
 
 	/*!
-	@brief Resets the profiler's values as well as all its initialized tracks.
-	@details Resetting do not change the names.
+	@brief The index of the baseline test in the repetition tests.
 	*/
-	PROFILE_API void Reset() noexcept;
+	u16 baselineIdx = 0;
 
 	/*!
-	@brief Resets the values of all blocks in all tracks that have a name.
-	@details Resetting do not change the names.
+	@brief The robust statistics of the elapsed time (in CPU cycles) of the test
+			over the rounds.
 	*/
-	PROFILE_API void ResetTracks() noexcept;
-};
+	RobustStatistics elapsedStatistics;
 
-/*!
-@brief A global function to set the pointer to the global profiler.
-*/
-extern PROFILE_API void SetProfiler(Profiler* _profiler);
+	/*!
+	@brief The robust statistics of the paired speedups over the rounds.
+	@details The confidence interval of the median (RobustStatistics::confidenceLow
+			 and RobustStatistics::confidenceHigh) tells whether the difference is
+			 significant: it is if the interval does not contain 1.
+	*/
+	RobustStatistics speedupStatistics;
 
-/*!
-@brief A global function to get the pointer to the global profiler.
-@details The profiler must be set with ::SetProfiler before calling this function.
-@remarks Mainly useful to get the profiler in functions defined in the header, given
-		 that the profiler is defined in the source file.
-@return The pointer to the global profiler.
-*/
-extern PROFILE_API Profiler* GetProfiler();
+	/*!
+	@brief Returns 1 if the test is significantly faster than the baseline, -1 if
+			it is significantly slower and 0 if the difference is not significant.
+	*/
+	inline s32 Verdict() const noexcept
+	{
+		if (speedupStatistics.confidenceLow > 1.0)
+		{
+			return 1;
+		}
+		if (speedupStatistics.confidenceHigh < 1.0)
+		{
+			return -1;
+		}
+		return 0;
+	}
+};
 
 /*!
-@brief A mirror of the Profiler struct to store all the statistics of a profiler
-		and the tracks it contains (thanks to Profile::ProfileTrackResult).
-@details In this mirror, the tracks are packed at the beginning of the array to
-		avoid having to iterate over all the tracks that might not have been used.
+@brief The statistics of a block aggregated over all the threads of a step of
+		Profile::RepetitionProfiler::ScalingRepetitionTesting.
 */
-struct ProfilerResults
+struct ScalingBlockResult
 {
 	/*!
-	@brief The name of the profiler.
-	@details Mirrors Profiler::name.
+	@brief The index of the profiling track the block belongs to.
 	*/
-	const char* name = nullptr;
+	u32 trackIdx = 0;
 
 	/*!
-	@brief The time between the initialization (when Profiler::Initialize was called)
-			and the end (when Profiler::End was called).
-	@details Mirrors Profiler::elapsed.
+	@brief The index of the block in the profiling track.
+	*/
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+
+	/*!
+	@brief The name of the block.
+	*/
+	const char* blockName = nullptr;
+
+	/*!
+	@brief The number of times the block was executed by all threads over all repetitions.
+	*/
+	u64 hitCount = 0;
+
+	/*!
+	@brief The accumulated time the block was executed by all threads over all repetitions.
 	*/
 	u64 elapsed = 0;
 
 	/*!
-	@brief The converted ::elapsed in seconds.
-	@details No equivalent in Profile::Profiler.
+	@brief The number of bytes processed by the block by all threads over all repetitions.
 	*/
-	f64 elapsedSec = 0.0;
+	u64 processedByteCount = 0;
 
 	/*!
-	@brief The number of tracks used in the profiler (i.e, which have at least
-			one used block).
-	@details No equivalent in Profile::Profiler.
+	@brief The bandwidth in bytes per second of all threads together, i.e.,
+			::processedByteCount over the wall time of the repetitions.
 	*/
-	NB_TRACKS_TYPE trackCount = 0;
+	f64 aggregateBandwidthInB = 0.0;
 
 	/*!
-	@brief The array of mirrors to the Profile::ProfileTrack structs originally
-			stored in the profiler.
-	@details The mirrored tracks are packed at the beginning of the array to
-			avoid having to iterate over all the tracks that might not have
-			been used.
+	@brief The average bandwidth in bytes per second of one thread.
 	*/
-	std::array<ProfileTrackResult, NB_TRACKS> tracks;
+	f64 perThreadBandwidthInB = 0.0;
+};
 
-	ProfilerResults() = default;
+/*!
+@brief The result of a step (i.e., for a given number of threads) of
+		Profile::RepetitionProfiler::ScalingRepetitionTesting.
+*/
+struct ScalingResult
+{
+	/*!
+	@brief The number of threads running the test at once.
+	*/
+	u32 threadCount = 0;
 
 	/*!
-	@brief Captures the statistics of a Profile::Profiler.
-	@details It will effectively assign or compute the values of all the
-			 member variables of this struct. In particular, it will fill the
-			 ::tracks array with the statistics of the Profile::ProfileTracks
-			 of the profiler that have been used.
+	@brief The number of repetitions of the step.
 	*/
-	PROFILE_API void Capture(Profiler* _profiler) noexcept;
+	u64 repetitionCount = 0;
 
 	/*!
-	@brief Clears the values of member variables of this struct and up to
-			::trackCount Profile::ProfileTrackResults in the ::tracks array.
-	@remarks This resets even the ::name.
-			 If you are looking to reset the values without changing the name,
-			 use ::Reset.
+	@brief The average wall time in seconds of a repetition, from the moment
+			all threads are released until the last one is done.
 	*/
-	PROFILE_API void Clear() noexcept;
+	f64 wallSec = 0.0;
 
 	/*!
-	@brief Exports the profiling statistics of the profiler to a CSV file.
-	@details The logic to create the directories where the file is stored MUST be handled outside
-			 before calling this function. The file will be overwritten if it already exists.
-			 The file starts with two lines giving the headers for statistics of the profiler
-			 followed by the associated numbers. Then, a line defines new headers for the
-			 statistics of the blocks in the tracks. The following lines give the statistics
-			 of the blocks in the tracks. The statistics of the blocks are ordered by the
-			 order of the tracks in the profiler, and then by the order of the blocks in the tracks.
-	@param _path The path of the CSV file.
-	@remarks This is equivalent to calling ::ExportToCSV on the profiler if you have captured
-			 the statistics with ::Capture.
+	@brief The shortest wall time in seconds of a repetition.
 	*/
-	PROFILE_API void ExportToCSV(const char* _path) noexcept;
+	f64 minWallSec = 0.0;
 
 	/*!
-	@brief Outputs the profiling statistics of the profiler.
+	@brief The average time in seconds a thread spent in the test in a repetition.
 	*/
-	PROFILE_API void Report() noexcept;
+	f64 threadElapsedSec = 0.0;
 
 	/*!
-	@brief Resets the values of member variables of this struct and up to
-			::trackCount Profile::ProfileTrackResults in the ::tracks array.
-	@details Resetting do not change the name.
+	@brief The average time in seconds the slowest thread spent in the test in a
+			repetition. Compared to ::threadElapsedSec, it shows the load imbalance.
 	*/
-	PROFILE_API void Reset() noexcept;
-};
+	f64 maxThreadElapsedSec = 0.0;
 
-/*!
-@brief A functor to wrap around code that will be profiled multiple times
-		via the Profile::RepetitionProfiler.
-@see ::RepetitionProfiler::FixedCountRepetitionTesting
-*/
-struct RepetitionTest
-{	
-	const char* name = nullptr;
+	/*!
+	@brief The number of executions of the test per second over all threads.
+	*/
+	f64 throughput = 0.0;
 
-	RepetitionTest() = default;
+	/*!
+	@brief The ratio of ::throughput over the throughput with one thread.
+	*/
+	f64 speedup = 0.0;
 
 	/*!
-	@brief Constructs a RepetitionTest with a name.
-	@param _name The name of the test.
+	@brief The parallel efficiency, i.e., ::speedup divided by ::threadCount.
 	*/
-	RepetitionTest(const char* _name) : name(_name){}
-	~RepetitionTest() = default;
+	f64 efficiency = 0.0;
 
 	/*!
-	@brief The operator to override to wrap around the code to profile.
+	@brief The statistics of the blocks executed during the step.
 	*/
-	PROFILE_API virtual void operator()() = 0;
+	std::vector<ScalingBlockResult> blocks;
 };
 
-
 /*!
 @brief A wrapper to test the performance of a function by running it a number of times.
 */
@@ -846,6 +2982,50 @@ struct RepetitionProfiler
 	*/
 	ProfilerResults varianceResults;
 
+	/*!
+	@brief The robust statistics of the total elapsed time (in CPU cycles) of the
+			repetitions.
+	@see ::ComputeRobustStatistics
+	*/
+	RobustStatistics elapsedStatistics;
+
+	/*!
+	@brief The robust statistics of the elapsed time (in CPU cycles) of the tracks
+			over the repetitions.
+	@details The tracks are packed in the same order as in ::averageResults.
+			 Grows like ProfilerResults::tracks with the tracks registered at runtime.
+	*/
+	std::vector<RobustStatistics> trackElapsedStatistics = std::vector<RobustStatistics>(NB_TRACKS);
+
+	/*!
+	@brief The robust statistics of the elapsed time (in CPU cycles) of the blocks
+			over the repetitions.
+	@details The tracks and blocks are packed in the same order as in ::averageResults.
+	*/
+	std::vector<std::array<RobustStatistics, NB_TIMINGS>> blockElapsedStatistics = std::vector<std::array<RobustStatistics, NB_TIMINGS>>(NB_TRACKS);
+
+	/*!
+	@brief For each repetition, whether its total elapsed time was flagged as an
+			outlier by ::elapsedStatistics.
+	@details Such repetitions were most likely disturbed by an interrupt, a context
+			 switch or any other external event.
+	*/
+	std::vector<bool> outlierRepetitions;
+
+	/*!
+	@brief The comparisons of every test against the baseline computed by the last
+			call to ::InterleavedRepetitionTesting.
+	@details There is one entry per repetition test, including the baseline itself
+			 (whose speedup is always 1).
+	*/
+	std::vector<RepetitionComparison> comparisons;
+
+	/*!
+	@brief The results of the last call to ::ScalingRepetitionTesting, one per
+			number of threads.
+	*/
+	std::vector<ScalingResult> scalingResults;
+
 	/*!
 	@brief Sets the pointer for ::ptr_repetitionResults.
 	@param _repetitionResults The pointer to the ProfilerResults storing the 
@@ -865,11 +3045,35 @@ private:
 	@see ::PushBackRepetitionTest, ::ClearRepetitionTests, ::RemoveRepetitionTest,
 		 ::PopBackRepetitionTest
 	*/
-	std::vector<RepetitionTest*> repetitionTests;
+	std::vector<RepetitionTestFunction> repetitionTests;
+
+	/*!
+	@brief The buffer gathering the samples of one statistic over the repetitions
+			in ::ComputeRobustStatistics.
+	*/
+	std::vector<f64> statisticsSamples;
+
+	/*!
+	@brief The scratch buffer used by RobustStatistics::Compute.
+	*/
+	std::vector<f64> statisticsScratch;
+
+	/*!
+	@brief The random generator used for the bootstrap confidence intervals.
+	@details It is re-seeded at every call to ::ComputeRobustStatistics so that
+			 the same repetitions always give the same report.
+	*/
+	RandomGenerator statisticsGenerator;
+
+	/*!
+	@brief Clears ::elapsedStatistics, ::trackElapsedStatistics, ::blockElapsedStatistics
+			and ::outlierRepetitions.
+	*/
+	PROFILE_API void ClearRobustStatistics() noexcept;
 
 	/*!
 	@brief A function to assign the maximum of two values to the first one.
-	@details The function is overloaded for u64, f32, and f64. It's used to
+	@details The function is overloaded for u64, s64, f32, and f64. It's used to
 			 lighten the code in ::FindMaxResults.
 	@param _a The first value.
 	@param _b The second value.
@@ -908,9 +3112,49 @@ private:
 		}
 	}
 
+	/*!
+	@brief An overloaded function to assign the maximum of two values to the first one.
+	@param _a The first value.
+	@param _b The second value.
+	*/
+	inline void MaxAssign(s64& _a, s64& _b) noexcept
+	{
+		if (_a < _b)
+		{
+			_a = _b;
+		}
+	}
+
+	/*!
+	@brief A function to add the square of the difference of two values, divided
+			by the number of repetitions, to a variance.
+	@details It's used to lighten the code in ::ComputeVarianceResults. The
+			 square is computed in double precision, since the one of a difference
+			 of cycles quickly overflows a u64 (e.g., 5 seconds at 4GHz). For an
+			 integer variance, the sum saturates at the maximal value of its type.
+	@param _variance The variance being accumulated.
+	@param _a The value of a repetition.
+	@param _b The average value.
+	@param _repetitionCount The number of repetitions.
+	*/
+	template<typename T>
+	inline void AccumulateSquaredDifference(T& _variance, std::type_identity_t<T> _a, std::type_identity_t<T> _b, u64 _repetitionCount) noexcept
+	{
+		f64 difference = (f64)_a - (f64)_b;
+		f64 variance = (f64)_variance + difference * difference / (f64)_repetitionCount;
+		if constexpr (std::is_integral_v<T>)
+		{
+			_variance = variance >= (f64)std::numeric_limits<T>::max() ? std::numeric_limits<T>::max() : (T)variance;
+		}
+		else
+		{
+			_variance = (T)variance;
+		}
+	}
+
 	/*!
 	@brief A function to assign the minimum of two values to the first one.
-	@details The function is overloaded for u64, f32, and f64. It's used to
+	@details The function is overloaded for u64, s64, f32, and f64. It's used to
 			 lighten the code in ::FindMinResults.
 	@param _a The first value.
 	@param _b The second value.
@@ -964,15 +3208,68 @@ private:
 		}
 	}
 
+	/*!
+	@brief An overloaded function to assign the minimum of two values to the first one.
+	@param _a The first value.
+	@param _b The second value.
+	*/
+	inline void MinAssign(s64& _a, s64& _b) noexcept
+	{
+		if (_a == 0)
+		{
+			_a = _b;
+		}
+
+		else if (_a > _b)
+		{
+			_a = _b;
+		}
+	}
+
 public:
 
 	/*!
 	@brief Pushes back a wrapper of a function to profile multiple times to
 			::repetitionTests.
+	@details Only the pointer to the wrapper is stored: the wrapper must outlive
+			 its stay in ::repetitionTests.
 	*/
 	PROFILE_API inline void PushBackRepetitionTest(RepetitionTest* _repetitionTest) noexcept
 	{
-		repetitionTests.push_back(_repetitionTest);
+		repetitionTests.emplace_back(_repetitionTest->name, [_repetitionTest]() { (*_repetitionTest)(); },
+			RepetitionTestNoOperation(), RepetitionTestNoOperation());
+	}
+
+	/*!
+	@brief Pushes back any callable (e.g., a lambda with captures) to profile
+			multiple times to ::repetitionTests.
+	@details The callable is moved (or copied) into a Profile::RepetitionTestFunction,
+			 which owns it: only what it captures by reference or by pointer must
+			 outlive its stay in ::repetitionTests.
+	@param _name The name of the test.
+	@param _body The code to profile.
+	*/
+	template<typename Body>
+	inline void PushBackRepetitionTest(const char* _name, Body&& _body)
+	{
+		repetitionTests.emplace_back(_name, std::forward<Body>(_body),
+			RepetitionTestNoOperation(), RepetitionTestNoOperation());
+	}
+
+	/*!
+	@brief Pushes back any callable to profile multiple times to ::repetitionTests,
+			together with a setup and a teardown that run around every repetition
+			outside of the timed region.
+	@param _name The name of the test.
+	@param _body The code to profile.
+	@param _setup The code to run before every repetition.
+	@param _teardown The code to run after every repetition.
+	*/
+	template<typename Body, typename Setup, typename Teardown>
+	inline void PushBackRepetitionTest(const char* _name, Body&& _body, Setup&& _setup, Teardown&& _teardown)
+	{
+		repetitionTests.emplace_back(_name, std::forward<Body>(_body),
+			std::forward<Setup>(_setup), std::forward<Teardown>(_teardown));
 	}
 
 	/*!
@@ -1022,6 +3319,17 @@ public:
 	*/
 	PROFILE_API void ComputeAverageResults(u64 _repetitionCount) noexcept;
 
+	/*!
+	@brief Computes the robust statistics (median, MAD, percentiles, trimmed mean,
+			bootstrap confidence interval of the median and outliers) of the elapsed
+			time of the profiler, of each track and of each block over the repetitions.
+	@details The repetitions whose total elapsed time is an outlier are flagged in
+			 ::outlierRepetitions.
+	@param _repetitionCount The number of repetitions.
+	@see ::elapsedStatistics, ::trackElapsedStatistics, ::blockElapsedStatistics
+	*/
+	PROFILE_API void ComputeRobustStatistics(u64 _repetitionCount) noexcept;
+
 	/*!
 	@brief Computes the variance of the repeated profiling.
 	@param _repetitionCount The number of repetitions.
@@ -1080,7 +3388,10 @@ public:
 			 where the files will be stored and not directly the name of a file.
 			 The files will be named after the nature of the profiling statistics
 			 they contain. Namely, the files will be named "Average.csv", "Variance.csv",
-			 "Max.csv", and "Min.csv". The individual profiling statistics of each
+			 "Max.csv", and "Min.csv". The robust statistics of every track (with an
+			 empty block name) and every block are exported
+			 in "RobustStatistics.csv" and the total elapsed time of every repetition,
+			 with its outlier flag, in "Repetitions.csv". The individual profiling statistics of each
 			 repetition will also be exported to CSV files named after the repetition
 			 number. The summary statistics will be in the directory "_path/Summary"
 			 and the individual statistics in the directory "_path/Repetitions".
@@ -1090,6 +3401,79 @@ public:
 	*/
 	PROFILE_API void ExportToCSV(const char* _path, u64 _repetitionCount) noexcept;
 
+	/*!
+	@brief Exports the comparisons computed by ::InterleavedRepetitionTesting to a CSV file.
+	@details The logic to create the directories where the file is stored MUST be handled outside
+			 before calling this function. The file will be overwritten if it already exists.
+			 There is one line per test giving the robust statistics of its elapsed time
+			 and of its paired speedup against the baseline.
+	@param _path The path of the CSV file.
+	*/
+	PROFILE_API void ExportComparisonToCSV(const char* _path) noexcept;
+
+	/*!
+	@brief Tests all functions wrapped in ::repetitionTests in interleaved rounds and
+			compares each of them against a baseline.
+	@details Every round runs every test exactly once, so all tests get the same number
+			 of samples. Running the tests in rounds rather than one after the other
+			 spreads thermal and frequency drifts evenly across all of them. The order
+			 of the tests in a round is either shuffled, or rotated by one every round.
+			 The profiling statistics of test t in round r are stored in the
+			 ProfilerResults pointed by ::ptr_repetitionResults at index
+			 t * @p _roundCount + r. In this case, ::ptr_repetitionResults must be set
+			 before calling this function and must be an array of at least
+			 ::repetitionTests.size() * @p _roundCount elements. At most 65535
+			 tests can be compared.
+			 Once all rounds are done, every test is reported as in ::Report and the
+			 paired speedups against the baseline are computed in ::comparisons and
+			 reported with their confidence intervals.
+	@param _roundCount The number of rounds.
+	@param _baselineIdx The index of the baseline test in ::repetitionTests. Default is 0.
+	@param _randomizeOrder Whether to shuffle the order of the tests in every round
+			(true) or to rotate it (false). Default is true.
+	*/
+	PROFILE_API void InterleavedRepetitionTesting(u64 _roundCount, u16 _baselineIdx = 0, bool _randomizeOrder = true);
+
+	/*!
+	@brief Outputs the comparisons computed by ::InterleavedRepetitionTesting.
+	*/
+	PROFILE_API void ReportComparison() noexcept;
+
+	/*!
+	@brief Exports the results of ::ScalingRepetitionTesting to a CSV file.
+	@details The logic to create the directories where the file is stored MUST be handled outside
+			 before calling this function. The file will be overwritten if it already exists.
+			 There is one line per number of threads and per block.
+	@param _path The path of the CSV file.
+	*/
+	PROFILE_API void ExportScalingToCSV(const char* _path) noexcept;
+
+	/*!
+	@brief Outputs the results of ::ScalingRepetitionTesting.
+	@details For every number of threads, it shows the wall time, the throughput,
+			 the speedup and the parallel efficiency as well as the aggregated and
+			 per-thread bandwidth of every block annotated with a byte count.
+	*/
+	PROFILE_API void ReportScaling() noexcept;
+
+	/*!
+	@brief Runs a test on 1 to @p _maxThreadCount threads at once to measure how it scales.
+	@details For every number of threads, the threads are created (and pinned to
+			 distinct cores if @p _pinThreads is true), then every repetition runs the
+			 setup of the test on all threads, releases them together through a barrier
+			 to run the body, and waits for all of them before the teardown. Every thread
+			 records its blocks in its own Profile::Profiler (see Profile::SetThreadProfiler),
+			 which is a copy of the profiler of the calling thread after a warm-up run
+			 of the test on the calling thread. The body of the test is given the index
+			 of the thread if it accepts a u32, so that each thread can work on its own data.
+			 The results are stored in ::scalingResults and reported with ::ReportScaling.
+	@param _testIdx The index of the test in ::repetitionTests.
+	@param _maxThreadCount The maximal number of threads.
+	@param _repetitionCount The number of repetitions for every number of threads.
+	@param _pinThreads Whether to pin the threads to distinct cores. Default is true.
+	*/
+	PROFILE_API void ScalingRepetitionTesting(u16 _testIdx, u32 _maxThreadCount, u64 _repetitionCount, bool _pinThreads = true);
+
 	/*!
 	@brief Repeatedly tests all functions wrapped in ::repetitionTests and consecutively
 			reports the profiling statistics.
@@ -1110,8 +3494,8 @@ public:
 	@brief Prints the results of the repeated profiling.
 	@details If none have been computed yet (i.e., the corresponding Profile::ProfilingResults
 			 have their names set to nullptr), the function will compute the
-			 average, the variance, the maximum, and the minimum of
-			 the repeated profiling before outputting the results.
+			 average, the variance, the maximum, the minimum, and the robust
+			 statistics of the repeated profiling before outputting the results.
 	@param _repetitionCount The number of repetitions.
 	*/
 	PROFILE_API void Report(u64 _repetitionCount) noexcept;
@@ -1126,4 +3510,23 @@ public:
 	*/
 	PROFILE_API void Reset(u64 _repetitionCount) noexcept;
 };
+
+/*!
+@brief Checks that a program was compiled with the same sizes as the profiling
+		library (see Profile::DefaultProfilerSizes).
+@details With different sizes, the program and the library disagree on the
+		 layout of the profiler, which silently corrupts it. This function
+		 turns the mismatch into an error message when the program is loaded
+		 (see Profile::s_IsLibraryConfigurationChecked).
+@param _sizesHash The Profile::ProfilerSizes::hash of the program.
+@param _profilerByteCount The size of Profile::Profiler in the program.
+@return Whether the sizes match.
+*/
+extern PROFILE_API bool CheckLibraryConfiguration(u64 _sizesHash, u64 _profilerByteCount) noexcept;
+
+/*!
+@brief Runs Profile::CheckLibraryConfiguration with the sizes of the program
+		including this header, once per translation unit, when it is loaded.
+*/
+static const bool s_IsLibraryConfigurationChecked = CheckLibraryConfiguration(DefaultProfilerSizes::hash, sizeof(Profiler));
 } // namespace Profile
\ No newline at end of file
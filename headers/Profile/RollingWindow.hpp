@@ -0,0 +1,476 @@
+#pragma once
+
+#include <vector> // for the ring of intervals and the deltas
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	struct Profiler;
+	struct ProfileTrack;
+
+	/*!
+	@brief The counters of a block the rolling window keeps track of.
+	@details Mirrors the cumulative counters of Profile::ProfileBlockRecorder.
+			 In a Profile::WindowBlockDelta, they are the increase of the
+			 counters during one interval.
+	*/
+	struct WindowBlockCounters
+	{
+		u64 hitCount = 0;
+		u64 elapsed = 0;
+		u64 processedByteCount = 0;
+		u64 flopCount = 0;
+		u64 allocationCount = 0;
+		u64 allocatedByteCount = 0;
+		u64 pageFaultCount = 0;
+
+		/*!
+		@brief Adds the counters of another block.
+		*/
+		inline void Accumulate(const WindowBlockCounters& _other) noexcept
+		{
+			hitCount += _other.hitCount;
+			elapsed += _other.elapsed;
+			processedByteCount += _other.processedByteCount;
+			flopCount += _other.flopCount;
+			allocationCount += _other.allocationCount;
+			allocatedByteCount += _other.allocatedByteCount;
+			pageFaultCount += _other.pageFaultCount;
+		}
+	};
+
+	/*!
+	@brief The activity of a block during one interval of a Profile::RollingWindow.
+	*/
+	struct WindowBlockDelta
+	{
+		/*!
+		@brief The name of the block.
+		@details Points to the name given to the profiling macro, so it lives
+				 as long as the program.
+		*/
+		const char* blockName = nullptr;
+
+		/*!
+		@brief The index of the track of the block.
+		*/
+		u32 trackIdx = 0;
+
+		/*!
+		@brief The index of the block in ProfileTrack::timings.
+		*/
+		u32 recorderIdx = 0;
+
+		/*!
+		@brief The increase of the counters of the block during the interval.
+		*/
+		WindowBlockCounters delta;
+	};
+
+	/*!
+	@brief One interval of a Profile::RollingWindow.
+	*/
+	struct WindowInterval
+	{
+		/*!
+		@brief The time the interval started on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The time the interval ended on the CPU timer.
+		*/
+		u64 end = 0;
+
+		/*!
+		@brief The blocks executed during the interval, and only those.
+		*/
+		std::vector<WindowBlockDelta> blocks;
+
+		/*!
+		@brief Returns the duration of the interval in seconds.
+		*/
+		PROFILE_API f64 GetDurationSec() const noexcept;
+	};
+
+	/*!
+	@brief Keeps the statistics of a profiler over the last intervals of time,
+			for long-running services whose cumulative statistics are dominated
+			by their history.
+	@details The profiler itself is never reset: at every rotation, the window
+			 takes a consistent copy of the tracks (see ProfileTrack::CaptureConsistent)
+			 and stores the difference with the copy of the previous rotation in
+			 a ring of ::capacity intervals. Only the blocks executed during an
+			 interval are stored in it, so the cost of a rotation is a copy of
+			 the used blocks of the tracks that recorded something since the
+			 previous rotation plus the allocation of the deltas, not a reset
+			 of all the NB_TIMINGS blocks of every track.
+			 The rotations are driven by the caller with ::Update (e.g., once per
+			 iteration of a service loop) or ::Rotate, from any one thread.
+			 A block still open at a rotation has its time up to the rotation in
+			 the interval that ends, and the rest in the next one.
+	*/
+	struct RollingWindow
+	{
+		/*!
+		@brief The duration of an interval on the CPU timer.
+		*/
+		u64 intervalDuration = 0;
+
+		/*!
+		@brief The maximal number of intervals kept.
+		*/
+		u32 capacity = 0;
+
+		/*!
+		@brief The number of intervals in ::intervals.
+		*/
+		u32 intervalCount = 0;
+
+		/*!
+		@brief The index in ::intervals where the next interval is stored.
+		*/
+		u32 nextIntervalIdx = 0;
+
+		/*!
+		@brief The ring of intervals.
+		*/
+		std::vector<WindowInterval> intervals;
+
+		/*!
+		@brief The cumulative counters of every block at the last rotation,
+				indexed by trackIdx * NB_TIMINGS + recorderIdx.
+		*/
+		std::vector<WindowBlockCounters> previousCounters;
+
+		/*!
+		@brief The sequence of every track (see ProfileTrack::sequence) when
+				::previousCounters were read, so that the tracks that recorded
+				nothing since are not copied again.
+		*/
+		std::vector<u64> previousSequences;
+
+		/*!
+		@brief The time of the last rotation (or of ::Start) on the CPU timer.
+		*/
+		u64 previousRotation = 0;
+
+		/*!
+		@brief The consistent copy of the track being diffed.
+		*/
+		ProfileTrack* ptr_trackCopy = nullptr;
+
+		/*!
+		@brief Sizes the window.
+		@param _intervalInMs The duration of an interval in milliseconds
+				(e.g., 1000, 10000 or 60000).
+		@param _capacity The number of intervals kept (e.g., 60 intervals of
+				1s keep the last minute).
+		*/
+		PROFILE_API RollingWindow(u32 _intervalInMs, u32 _capacity);
+		RollingWindow(const RollingWindow&) = delete;
+		RollingWindow& operator=(const RollingWindow&) = delete;
+		PROFILE_API ~RollingWindow();
+
+		/*!
+		@brief Forgets the intervals and starts the first one from the current
+				state of a profiler.
+		@param _profiler The profiler to follow.
+		*/
+		PROFILE_API void Start(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Rotates the window if the current interval lasted at least
+				::intervalDuration.
+		@param _profiler The profiler given to ::Start.
+		@return Whether the window rotated.
+		*/
+		PROFILE_API bool Update(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Ends the current interval now, stores it in the ring (dropping
+				the oldest one when the ring is full) and starts the next one.
+		@param _profiler The profiler given to ::Start.
+		*/
+		PROFILE_API void Rotate(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Returns an interval of the ring.
+		@param _age The age of the interval: 0 is the most recent one. Must be
+				less than ::intervalCount.
+		*/
+		PROFILE_API const WindowInterval& GetInterval(u32 _age) const noexcept;
+
+		/*!
+		@brief Sums the activity of the blocks over the most recent intervals.
+		@param _intervalCount The number of intervals to sum, capped to ::intervalCount.
+		@param _blocks Receives one entry per block executed in these intervals.
+		@return The time covered by the intervals on the CPU timer.
+		*/
+		PROFILE_API u64 Aggregate(u32 _intervalCount, std::vector<WindowBlockDelta>& _blocks) const;
+
+		/*!
+		@brief Prints the rates of every block over the most recent intervals.
+		@details For every block: the hits per second, the share of the wall
+				 time, the time per hit and the bandwidth over the intervals, and
+				 the trend of its time share in the most recent interval compared
+				 to the whole span.
+		@param _intervalCount The number of intervals to report, capped to ::intervalCount.
+		*/
+		PROFILE_API void Report(u32 _intervalCount) const;
+
+		/*!
+		@brief Writes one line per block and interval of the ring in a CSV file,
+				from the oldest interval to the most recent one.
+		@param _path The path of the CSV file.
+		*/
+		PROFILE_API void ExportToCSV(const char* _path) const;
+	};
+
+	/*!
+	@brief One frame of a Profile::FrameProfiler.
+	*/
+	struct ProfileFrame
+	{
+		/*!
+		@brief The number of frames ended before this one since ::FrameProfiler::Start.
+		*/
+		u64 frameIdx = 0;
+
+		/*!
+		@brief The time the frame started on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The time the frame ended on the CPU timer.
+		*/
+		u64 end = 0;
+
+		/*!
+		@brief The median duration of the frames of the ring when the frame
+				ended, on the CPU timer. 0 if there were not enough frames yet.
+		*/
+		u64 medianDuration = 0;
+
+		/*!
+		@brief Whether the frame exceeded the budget or the multiple of the median.
+		*/
+		bool isSpike = false;
+
+		/*!
+		@brief The blocks executed during the frame, and only those.
+		*/
+		std::vector<WindowBlockDelta> blocks;
+
+		/*!
+		@brief Returns the duration of the frame in seconds.
+		*/
+		PROFILE_API f64 GetDurationSec() const noexcept;
+	};
+
+	/*!
+	@brief Profiles the iterations of a fixed-rate loop one by one, to find the
+			rare slow iterations hidden by the cumulative statistics.
+	@details Every iteration is delimited by ::BeginFrame and ::EndFrame (or
+			 ::NextFrame in a loop without gap between the frames). Like
+			 Profile::RollingWindow, the profiler is never reset: a frame is the
+			 difference of consistent copies of the tracks taken at its start
+			 and end, and holds only the blocks executed during the frame. Only
+			 the tracks that recorded something during the frame are copied,
+			 and only their used blocks are diffed. The last ::capacity frames
+			 are kept in a ring.
+			 A frame is a spike when it lasts more than ::budget, or more than
+			 ::medianFactor times the median duration of the frames of the ring.
+			 The spikes are also copied in a second ring of ::spikeCapacity
+			 frames, so their details outlive the frames that follow them.
+			 The frames are delimited from any one thread; the blocks may be
+			 recorded by any thread.
+	*/
+	struct FrameProfiler
+	{
+		/*!
+		@brief The number of frames the ring must hold before the median is
+				used to detect the spikes (capped to ::capacity).
+		*/
+		static constexpr u32 minMedianFrameCount = 8;
+
+		/*!
+		@brief The maximal duration of a frame on the CPU timer. 0 disables
+				the check.
+		*/
+		u64 budget = 0;
+
+		/*!
+		@brief The multiple of the median duration above which a frame is a
+				spike. 0 disables the check.
+		*/
+		f64 medianFactor = 0.0;
+
+		/*!
+		@brief The maximal number of frames kept in ::frames.
+		*/
+		u32 capacity = 0;
+
+		/*!
+		@brief The number of frames in ::frames.
+		*/
+		u32 frameCount = 0;
+
+		/*!
+		@brief The index in ::frames where the next frame is stored.
+		*/
+		u32 nextFrameIdx = 0;
+
+		/*!
+		@brief The ring of the last frames.
+		*/
+		std::vector<ProfileFrame> frames;
+
+		/*!
+		@brief The maximal number of frames kept in ::spikes.
+		*/
+		u32 spikeCapacity = 0;
+
+		/*!
+		@brief The number of frames in ::spikes.
+		*/
+		u32 spikeCount = 0;
+
+		/*!
+		@brief The index in ::spikes where the next spike is stored.
+		*/
+		u32 nextSpikeIdx = 0;
+
+		/*!
+		@brief The ring of the last spikes.
+		*/
+		std::vector<ProfileFrame> spikes;
+
+		/*!
+		@brief The number of frames ended since ::Start.
+		*/
+		u64 totalFrameCount = 0;
+
+		/*!
+		@brief The number of spikes since ::Start, including those dropped from ::spikes.
+		*/
+		u64 totalSpikeCount = 0;
+
+		/*!
+		@brief The time the current frame started on the CPU timer, 0 outside of a frame.
+		*/
+		u64 frameStart = 0;
+
+		/*!
+		@brief The cumulative counters of every block at the start of the
+				current frame, indexed by trackIdx * NB_TIMINGS + recorderIdx.
+		*/
+		std::vector<WindowBlockCounters> previousCounters;
+
+		/*!
+		@brief The sequence of every track (see ProfileTrack::sequence) when
+				::previousCounters were read, so that the tracks that recorded
+				nothing since are not copied again.
+		*/
+		std::vector<u64> previousSequences;
+
+		/*!
+		@brief The durations of the frames of the ring, reordered to find their median.
+		*/
+		std::vector<u64> durations;
+
+		/*!
+		@brief The consistent copy of the track being diffed.
+		*/
+		ProfileTrack* ptr_trackCopy = nullptr;
+
+		/*!
+		@brief Sizes the rings and sets the spike thresholds.
+		@param _capacity The number of frames kept (e.g., 1000 frames of a
+				60Hz loop keep the last 16s).
+		@param _budgetInMs The maximal duration of a frame in milliseconds.
+				0 disables the check.
+		@param _medianFactor The multiple of the median duration above which
+				a frame is a spike (e.g., 2.0). 0 disables the check.
+		@param _spikeCapacity The number of spikes kept.
+		*/
+		PROFILE_API FrameProfiler(u32 _capacity, f64 _budgetInMs, f64 _medianFactor, u32 _spikeCapacity);
+		FrameProfiler(const FrameProfiler&) = delete;
+		FrameProfiler& operator=(const FrameProfiler&) = delete;
+		PROFILE_API ~FrameProfiler();
+
+		/*!
+		@brief Forgets the frames and the spikes.
+		*/
+		PROFILE_API void Start() noexcept;
+
+		/*!
+		@brief Starts a frame from the current state of a profiler.
+		@param _profiler The profiler to follow.
+		*/
+		PROFILE_API void BeginFrame(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Ends the current frame now, stores it in the ring (dropping the
+				oldest one when the ring is full) and checks whether it is a spike.
+		@details The frame ends before the tracks are diffed, so that the cost
+				 of the diff is not part of its duration.
+		@param _profiler The profiler given to ::BeginFrame.
+		@return Whether the frame is a spike.
+		*/
+		PROFILE_API bool EndFrame(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Ends the current frame and starts the next one right after.
+		@details Cheaper than ::EndFrame followed by ::BeginFrame since the
+				 tracks are copied once. Like with ::BeginFrame, the next frame
+				 starts after the copy, which is part of neither frame.
+		@param _profiler The profiler given to ::BeginFrame.
+		@return Whether the frame that ended is a spike.
+		*/
+		PROFILE_API bool NextFrame(const Profiler& _profiler) noexcept;
+
+		/*!
+		@brief Returns a frame of the ring.
+		@param _age The age of the frame: 0 is the most recent one. Must be
+				less than ::frameCount.
+		*/
+		PROFILE_API const ProfileFrame& GetFrame(u32 _age) const noexcept;
+
+		/*!
+		@brief Returns a spike of the ring of spikes.
+		@param _age The age of the spike: 0 is the most recent one. Must be
+				less than ::spikeCount.
+		*/
+		PROFILE_API const ProfileFrame& GetSpike(u32 _age) const noexcept;
+
+		/*!
+		@brief Computes the median duration of the frames of the ring.
+		@return The median on the CPU timer, 0 if the ring is empty.
+		*/
+		PROFILE_API u64 ComputeMedianDuration() noexcept;
+
+		/*!
+		@brief Prints the distribution of the durations of the frames of the
+				ring, then the blocks of every spike kept, by decreasing time.
+		*/
+		PROFILE_API void Report();
+
+		/*!
+		@brief Writes one line per block and frame of the ring in a CSV file,
+				from the oldest frame to the most recent one.
+		@param _path The path of the CSV file.
+		*/
+		PROFILE_API void ExportToCSV(const char* _path) const;
+
+		/*!
+		@brief Writes one line per block and spike kept in a CSV file, from the
+				oldest spike to the most recent one.
+		@param _path The path of the CSV file.
+		*/
+		PROFILE_API void ExportSpikesToCSV(const char* _path) const;
+	};
+}
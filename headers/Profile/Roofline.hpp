@@ -0,0 +1,183 @@
+#pragma once
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	/*!
+	@brief The peak memory bandwidth and floating point throughput of the machine
+			for one core, used to put the profiled blocks in context (roofline model).
+	@details The peaks are measured with Profile::Kernels on a buffer much larger
+			 than the caches, so the bandwidths are the ones of the main memory.
+			 Measuring takes a few seconds, so the results are meant to be cached
+			 on disk with ::LoadOrMeasure.
+	*/
+	struct MachinePeaks
+	{
+		/*!
+		@brief The brand string of the CPU the peaks were measured on.
+		@details Used to invalidate a cache file written on another machine.
+		*/
+		char cpuBrand[49] = {0};
+
+		/*!
+		@brief The size in bytes of the buffer used to measure the bandwidths.
+		*/
+		u64 bufferByteCount = 0;
+
+		/*!
+		@brief The peak read bandwidth in bytes per second.
+		*/
+		f64 readBandwidthInB = 0.0;
+
+		/*!
+		@brief The peak write bandwidth in bytes per second.
+		*/
+		f64 writeBandwidthInB = 0.0;
+
+		/*!
+		@brief The peak copy bandwidth in bytes per second.
+		@details As in the STREAM benchmark, both the bytes read and written count.
+		*/
+		f64 copyBandwidthInB = 0.0;
+
+		/*!
+		@brief The peak scalar double precision throughput in floating point
+				operations per second.
+		*/
+		f64 scalarFlops = 0.0;
+
+		/*!
+		@brief The peak SIMD double precision throughput in floating point
+				operations per second.
+		*/
+		f64 simdFlops = 0.0;
+
+		/*!
+		@brief The default size of the buffer used to measure the bandwidths (256MB).
+		*/
+		static constexpr u64 defaultBufferByteCount = 256ull << 20;
+
+		/*!
+		@brief The default path of the cache file.
+		*/
+		static constexpr const char* defaultCachePath = "./MachinePeaks.txt";
+
+		/*!
+		@brief Whether the peaks were measured (or loaded).
+		*/
+		inline bool IsValid() const noexcept
+		{
+			return readBandwidthInB > 0.0 && simdFlops > 0.0;
+		}
+
+		/*!
+		@brief Returns the highest of the measured bandwidths in bytes per second.
+		@details It is the reference to which the bandwidth of a block is compared
+				 since the profiler does not know whether the block reads, writes or copies.
+		*/
+		PROFILE_API f64 GetPeakBandwidthInB() const noexcept;
+
+		/*!
+		@brief Returns the highest of the measured floating point throughputs.
+		*/
+		PROFILE_API f64 GetPeakFlops() const noexcept;
+
+		/*!
+		@brief Returns the arithmetic intensity (in FLOP per byte) at which the
+				roofline switches from memory-bound to compute-bound.
+		*/
+		PROFILE_API f64 GetRidgePoint() const noexcept;
+
+		/*!
+		@brief Returns the attainable throughput for an arithmetic intensity
+				according to the roofline model.
+		@param _arithmeticIntensity The floating point operations per byte.
+		*/
+		PROFILE_API f64 GetAttainableFlops(f64 _arithmeticIntensity) const noexcept;
+
+		/*!
+		@brief Returns the percentage of the peak bandwidth reached by a block.
+		@param _processedByteCount The number of bytes processed by the block.
+		@param _elapsedSec The time the block was executed in seconds.
+		@return The percentage, or 0 if the peaks are not valid or the block
+				processed no bytes.
+		*/
+		PROFILE_API f64 GetPercentOfPeakBandwidth(u64 _processedByteCount, f64 _elapsedSec) const noexcept;
+
+		/*!
+		@brief Returns the percentage of the attainable throughput reached by a
+				block according to the roofline model.
+		@param _processedByteCount The number of bytes processed by the block.
+		@param _flopCount The number of floating point operations of the block.
+		@param _elapsedSec The time the block was executed in seconds.
+		@return The percentage, or 0 if the peaks are not valid or the block
+				has no bytes or no FLOP count.
+		*/
+		PROFILE_API f64 GetPercentOfRoofline(u64 _processedByteCount, u64 _flopCount, f64 _elapsedSec) const noexcept;
+
+		/*!
+		@brief Loads the peaks from a cache file.
+		@param _path The path of the file written by ::SaveToFile.
+		@return Whether the file exists, is well formed and was written on the same CPU.
+		*/
+		PROFILE_API bool LoadFromFile(const char* _path) noexcept;
+
+		/*!
+		@brief Loads the peaks from a cache file or measures and saves them if
+				the file is missing, was written on another CPU or was measured
+				with another buffer size.
+		@param _path The path of the cache file.
+		@param _bufferByteCount The size of the buffer used if the bandwidths must be measured.
+		*/
+		PROFILE_API void LoadOrMeasure(const char* _path = defaultCachePath, u64 _bufferByteCount = defaultBufferByteCount) noexcept;
+
+		/*!
+		@brief Measures the peaks of the machine on the calling thread.
+		@details Every kernel is run @p _repetitionCount times and the best run is kept.
+		@param _bufferByteCount The size of the buffer used to measure the bandwidths.
+				It should be much larger than the last level cache.
+		@param _repetitionCount The number of runs of every kernel.
+		*/
+		PROFILE_API void Measure(u64 _bufferByteCount = defaultBufferByteCount, u32 _repetitionCount = 5) noexcept;
+
+		/*!
+		@brief Outputs the peaks.
+		*/
+		PROFILE_API void Report() const noexcept;
+
+		/*!
+		@brief Saves the peaks in a cache file.
+		@param _path The path of the file. The directories must exist.
+		@return Whether the file was written.
+		*/
+		PROFILE_API bool SaveToFile(const char* _path) const noexcept;
+	};
+
+	/*!
+	@brief A global function to set the machine peaks the reports compare the blocks with.
+	@details When no peaks are set (the default), the reports only show the raw
+			 bandwidths. The peaks must outlive their use by the reports.
+	*/
+	extern PROFILE_API void SetMachinePeaks(const MachinePeaks* _machinePeaks);
+
+	/*!
+	@brief A global function to get the machine peaks set with ::SetMachinePeaks.
+	@return The peaks, or nullptr if none were set.
+	*/
+	extern PROFILE_API const MachinePeaks* GetMachinePeaks();
+
+	/*!
+	@brief Outputs the position of a block with regard to the machine peaks as
+			the continuation of its report line.
+	@details It prints the percentage of the peak bandwidth and, when the block
+			 has a FLOP count, its arithmetic intensity, its throughput, the
+			 percentage of the attainable throughput and whether it is memory-bound
+			 or compute-bound. Does nothing if no peaks are set.
+	@param _processedByteCount The number of bytes processed by the block.
+	@param _flopCount The number of floating point operations of the block.
+	@param _elapsedSec The time the block was executed in seconds.
+	*/
+	extern PROFILE_API void ReportRoofline(u64 _processedByteCount, u64 _flopCount, f64 _elapsedSec);
+}
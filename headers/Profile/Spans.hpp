@@ -0,0 +1,505 @@
+#pragma once
+
+#include <array> // for the histogram of the spans
+#include <atomic> // for std::atomic_ref on the counters of the spans
+#include <bit> // for std::bit_width in SpanRecorder::Record
+#include <coroutine> // for std::coroutine_handle in ProfileSpanAwaiter
+#include <type_traits> // for std::conditional_t in ProfileSpan::Await
+#include <utility> // for std::forward and std::move
+#include <vector> // for the blocks of the tail captures
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	/*!
+	@brief The statistics of a type of span (see Profile::ProfileSpan).
+	@details Unlike Profile::ProfileBlockRecorder, a span may end on another
+			 thread than the one it began on, and many spans of the same type
+			 may end concurrently: the counters are only updated with atomic
+			 read-modify-write operations (through std::atomic_ref, so that
+			 the profiler stays copyable).
+	*/
+	struct SpanRecorder
+	{
+		/*!
+		@brief The number of buckets of ::histogram.
+		*/
+		static constexpr u32 histogramBucketCount = 64;
+
+		/*!
+		@brief The name of the span.
+		@details Points to the name given to the profiling macro, so it lives
+				 as long as the program. The span is registered if it is not nullptr.
+		*/
+		const char* spanName = nullptr;
+
+		/*!
+		@brief The name of the file where the span is located.
+		*/
+		const char* fileName = nullptr;
+
+		/*!
+		@brief The line number in the file where the span is located.
+		*/
+		u32 lineNumber = 0;
+
+		/*!
+		@brief The number of spans that ended.
+		*/
+		u64 hitCount = 0;
+
+		/*!
+		@brief The sum of the durations of the spans, from their beginning to
+				their end, on the CPU timer.
+		*/
+		u64 elapsed = 0;
+
+		/*!
+		@brief The part of ::elapsed the spans spent suspended.
+		@details The active time of the spans is ::elapsed - ::suspendedElapsed.
+		*/
+		u64 suspendedElapsed = 0;
+
+		/*!
+		@brief The number of times the spans were suspended.
+		*/
+		u64 suspendCount = 0;
+
+		/*!
+		@brief The number of spans that began but did not end yet (e.g., the
+				requests waiting in a queue).
+		*/
+		u64 openCount = 0;
+
+		/*!
+		@brief The longest duration of a span on the CPU timer.
+		*/
+		u64 maxElapsed = 0;
+
+		/*!
+		@brief The number of spans per duration: bucket i counts the spans whose
+				duration on the CPU timer has a bit width of i (i.e., is in
+				[2^(i-1), 2^i[), the last bucket holding the longer ones as well.
+		*/
+		std::array<u64, histogramBucketCount> histogram = { 0 };
+
+		/*!
+		@brief Counts a span that began.
+		@details Safe to call from any thread.
+		*/
+		inline void Open() noexcept
+		{
+			std::atomic_ref<u64>(openCount).fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/*!
+		@brief Adds an ended span to the statistics.
+		@details Safe to call from any thread, concurrently with the other spans
+				 of the same type. The span must have been counted with ::Open.
+		@param _elapsed The duration of the span on the CPU timer.
+		@param _suspendedElapsed The time the span was suspended on the CPU timer.
+		@param _suspendCount The number of times the span was suspended.
+		*/
+		inline void Record(u64 _elapsed, u64 _suspendedElapsed, u64 _suspendCount) noexcept
+		{
+			std::atomic_ref<u64>(openCount).fetch_sub(1, std::memory_order_relaxed);
+			std::atomic_ref<u64>(hitCount).fetch_add(1, std::memory_order_relaxed);
+			std::atomic_ref<u64>(elapsed).fetch_add(_elapsed, std::memory_order_relaxed);
+			if (_suspendCount)
+			{
+				std::atomic_ref<u64>(suspendedElapsed).fetch_add(_suspendedElapsed, std::memory_order_relaxed);
+				std::atomic_ref<u64>(suspendCount).fetch_add(_suspendCount, std::memory_order_relaxed);
+			}
+
+			u32 bucketIdx = (u32)std::bit_width(_elapsed);
+			std::atomic_ref<u64>(histogram[bucketIdx < histogramBucketCount ? bucketIdx : histogramBucketCount - 1]).fetch_add(1, std::memory_order_relaxed);
+
+			std::atomic_ref<u64> maxElapsedRef(maxElapsed);
+			u64 currentMax = maxElapsedRef.load(std::memory_order_relaxed);
+			while (currentMax < _elapsed && !maxElapsedRef.compare_exchange_weak(currentMax, _elapsed, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		/*!
+		@brief Estimates a percentile of the durations of the spans from ::histogram.
+		@param _percentile The percentile in [0, 100].
+		@return The upper bound of the bucket containing the percentile on the
+				CPU timer (capped to ::maxElapsed), or 0 if no span ended.
+		*/
+		PROFILE_API u64 GetElapsedPercentile(f64 _percentile) const noexcept;
+
+		/*!
+		@brief Outputs the statistics of the span.
+		*/
+		PROFILE_API void Report() const noexcept;
+
+		/*!
+		@brief Sets all the values of the span to 0 or nullptr.
+		*/
+		PROFILE_API void Clear() noexcept;
+
+		/*!
+		@brief Sets the counters of the span to 0.
+		@details Resetting do not change the name nor the location, nor
+				 ::openCount since the spans in flight still have to end.
+		*/
+		PROFILE_API void Reset() noexcept;
+	};
+
+	/*!
+	@brief Begins an asynchronous span: a span that may end on another thread,
+			identified by a user-supplied ID rather than by a scope (e.g., a
+			request from the moment it is enqueued by the network thread to the
+			moment a worker dequeues it).
+	@details The span is kept in a table of the spans in flight, shared by all
+			 the threads, until Profile::EndAsyncSpan is called with the same ID.
+			 Its time in flight is then added to the Profile::SpanRecorder of its
+			 type and the span is stored in the timeline exported by
+			 Profiler::ExportTimeline, with a flow from the thread it began on
+			 to the one it ended on.
+			 Use the PROFILE_ASYNC_SPAN_BEGIN macro rather than calling it directly.
+	@param _spanRecorderIdx The index of the statistics of the type of the span
+			in Profiler::spans (see Profiler::GetSpanRecorderIndex).
+	@param _id The ID of the span, unique among the spans in flight.
+	@return Whether the span began: false if no profiler is set, if the
+			profiling is disabled at runtime (see Profile::RuntimeSwitch) or if
+			a span with the same ID is already in flight (which is left untouched).
+	*/
+	extern PROFILE_API bool BeginAsyncSpan(u32 _spanRecorderIdx, u64 _id);
+
+	/*!
+	@brief Ends the asynchronous span begun with Profile::BeginAsyncSpan with
+			the same ID, possibly on another thread.
+	@param _id The ID of the span.
+	@return Whether a span with this ID was in flight.
+	*/
+	extern PROFILE_API bool EndAsyncSpan(u64 _id);
+
+	struct ProfileSpan;
+
+	/*!
+	@brief Wraps the awaiter of a co_await expression to pause a Profile::ProfileSpan
+			while the coroutine is suspended.
+	@details Built by ProfileSpan::Await. ::await_suspend pauses the span before
+			 forwarding the call, since the coroutine may be resumed (and the
+			 span destroyed) on another thread before it returns. ::await_resume
+			 resumes the span, on whichever thread the coroutine was resumed.
+	@tparam Awaiter The type of the wrapped awaiter: a reference to an lvalue
+			awaiter, or the awaiter itself otherwise.
+	*/
+	template<typename Awaiter>
+	struct ProfileSpanAwaiter
+	{
+		ProfileSpan* ptr_span = nullptr;
+		Awaiter awaiter;
+
+		bool await_ready()
+		{
+			return awaiter.await_ready();
+		}
+
+		template<typename Promise>
+		decltype(auto) await_suspend(std::coroutine_handle<Promise> _handle);
+
+		decltype(auto) await_resume();
+	};
+
+	/*!
+	@brief A profiled span of a coroutine, which may be suspended and resumed,
+			possibly on other threads, before it ends.
+	@details A Profile::ProfileBlock times its block on the stack of one thread:
+			 spanning a co_await, it would count the time the coroutine was
+			 suspended as if it was running, and ending on another thread would
+			 corrupt the track it was opened in. A span keeps its own timestamps
+			 (it lives in the frame of the coroutine) and only touches the shared
+			 Profile::SpanRecorder, atomically, when it ends. The time it spent
+			 suspended is reported separately from its active time.
+			 The span is paused around the co_await expressions wrapped with
+			 ::Await, or explicitly with ::Pause and ::Resume.
+			 Use the PROFILE_SPAN and PROFILE_FUNCTION_SPAN macros rather than
+			 constructing it directly.
+	*/
+	struct ProfileSpan
+	{
+		/*!
+		@brief The statistics the span is recorded in.
+		@details In the profiler of the thread that began the span (see
+				 Profile::SetThreadProfiler), or the global one. nullptr if the
+				 profiling was disabled at runtime when the span began.
+		*/
+		SpanRecorder* ptr_recorder = nullptr;
+
+		/*!
+		@brief The time the span began on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The time the span was paused on the CPU timer, or 0 if it runs.
+		*/
+		u64 pauseStart = 0;
+
+		/*!
+		@brief The time the span spent paused so far on the CPU timer.
+		*/
+		u64 suspendedElapsed = 0;
+
+		/*!
+		@brief The number of times the span was paused so far.
+		*/
+		u64 suspendCount = 0;
+
+		/*!
+		@brief Begins the span.
+		@param _spanRecorderIdx The index of the statistics of the span in
+				Profiler::spans (see Profiler::GetSpanRecorderIndex).
+		*/
+		PROFILE_API ProfileSpan(u32 _spanRecorderIdx) noexcept;
+		ProfileSpan(const ProfileSpan&) = delete;
+		ProfileSpan& operator=(const ProfileSpan&) = delete;
+
+		/*!
+		@brief Ends the span and records it. The span is resumed first if it
+				is paused.
+		*/
+		PROFILE_API ~ProfileSpan() noexcept;
+
+		/*!
+		@brief Wraps an awaitable so that the span is paused while the coroutine
+				awaits it: `co_await span.Await(socket.Read(buffer));`
+		@param _awaitable The awaitable, or awaiter, of the co_await expression.
+		@return The awaiter to co_await.
+		*/
+		template<typename Awaitable>
+		auto Await(Awaitable&& _awaitable)
+		{
+			using AwaiterResult = decltype(GetAwaiter(std::forward<Awaitable>(_awaitable)));
+			//A temporary awaiter is moved in the wrapper, an lvalue one is referenced
+			using Awaiter = std::conditional_t<std::is_rvalue_reference_v<AwaiterResult>, std::remove_reference_t<AwaiterResult>, AwaiterResult>;
+			return ProfileSpanAwaiter<Awaiter>{ this, GetAwaiter(std::forward<Awaitable>(_awaitable)) };
+		}
+
+		/*!
+		@brief Pauses the span: the time until ::Resume is counted as suspended.
+		@details Does nothing if the span is already paused.
+		*/
+		PROFILE_API void Pause() noexcept;
+
+		/*!
+		@brief Resumes the span after ::Pause.
+		@details Does nothing if the span is not paused.
+		*/
+		PROFILE_API void Resume() noexcept;
+
+	private:
+		/*!
+		@brief Gets the awaiter of an awaitable the way a co_await expression does:
+				through its operator co_await if it has one, or the awaitable itself.
+		*/
+		template<typename Awaitable>
+		static decltype(auto) GetAwaiter(Awaitable&& _awaitable)
+		{
+			if constexpr (requires { std::forward<Awaitable>(_awaitable).operator co_await(); })
+			{
+				return std::forward<Awaitable>(_awaitable).operator co_await();
+			}
+			else if constexpr (requires { operator co_await(std::forward<Awaitable>(_awaitable)); })
+			{
+				return operator co_await(std::forward<Awaitable>(_awaitable));
+			}
+			else
+			{
+				return std::forward<Awaitable>(_awaitable);
+			}
+		}
+	};
+
+	template<typename Awaiter>
+	template<typename Promise>
+	decltype(auto) ProfileSpanAwaiter<Awaiter>::await_suspend(std::coroutine_handle<Promise> _handle)
+	{
+		ptr_span->Pause();
+		return awaiter.await_suspend(_handle);
+	}
+
+	template<typename Awaiter>
+	decltype(auto) ProfileSpanAwaiter<Awaiter>::await_resume()
+	{
+		ptr_span->Resume();
+		return awaiter.await_resume();
+	}
+
+	struct Profiler;
+
+	/*!
+	@brief A block executed by a thread while a Profile::TailCaptureScope was open.
+	*/
+	struct TailEvent
+	{
+		/*!
+		@brief The name of the block.
+		@details Points to the name given to the profiling macro, so it lives
+				 as long as the program.
+		*/
+		const char* blockName = nullptr;
+
+		/*!
+		@brief The time the block was opened on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The time the block was closed on the CPU timer.
+		*/
+		u64 end = 0;
+	};
+
+	/*!
+	@brief The blocks a thread executed during a slow execution of a block
+			watched by a Profile::TailCaptureScope.
+	*/
+	struct TailCapture
+	{
+		/*!
+		@brief The name of the watched block.
+		*/
+		const char* blockName = nullptr;
+
+		/*!
+		@brief The profiler the blocks were recorded in.
+		*/
+		const Profiler* ptr_profiler = nullptr;
+
+		/*!
+		@brief The index of the thread in the timeline (see Profiler::ExportTimeline).
+		*/
+		u32 threadIdx = 0;
+
+		/*!
+		@brief The time the watched block was opened on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The time the watched block was closed on the CPU timer.
+		*/
+		u64 end = 0;
+
+		/*!
+		@brief The duration above which the watched block was captured on the CPU timer.
+		*/
+		u64 threshold = 0;
+
+		/*!
+		@brief The number of blocks executed during the watched block that did
+				not fit in the buffer of the thread (see NB_TAIL_EVENTS). The
+				oldest ones are dropped.
+		*/
+		u64 droppedEventCount = 0;
+
+		/*!
+		@brief The blocks executed during the watched block, in the order they
+				were closed. The watched block itself is the last one.
+		*/
+		std::vector<TailEvent> events;
+	};
+
+	/*!
+	@brief Watches a block of code (e.g., a request handler) and keeps the
+			blocks the thread executed during it when it is slow.
+	@details While a scope is open, the thread appends every block it closes
+			 to its own ring of the last NB_TAIL_EVENTS blocks, without any
+			 synchronization. When the scope ends after more than its
+			 threshold, the blocks executed since it opened are copied in the
+			 store of the last NB_TAIL_CAPTURES captures (see
+			 Profile::GetTailCaptures); otherwise they are discarded. Outside of
+			 the scopes, a block only pays the check of a thread-local pointer.
+			 A scope nested in another one only captures the blocks executed
+			 since it opened.
+			 Use the PROFILE_BLOCK_TIME_TAIL_CAPTURE macro rather than
+			 constructing it directly.
+	*/
+	struct TailCaptureScope
+	{
+		/*!
+		@brief The name of the watched block.
+		*/
+		const char* blockName = nullptr;
+
+		/*!
+		@brief The duration above which the blocks are captured on the CPU timer.
+		*/
+		u64 threshold = 0;
+
+		/*!
+		@brief The time the scope opened on the CPU timer.
+		*/
+		u64 start = 0;
+
+		/*!
+		@brief The number of blocks the thread had recorded when the scope opened.
+		*/
+		u64 firstEventIdx = 0;
+
+		/*!
+		@brief Whether the scope recorded the blocks of the thread. false if
+				the profiling was disabled at runtime when it opened.
+		*/
+		bool isActive = false;
+
+		/*!
+		@brief Whether the scope is not nested in another one.
+		*/
+		bool isOutermost = false;
+
+		/*!
+		@brief Starts recording the blocks of the thread if the track is active
+				(see Profile::RuntimeSwitch).
+		@param _blockName The name of the watched block.
+		@param _trackIdx The track of the watched block.
+		@param _threshold The duration above which the blocks are captured on
+				the CPU timer.
+		*/
+		PROFILE_API TailCaptureScope(const char* _blockName, u32 _trackIdx, u64 _threshold) noexcept;
+		TailCaptureScope(const TailCaptureScope&) = delete;
+		TailCaptureScope& operator=(const TailCaptureScope&) = delete;
+
+		/*!
+		@brief Captures the blocks if the scope lasted more than ::threshold and
+				stops recording them if the scope is the outermost one.
+		*/
+		PROFILE_API ~TailCaptureScope() noexcept;
+	};
+
+	/*!
+	@brief Copies the tail captures kept, from the oldest to the most recent one.
+	@param _captures Receives the captures.
+	@return The number of captures since the program started (or since
+			Profile::ClearTailCaptures), including those that were dropped.
+	*/
+	extern PROFILE_API u64 GetTailCaptures(std::vector<TailCapture>& _captures);
+
+	/*!
+	@brief Forgets the tail captures.
+	*/
+	extern PROFILE_API void ClearTailCaptures() noexcept;
+
+	/*!
+	@brief Stands for Profile::ProfileSpan when the profiler is disabled, so
+			that the code calling ::Await, ::Pause or ::Resume still compiles.
+	*/
+	struct NullProfileSpan
+	{
+		template<typename Awaitable>
+		inline Awaitable&& Await(Awaitable&& _awaitable) noexcept
+		{
+			return std::forward<Awaitable>(_awaitable);
+		}
+
+		inline void Pause() noexcept {}
+		inline void Resume() noexcept {}
+	};
+}
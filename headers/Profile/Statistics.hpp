@@ -0,0 +1,239 @@
+#pragma once
+
+#include "Export.hpp"
+#include "Types.hpp"
+
+namespace Profile
+{
+	/*!
+	@brief A small xorshift64* pseudo-random number generator.
+	@details It is used for resampling (bootstrap) and for shuffling test orders.
+			 It is deterministic for a given seed so that reports can be reproduced.
+	*/
+	struct RandomGenerator
+	{
+		/*!
+		@brief The internal state of the generator. Must never be 0.
+		*/
+		u64 state = 0x9E3779B97F4A7C15ull;
+
+		RandomGenerator() = default;
+
+		/*!
+		@brief Constructs a generator with a given seed.
+		@param _seed The seed. A seed of 0 is replaced by a default non-zero value.
+		*/
+		RandomGenerator(u64 _seed) : state(_seed ? _seed : 0x9E3779B97F4A7C15ull) {}
+
+		/*!
+		@brief Returns the next pseudo-random 64 bits integer.
+		*/
+		inline u64 Next() noexcept
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		/*!
+		@brief Returns a pseudo-random integer in [0, @p _bound[.
+		@param _bound The exclusive upper bound. Must be greater than 0.
+		*/
+		inline u64 NextBounded(u64 _bound) noexcept
+		{
+			return Next() % _bound;
+		}
+	};
+
+	/*!
+	@brief A set of summary statistics of a series of samples that are robust
+			to the skewed and heavy-tailed distributions typical of performance
+			measurements.
+	@details Next to the classic mean and standard deviation, it holds the median,
+			 the median absolute deviation (MAD), a few percentiles, a trimmed mean
+			 and a bootstrap confidence interval of the median. Samples whose modified
+			 z-score (0.6745 * |x - median| / MAD) exceeds a threshold are counted as
+			 outliers; on a quiet machine, those are typically repetitions that were
+			 hit by an interrupt, a context switch or a page fault storm.
+	*/
+	struct RobustStatistics
+	{
+		/*!
+		@brief The number of samples the statistics were computed on.
+		*/
+		u64 sampleCount = 0;
+
+		/*!
+		@brief The arithmetic mean of the samples.
+		*/
+		f64 mean = 0.0;
+
+		/*!
+		@brief The (population) standard deviation of the samples.
+		*/
+		f64 standardDeviation = 0.0;
+
+		/*!
+		@brief The smallest sample.
+		*/
+		f64 min = 0.0;
+
+		/*!
+		@brief The largest sample.
+		*/
+		f64 max = 0.0;
+
+		/*!
+		@brief The median (50th percentile) of the samples.
+		*/
+		f64 median = 0.0;
+
+		/*!
+		@brief The median of the absolute deviations to the median (not scaled).
+		*/
+		f64 medianAbsoluteDeviation = 0.0;
+
+		/*!
+		@brief The mean of the absolute deviations to the median (not scaled).
+		@details Used by ::IsOutlier when ::medianAbsoluteDeviation is 0.
+		*/
+		f64 meanAbsoluteDeviation = 0.0;
+
+		/*!
+		@brief The 5th percentile of the samples.
+		*/
+		f64 percentile5 = 0.0;
+
+		/*!
+		@brief The 25th percentile (first quartile) of the samples.
+		*/
+		f64 percentile25 = 0.0;
+
+		/*!
+		@brief The 75th percentile (third quartile) of the samples.
+		*/
+		f64 percentile75 = 0.0;
+
+		/*!
+		@brief The 95th percentile of the samples.
+		*/
+		f64 percentile95 = 0.0;
+
+		/*!
+		@brief The 99th percentile of the samples.
+		*/
+		f64 percentile99 = 0.0;
+
+		/*!
+		@brief The mean of the samples once the ::trimFraction lowest and highest
+				samples are discarded.
+		*/
+		f64 trimmedMean = 0.0;
+
+		/*!
+		@brief The lower bound of the bootstrap confidence interval of the median.
+		*/
+		f64 confidenceLow = 0.0;
+
+		/*!
+		@brief The upper bound of the bootstrap confidence interval of the median.
+		*/
+		f64 confidenceHigh = 0.0;
+
+		/*!
+		@brief The number of samples flagged as outliers.
+		@see ::IsOutlier
+		*/
+		u64 outlierCount = 0;
+
+		/*!
+		@brief The fraction of samples discarded on each side to compute ::trimmedMean.
+		*/
+		static constexpr f64 trimFraction = 0.1;
+
+		/*!
+		@brief The confidence level of [::confidenceLow, ::confidenceHigh].
+		*/
+		static constexpr f64 confidenceLevel = 0.95;
+
+		/*!
+		@brief The number of resamples drawn to compute the bootstrap confidence interval.
+		*/
+		static constexpr u32 bootstrapResampleCount = 1000;
+
+		/*!
+		@brief The modified z-score above which a sample is flagged as an outlier.
+		@details 3.5 is the value recommended by Iglewicz and Hoaglin.
+		*/
+		static constexpr f64 outlierThreshold = 3.5;
+
+		RobustStatistics() = default;
+
+		/*!
+		@brief Clears all the statistics.
+		*/
+		PROFILE_API void Clear() noexcept;
+
+		/*!
+		@brief Computes all the statistics of a series of samples.
+		@param _samples The samples. They will be sorted in place.
+		@param _sampleCount The number of samples.
+		@param _scratch A buffer of at least @p _sampleCount elements used for
+				intermediate computations (deviations and bootstrap resamples).
+		@param _generator The random generator used for the bootstrap resampling.
+		*/
+		PROFILE_API void Compute(f64* _samples, u64 _sampleCount, f64* _scratch, RandomGenerator& _generator) noexcept;
+
+		/*!
+		@brief Whether a value is an outlier regarding ::median and ::medianAbsoluteDeviation.
+		@details The function uses the modified z-score 0.6745 * |x - median| / MAD.
+				 When the MAD is 0 (more than half of the samples are equal, which
+				 is common with quantized cycle counts), it falls back to the
+				 mean absolute deviation: |x - median| / (1.2533 * MeanAD), 1.2533
+				 making it consistent with the MAD for normal samples. Only when
+				 all the samples are equal is no value an outlier.
+		@param _value The value to test.
+		*/
+		PROFILE_API bool IsOutlier(f64 _value) const noexcept;
+
+		/*!
+		@brief Outputs the statistics on a single line.
+		@param _scale A factor applied to all the values before printing (e.g., to
+				convert cycles to milliseconds).
+		@param _unit The unit to print after the values.
+		*/
+		PROFILE_API void Report(f64 _scale, const char* _unit) const noexcept;
+
+		/*!
+		@brief Computes a percentile of sorted samples by linear interpolation.
+		@param _sortedSamples The samples sorted in increasing order.
+		@param _sampleCount The number of samples.
+		@param _percentile The percentile in [0, 100].
+		*/
+		PROFILE_API static f64 Percentile(const f64* _sortedSamples, u64 _sampleCount, f64 _percentile) noexcept;
+
+		/*!
+		@brief Computes the mean of sorted samples after discarding a fraction of
+				the lowest and highest ones.
+		@param _sortedSamples The samples sorted in increasing order.
+		@param _sampleCount The number of samples.
+		@param _fraction The fraction of samples to discard on each side, in [0, 0.5[.
+		*/
+		PROFILE_API static f64 TrimmedMean(const f64* _sortedSamples, u64 _sampleCount, f64 _fraction) noexcept;
+
+		/*!
+		@brief Computes a percentile bootstrap confidence interval of the median.
+		@param _samples The samples (any order).
+		@param _sampleCount The number of samples.
+		@param _scratch A buffer of at least @p _sampleCount elements.
+		@param _generator The random generator used for the resampling.
+		@param _resampleCount The number of resamples.
+		@param _confidenceLevel The confidence level in ]0, 1[.
+		@param _low The lower bound of the interval.
+		@param _high The upper bound of the interval.
+		*/
+		PROFILE_API static void BootstrapMedianConfidenceInterval(const f64* _samples, u64 _sampleCount, f64* _scratch,
+			RandomGenerator& _generator, u32 _resampleCount, f64 _confidenceLevel, f64& _low, f64& _high) noexcept;
+	};
+}
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <cstdlib> //for strtoull
+#include <vector>
+#include "Profile/MemoryBenchmarks.hpp"
+
+/*
+Characterizes the memory system of the host with the built-in memory benchmarks
+of the profiler library:
+	1. the sequential read, write, copy and non-temporal write bandwidths of a
+	   buffer for every instruction set the CPU supports;
+	2. the latency of strided and random pointer chasing for working sets from
+	   4KB up to the size of the buffer.
+The best repetition of every test is summarized at the end and exported as CSV
+so that the reference numbers of several hosts can be compared.
+
+Usage: CppProfiler_Characterize [bufferSizeInMB=256] [repetitionCount=10] [csvPath=./Characterization.csv]
+*/
+
+/*!
+@brief The best repetition of a characterization test.
+*/
+struct CharacterizationResult
+{
+	const char* kind = nullptr;
+	char name[64] = {0};
+	const char* isa = "";
+	Profile::u64 byteCount = 0;
+	Profile::u64 stride = 0;
+	Profile::f64 bandwidthInB = 0.0;
+	Profile::f64 latencyInNs = 0.0;
+};
+
+/*!
+@brief Runs a test alone in the repetition profiler and returns its fastest repetition.
+@return The result of the only block of the test, or nullptr if the profiler is disabled.
+*/
+static const Profile::ProfileBlockResult* RunTest(Profile::RepetitionProfiler& _repetitionProfiler, Profile::RepetitionTest& _test, Profile::u64 _repetitionCount)
+{
+	_repetitionProfiler.ClearRepetitionTests();
+	_repetitionProfiler.PushBackRepetitionTest(&_test);
+	_repetitionProfiler.FixedCountRepetitionTesting(_repetitionCount, false, true);
+
+	const Profile::ProfileTrackResult& track = _repetitionProfiler.minResults.tracks[0];
+	return track.blockCount ? &track.timings[0] : nullptr;
+}
+
+int main(int _argc, char** _argv)
+{
+	Profile::u64 bufferByteCount = (_argc > 1 ? strtoull(_argv[1], nullptr, 10) : 256) << 20;
+	Profile::u64 repetitionCount = _argc > 2 ? strtoull(_argv[2], nullptr, 10) : 10;
+	const char* csvPath = _argc > 3 ? _argv[3] : "./Characterization.csv";
+	repetitionCount = repetitionCount ? repetitionCount : 1;
+
+	const Profile::CPUFeatures& features = Profile::CPUFeatures::Get();
+	printf("---- Characterizing %s (SSE2 %s, AVX2 %s, AVX-512 %s) ----\n", features.brand,
+		features.sse2 ? "yes" : "no", features.avx2 ? "yes" : "no", features.avx512f ? "yes" : "no");
+
+	Profile::Profiler* profiler = new Profile::Profiler();
+	Profile::SetProfiler(profiler);
+	Profile::ProfilerResults* results = new Profile::ProfilerResults[repetitionCount];
+	Profile::RepetitionProfiler* repetitionProfiler = new Profile::RepetitionProfiler();
+	repetitionProfiler->SetRepetitionResults(results);
+
+	std::vector<CharacterizationResult> summary;
+
+	//1. Sequential bandwidths
+	for (Profile::u8 operation = 0; operation < Profile::MemoryOperation_Count; ++operation)
+	{
+		for (Profile::u8 isa = 0; isa < Profile::KernelISA_Count; ++isa)
+		{
+			if (!Profile::Kernels::IsSupported((Profile::KernelISA)isa))
+			{
+				continue;
+			}
+
+			Profile::SequentialMemoryTest test((Profile::MemoryOperation)operation, (Profile::KernelISA)isa, bufferByteCount);
+			const Profile::ProfileBlockResult* best = RunTest(*repetitionProfiler, test, repetitionCount);
+
+			CharacterizationResult& result = summary.emplace_back();
+			result.kind = "Bandwidth";
+			snprintf(result.name, sizeof(result.name), "%s", test.label);
+			result.isa = Profile::Kernels::GetISAName(test.isa);
+			result.byteCount = test.byteCount;
+			result.bandwidthInB = best && best->elapsedSec > 0.0 ? (Profile::f64)best->processedByteCount / best->elapsedSec : 0.0;
+		}
+	}
+
+	//2. Latencies of the pointer chasing
+	for (Profile::u8 randomOrder = 0; randomOrder < 2; ++randomOrder)
+	{
+		for (Profile::u64 workingSetByteCount = 4096; workingSetByteCount <= bufferByteCount; workingSetByteCount *= 2)
+		{
+			Profile::PointerChaseTest test(workingSetByteCount, 64, randomOrder);
+			const Profile::ProfileBlockResult* best = RunTest(*repetitionProfiler, test, repetitionCount);
+
+			CharacterizationResult& result = summary.emplace_back();
+			result.kind = "Latency";
+			snprintf(result.name, sizeof(result.name), "%s", test.label);
+			result.byteCount = test.workingSetByteCount;
+			result.stride = test.stride;
+			result.bandwidthInB = best && best->elapsedSec > 0.0 ? (Profile::f64)best->processedByteCount / best->elapsedSec : 0.0;
+			result.latencyInNs = best ? test.GetLatencyInNs(best->elapsedSec) : 0.0;
+		}
+	}
+
+	printf("\n---- Characterization Summary: %s (best of %llu repetitions) ----\n", features.brand, repetitionCount);
+	for (const CharacterizationResult& result : summary)
+	{
+		if (result.latencyInNs > 0.0)
+		{
+			printf("%-40s %10.2fns per load\n", result.name, result.latencyInNs);
+		}
+		else
+		{
+			printf("%-40s %10.3fGB/s\n", result.name, result.bandwidthInB / (1 << 30));
+		}
+	}
+
+	FILE* file = fopen(csvPath, "w");
+	if (file)
+	{
+		printf("Exporting characterization to %s\n", csvPath);
+		fprintf(file, "CPU Brand,Kind,Test Name,ISA,Byte Count,Stride,Best Bandwidth In Bytes,Best Latency In Nanoseconds\n");
+		for (const CharacterizationResult& result : summary)
+		{
+			fprintf(file, "%s,%s,%s,%s,%llu,%llu,%f,%f\n",
+				features.brand, //CPU Brand
+				result.kind, //Kind
+				result.name, //Test Name
+				result.isa, //ISA
+				result.byteCount, //Byte Count
+				result.stride, //Stride
+				result.bandwidthInB, //Best Bandwidth In Bytes
+				result.latencyInNs //Best Latency In Nanoseconds
+				);
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", csvPath);
+	}
+
+	delete repetitionProfiler;
+	delete[] results;
+	delete profiler;
+
+	return 0;
+}
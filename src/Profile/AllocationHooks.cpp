@@ -0,0 +1,258 @@
+#include <cstdlib> //for malloc and free
+#include <new> //for std::bad_alloc, std::nothrow_t and std::align_val_t
+#include "Profile/Profiler.hpp"
+
+#if PROFILER_ENABLED && PROFILER_TRACK_ALLOCATIONS
+
+/*
+Heap allocation hooks attributing every allocation and deallocation to the
+innermost open block of the calling thread (see Profile::RecordAllocation).
+
+With glibc, the C allocation functions are interposed: defining them here takes
+precedence over the ones of the C library for the whole process, both when this
+file is compiled in the executable and when it is part of the shared profiler
+library. The real allocator is reached through the __libc_* entry points.
+operator new and operator delete of the C++ runtime are implemented on top of
+malloc and free, so they are covered as well without being counted twice.
+
+Both the allocations and the deallocations record the size the allocator reports
+for the block (e.g., malloc_usable_size), so that a block releasing everything it
+allocated frees as many bytes as it allocated.
+
+On the other platforms, the C allocation functions cannot be interposed portably,
+so the replaceable global operator new and operator delete are defined instead.
+On Windows, a replacement defined in a DLL only applies to the DLL itself: this
+file must then be compiled in the executable.
+*/
+
+#if defined(__GLIBC__)
+
+#include <malloc.h> //for malloc_usable_size
+
+extern "C"
+{
+	void* __libc_malloc(size_t _size);
+	void* __libc_calloc(size_t _count, size_t _size);
+	void* __libc_realloc(void* _ptr, size_t _size);
+	void* __libc_memalign(size_t _alignment, size_t _size);
+	void __libc_free(void* _ptr);
+
+	void* malloc(size_t _size)
+	{
+		void* ptr = __libc_malloc(_size);
+		if (ptr)
+		{
+			Profile::RecordAllocation(malloc_usable_size(ptr));
+		}
+		return ptr;
+	}
+
+	void* calloc(size_t _count, size_t _size)
+	{
+		void* ptr = __libc_calloc(_count, _size);
+		if (ptr)
+		{
+			Profile::RecordAllocation(malloc_usable_size(ptr));
+		}
+		return ptr;
+	}
+
+	void* realloc(void* _ptr, size_t _size)
+	{
+		size_t previousSize = _ptr ? malloc_usable_size(_ptr) : 0;
+		void* ptr = __libc_realloc(_ptr, _size);
+		if (ptr || _size == 0)
+		{
+			if (_ptr)
+			{
+				Profile::RecordDeallocation(previousSize);
+			}
+			if (ptr)
+			{
+				Profile::RecordAllocation(malloc_usable_size(ptr));
+			}
+		}
+		return ptr;
+	}
+
+	void* memalign(size_t _alignment, size_t _size)
+	{
+		void* ptr = __libc_memalign(_alignment, _size);
+		if (ptr)
+		{
+			Profile::RecordAllocation(malloc_usable_size(ptr));
+		}
+		return ptr;
+	}
+
+	void* aligned_alloc(size_t _alignment, size_t _size)
+	{
+		return memalign(_alignment, _size);
+	}
+
+	int posix_memalign(void** _ptr, size_t _alignment, size_t _size)
+	{
+		//The alignment must be a power of two multiple of sizeof(void*)
+		if (_alignment % sizeof(void*) != 0 || (_alignment & (_alignment - 1)) != 0)
+		{
+			return 22; //EINVAL
+		}
+		void* ptr = memalign(_alignment, _size);
+		if (ptr == nullptr)
+		{
+			return 12; //ENOMEM
+		}
+		*_ptr = ptr;
+		return 0;
+	}
+
+	void free(void* _ptr)
+	{
+		if (_ptr)
+		{
+			Profile::RecordDeallocation(malloc_usable_size(_ptr));
+			__libc_free(_ptr);
+		}
+	}
+}
+
+#else // __GLIBC__
+
+#if _WIN32
+	#include <malloc.h> //for _msize
+	#define PROFILER_ALLOCATION_SIZE(ptr) _msize(ptr)
+#elif __APPLE__
+	#include <malloc/malloc.h> //for malloc_size
+	#define PROFILER_ALLOCATION_SIZE(ptr) malloc_size(ptr)
+#else
+	//The size of a block is unknown: neither the allocations nor the deallocations record bytes
+	#define PROFILER_ALLOCATION_SIZE(ptr) 0
+#endif
+
+/*!
+@brief Allocates memory for the replaced operator new and records it.
+@details Aligned allocations are over-allocated and store the original pointer
+		 right before the aligned one.
+*/
+static void* AllocateAndRecord(size_t _size, size_t _alignment) noexcept
+{
+	void* base = nullptr;
+	void* ptr = nullptr;
+	if (_alignment <= alignof(std::max_align_t))
+	{
+		base = malloc(_size ? _size : 1);
+		ptr = base;
+	}
+	else
+	{
+		base = malloc(_size + _alignment + sizeof(void*));
+		if (base)
+		{
+			size_t address = ((size_t)base + sizeof(void*) + _alignment - 1) & ~(_alignment - 1);
+			ptr = (void*)address;
+			((void**)ptr)[-1] = base;
+		}
+	}
+	if (ptr)
+	{
+		Profile::RecordAllocation(PROFILER_ALLOCATION_SIZE(base));
+	}
+	return ptr;
+}
+
+/*!
+@brief Releases memory allocated by AllocateAndRecord and records it.
+*/
+static void FreeAndRecord(void* _ptr, size_t _alignment) noexcept
+{
+	if (_ptr)
+	{
+		void* base = _alignment <= alignof(std::max_align_t) ? _ptr : ((void**)_ptr)[-1];
+		Profile::RecordDeallocation(PROFILER_ALLOCATION_SIZE(base));
+		free(base);
+	}
+}
+
+void* operator new(size_t _size)
+{
+	void* ptr = AllocateAndRecord(_size, alignof(std::max_align_t));
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t _size)
+{
+	return operator new(_size);
+}
+
+void* operator new(size_t _size, const std::nothrow_t&) noexcept
+{
+	return AllocateAndRecord(_size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t _size, const std::nothrow_t&) noexcept
+{
+	return AllocateAndRecord(_size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t _size, std::align_val_t _alignment)
+{
+	void* ptr = AllocateAndRecord(_size, (size_t)_alignment);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t _size, std::align_val_t _alignment)
+{
+	return operator new(_size, _alignment);
+}
+
+void operator delete(void* _ptr) noexcept
+{
+	FreeAndRecord(_ptr, alignof(std::max_align_t));
+}
+
+void operator delete[](void* _ptr) noexcept
+{
+	FreeAndRecord(_ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* _ptr, size_t) noexcept
+{
+	FreeAndRecord(_ptr, alignof(std::max_align_t));
+}
+
+void operator delete[](void* _ptr, size_t) noexcept
+{
+	FreeAndRecord(_ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* _ptr, std::align_val_t _alignment) noexcept
+{
+	FreeAndRecord(_ptr, (size_t)_alignment);
+}
+
+void operator delete[](void* _ptr, std::align_val_t _alignment) noexcept
+{
+	FreeAndRecord(_ptr, (size_t)_alignment);
+}
+
+void operator delete(void* _ptr, size_t, std::align_val_t _alignment) noexcept
+{
+	FreeAndRecord(_ptr, (size_t)_alignment);
+}
+
+void operator delete[](void* _ptr, size_t, std::align_val_t _alignment) noexcept
+{
+	FreeAndRecord(_ptr, (size_t)_alignment);
+}
+
+#endif // __GLIBC__
+
+#endif // PROFILER_ENABLED && PROFILER_TRACK_ALLOCATIONS
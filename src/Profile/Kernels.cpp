@@ -0,0 +1,798 @@
+#include <cstring> //for memcpy and strlen
+#include <vector> //for the order of the slots in BuildPointerChain
+#include "Profile/Kernels.hpp"
+#include "Profile/Statistics.hpp" //for the RandomGenerator of BuildPointerChain
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define PROFILER_X86 1
+	#include <immintrin.h> //for the SSE2, AVX2 and AVX-512 intrinsics
+	#if _MSC_VER
+		#include <intrin.h> //for __cpuidex and _xgetbv
+	#else
+		#include <cpuid.h> //for __cpuid_count
+	#endif
+#else
+	#define PROFILER_X86 0
+#endif
+
+//GCC and Clang need to be told that a function may use instructions beyond the
+//baseline of the compilation target; MSVC accepts the intrinsics anywhere.
+#if PROFILER_X86 && (defined(__GNUC__) || defined(__clang__))
+	#define PROFILER_TARGET(isa) __attribute__((target(isa)))
+#else
+	#define PROFILER_TARGET(isa)
+#endif
+
+#if PROFILER_X86
+
+/*!
+@brief Executes CPUID for a leaf and a sub-leaf.
+@param _registers Receives EAX, EBX, ECX and EDX.
+*/
+static void CPUID(Profile::u32 _leaf, Profile::u32 _subLeaf, Profile::u32 _registers[4])
+{
+#if _MSC_VER
+	__cpuidex((int*)_registers, (int)_leaf, (int)_subLeaf);
+#else
+	__cpuid_count(_leaf, _subLeaf, _registers[0], _registers[1], _registers[2], _registers[3]);
+#endif
+}
+
+/*!
+@brief Reads an extended control register (XCR0 tells which registers the OS saves).
+*/
+static Profile::u64 XGetBV(Profile::u32 _idx)
+{
+#if _MSC_VER
+	return _xgetbv(_idx);
+#else
+	Profile::u32 low = 0;
+	Profile::u32 high = 0;
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(_idx));
+	return ((Profile::u64)high << 32) | low;
+#endif
+}
+
+#endif // PROFILER_X86
+
+const Profile::CPUFeatures& Profile::CPUFeatures::Get()
+{
+	static const CPUFeatures features = []()
+	{
+		CPUFeatures result;
+		strcpy(result.brand, "Unknown CPU");
+#if PROFILER_X86
+		u32 registers[4] = {};
+		CPUID(0, 0, registers);
+		u32 maxLeaf = registers[0];
+
+		CPUID(1, 0, registers);
+		result.sse2 = (registers[3] >> 26) & 1;
+		bool osXSave = (registers[2] >> 27) & 1;
+		u64 xcr0 = osXSave ? XGetBV(0) : 0;
+		//XMM and YMM states for AVX; opmask, ZMM0-15 upper halves and ZMM16-31 for AVX-512
+		bool osSavesAVX = (xcr0 & 0x6) == 0x6;
+		bool osSavesAVX512 = (xcr0 & 0xE6) == 0xE6;
+		result.fma = osSavesAVX && ((registers[2] >> 12) & 1);
+		if (maxLeaf >= 7)
+		{
+			CPUID(7, 0, registers);
+			result.avx2 = osSavesAVX && ((registers[1] >> 5) & 1);
+			result.avx512f = osSavesAVX512 && ((registers[1] >> 16) & 1);
+		}
+
+		CPUID(0x80000000, 0, registers);
+		if (registers[0] >= 0x80000004)
+		{
+			for (u32 i = 0; i < 3; ++i)
+			{
+				CPUID(0x80000002 + i, 0, registers);
+				memcpy(result.brand + 16 * i, registers, 16);
+			}
+			result.brand[48] = '\0';
+		}
+#endif
+		return result;
+	}();
+	return features;
+}
+
+/*!
+@brief The portable implementations of the kernels.
+*/
+namespace GenericKernels
+{
+	using namespace Profile;
+
+	//The accesses are volatile so that the compiler neither vectorizes nor merges
+	//them: the scalar kernels must stay 8 bytes loads and stores.
+
+	static u64 Read(const void* _data, u64 _byteCount)
+	{
+		const volatile u64* data = (const volatile u64*)_data;
+		u64 a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+		for (u64 i = 0; i < _byteCount / sizeof(u64); i += 4)
+		{
+			a0 ^= data[i];
+			a1 ^= data[i + 1];
+			a2 ^= data[i + 2];
+			a3 ^= data[i + 3];
+		}
+		return a0 + a1 + a2 + a3;
+	}
+
+	static void Write(void* _data, u64 _byteCount, u64 _value)
+	{
+		volatile u64* data = (volatile u64*)_data;
+		for (u64 i = 0; i < _byteCount / sizeof(u64); i += 4)
+		{
+			data[i] = _value;
+			data[i + 1] = _value;
+			data[i + 2] = _value;
+			data[i + 3] = _value;
+		}
+	}
+
+	static void Copy(void* _destination, const void* _source, u64 _byteCount)
+	{
+		volatile u64* destination = (volatile u64*)_destination;
+		const volatile u64* source = (const volatile u64*)_source;
+		for (u64 i = 0; i < _byteCount / sizeof(u64); i += 4)
+		{
+			destination[i] = source[i];
+			destination[i + 1] = source[i + 1];
+			destination[i + 2] = source[i + 2];
+			destination[i + 3] = source[i + 3];
+		}
+	}
+
+	static f64 ScalarFlops(u64 _iterationCount)
+	{
+		f64 a0 = 0.0, a1 = 0.1, a2 = 0.2, a3 = 0.3, a4 = 0.4, a5 = 0.5, a6 = 0.6, a7 = 0.7;
+		const f64 m = 0.999999;
+		const f64 c = 1e-6;
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			a0 = a0 * m + c; a1 = a1 * m + c; a2 = a2 * m + c; a3 = a3 * m + c;
+			a4 = a4 * m + c; a5 = a5 * m + c; a6 = a6 * m + c; a7 = a7 * m + c;
+		}
+		return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+	}
+
+	static f64 SIMDFlops(u64 _iterationCount)
+	{
+		//Left to the auto-vectorizer of the compiler.
+		f64 accumulators[16];
+		for (u32 j = 0; j < 16; ++j)
+		{
+			accumulators[j] = 0.01 * j;
+		}
+		const f64 m = 0.999999;
+		const f64 c = 1e-6;
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			for (u32 j = 0; j < 16; ++j)
+			{
+				accumulators[j] = accumulators[j] * m + c;
+			}
+		}
+		f64 sum = 0.0;
+		for (u32 j = 0; j < 16; ++j)
+		{
+			sum += accumulators[j];
+		}
+		return sum;
+	}
+}
+
+#if PROFILER_X86
+
+/*!
+@brief The implementations of the kernels with SSE2 instructions.
+*/
+namespace SSE2Kernels
+{
+	using namespace Profile;
+
+	PROFILER_TARGET("sse2") static u64 Read(const void* _data, u64 _byteCount)
+	{
+		const __m128i* data = (const __m128i*)_data;
+		__m128i a0 = _mm_setzero_si128(), a1 = a0, a2 = a0, a3 = a0;
+		for (u64 i = 0; i < _byteCount / sizeof(__m128i); i += 4)
+		{
+			a0 = _mm_xor_si128(a0, _mm_load_si128(data + i));
+			a1 = _mm_xor_si128(a1, _mm_load_si128(data + i + 1));
+			a2 = _mm_xor_si128(a2, _mm_load_si128(data + i + 2));
+			a3 = _mm_xor_si128(a3, _mm_load_si128(data + i + 3));
+		}
+		__m128i sum = _mm_add_epi64(_mm_add_epi64(a0, a1), _mm_add_epi64(a2, a3));
+		u64 lanes[2];
+		_mm_storeu_si128((__m128i*)lanes, sum);
+		return lanes[0] + lanes[1];
+	}
+
+	PROFILER_TARGET("sse2") static void Write(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m128i* data = (__m128i*)_data;
+		__m128i value = _mm_set1_epi64x((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m128i); i += 4)
+		{
+			_mm_store_si128(data + i, value);
+			_mm_store_si128(data + i + 1, value);
+			_mm_store_si128(data + i + 2, value);
+			_mm_store_si128(data + i + 3, value);
+		}
+	}
+
+	PROFILER_TARGET("sse2") static void Copy(void* _destination, const void* _source, u64 _byteCount)
+	{
+		__m128i* destination = (__m128i*)_destination;
+		const __m128i* source = (const __m128i*)_source;
+		for (u64 i = 0; i < _byteCount / sizeof(__m128i); i += 4)
+		{
+			_mm_store_si128(destination + i, _mm_load_si128(source + i));
+			_mm_store_si128(destination + i + 1, _mm_load_si128(source + i + 1));
+			_mm_store_si128(destination + i + 2, _mm_load_si128(source + i + 2));
+			_mm_store_si128(destination + i + 3, _mm_load_si128(source + i + 3));
+		}
+	}
+
+	PROFILER_TARGET("sse2") static void WriteNonTemporal(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m128i* data = (__m128i*)_data;
+		__m128i value = _mm_set1_epi64x((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m128i); i += 4)
+		{
+			_mm_stream_si128(data + i, value);
+			_mm_stream_si128(data + i + 1, value);
+			_mm_stream_si128(data + i + 2, value);
+			_mm_stream_si128(data + i + 3, value);
+		}
+		_mm_sfence();
+	}
+
+	/*!
+	@brief Non-temporal stores from the general purpose registers (MOVNTI).
+	*/
+	PROFILER_TARGET("sse2") static void WriteNonTemporalScalar(void* _data, u64 _byteCount, u64 _value)
+	{
+#if defined(__x86_64__) || defined(_M_X64)
+		long long* data = (long long*)_data;
+		for (u64 i = 0; i < _byteCount / sizeof(long long); i += 4)
+		{
+			_mm_stream_si64(data + i, (long long)_value);
+			_mm_stream_si64(data + i + 1, (long long)_value);
+			_mm_stream_si64(data + i + 2, (long long)_value);
+			_mm_stream_si64(data + i + 3, (long long)_value);
+		}
+#else
+		int* data = (int*)_data;
+		for (u64 i = 0; i < _byteCount / sizeof(int); i += 2)
+		{
+			_mm_stream_si32(data + i, (int)_value);
+			_mm_stream_si32(data + i + 1, (int)(_value >> 32));
+		}
+#endif
+		_mm_sfence();
+	}
+
+	/*!
+	@brief Scalar multiply-adds written with the scalar SSE2 instructions, so
+			that the compiler cannot vectorize them.
+	*/
+	PROFILER_TARGET("sse2") static f64 ScalarFlops(u64 _iterationCount)
+	{
+		__m128d a[8];
+		for (u32 j = 0; j < 8; ++j)
+		{
+			a[j] = _mm_set_sd(0.1 * j);
+		}
+		const __m128d m = _mm_set_sd(0.999999);
+		const __m128d c = _mm_set_sd(1e-6);
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			a[0] = _mm_add_sd(_mm_mul_sd(a[0], m), c);
+			a[1] = _mm_add_sd(_mm_mul_sd(a[1], m), c);
+			a[2] = _mm_add_sd(_mm_mul_sd(a[2], m), c);
+			a[3] = _mm_add_sd(_mm_mul_sd(a[3], m), c);
+			a[4] = _mm_add_sd(_mm_mul_sd(a[4], m), c);
+			a[5] = _mm_add_sd(_mm_mul_sd(a[5], m), c);
+			a[6] = _mm_add_sd(_mm_mul_sd(a[6], m), c);
+			a[7] = _mm_add_sd(_mm_mul_sd(a[7], m), c);
+		}
+		f64 sum = 0.0;
+		for (u32 j = 0; j < 8; ++j)
+		{
+			sum += _mm_cvtsd_f64(a[j]);
+		}
+		return sum;
+	}
+
+	PROFILER_TARGET("sse2") static f64 SIMDFlops(u64 _iterationCount)
+	{
+		__m128d a[12];
+		for (u32 j = 0; j < 12; ++j)
+		{
+			a[j] = _mm_set1_pd(0.1 * j);
+		}
+		const __m128d m = _mm_set1_pd(0.999999);
+		const __m128d c = _mm_set1_pd(1e-6);
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			a[0] = _mm_add_pd(_mm_mul_pd(a[0], m), c);
+			a[1] = _mm_add_pd(_mm_mul_pd(a[1], m), c);
+			a[2] = _mm_add_pd(_mm_mul_pd(a[2], m), c);
+			a[3] = _mm_add_pd(_mm_mul_pd(a[3], m), c);
+			a[4] = _mm_add_pd(_mm_mul_pd(a[4], m), c);
+			a[5] = _mm_add_pd(_mm_mul_pd(a[5], m), c);
+			a[6] = _mm_add_pd(_mm_mul_pd(a[6], m), c);
+			a[7] = _mm_add_pd(_mm_mul_pd(a[7], m), c);
+			a[8] = _mm_add_pd(_mm_mul_pd(a[8], m), c);
+			a[9] = _mm_add_pd(_mm_mul_pd(a[9], m), c);
+			a[10] = _mm_add_pd(_mm_mul_pd(a[10], m), c);
+			a[11] = _mm_add_pd(_mm_mul_pd(a[11], m), c);
+		}
+		__m128d sum = _mm_setzero_pd();
+		for (u32 j = 0; j < 12; ++j)
+		{
+			sum = _mm_add_pd(sum, a[j]);
+		}
+		f64 lanes[2];
+		_mm_storeu_pd(lanes, sum);
+		return lanes[0] + lanes[1];
+	}
+}
+
+/*!
+@brief The implementations of the kernels with AVX2 (and FMA) instructions.
+*/
+namespace AVX2Kernels
+{
+	using namespace Profile;
+
+	PROFILER_TARGET("avx2") static u64 Read(const void* _data, u64 _byteCount)
+	{
+		const __m256i* data = (const __m256i*)_data;
+		__m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0;
+		for (u64 i = 0; i < _byteCount / sizeof(__m256i); i += 4)
+		{
+			a0 = _mm256_xor_si256(a0, _mm256_load_si256(data + i));
+			a1 = _mm256_xor_si256(a1, _mm256_load_si256(data + i + 1));
+			a2 = _mm256_xor_si256(a2, _mm256_load_si256(data + i + 2));
+			a3 = _mm256_xor_si256(a3, _mm256_load_si256(data + i + 3));
+		}
+		__m256i sum = _mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3));
+		u64 lanes[4];
+		_mm256_storeu_si256((__m256i*)lanes, sum);
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	PROFILER_TARGET("avx2") static void Write(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m256i* data = (__m256i*)_data;
+		__m256i value = _mm256_set1_epi64x((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m256i); i += 4)
+		{
+			_mm256_store_si256(data + i, value);
+			_mm256_store_si256(data + i + 1, value);
+			_mm256_store_si256(data + i + 2, value);
+			_mm256_store_si256(data + i + 3, value);
+		}
+	}
+
+	PROFILER_TARGET("avx2") static void Copy(void* _destination, const void* _source, u64 _byteCount)
+	{
+		__m256i* destination = (__m256i*)_destination;
+		const __m256i* source = (const __m256i*)_source;
+		for (u64 i = 0; i < _byteCount / sizeof(__m256i); i += 4)
+		{
+			_mm256_store_si256(destination + i, _mm256_load_si256(source + i));
+			_mm256_store_si256(destination + i + 1, _mm256_load_si256(source + i + 1));
+			_mm256_store_si256(destination + i + 2, _mm256_load_si256(source + i + 2));
+			_mm256_store_si256(destination + i + 3, _mm256_load_si256(source + i + 3));
+		}
+	}
+
+	PROFILER_TARGET("avx2") static void WriteNonTemporal(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m256i* data = (__m256i*)_data;
+		__m256i value = _mm256_set1_epi64x((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m256i); i += 4)
+		{
+			_mm256_stream_si256(data + i, value);
+			_mm256_stream_si256(data + i + 1, value);
+			_mm256_stream_si256(data + i + 2, value);
+			_mm256_stream_si256(data + i + 3, value);
+		}
+		_mm_sfence();
+	}
+
+	PROFILER_TARGET("avx2,fma") static f64 SIMDFlops(u64 _iterationCount)
+	{
+		//12 independent chains cover the latency of two FMA units (4 cycles each).
+		//They are written out so that they stay in registers.
+		__m256d a[12];
+		for (u32 j = 0; j < 12; ++j)
+		{
+			a[j] = _mm256_set1_pd(0.1 * j);
+		}
+		const __m256d m = _mm256_set1_pd(0.999999);
+		const __m256d c = _mm256_set1_pd(1e-6);
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			a[0] = _mm256_fmadd_pd(a[0], m, c);
+			a[1] = _mm256_fmadd_pd(a[1], m, c);
+			a[2] = _mm256_fmadd_pd(a[2], m, c);
+			a[3] = _mm256_fmadd_pd(a[3], m, c);
+			a[4] = _mm256_fmadd_pd(a[4], m, c);
+			a[5] = _mm256_fmadd_pd(a[5], m, c);
+			a[6] = _mm256_fmadd_pd(a[6], m, c);
+			a[7] = _mm256_fmadd_pd(a[7], m, c);
+			a[8] = _mm256_fmadd_pd(a[8], m, c);
+			a[9] = _mm256_fmadd_pd(a[9], m, c);
+			a[10] = _mm256_fmadd_pd(a[10], m, c);
+			a[11] = _mm256_fmadd_pd(a[11], m, c);
+		}
+		__m256d sum = _mm256_setzero_pd();
+		for (u32 j = 0; j < 12; ++j)
+		{
+			sum = _mm256_add_pd(sum, a[j]);
+		}
+		f64 lanes[4];
+		_mm256_storeu_pd(lanes, sum);
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+}
+
+/*!
+@brief The implementations of the kernels with AVX-512 Foundation instructions.
+*/
+namespace AVX512Kernels
+{
+	using namespace Profile;
+
+	PROFILER_TARGET("avx512f") static u64 Read(const void* _data, u64 _byteCount)
+	{
+		const __m512i* data = (const __m512i*)_data;
+		__m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0;
+		for (u64 i = 0; i < _byteCount / sizeof(__m512i); i += 4)
+		{
+			a0 = _mm512_xor_si512(a0, _mm512_load_si512(data + i));
+			a1 = _mm512_xor_si512(a1, _mm512_load_si512(data + i + 1));
+			a2 = _mm512_xor_si512(a2, _mm512_load_si512(data + i + 2));
+			a3 = _mm512_xor_si512(a3, _mm512_load_si512(data + i + 3));
+		}
+		__m512i sum = _mm512_add_epi64(_mm512_add_epi64(a0, a1), _mm512_add_epi64(a2, a3));
+		u64 lanes[8];
+		_mm512_storeu_si512(lanes, sum);
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+	}
+
+	PROFILER_TARGET("avx512f") static void Write(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m512i* data = (__m512i*)_data;
+		__m512i value = _mm512_set1_epi64((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m512i); i += 4)
+		{
+			_mm512_store_si512(data + i, value);
+			_mm512_store_si512(data + i + 1, value);
+			_mm512_store_si512(data + i + 2, value);
+			_mm512_store_si512(data + i + 3, value);
+		}
+	}
+
+	PROFILER_TARGET("avx512f") static void WriteNonTemporal(void* _data, u64 _byteCount, u64 _value)
+	{
+		__m512i* data = (__m512i*)_data;
+		__m512i value = _mm512_set1_epi64((long long)_value);
+		for (u64 i = 0; i < _byteCount / sizeof(__m512i); i += 4)
+		{
+			_mm512_stream_si512(data + i, value);
+			_mm512_stream_si512(data + i + 1, value);
+			_mm512_stream_si512(data + i + 2, value);
+			_mm512_stream_si512(data + i + 3, value);
+		}
+		_mm_sfence();
+	}
+
+	PROFILER_TARGET("avx512f") static void Copy(void* _destination, const void* _source, u64 _byteCount)
+	{
+		__m512i* destination = (__m512i*)_destination;
+		const __m512i* source = (const __m512i*)_source;
+		for (u64 i = 0; i < _byteCount / sizeof(__m512i); i += 4)
+		{
+			_mm512_store_si512(destination + i, _mm512_load_si512(source + i));
+			_mm512_store_si512(destination + i + 1, _mm512_load_si512(source + i + 1));
+			_mm512_store_si512(destination + i + 2, _mm512_load_si512(source + i + 2));
+			_mm512_store_si512(destination + i + 3, _mm512_load_si512(source + i + 3));
+		}
+	}
+
+	PROFILER_TARGET("avx512f") static f64 SIMDFlops(u64 _iterationCount)
+	{
+		//Same 12 chains as the AVX2 kernel, with 8 lanes.
+		__m512d a[12];
+		for (u32 j = 0; j < 12; ++j)
+		{
+			a[j] = _mm512_set1_pd(0.1 * j);
+		}
+		const __m512d m = _mm512_set1_pd(0.999999);
+		const __m512d c = _mm512_set1_pd(1e-6);
+		for (u64 i = 0; i < _iterationCount; ++i)
+		{
+			a[0] = _mm512_fmadd_pd(a[0], m, c);
+			a[1] = _mm512_fmadd_pd(a[1], m, c);
+			a[2] = _mm512_fmadd_pd(a[2], m, c);
+			a[3] = _mm512_fmadd_pd(a[3], m, c);
+			a[4] = _mm512_fmadd_pd(a[4], m, c);
+			a[5] = _mm512_fmadd_pd(a[5], m, c);
+			a[6] = _mm512_fmadd_pd(a[6], m, c);
+			a[7] = _mm512_fmadd_pd(a[7], m, c);
+			a[8] = _mm512_fmadd_pd(a[8], m, c);
+			a[9] = _mm512_fmadd_pd(a[9], m, c);
+			a[10] = _mm512_fmadd_pd(a[10], m, c);
+			a[11] = _mm512_fmadd_pd(a[11], m, c);
+		}
+		__m512d sum = _mm512_setzero_pd();
+		for (u32 j = 0; j < 12; ++j)
+		{
+			sum = _mm512_add_pd(sum, a[j]);
+		}
+		f64 lanes[8];
+		_mm512_storeu_pd(lanes, sum);
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+	}
+}
+
+#endif // PROFILER_X86
+
+Profile::KernelISA Profile::Kernels::GetBestISA()
+{
+	const CPUFeatures& features = CPUFeatures::Get();
+	if (features.avx512f)
+	{
+		return KernelISA_AVX512;
+	}
+	if (features.avx2)
+	{
+		return KernelISA_AVX2;
+	}
+	if (features.sse2)
+	{
+		return KernelISA_SSE2;
+	}
+	return KernelISA_Scalar;
+}
+
+const char* Profile::Kernels::GetISAName(KernelISA _isa)
+{
+	switch (_isa)
+	{
+	case KernelISA_Scalar:
+		return "Scalar";
+	case KernelISA_SSE2:
+		return "SSE2";
+	case KernelISA_AVX2:
+		return "AVX2";
+	case KernelISA_AVX512:
+		return "AVX-512";
+	default:
+		return GetISAName(GetBestISA());
+	}
+}
+
+bool Profile::Kernels::IsSupported(KernelISA _isa)
+{
+	const CPUFeatures& features = CPUFeatures::Get();
+	switch (_isa)
+	{
+	case KernelISA_Scalar:
+	case KernelISA_Best:
+		return true;
+	case KernelISA_SSE2:
+		return features.sse2;
+	case KernelISA_AVX2:
+		return features.avx2;
+	case KernelISA_AVX512:
+		return features.avx512f;
+	default:
+		return false;
+	}
+}
+
+/*!
+@brief Replaces KernelISA_Best and the instruction sets the CPU does not support
+		by the widest supported one.
+*/
+static Profile::KernelISA ResolveISA(Profile::KernelISA _isa)
+{
+	return _isa != Profile::KernelISA_Best && Profile::Kernels::IsSupported(_isa) ? _isa : Profile::Kernels::GetBestISA();
+}
+
+Profile::u64 Profile::Kernels::Read(const void* _data, u64 _byteCount, KernelISA _isa)
+{
+	switch (ResolveISA(_isa))
+	{
+#if PROFILER_X86
+	case KernelISA_AVX512:
+		return AVX512Kernels::Read(_data, _byteCount);
+	case KernelISA_AVX2:
+		return AVX2Kernels::Read(_data, _byteCount);
+	case KernelISA_SSE2:
+		return SSE2Kernels::Read(_data, _byteCount);
+#endif
+	default:
+		return GenericKernels::Read(_data, _byteCount);
+	}
+}
+
+void Profile::Kernels::Write(void* _data, u64 _byteCount, u64 _value, KernelISA _isa)
+{
+	switch (ResolveISA(_isa))
+	{
+#if PROFILER_X86
+	case KernelISA_AVX512:
+		return AVX512Kernels::Write(_data, _byteCount, _value);
+	case KernelISA_AVX2:
+		return AVX2Kernels::Write(_data, _byteCount, _value);
+	case KernelISA_SSE2:
+		return SSE2Kernels::Write(_data, _byteCount, _value);
+#endif
+	default:
+		return GenericKernels::Write(_data, _byteCount, _value);
+	}
+}
+
+void Profile::Kernels::WriteNonTemporal(void* _data, u64 _byteCount, u64 _value, KernelISA _isa)
+{
+	switch (ResolveISA(_isa))
+	{
+#if PROFILER_X86
+	case KernelISA_AVX512:
+		return AVX512Kernels::WriteNonTemporal(_data, _byteCount, _value);
+	case KernelISA_AVX2:
+		return AVX2Kernels::WriteNonTemporal(_data, _byteCount, _value);
+	case KernelISA_SSE2:
+		return SSE2Kernels::WriteNonTemporal(_data, _byteCount, _value);
+	case KernelISA_Scalar:
+		//MOVNTI is part of SSE2, always available on x86-64
+		if (CPUFeatures::Get().sse2)
+		{
+			return SSE2Kernels::WriteNonTemporalScalar(_data, _byteCount, _value);
+		}
+		return GenericKernels::Write(_data, _byteCount, _value);
+#endif
+	default:
+		return GenericKernels::Write(_data, _byteCount, _value);
+	}
+}
+
+void Profile::Kernels::Copy(void* _destination, const void* _source, u64 _byteCount, KernelISA _isa)
+{
+	switch (ResolveISA(_isa))
+	{
+#if PROFILER_X86
+	case KernelISA_AVX512:
+		return AVX512Kernels::Copy(_destination, _source, _byteCount);
+	case KernelISA_AVX2:
+		return AVX2Kernels::Copy(_destination, _source, _byteCount);
+	case KernelISA_SSE2:
+		return SSE2Kernels::Copy(_destination, _source, _byteCount);
+#endif
+	default:
+		return GenericKernels::Copy(_destination, _source, _byteCount);
+	}
+}
+
+const void* Profile::Kernels::BuildPointerChain(void* _buffer, u64 _byteCount, u64 _stride, u64 _seed)
+{
+	_stride = _stride < sizeof(void*) ? sizeof(void*) : _stride;
+	u64 slotCount = _byteCount / _stride;
+	slotCount = slotCount ? slotCount : 1;
+	u8* buffer = (u8*)_buffer;
+
+	std::vector<u64> order(slotCount);
+	for (u64 i = 0; i < slotCount; ++i)
+	{
+		order[i] = i;
+	}
+
+	if (_seed)
+	{
+		//Sattolo's algorithm: a random permutation made of a single cycle, so
+		//that the chase visits every slot before coming back to the start.
+		RandomGenerator generator(_seed);
+		for (u64 i = slotCount - 1; i > 0; --i)
+		{
+			u64 j = generator.NextBounded(i);
+			u64 swap = order[i];
+			order[i] = order[j];
+			order[j] = swap;
+		}
+	}
+
+	for (u64 i = 0; i < slotCount; ++i)
+	{
+		void** slot = (void**)(buffer + order[i] * _stride);
+		*slot = buffer + order[(i + 1) % slotCount] * _stride;
+	}
+
+	return buffer + order[0] * _stride;
+}
+
+const void* Profile::Kernels::PointerChase(const void* _start, u64 _stepCount)
+{
+	const void* const* pointer = (const void* const*)_start;
+	u64 i = 0;
+	for (; i + 4 <= _stepCount; i += 4)
+	{
+		pointer = (const void* const*)*pointer;
+		pointer = (const void* const*)*pointer;
+		pointer = (const void* const*)*pointer;
+		pointer = (const void* const*)*pointer;
+	}
+	for (; i < _stepCount; ++i)
+	{
+		pointer = (const void* const*)*pointer;
+	}
+	return pointer;
+}
+
+Profile::f64 Profile::Kernels::ScalarFlops(u64 _iterationCount)
+{
+#if PROFILER_X86
+	if (CPUFeatures::Get().sse2)
+	{
+		return SSE2Kernels::ScalarFlops(_iterationCount);
+	}
+#endif
+	return GenericKernels::ScalarFlops(_iterationCount);
+}
+
+Profile::u64 Profile::Kernels::ScalarFlopsPerIteration()
+{
+	//8 chains of one multiplication and one addition
+	return 8 * 2;
+}
+
+Profile::f64 Profile::Kernels::SIMDFlops(u64 _iterationCount)
+{
+#if PROFILER_X86
+	if (CPUFeatures::Get().avx512f)
+	{
+		return AVX512Kernels::SIMDFlops(_iterationCount);
+	}
+	if (CPUFeatures::Get().avx2 && CPUFeatures::Get().fma)
+	{
+		return AVX2Kernels::SIMDFlops(_iterationCount);
+	}
+	if (CPUFeatures::Get().sse2)
+	{
+		return SSE2Kernels::SIMDFlops(_iterationCount);
+	}
+#endif
+	return GenericKernels::SIMDFlops(_iterationCount);
+}
+
+Profile::u64 Profile::Kernels::SIMDFlopsPerIteration()
+{
+#if PROFILER_X86
+	if (CPUFeatures::Get().avx512f)
+	{
+		//12 chains of 8 lanes of one fused multiply-add
+		return 12 * 8 * 2;
+	}
+	if (CPUFeatures::Get().avx2 && CPUFeatures::Get().fma)
+	{
+		//12 chains of 4 lanes of one fused multiply-add
+		return 12 * 4 * 2;
+	}
+	if (CPUFeatures::Get().sse2)
+	{
+		//12 chains of 2 lanes of one multiplication and one addition
+		return 12 * 2 * 2;
+	}
+#endif
+	//16 chains of one multiplication and one addition
+	return 16 * 2;
+}
@@ -0,0 +1,286 @@
+#include <cstdio> //for snprintf
+#include <cstring> //for memcpy and memset
+#include "Profile/LiveSnapshot.hpp"
+#include "Profile/Profiler.hpp"
+
+#if _WIN32
+#include <windows.h> //for CreateFileMappingA and MapViewOfFile
+#else
+#include <fcntl.h> //for O_CREAT and O_RDWR
+#include <sys/mman.h> //for shm_open and mmap
+#include <sys/stat.h> //for fstat
+#include <unistd.h> //for ftruncate and close
+#endif
+
+/*
+The segment is updated with a seqlock: the publisher makes the sequence number
+odd, writes the tables and makes it even again; a reader copies the segment
+between two loads of the sequence number and keeps the copy only if both loads
+returned the same even value. The copy of the data itself races with the
+publisher by design, which is why it is only trusted after the second check.
+*/
+
+#if _WIN32
+/*!
+@brief Skips the leading '/' of a POSIX name, not allowed in Windows object names.
+*/
+static const char* GetOSSegmentName(const char* _segmentName)
+{
+	return _segmentName[0] == '/' ? _segmentName + 1 : _segmentName;
+}
+#endif
+
+Profile::LiveSnapshotPublisher::~LiveSnapshotPublisher()
+{
+	Close();
+}
+
+bool Profile::LiveSnapshotPublisher::Open(const char* _segmentName) noexcept
+{
+	Close();
+
+	u64 byteCount = LiveSnapshotHeader::GetByteCount(NB_TRACKS, NB_TIMINGS);
+	u8* mapping = nullptr;
+#if _WIN32
+	HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		(DWORD)(byteCount >> 32), (DWORD)byteCount, GetOSSegmentName(_segmentName));
+	if (handle == nullptr)
+	{
+		return false;
+	}
+	mapping = (u8*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, byteCount);
+	if (mapping == nullptr)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+	ptr_osHandle = handle;
+#else
+	int fileDescriptor = shm_open(_segmentName, O_CREAT | O_RDWR, 0644);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+	if (ftruncate(fileDescriptor, (off_t)byteCount) != 0)
+	{
+		close(fileDescriptor);
+		shm_unlink(_segmentName);
+		return false;
+	}
+	void* address = mmap(nullptr, byteCount, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (address == MAP_FAILED)
+	{
+		shm_unlink(_segmentName);
+		return false;
+	}
+	mapping = (u8*)address;
+#endif
+
+	memset(mapping, 0, byteCount);
+	LiveSnapshotHeader* header = new (mapping) LiveSnapshotHeader();
+	header->trackCount = NB_TRACKS;
+	header->blockCapacity = NB_TIMINGS;
+	header->cpuFreq = Timer::GetEstimatedCPUFreq();
+
+	snprintf(segmentName, sizeof(segmentName), "%s", _segmentName);
+	ptr_trackCopy = new ProfileTrack();
+	ptr_mapping = mapping;
+	mappingByteCount = byteCount;
+	return true;
+}
+
+void Profile::LiveSnapshotPublisher::Close() noexcept
+{
+	if (ptr_mapping == nullptr)
+	{
+		return;
+	}
+
+#if _WIN32
+	UnmapViewOfFile(ptr_mapping);
+	CloseHandle((HANDLE)ptr_osHandle);
+	ptr_osHandle = nullptr;
+#else
+	munmap(ptr_mapping, mappingByteCount);
+	shm_unlink(segmentName);
+#endif
+	delete ptr_trackCopy;
+	ptr_trackCopy = nullptr;
+	ptr_mapping = nullptr;
+	mappingByteCount = 0;
+	segmentName[0] = '\0';
+}
+
+bool Profile::LiveSnapshotPublisher::Publish(const Profiler& _profiler) noexcept
+{
+	if (ptr_mapping == nullptr)
+	{
+		return false;
+	}
+
+	LiveSnapshotHeader* header = (LiveSnapshotHeader*)ptr_mapping;
+	u64 sequence = header->sequence.load(std::memory_order_relaxed);
+	header->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	header->publishCount++;
+	header->publishTime = Timer::GetCPUTimer();
+	header->elapsed = _profiler.start ? header->publishTime - _profiler.start : 0;
+	snprintf(header->profilerName, sizeof(header->profilerName), "%s", _profiler.name);
+
+	bool published = true;
+	for (u32 i = 0; i < NB_TRACKS; ++i)
+	{
+		if (!_profiler.tracks[i].CaptureConsistent(*ptr_trackCopy))
+		{
+			//Keep the previous tables of the track rather than torn ones
+			published = false;
+			continue;
+		}
+		const ProfileTrack& track = *ptr_trackCopy;
+		LiveTrackSnapshot* trackSnapshot = (LiveTrackSnapshot*)(ptr_mapping + LiveSnapshotHeader::GetTrackOffset(i, NB_TIMINGS));
+		LiveBlockSnapshot* blockSnapshots = (LiveBlockSnapshot*)(trackSnapshot + 1);
+
+		snprintf(trackSnapshot->name, sizeof(trackSnapshot->name), "%s", track.name);
+		trackSnapshot->elapsed = track.elapsed;
+
+		u32 blockCount = 0;
+		if (track.hasBlock)
+		{
+			for (u32 j = 0; j < NB_TIMINGS; ++j)
+			{
+				const ProfileBlockRecorder& record = track.timings[j];
+				if (record.hitCount == 0)
+				{
+					continue;
+				}
+
+				LiveBlockSnapshot& blockSnapshot = blockSnapshots[blockCount++];
+				snprintf(blockSnapshot.name, sizeof(blockSnapshot.name), "%s", record.blockName ? record.blockName : "");
+				blockSnapshot.recorderIdx = j;
+				blockSnapshot.hitCount = record.hitCount;
+				blockSnapshot.elapsed = record.elapsed;
+				blockSnapshot.processedByteCount = record.processedByteCount;
+				blockSnapshot.flopCount = record.flopCount;
+				blockSnapshot.allocationCount = record.allocationCount;
+				blockSnapshot.allocatedByteCount = record.allocatedByteCount;
+				blockSnapshot.pageFaultCount = record.pageFaultCountTotal;
+			}
+		}
+		trackSnapshot->blockCount = blockCount;
+	}
+
+	header->sequence.store(sequence + 2, std::memory_order_release);
+	return published;
+}
+
+Profile::LiveSnapshotReader::~LiveSnapshotReader()
+{
+	Detach();
+}
+
+bool Profile::LiveSnapshotReader::Attach(const char* _segmentName) noexcept
+{
+	Detach();
+
+	const u8* mapping = nullptr;
+	u64 byteCount = 0;
+#if _WIN32
+	HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, GetOSSegmentName(_segmentName));
+	if (handle == nullptr)
+	{
+		return false;
+	}
+	mapping = (const u8*)MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+	if (mapping == nullptr)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+	MEMORY_BASIC_INFORMATION information;
+	VirtualQuery(mapping, &information, sizeof(information));
+	byteCount = information.RegionSize;
+	ptr_osHandle = handle;
+#else
+	int fileDescriptor = shm_open(_segmentName, O_RDONLY, 0);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	if (fstat(fileDescriptor, &status) != 0 || (u64)status.st_size < sizeof(LiveSnapshotHeader))
+	{
+		close(fileDescriptor);
+		return false;
+	}
+	byteCount = (u64)status.st_size;
+	void* address = mmap(nullptr, byteCount, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (address == MAP_FAILED)
+	{
+		return false;
+	}
+	mapping = (const u8*)address;
+#endif
+
+	ptr_mapping = mapping;
+	mappingByteCount = byteCount;
+
+	const LiveSnapshotHeader* header = (const LiveSnapshotHeader*)mapping;
+	if (header->magic != LiveSnapshotHeader::magicValue || header->version != LiveSnapshotHeader::layoutVersion ||
+		LiveSnapshotHeader::GetByteCount(header->trackCount, header->blockCapacity) > byteCount)
+	{
+		Detach();
+		return false;
+	}
+	return true;
+}
+
+void Profile::LiveSnapshotReader::Detach() noexcept
+{
+	if (ptr_mapping == nullptr)
+	{
+		return;
+	}
+
+#if _WIN32
+	UnmapViewOfFile(ptr_mapping);
+	CloseHandle((HANDLE)ptr_osHandle);
+	ptr_osHandle = nullptr;
+#else
+	munmap((void*)ptr_mapping, mappingByteCount);
+#endif
+	ptr_mapping = nullptr;
+	mappingByteCount = 0;
+}
+
+bool Profile::LiveSnapshotReader::Read(u32 _maxRetryCount)
+{
+	if (ptr_mapping == nullptr)
+	{
+		return false;
+	}
+
+	const LiveSnapshotHeader* header = (const LiveSnapshotHeader*)ptr_mapping;
+	u64 byteCount = LiveSnapshotHeader::GetByteCount(header->trackCount, header->blockCapacity);
+	std::vector<u8> copy(byteCount);
+	for (u32 attempt = 0; attempt < _maxRetryCount; ++attempt)
+	{
+		u64 sequenceBefore = header->sequence.load(std::memory_order_acquire);
+		if (sequenceBefore & 1)
+		{
+			continue;
+		}
+
+		memcpy(copy.data(), ptr_mapping, byteCount);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->sequence.load(std::memory_order_relaxed) == sequenceBefore)
+		{
+			snapshot.swap(copy);
+			return true;
+		}
+	}
+	return false;
+}
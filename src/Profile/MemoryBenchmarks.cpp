@@ -0,0 +1,164 @@
+#include <cstdio> //for snprintf
+#include <new> //for the aligned operator new
+#include "Profile/MemoryBenchmarks.hpp"
+
+/*
+The kernels are wrapped in functions of their own so that every operation is
+profiled as a block named after it, and so that the profile block does not
+include the bookkeeping of the tests.
+*/
+
+static Profile::u64 SequentialRead(const void* _data, Profile::u64 _byteCount, Profile::KernelISA _isa)
+{
+	PROFILE_FUNCTION_TIME_BANDWIDTH(0, _byteCount);
+	return Profile::Kernels::Read(_data, _byteCount, _isa);
+}
+
+static void SequentialWrite(void* _data, Profile::u64 _byteCount, Profile::KernelISA _isa)
+{
+	PROFILE_FUNCTION_TIME_BANDWIDTH(0, _byteCount);
+	Profile::Kernels::Write(_data, _byteCount, _byteCount, _isa);
+}
+
+static void SequentialCopy(void* _destination, const void* _source, Profile::u64 _byteCount, Profile::KernelISA _isa)
+{
+	PROFILE_FUNCTION_TIME_BANDWIDTH(0, 2 * _byteCount);
+	Profile::Kernels::Copy(_destination, _source, _byteCount, _isa);
+}
+
+static void SequentialWriteNonTemporal(void* _data, Profile::u64 _byteCount, Profile::KernelISA _isa)
+{
+	PROFILE_FUNCTION_TIME_BANDWIDTH(0, _byteCount);
+	Profile::Kernels::WriteNonTemporal(_data, _byteCount, _byteCount, _isa);
+}
+
+static const void* PointerChase(const void* _start, Profile::u64 _stepCount)
+{
+	PROFILE_FUNCTION_TIME_BANDWIDTH(0, _stepCount * sizeof(void*));
+	return Profile::Kernels::PointerChase(_start, _stepCount);
+}
+
+/*!
+@brief Allocates a buffer aligned on 64 bytes and touches all its pages.
+*/
+static Profile::u8* AllocateTouchedBuffer(Profile::u64 _byteCount)
+{
+	Profile::u8* buffer = (Profile::u8*)operator new(_byteCount, std::align_val_t(64));
+	Profile::Kernels::Write(buffer, _byteCount, 0);
+	return buffer;
+}
+
+/*!
+@brief Writes a size in bytes with the largest unit that divides it, e.g. "256MB".
+*/
+static void FormatByteCount(char* _buffer, Profile::u64 _bufferSize, Profile::u64 _byteCount)
+{
+	if (_byteCount >= (1ull << 30) && _byteCount % (1ull << 30) == 0)
+	{
+		snprintf(_buffer, _bufferSize, "%lluGB", _byteCount >> 30);
+	}
+	else if (_byteCount >= (1ull << 20) && _byteCount % (1ull << 20) == 0)
+	{
+		snprintf(_buffer, _bufferSize, "%lluMB", _byteCount >> 20);
+	}
+	else if (_byteCount >= (1ull << 10) && _byteCount % (1ull << 10) == 0)
+	{
+		snprintf(_buffer, _bufferSize, "%lluKB", _byteCount >> 10);
+	}
+	else
+	{
+		snprintf(_buffer, _bufferSize, "%lluB", _byteCount);
+	}
+}
+
+Profile::SequentialMemoryTest::SequentialMemoryTest(MemoryOperation _operation, KernelISA _isa, u64 _byteCount) :
+	operation(_operation), isa(Kernels::IsSupported(_isa) && _isa != KernelISA_Best ? _isa : Kernels::GetBestISA()),
+	byteCount(_byteCount < 256 ? 256 : _byteCount & ~255ull)
+{
+	if (operation == MemoryOperation_Read || operation == MemoryOperation_Copy)
+	{
+		ptr_source = AllocateTouchedBuffer(byteCount);
+	}
+	if (operation != MemoryOperation_Read)
+	{
+		ptr_destination = AllocateTouchedBuffer(byteCount);
+	}
+
+	char size[32];
+	FormatByteCount(size, sizeof(size), byteCount);
+	snprintf(label, sizeof(label), "%s %s %s", GetOperationName(operation), Kernels::GetISAName(isa), size);
+	name = label;
+}
+
+Profile::SequentialMemoryTest::~SequentialMemoryTest()
+{
+	if (ptr_source)
+	{
+		operator delete(ptr_source, std::align_val_t(64));
+	}
+	if (ptr_destination)
+	{
+		operator delete(ptr_destination, std::align_val_t(64));
+	}
+}
+
+const char* Profile::SequentialMemoryTest::GetOperationName(MemoryOperation _operation)
+{
+	switch (_operation)
+	{
+	case MemoryOperation_Read:
+		return "Read";
+	case MemoryOperation_Write:
+		return "Write";
+	case MemoryOperation_Copy:
+		return "Copy";
+	case MemoryOperation_WriteNonTemporal:
+		return "Non-temporal write";
+	default:
+		return "Unknown";
+	}
+}
+
+void Profile::SequentialMemoryTest::operator()()
+{
+	switch (operation)
+	{
+	case MemoryOperation_Read:
+		checksum += SequentialRead(ptr_source, byteCount, isa);
+		break;
+	case MemoryOperation_Write:
+		SequentialWrite(ptr_destination, byteCount, isa);
+		break;
+	case MemoryOperation_Copy:
+		SequentialCopy(ptr_destination, ptr_source, byteCount, isa);
+		break;
+	case MemoryOperation_WriteNonTemporal:
+		SequentialWriteNonTemporal(ptr_destination, byteCount, isa);
+		break;
+	default:
+		break;
+	}
+}
+
+Profile::PointerChaseTest::PointerChaseTest(u64 _workingSetByteCount, u64 _stride, bool _randomOrder, u64 _stepCount) :
+	workingSetByteCount(_workingSetByteCount < 256 ? 256 : _workingSetByteCount & ~255ull),
+	stride(_stride < sizeof(void*) ? sizeof(void*) : _stride), stepCount(_stepCount), randomOrder(_randomOrder)
+{
+	ptr_buffer = AllocateTouchedBuffer(workingSetByteCount);
+	ptr_current = Kernels::BuildPointerChain(ptr_buffer, workingSetByteCount, stride, randomOrder ? workingSetByteCount : 0);
+
+	char size[32];
+	FormatByteCount(size, sizeof(size), workingSetByteCount);
+	snprintf(label, sizeof(label), "%s chase %s (%lluB stride)", randomOrder ? "Random" : "Strided", size, stride);
+	name = label;
+}
+
+Profile::PointerChaseTest::~PointerChaseTest()
+{
+	operator delete(ptr_buffer, std::align_val_t(64));
+}
+
+void Profile::PointerChaseTest::operator()()
+{
+	ptr_current = PointerChase(ptr_current, stepCount);
+}
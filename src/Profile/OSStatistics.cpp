@@ -1,7 +1,108 @@
+#include <bit> //for std::popcount
+#if __linux__
+#include <fcntl.h> //for open
+#endif
 #include "Profile/OSStatistics.hpp"
 
 Profile::Surveyor::os_metrics Profile::Surveyor::GlobalMetrics = {};
 
+Profile::u32 Profile::Surveyor::s_osMetricsMask = Profile::OSMetric_PageFaults;
+
+void Profile::Surveyor::CaptureOSMetrics(OSMetricsSnapshot& _snapshot, u32 _mask)
+{
+	_snapshot.mask = _mask;
+#if _WIN32
+	if (_mask & (OSMetric_PageFaults | OSMetric_ResidentSetSize))
+	{
+		PROCESS_MEMORY_COUNTERS_EX MemoryCounters = {};
+		MemoryCounters.cb = sizeof(MemoryCounters);
+		GetProcessMemoryInfo(GlobalMetrics.ProcessHandle, (PROCESS_MEMORY_COUNTERS *)&MemoryCounters, sizeof(MemoryCounters));
+		// NOTE: Windows does not tell soft faults from hard faults.
+		_snapshot.minorPageFaultCount = MemoryCounters.PageFaultCount;
+		_snapshot.residentSetSizeInB = MemoryCounters.WorkingSetSize;
+		_snapshot.peakResidentSetSizeInB = MemoryCounters.PeakWorkingSetSize;
+	}
+	if (_mask & OSMetric_CPUTime)
+	{
+		FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+		GetThreadTimes(GetCurrentThread(), &CreationTime, &ExitTime, &KernelTime, &UserTime);
+		// NOTE: FILETIME is in units of 100 nanoseconds.
+		_snapshot.userTimeInUs = (((u64)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime) / 10;
+		_snapshot.systemTimeInUs = (((u64)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime) / 10;
+	}
+	if (_mask & OSMetric_ThreadCPUTime)
+	{
+		FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+		GetThreadTimes(GetCurrentThread(), &CreationTime, &ExitTime, &KernelTime, &UserTime);
+		_snapshot.threadCPUTimeInNs = 100 * ((((u64)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime) +
+			(((u64)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime));
+	}
+#else
+	if (_mask & OSMetric_ThreadCPUTime)
+	{
+		struct timespec Value;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Value);
+		_snapshot.threadCPUTimeInNs = 1000000000 * (u64)Value.tv_sec + (u64)Value.tv_nsec;
+	}
+	if (_mask & (OSMetric_PageFaults | OSMetric_ContextSwitches | OSMetric_CPUTime))
+	{
+		struct rusage Usage = {};
+	#if __linux__
+		getrusage(RUSAGE_THREAD, &Usage);
+	#else
+		getrusage(RUSAGE_SELF, &Usage);
+	#endif
+		_snapshot.minorPageFaultCount = (u64)Usage.ru_minflt;
+		_snapshot.majorPageFaultCount = (u64)Usage.ru_majflt;
+		_snapshot.voluntaryContextSwitchCount = (u64)Usage.ru_nvcsw;
+		_snapshot.involuntaryContextSwitchCount = (u64)Usage.ru_nivcsw;
+		_snapshot.userTimeInUs = 1000000 * (u64)Usage.ru_utime.tv_sec + (u64)Usage.ru_utime.tv_usec;
+		_snapshot.systemTimeInUs = 1000000 * (u64)Usage.ru_stime.tv_sec + (u64)Usage.ru_stime.tv_usec;
+	}
+	if (_mask & OSMetric_ResidentSetSize)
+	{
+	#if __APPLE__
+		mach_task_basic_info_data_t TaskInfo = {};
+		mach_msg_type_number_t TaskInfoCount = MACH_TASK_BASIC_INFO_COUNT;
+		task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&TaskInfo, &TaskInfoCount);
+		_snapshot.residentSetSizeInB = TaskInfo.resident_size;
+		_snapshot.peakResidentSetSizeInB = TaskInfo.resident_size_max;
+	#else
+		// NOTE: ru_maxrss is in kilobytes on Linux and the current size is only
+		//       exposed by /proc. The file is opened once and re-read from the start.
+		struct rusage Usage = {};
+		getrusage(RUSAGE_SELF, &Usage);
+		_snapshot.peakResidentSetSizeInB = 1024 * (u64)Usage.ru_maxrss;
+
+		static int StatmFile = open("/proc/self/statm", O_RDONLY);
+		char Buffer[128] = {};
+		if (StatmFile >= 0 && pread(StatmFile, Buffer, sizeof(Buffer) - 1, 0) > 0)
+		{
+			// The first field is the total program size, the second one the resident size (in pages).
+			const char* At = Buffer;
+			while (*At && *At != ' ') ++At;
+			u64 ResidentPageCount = 0;
+			for (++At; *At >= '0' && *At <= '9'; ++At)
+			{
+				ResidentPageCount = 10 * ResidentPageCount + (u64)(*At - '0');
+			}
+			_snapshot.residentSetSizeInB = ResidentPageCount * GetOSPageSize();
+		}
+	#endif
+	}
+#endif
+}
+
+Profile::u32 Profile::Surveyor::GetOSMetricsMask()
+{
+	return s_osMetricsMask;
+}
+
+void Profile::Surveyor::SetOSMetricsMask(u32 _mask)
+{
+	s_osMetricsMask = _mask;
+}
+
 Profile::u64 Profile::Surveyor::GetOSPageFaultCount(void)
 {
 #if _WIN32
@@ -15,7 +116,7 @@ Profile::u64 Profile::Surveyor::GetOSPageFaultCount(void)
     //       ru_majflt  the number of page faults serviced that required I/O activity.
     struct rusage Usage = {};
     getrusage(RUSAGE_SELF, &Usage);
-    int Result = Usage.ru_minflt + Usage.ru_majflt;
+    u64 Result = (u64)Usage.ru_minflt + (u64)Usage.ru_majflt;
     return Result;
 #endif
 }
@@ -32,6 +133,64 @@ Profile::u64 Profile::Surveyor::GetOSPageSize()
 #endif
 }
 
+Profile::u32 Profile::Surveyor::GetOSLogicalCoreCount()
+{
+#if _WIN32
+	SYSTEM_INFO SystemInfo = {};
+	GetSystemInfo(&SystemInfo);
+	return SystemInfo.dwNumberOfProcessors;
+#else
+	long Result = sysconf(_SC_NPROCESSORS_ONLN);
+	return Result > 0 ? (u32)Result : 1;
+#endif
+}
+
+bool Profile::Surveyor::PinCurrentThreadToCore(u32 _coreIdx)
+{
+	// NOTE: The core is picked among the ones the process may run on (e.g., under
+	// taskset or a cgroup cpuset), not among all the cores of the machine.
+#if _WIN32
+	DWORD_PTR ProcessMask = 0;
+	DWORD_PTR SystemMask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &ProcessMask, &SystemMask) || ProcessMask == 0)
+	{
+		return false;
+	}
+	u32 Rank = _coreIdx % (u32)std::popcount((u64)ProcessMask);
+	for (u32 CoreIdx = 0; CoreIdx < 8 * sizeof(DWORD_PTR); ++CoreIdx)
+	{
+		if ((ProcessMask >> CoreIdx & 1) && Rank-- == 0)
+		{
+			return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << CoreIdx) != 0;
+		}
+	}
+	return false;
+#elif __linux__
+	cpu_set_t AllowedSet;
+	CPU_ZERO(&AllowedSet);
+	if (sched_getaffinity(getpid(), sizeof(AllowedSet), &AllowedSet) != 0 || CPU_COUNT(&AllowedSet) == 0)
+	{
+		return false;
+	}
+	u32 Rank = _coreIdx % (u32)CPU_COUNT(&AllowedSet);
+	for (int CoreIdx = 0; CoreIdx < CPU_SETSIZE; ++CoreIdx)
+	{
+		if (CPU_ISSET(CoreIdx, &AllowedSet) && Rank-- == 0)
+		{
+			cpu_set_t CPUSet;
+			CPU_ZERO(&CPUSet);
+			CPU_SET(CoreIdx, &CPUSet);
+			return pthread_setaffinity_np(pthread_self(), sizeof(CPUSet), &CPUSet) == 0;
+		}
+	}
+	return false;
+#else
+	// NOTE: MacOS has no API to pin a thread to a given core.
+	(void)_coreIdx;
+	return false;
+#endif
+}
+
 void Profile::Surveyor::InitializeOSMetrics(void)
 {
 #if _WIN32
@@ -63,11 +222,11 @@ Profile::u64 Profile::Timer::GetOSTimer(void)
 #elif __ARM_ARCH
 	struct timespec value;
 	clock_gettime(CLOCK_MONOTONIC, &value);
-	return GetOSTimerFreq() * (u64)value.tv_sec * + (u64)value.tv_nsec;
+	return GetOSTimerFreq() * (u64)value.tv_sec + (u64)value.tv_nsec / 1000;
 #else
 	struct timeval value;
 	gettimeofday(&value, 0);
-	return GetOSTimerFreq() * (u64)value.tv_sec * + (u64)value.tv_usec;
+	return GetOSTimerFreq() * (u64)value.tv_sec + (u64)value.tv_usec;
 #endif
 }
 
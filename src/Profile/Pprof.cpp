@@ -0,0 +1,311 @@
+#include <array>
+#include <chrono> //for the time of the profile
+#include <cstring> //for strlen
+#include <stdio.h> //for FILE
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Profile/Profiler.hpp"
+
+/*
+Hand-written encoders for the pprof format, to avoid depending on protobuf and
+zlib. The layout of the messages follows
+https://github.com/google/pprof/blob/main/proto/profile.proto; only the fields
+the profiler can fill are written.
+*/
+
+#if PROFILER_ENABLED
+namespace
+{
+	using namespace Profile;
+
+	/*!
+	@brief Appends protobuf fields to a buffer.
+	*/
+	struct ProtobufWriter
+	{
+		std::vector<u8> buffer;
+
+		void WriteVarint(u64 _value)
+		{
+			while (_value >= 0x80)
+			{
+				buffer.push_back((u8)(_value | 0x80));
+				_value >>= 7;
+			}
+			buffer.push_back((u8)_value);
+		}
+
+		void WriteTag(u32 _field, u32 _wireType)
+		{
+			WriteVarint((u64)_field << 3 | _wireType);
+		}
+
+		/*!
+		@brief Writes a varint field, skipping it if it has the default value 0.
+		*/
+		void WriteVarintField(u32 _field, u64 _value)
+		{
+			if (_value)
+			{
+				WriteTag(_field, 0);
+				WriteVarint(_value);
+			}
+		}
+
+		void WriteBytesField(u32 _field, const void* _data, u64 _byteCount)
+		{
+			WriteTag(_field, 2);
+			WriteVarint(_byteCount);
+			buffer.insert(buffer.end(), (const u8*)_data, (const u8*)_data + _byteCount);
+		}
+
+		void WriteMessageField(u32 _field, const ProtobufWriter& _message)
+		{
+			WriteBytesField(_field, _message.buffer.data(), _message.buffer.size());
+		}
+
+		/*!
+		@brief Writes a repeated varint field in the packed encoding.
+		*/
+		void WritePackedField(u32 _field, const u64* _values, u64 _count)
+		{
+			ProtobufWriter packed;
+			for (u64 i = 0; i < _count; ++i)
+			{
+				packed.WriteVarint(_values[i]);
+			}
+			WriteMessageField(_field, packed);
+		}
+	};
+
+	/*!
+	@brief Collects the strings, functions, locations and samples of a pprof
+			profile, then encodes it.
+	@details Every function has exactly one location, with the same id.
+	*/
+	struct PprofBuilder
+	{
+		static constexpr u32 valueCount = 2;
+
+		std::vector<std::string> strings = { "" };
+		std::unordered_map<std::string, u64> stringIds = { { "", 0 } };
+
+		struct Function
+		{
+			u64 nameId = 0;
+			u64 fileNameId = 0;
+			u64 lineNumber = 0;
+		};
+		std::vector<Function> functions;
+		std::unordered_map<std::string, u64> functionIds;
+
+		struct Sample
+		{
+			std::vector<u64> locationIds;
+			u64 values[valueCount] = { 0 };
+		};
+		std::vector<Sample> samples;
+
+		u64 GetStringId(const char* _string)
+		{
+			std::string string = _string ? _string : "";
+			auto it = stringIds.find(string);
+			if (it != stringIds.end())
+			{
+				return it->second;
+			}
+			strings.push_back(string);
+			return stringIds[string] = strings.size() - 1;
+		}
+
+		/*!
+		@brief Returns the id of the location of a function, adding both if needed.
+		*/
+		u64 GetLocationId(const char* _name, const char* _fileName, u32 _lineNumber)
+		{
+			std::string key = std::string(_name ? _name : "") + '\0' + (_fileName ? _fileName : "") + '\0' + std::to_string(_lineNumber);
+			auto it = functionIds.find(key);
+			if (it != functionIds.end())
+			{
+				return it->second;
+			}
+			Function& function = functions.emplace_back();
+			function.nameId = GetStringId(_name);
+			function.fileNameId = GetStringId(_fileName);
+			function.lineNumber = _lineNumber;
+			return functionIds[key] = functions.size();
+		}
+
+		std::vector<u8> Encode(const char* const* _sampleTypes, const char* const* _sampleUnits, u64 _durationInNs)
+		{
+			//The string ids must be known before the string table is written
+			u64 typeIds[valueCount];
+			u64 unitIds[valueCount];
+			for (u32 i = 0; i < valueCount; ++i)
+			{
+				typeIds[i] = GetStringId(_sampleTypes[i]);
+				unitIds[i] = GetStringId(_sampleUnits[i]);
+			}
+
+			ProtobufWriter profile;
+			for (u32 i = 0; i < valueCount; ++i)
+			{
+				ProtobufWriter valueType;
+				valueType.WriteVarintField(1, typeIds[i]); //type
+				valueType.WriteVarintField(2, unitIds[i]); //unit
+				profile.WriteMessageField(1, valueType); //sample_type
+			}
+			for (const Sample& sample : samples)
+			{
+				ProtobufWriter message;
+				message.WritePackedField(1, sample.locationIds.data(), sample.locationIds.size()); //location_id
+				message.WritePackedField(2, sample.values, valueCount); //value
+				profile.WriteMessageField(2, message); //sample
+			}
+			for (u64 i = 0; i < functions.size(); ++i)
+			{
+				ProtobufWriter line;
+				line.WriteVarintField(1, i + 1); //function_id
+				line.WriteVarintField(2, functions[i].lineNumber); //line
+
+				ProtobufWriter location;
+				location.WriteVarintField(1, i + 1); //id
+				location.WriteMessageField(4, line); //line
+				profile.WriteMessageField(4, location); //location
+			}
+			for (u64 i = 0; i < functions.size(); ++i)
+			{
+				ProtobufWriter function;
+				function.WriteVarintField(1, i + 1); //id
+				function.WriteVarintField(2, functions[i].nameId); //name
+				function.WriteVarintField(3, functions[i].nameId); //system_name
+				function.WriteVarintField(4, functions[i].fileNameId); //filename
+				function.WriteVarintField(5, functions[i].lineNumber); //start_line
+				profile.WriteMessageField(5, function); //function
+			}
+			for (const std::string& string : strings)
+			{
+				profile.WriteBytesField(6, string.data(), string.size()); //string_table
+			}
+			u64 timeInNs = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			profile.WriteVarintField(9, timeInNs); //time_nanos
+			profile.WriteVarintField(10, _durationInNs); //duration_nanos
+			profile.WriteVarintField(14, typeIds[0]); //default_sample_type
+			return std::move(profile.buffer);
+		}
+	};
+
+	/*!
+	@brief Computes the table of the CRC-32 of every byte (reflected polynomial 0xEDB88320).
+	*/
+	constexpr std::array<u32, 256> ComputeCRC32Table()
+	{
+		std::array<u32, 256> table = {};
+		for (u32 i = 0; i < 256; ++i)
+		{
+			u32 crc = i;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+			}
+			table[i] = crc;
+		}
+		return table;
+	}
+
+	/*!
+	@brief The CRC-32 table, computed at compile time so that concurrent exports
+			do not race to fill it.
+	*/
+	constexpr std::array<u32, 256> s_CRC32Table = ComputeCRC32Table();
+
+	/*!
+	@brief Computes the CRC-32 of the gzip trailer.
+	*/
+	u32 ComputeCRC32(const u8* _data, u64 _byteCount)
+	{
+		u32 crc = 0xFFFFFFFFu;
+		for (u64 i = 0; i < _byteCount; ++i)
+		{
+			crc = s_CRC32Table[(crc ^ _data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	void WriteLittleEndian32(FILE* _file, u32 _value)
+	{
+		u8 bytes[4] = { (u8)_value, (u8)(_value >> 8), (u8)(_value >> 16), (u8)(_value >> 24) };
+		fwrite(bytes, 1, 4, _file);
+	}
+
+	/*!
+	@brief Writes data in a gzip container made of stored (uncompressed) deflate blocks.
+	*/
+	void WriteGzip(FILE* _file, const std::vector<u8>& _data)
+	{
+		//ID1, ID2, deflate, no flags, no modification time, no extra flags, unknown OS
+		const u8 header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+		fwrite(header, 1, sizeof(header), _file);
+
+		u64 offset = 0;
+		do
+		{
+			u64 blockByteCount = _data.size() - offset < 0xFFFF ? _data.size() - offset : 0xFFFF;
+			bool isFinal = offset + blockByteCount == _data.size();
+			u8 blockHeader[5] = { (u8)(isFinal ? 1 : 0), //BFINAL and BTYPE=00 (stored)
+				(u8)blockByteCount, (u8)(blockByteCount >> 8), //LEN
+				(u8)~blockByteCount, (u8)(~blockByteCount >> 8) }; //NLEN
+			fwrite(blockHeader, 1, sizeof(blockHeader), _file);
+			fwrite(_data.data() + offset, 1, blockByteCount, _file);
+			offset += blockByteCount;
+		} while (offset < _data.size());
+
+		WriteLittleEndian32(_file, ComputeCRC32(_data.data(), _data.size()));
+		WriteLittleEndian32(_file, (u32)_data.size());
+	}
+}
+#endif
+
+void Profile::ProfilerResults::ExportToPprof([[maybe_unused]] const char* _path) noexcept
+{
+#if PROFILER_ENABLED
+	FILE* file = fopen(_path, "wb");
+	if (file)
+	{
+		printf("Exporting profiler results to %s\n", _path);
+		PprofBuilder builder;
+		for (u32 i = 0; i < trackCount; ++i)
+		{
+			const ProfileTrackResult& track = tracks[i];
+			const CallTree& tree = track.callTree;
+			u64 trackLocationId = builder.GetLocationId(track.name, nullptr, 0);
+			//Counters and gauges are never in the call tree: they have no weight in a profile
+			for (CALL_NODES_TYPE j = 0; j < tree.nodeCount; ++j)
+			{
+				PprofBuilder::Sample& sample = builder.samples.emplace_back();
+				//The leaf comes first
+				for (CALL_NODES_TYPE nodeIdx = j; nodeIdx != CallTree::rootIdx; nodeIdx = tree.nodes[nodeIdx].parentIdx)
+				{
+					const ProfileBlockResult& block = track.timings[tree.nodes[nodeIdx].profileBlockRecorderIdx];
+					sample.locationIds.push_back(builder.GetLocationId(block.blockName, block.fileName, block.lineNumber));
+				}
+				sample.locationIds.push_back(trackLocationId);
+				sample.values[0] = tree.GetSelfElapsed(j);
+				sample.values[1] = tree.nodes[j].hitCount;
+			}
+		}
+
+		static const char* const sampleTypes[PprofBuilder::valueCount] = { "wall", "hits" };
+		static const char* const sampleUnits[PprofBuilder::valueCount] = { "cycles", "count" };
+		WriteGzip(file, builder.Encode(sampleTypes, sampleUnits, (u64)(elapsedSec * 1e9)));
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+#else
+	printf("Profiler results export as pprof was called but the profiler is disabled. The profiler results are therefore empty and the export will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
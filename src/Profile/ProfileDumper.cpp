@@ -0,0 +1,263 @@
+#include <chrono>
+#include <cstdio> //for snprintf
+#include <cstring> //for strncpy and memset
+#include <ctime> //for strftime
+#include <filesystem> //for create_directories and exists
+#include "Profile/ProfileDumper.hpp"
+#include "Profile/Profiler.hpp"
+
+#if _WIN32
+#include <windows.h> //for SetThreadPriority
+#else
+#include <signal.h> //for sigaction
+#include <sys/resource.h> //for setpriority
+#include <unistd.h> //for the thread id
+#if __linux__
+#include <sys/syscall.h> //for SYS_gettid
+#endif
+#endif
+
+/*
+The signal handler only increments s_SignalCount; the dumping threads poll it
+every s_SignalPollPeriodInMs milliseconds. Incrementing a lock-free atomic is
+async-signal-safe, unlike waking up a condition variable.
+The counter and the previous action of the signal are process-wide, so only the
+dumper in s_SignalDumper listens to a signal.
+*/
+
+static std::atomic<Profile::u64> s_SignalCount = 0;
+static std::atomic<const Profile::ProfileDumper*> s_SignalDumper = nullptr;
+static constexpr Profile::u32 s_SignalPollPeriodInMs = 100;
+static_assert(std::atomic<Profile::u64>::is_always_lock_free, "The signal handler of the dumper requires a lock-free counter.");
+
+#if !_WIN32
+static struct sigaction s_PreviousSignalAction;
+
+static void OnDumpSignal(int)
+{
+	s_SignalCount.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+/*!
+@brief Lowers the priority of the calling thread so that the dumps do not
+		compete with the instrumented threads.
+*/
+static void LowerCurrentThreadPriority()
+{
+#if _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif __linux__
+	//On Linux, the nice value is per thread
+	setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+}
+
+/*!
+@brief The body of the dumping thread.
+@param _dumper The dumper the thread belongs to.
+@param _signalCount The value of s_SignalCount before the signal handler was
+		installed, so that a signal received before the thread runs is not missed.
+*/
+static void RunDumper(Profile::ProfileDumper* _dumper, Profile::u64 _signalCount)
+{
+	LowerCurrentThreadPriority();
+
+	using Clock = std::chrono::steady_clock;
+	Profile::u64 signalCount = _signalCount;
+	Clock::time_point nextPeriodicDump = Clock::now() + std::chrono::milliseconds(_dumper->periodInMs);
+
+	std::unique_lock<std::mutex> lock(_dumper->mutex);
+	while (!_dumper->stopRequested)
+	{
+		Clock::time_point wakeUpTime = Clock::time_point::max();
+		if (_dumper->signalNumber)
+		{
+			wakeUpTime = Clock::now() + std::chrono::milliseconds(s_SignalPollPeriodInMs);
+		}
+		if (_dumper->periodInMs && nextPeriodicDump < wakeUpTime)
+		{
+			wakeUpTime = nextPeriodicDump;
+		}
+		auto isWokenUp = [_dumper]() { return _dumper->stopRequested || _dumper->dumpRequested; };
+		if (wakeUpTime == Clock::time_point::max())
+		{
+			_dumper->wakeUp.wait(lock, isWokenUp);
+		}
+		else
+		{
+			_dumper->wakeUp.wait_until(lock, wakeUpTime, isWokenUp);
+		}
+		if (_dumper->stopRequested)
+		{
+			break;
+		}
+
+		Profile::u64 currentSignalCount = s_SignalCount.load(std::memory_order_relaxed);
+		bool dump = _dumper->dumpRequested || currentSignalCount != signalCount ||
+			(_dumper->periodInMs && Clock::now() >= nextPeriodicDump);
+		if (dump)
+		{
+			_dumper->dumpRequested = false;
+			signalCount = currentSignalCount;
+			nextPeriodicDump = Clock::now() + std::chrono::milliseconds(_dumper->periodInMs);
+
+			lock.unlock();
+			_dumper->Dump();
+			lock.lock();
+		}
+	}
+}
+
+Profile::ProfileDumper::~ProfileDumper()
+{
+	Stop();
+	delete ptr_results;
+}
+
+int Profile::ProfileDumper::GetDefaultSignal() noexcept
+{
+#if _WIN32
+	return 0;
+#else
+	return SIGUSR1;
+#endif
+}
+
+bool Profile::ProfileDumper::Start(const Profiler* _profiler, const char* _directory, int _signalNumber, u32 _periodInMs)
+{
+	Stop();
+
+	u64 signalCount = s_SignalCount.load(std::memory_order_relaxed);
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+	if (error)
+	{
+		printf("Error: Could not create the dump directory %s.\n", _directory);
+		return false;
+	}
+
+#if _WIN32
+	if (_signalNumber)
+	{
+		printf("Error: Dumps cannot be requested by signal on Windows.\n");
+		return false;
+	}
+#else
+	if (_signalNumber)
+	{
+		const ProfileDumper* signalDumper = nullptr;
+		if (!s_SignalDumper.compare_exchange_strong(signalDumper, this))
+		{
+			printf("Error: Another dumper already listens to a signal.\n");
+			return false;
+		}
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = OnDumpSignal;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(_signalNumber, &action, &s_PreviousSignalAction) != 0)
+		{
+			printf("Error: Could not install the handler of signal %d.\n", _signalNumber);
+			s_SignalDumper.store(nullptr);
+			return false;
+		}
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> lock(dumpMutex);
+		ptr_profiler = _profiler;
+		strncpy(directory, _directory, sizeof(directory) - 1);
+		signalNumber = _signalNumber;
+		periodInMs = _periodInMs;
+		dumpCount = 0;
+		if (ptr_results == nullptr)
+		{
+			ptr_results = new ProfilerResults();
+		}
+	}
+
+	stopRequested = false;
+	dumpRequested = false;
+	thread = std::thread(RunDumper, this, signalCount);
+	return true;
+}
+
+void Profile::ProfileDumper::Stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	wakeUp.notify_one();
+	thread.join();
+
+#if !_WIN32
+	if (signalNumber)
+	{
+		sigaction(signalNumber, &s_PreviousSignalAction, nullptr);
+		s_SignalDumper.store(nullptr);
+	}
+#endif
+}
+
+void Profile::ProfileDumper::RequestDump()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		dumpRequested = true;
+	}
+	wakeUp.notify_one();
+}
+
+bool Profile::ProfileDumper::Dump()
+{
+	std::lock_guard<std::mutex> lock(dumpMutex);
+	if (ptr_profiler == nullptr)
+	{
+		return false;
+	}
+	if (ptr_results == nullptr)
+	{
+		ptr_results = new ProfilerResults();
+	}
+
+	ptr_results->CaptureLive(ptr_profiler);
+
+	//The name of the profiler may contain characters not allowed in file names
+	char profilerName[PROFILER_NAME_LENGTH] = {0};
+	for (u32 i = 0; i < PROFILER_NAME_LENGTH - 1 && ptr_profiler->name[i]; ++i)
+	{
+		char c = ptr_profiler->name[i];
+		bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+		profilerName[i] = allowed ? c : '_';
+	}
+
+	std::chrono::system_clock::time_point nowPoint = std::chrono::system_clock::now();
+	time_t now = std::chrono::system_clock::to_time_t(nowPoint);
+	u64 milliseconds = (u64)(std::chrono::duration_cast<std::chrono::milliseconds>(nowPoint.time_since_epoch()).count() % 1000);
+	tm localTime;
+#if _WIN32
+	localtime_s(&localTime, &now);
+#else
+	localtime_r(&now, &localTime);
+#endif
+	char timestamp[32];
+	strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", &localTime);
+
+	u64 dumpIdx = dumpCount.load(std::memory_order_relaxed) + 1;
+	snprintf(lastDumpPath, sizeof(lastDumpPath), "%s/%s_%s-%03llu_%llu.csv",
+		directory, profilerName[0] ? profilerName : "Profiler", timestamp, milliseconds, dumpIdx);
+	ptr_results->ExportToCSV(lastDumpPath);
+	dumpCount.store(dumpIdx, std::memory_order_release);
+
+	return std::filesystem::exists(lastDumpPath);
+}
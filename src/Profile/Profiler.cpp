@@ -1,10 +1,308 @@
+#include <algorithm> //for std::sort and std::min
+#include <barrier> //for std::barrier
 #include <cmath> //for std::sqrt
-#include <cstring> //for strlen
+#include <cstring> //for strlen, strnlen and memcpy
+#include <functional> //for std::less
+#include <memory> //for std::unique_ptr
+#include <mutex> //for the registration of the dynamic tracks
 #include <stdio.h> //for FILE
+#include <string_view> //for comparing the names of the tracks
+#include <thread> //for std::thread
 #include "Profile/Profiler.hpp"
 
 static Profile::Profiler* s_Profiler = nullptr;
 
+/*!
+@brief Serializes the registrations of the tracks at runtime (see Profile::Profiler::RegisterTrack).
+*/
+static std::mutex s_TrackRegistrationMutex;
+
+/*!
+@brief A call site of a block, counter or gauge registered in a slot of a static
+		track, shared by all the profilers.
+@details The index of the slot is cached at the call site, so it must be the
+		 same in every profiler: the slots are claimed here once, and a profiler
+		 takes the name of a slot the first time it records in it (see BindCallSite).
+*/
+struct CallSite
+{
+	const char* name = nullptr;
+	const char* fileName = nullptr;
+	Profile::u32 lineNumber = 0;
+	Profile::RecorderKind kind = Profile::RecorderKind_Block;
+	Profile::BlockKeyKind keyKind = Profile::BlockKeyKind_None;
+	Profile::u64 key = 0;
+	const char* keyName = nullptr;
+};
+
+/*!
+@brief The call sites of the slots of every static track.
+*/
+static CallSite s_CallSites[NB_TRACKS][NB_TIMINGS];
+
+/*!
+@brief Serializes the registrations of the call sites.
+*/
+static std::mutex s_CallSiteMutex;
+
+/*!
+@brief The profiler of the current thread, if any. It takes precedence over
+		s_Profiler.
+*/
+static thread_local Profile::Profiler* t_Profiler = nullptr;
+
+#if PROFILER_TRACK_ALLOCATIONS && (defined(__GNUC__) || defined(__clang__))
+	//The allocation hooks read it on every allocation: make sure accessing it
+	//never goes through __tls_get_addr, which may allocate itself.
+	#define PROFILER_INITIAL_EXEC_TLS __attribute__((tls_model("initial-exec")))
+#else
+	#define PROFILER_INITIAL_EXEC_TLS
+#endif
+
+/*!
+@brief The innermost open block of the current thread, the one the heap
+		allocations are attributed to.
+@details Only maintained when PROFILER_TRACK_ALLOCATIONS is enabled.
+*/
+static thread_local Profile::ProfileBlockRecorder* t_OpenRecorder PROFILER_INITIAL_EXEC_TLS = nullptr;
+
+namespace Profile
+{
+	//Defined in Spans.cpp with the tail captures (see Profile::TailCaptureScope)
+	struct TailEventBuffer;
+	extern thread_local TailEventBuffer* t_TailEventBuffer;
+	void RecordTailEvent(const char* _blockName, u64 _start) noexcept;
+}
+
+/*!
+@brief Returns the profiler the blocks of the current thread are recorded in.
+*/
+static inline Profile::Profiler* GetCurrentProfiler()
+{
+	return t_Profiler ? t_Profiler : s_Profiler;
+}
+
+/*!
+@brief Names a slot of a track after the call site registered in it.
+@details Called the first time a profiler records in a slot (e.g., a profiler
+		 created after the call site was registered, or whose tracks were cleared).
+@param _track The track of the profiler.
+@param _trackIdx The index of the track.
+@param _profileBlockRecorderIdx The index of the slot.
+*/
+static void BindCallSite(Profile::ProfileTrack& _track, NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx) noexcept
+{
+	const CallSite& site = s_CallSites[_trackIdx][_profileBlockRecorderIdx];
+	Profile::ProfileBlockRecorder& record = _track.timings[_profileBlockRecorderIdx];
+	_track.BeginUpdate();
+	if (record.blockName == nullptr)
+	{
+		_track.AddUsedTiming(_profileBlockRecorderIdx);
+	}
+	record.blockName = site.name;
+	record.fileName = site.fileName;
+	record.lineNumber = site.lineNumber;
+	record.kind = site.kind;
+	record.keyKind = site.keyKind;
+	record.key = site.key;
+	record.keyName = site.keyName;
+	_track.EndUpdate();
+}
+
+/*!
+@brief Outputs the OS metrics of a block as the continuation of its report line.
+@details It ends with a hint of why the block may be slow: page faults that needed
+		 I/O, waiting on a resource (voluntary context switches with a CPU time much
+		 lower than the wall time) or preemption (involuntary context switches).
+@param _osMetrics The OS metrics accumulated by the block.
+@param _elapsed The time the block was executed in CPU timer units.
+*/
+static void ReportOSMetrics(const Profile::OSMetricsSnapshot& _osMetrics, Profile::u64 _elapsed)
+{
+	using namespace Profile;
+
+	if (_osMetrics.mask & OSMetric_PageFaults)
+	{
+		printf("; %llu minor/%llu major PF", _osMetrics.minorPageFaultCount, _osMetrics.majorPageFaultCount);
+	}
+	if (_osMetrics.mask & OSMetric_ContextSwitches)
+	{
+		printf("; %llu voluntary/%llu involuntary CS", _osMetrics.voluntaryContextSwitchCount, _osMetrics.involuntaryContextSwitchCount);
+	}
+	f64 wallInUs = 1000000.0 * (f64)_elapsed / (f64)Timer::GetEstimatedCPUFreq();
+	f64 cpuInUs = (f64)(_osMetrics.userTimeInUs + _osMetrics.systemTimeInUs);
+	if (_osMetrics.mask & OSMetric_CPUTime)
+	{
+		printf("; CPU %.3fms user/%.3fms system (%.1f%% of wall)", (f64)_osMetrics.userTimeInUs / 1000.0, (f64)_osMetrics.systemTimeInUs / 1000.0,
+			wallInUs == 0.0 ? 0.0 : 100.0 * cpuInUs / wallInUs);
+	}
+	if (_osMetrics.mask & OSMetric_ResidentSetSize)
+	{
+		printf("; RSS %.2fMB (peak %.2fMB)", (f64)_osMetrics.residentSetSizeInB / (1 << 20), (f64)_osMetrics.peakResidentSetSizeInB / (1 << 20));
+	}
+	if (_osMetrics.mask & OSMetric_ThreadCPUTime)
+	{
+		//The thread CPU time is more precise than the one of getrusage
+		cpuInUs = (f64)_osMetrics.threadCPUTimeInNs / 1000.0;
+		printf("; thread CPU %.3fms (%.1f%% off-CPU)", cpuInUs / 1000.0,
+			wallInUs == 0.0 || cpuInUs > wallInUs ? 0.0 : 100.0 * (1.0 - cpuInUs / wallInUs));
+	}
+
+	bool hasHint = false;
+	if (_osMetrics.majorPageFaultCount > 0)
+	{
+		printf("%s page-faulting on I/O", hasHint ? "," : "; likely");
+		hasHint = true;
+	}
+	bool hasCPUTime = _osMetrics.mask & (OSMetric_CPUTime | OSMetric_ThreadCPUTime);
+	bool isMostlyOffCPU = hasCPUTime && cpuInUs < 0.5 * wallInUs;
+	if (hasCPUTime ? isMostlyOffCPU && (_osMetrics.voluntaryContextSwitchCount > 0 || !(_osMetrics.mask & OSMetric_ContextSwitches))
+		: _osMetrics.voluntaryContextSwitchCount > 0)
+	{
+		printf("%s waiting (I/O, lock or sleep)", hasHint ? "," : "; likely");
+		hasHint = true;
+	}
+	if (_osMetrics.involuntaryContextSwitchCount > 0)
+	{
+		printf("%s preempted", hasHint ? "," : "; likely");
+		hasHint = true;
+	}
+}
+
+/*!
+@brief Computes the off-CPU percentage of a track from the thread CPU time of its blocks.
+@param _timings The blocks of the track (Profile::ProfileBlockRecorder or Profile::ProfileBlockResult).
+@param _trackElapsed The elapsed time of the track in CPU timer units.
+@return The percentage of the track's time its blocks were off-CPU, or a
+		negative value if the thread CPU time was not captured.
+*/
+template<typename Timings>
+static Profile::f64 ComputeTrackOffCPUPercentage(const Timings& _timings, Profile::u64 _trackElapsed)
+{
+	using namespace Profile;
+
+	bool hasThreadCPUTime = false;
+	f64 cpuInNs = 0.0;
+	for (const auto& record : _timings)
+	{
+		if (record.hitCount && (record.osMetricsTotal.mask & OSMetric_ThreadCPUTime))
+		{
+			hasThreadCPUTime = true;
+			cpuInNs += (f64)record.osMetricsTotal.threadCPUTimeInNs;
+		}
+	}
+	f64 wallInNs = 1000000000.0 * (f64)_trackElapsed / (f64)Timer::GetEstimatedCPUFreq();
+	if (!hasThreadCPUTime || wallInNs == 0.0)
+	{
+		return -1.0;
+	}
+	return cpuInNs > wallInNs ? 0.0 : 100.0 * (1.0 - cpuInNs / wallInNs);
+}
+
+/*!
+@brief Outputs the report line of a counter or a gauge.
+@param _hitCount The number of values recorded.
+*/
+static void ReportValue(const char* _name, Profile::RecorderKind _kind, Profile::u64 _hitCount,
+	Profile::s64 _value, Profile::s64 _valueSum, Profile::s64 _minValue, Profile::s64 _maxValue)
+{
+	using namespace Profile;
+
+	if (_kind == RecorderKind_Counter)
+	{
+		printf("%s[%llu]: counter %lld (increments in [%lld, %lld])\n", _name, _hitCount, _value, _minValue, _maxValue);
+	}
+	else
+	{
+		printf("%s[%llu]: gauge %lld (mean %.2f in [%lld, %lld])\n", _name, _hitCount, _value,
+			_hitCount == 0 ? 0.0 : (f64)_valueSum / (f64)_hitCount, _minValue, _maxValue);
+	}
+}
+
+/*!
+@brief Writes the label of the key of a keyed block: its name if it is a string,
+		"other keys" for the overflow slot, its value otherwise.
+@param _buffer Receives the label of an integer key.
+@return The label, which is empty if the block is not keyed.
+*/
+static const char* FormatBlockKey(Profile::BlockKeyKind _keyKind, Profile::u64 _key, const char* _keyName, char (&_buffer)[24])
+{
+	using namespace Profile;
+
+	switch (_keyKind)
+	{
+	case BlockKeyKind_Integer:
+		snprintf(_buffer, sizeof(_buffer), "%llu", _key);
+		return _buffer;
+	case BlockKeyKind_String:
+		return _keyName;
+	case BlockKeyKind_Overflow:
+		return "other keys";
+	default:
+		return "";
+	}
+}
+
+/*!
+@brief Outputs the keyed blocks of a track grouped by call site: a line with the
+		totals of the call site, then one line per key by decreasing elapsed time.
+@param _timings The blocks of the track (Profile::ProfileBlockRecorder or Profile::ProfileBlockResult).
+@param _trackElapsed The elapsed time of the track in CPU timer units.
+*/
+template<typename Timings>
+static void ReportKeyedBlocks(const Timings& _timings, Profile::u64 _trackElapsed)
+{
+	using namespace Profile;
+	using Record = std::remove_cvref_t<decltype(*std::begin(_timings))>;
+
+	std::vector<const Record*> keyedRecords;
+	for (const Record& record : _timings)
+	{
+		if (record.hitCount && record.keyKind != BlockKeyKind_None)
+		{
+			keyedRecords.push_back(&record);
+		}
+	}
+	std::sort(keyedRecords.begin(), keyedRecords.end(), [](const Record* _a, const Record* _b)
+		{
+			if (_a->fileName != _b->fileName)
+			{
+				return std::less<const char*>()(_a->fileName, _b->fileName);
+			}
+			if (_a->lineNumber != _b->lineNumber)
+			{
+				return _a->lineNumber < _b->lineNumber;
+			}
+			return _a->elapsed > _b->elapsed;
+		});
+
+	u64 groupEnd = 0;
+	for (u64 groupStart = 0; groupStart < keyedRecords.size(); groupStart = groupEnd)
+	{
+		const Record& first = *keyedRecords[groupStart];
+		u64 hitCount = 0;
+		u64 elapsed = 0;
+		for (groupEnd = groupStart; groupEnd < keyedRecords.size() && keyedRecords[groupEnd]->fileName == first.fileName
+			&& keyedRecords[groupEnd]->lineNumber == first.lineNumber; ++groupEnd)
+		{
+			hitCount += keyedRecords[groupEnd]->hitCount;
+			elapsed += keyedRecords[groupEnd]->elapsed;
+		}
+		printf("%s by key[%llu]: %llu (%.2f%% of track; %llu keys)\n", first.blockName, hitCount, elapsed,
+			_trackElapsed == 0 ? 0 : 100.0 * (f64)elapsed / (f64)_trackElapsed, groupEnd - groupStart);
+		for (u64 i = groupStart; i < groupEnd; ++i)
+		{
+			const Record& record = *keyedRecords[i];
+			char keyBuffer[24];
+			printf("\t%s[%llu]: %llu (%.2f%% of block; %.2f%% of track; %.0f cycles per hit)\n",
+				FormatBlockKey(record.keyKind, record.key, record.keyName, keyBuffer), record.hitCount, record.elapsed,
+				elapsed == 0 ? 0 : 100.0 * (f64)record.elapsed / (f64)elapsed,
+				_trackElapsed == 0 ? 0 : 100.0 * (f64)record.elapsed / (f64)_trackElapsed,
+				(f64)record.elapsed / (f64)record.hitCount);
+		}
+	}
+}
+
 void Profile::SetProfiler(Profiler* _profiler)
 {
 	s_Profiler = _profiler;
@@ -12,18 +310,139 @@ void Profile::SetProfiler(Profiler* _profiler)
 
 Profile::Profiler* Profile::GetProfiler()
 {
-	return s_Profiler;
+	return GetCurrentProfiler();
+}
+
+void Profile::SetThreadProfiler(Profiler* _profiler)
+{
+	t_Profiler = _profiler;
+}
+
+Profile::Profiler* Profile::GetThreadProfiler()
+{
+	return t_Profiler;
+}
+
+Profile::ProfilerScope::ProfilerScope(Profiler* _profiler) noexcept :
+	ptr_previousProfiler(t_Profiler)
+{
+	t_Profiler = _profiler;
 }
 
-Profile::ProfileBlock::ProfileBlock(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _byteCount) :
-	trackIdx(_trackIdx), profileBlockRecorderIdx(_profileBlockRecorderIdx)
+Profile::ProfilerScope::~ProfilerScope() noexcept
 {
-	s_Profiler->OpenBlock(trackIdx, profileBlockRecorderIdx, _byteCount);
+	t_Profiler = ptr_previousProfiler;
 }
 
-Profile::ProfileBlock::~ProfileBlock()
+void Profile::RecordAllocation(u64 _byteCount) noexcept
 {
-	s_Profiler->CloseBlock(trackIdx, profileBlockRecorderIdx);
+	ProfileBlockRecorder* ptr_recorder = t_OpenRecorder;
+	if (ptr_recorder)
+	{
+		ptr_recorder->allocationCount++;
+		ptr_recorder->allocatedByteCount += _byteCount;
+	}
+}
+
+void Profile::RecordDeallocation(u64 _byteCount) noexcept
+{
+	ProfileBlockRecorder* ptr_recorder = t_OpenRecorder;
+	if (ptr_recorder)
+	{
+		ptr_recorder->freedByteCount += _byteCount;
+	}
+}
+
+void Profile::RecordValue(NB_TRACKS_TYPE _trackIdx, NB_TIMINGS_TYPE _profileBlockRecorderIdx, s64 _value) noexcept
+{
+	ProfileTrack& track = GetCurrentProfiler()->tracks[_trackIdx];
+	if (track.timings[_profileBlockRecorderIdx].blockName == nullptr)
+	{
+		BindCallSite(track, _trackIdx, _profileBlockRecorderIdx);
+	}
+	track.hasBlock = true;
+	track.RecordValue(_profileBlockRecorderIdx, _value);
+}
+
+bool Profile::CheckLibraryConfiguration(u64 _sizesHash, u64 _profilerByteCount) noexcept
+{
+	if (_sizesHash == DefaultProfilerSizes::hash && _profilerByteCount == sizeof(Profiler))
+	{
+		return true;
+	}
+	printf("Error: The program was compiled with other sizes than the profiling library (a Profile::Profiler of %llu bytes instead of %llu).\n"
+		"Compile both with the same NB_TRACKS (%llu in the library), NB_TIMINGS (%llu), PROFILER_NAME_LENGTH (%llu), PROFILE_TRACK_NAME_LENGTH (%llu) and NB_CALL_NODES (%llu).\n",
+		_profilerByteCount, (u64)sizeof(Profiler), DefaultProfilerSizes::trackCount, DefaultProfilerSizes::timingCount,
+		DefaultProfilerSizes::nameLength, DefaultProfilerSizes::trackNameLength, DefaultProfilerSizes::callNodeCount);
+	return false;
+}
+
+const char* Profile::GetRecorderKindName(RecorderKind _kind) noexcept
+{
+	switch (_kind)
+	{
+	case RecorderKind_Counter:
+		return "Counter";
+	case RecorderKind_Gauge:
+		return "Gauge";
+	default:
+		return "Block";
+	}
+}
+
+void Profile::ProfileBlock::Open(u64 _byteCount, u64 _flopCount)
+{
+	ProfileTrack* track = &GetCurrentProfiler()->tracks[trackIdx];
+	if (track->timings[profileBlockRecorderIdx].blockName == nullptr)
+	{
+		BindCallSite(*track, (NB_TRACKS_TYPE)trackIdx, profileBlockRecorderIdx);
+	}
+	OpenInTrack(track, _byteCount, _flopCount);
+}
+
+void Profile::ProfileBlock::Open(TrackHandle _track, NB_TIMINGS_TYPE _preferredRecorderIdx, const char* _blockName,
+	const char* _fileName, u32 _lineNumber, u64 _byteCount, u64 _flopCount)
+{
+	ProfileTrack* track = GetCurrentProfiler()->GetTrack(_track.trackIdx);
+	if (track)
+	{
+		profileBlockRecorderIdx = track->GetBlockRecorderIndex(_preferredRecorderIdx, _blockName, _fileName, _lineNumber);
+		OpenInTrack(track, _byteCount, _flopCount);
+	}
+}
+
+void Profile::ProfileBlock::Open(BlockKeySite& _site, u64 _key, const char* _keyName)
+{
+	if (!_site.FindRecorderIndex(_key, profileBlockRecorderIdx))
+	{
+		profileBlockRecorderIdx = Profiler::GetKeyedBlockRecorderIndex((NB_TRACKS_TYPE)trackIdx, _site, _key, _keyName);
+	}
+	Open(0, 0);
+}
+
+void Profile::ProfileBlock::OpenInTrack(ProfileTrack* _track, u64 _byteCount, u64 _flopCount)
+{
+	ptr_track = _track;
+	//The track is used if a block is added (see Profile::Profiler::OpenBlock).
+	ptr_track->hasBlock = true;
+	ptr_track->OpenBlock(profileBlockRecorderIdx, _byteCount, _flopCount);
+#if PROFILER_TRACK_ALLOCATIONS
+	ptr_parentRecorder = t_OpenRecorder;
+	t_OpenRecorder = &ptr_track->timings[profileBlockRecorderIdx];
+#endif
+}
+
+void Profile::ProfileBlock::Close()
+{
+#if PROFILER_TRACK_ALLOCATIONS
+	t_OpenRecorder = ptr_parentRecorder;
+#endif
+	ptr_track->CloseBlock(profileBlockRecorderIdx);
+	if (t_TailEventBuffer)
+	{
+		const ProfileBlockRecorder& record = ptr_track->timings[profileBlockRecorderIdx];
+		RecordTailEvent(record.blockName, record.start);
+	}
 }
 
 void Profile::ProfileBlockRecorder::Clear() noexcept
@@ -33,7 +452,17 @@ void Profile::ProfileBlockRecorder::Clear() noexcept
 	hitCount = 0;
 	pageFaultCountStart = 0;
 	pageFaultCountTotal = 0;
+	osMetricsStart.Clear();
+	osMetricsTotal.Clear();
+	allocationCount = 0;
+	allocatedByteCount = 0;
+	freedByteCount = 0;
 	processedByteCount = 0;
+	flopCount = 0;
+	value = 0;
+	valueSum = 0;
+	minValue = 0;
+	maxValue = 0;
 }
 
 void Profile::ProfileBlockRecorder::Reset() noexcept
@@ -43,23 +472,48 @@ void Profile::ProfileBlockRecorder::Reset() noexcept
 	hitCount = 0;
 	pageFaultCountStart = 0;
 	pageFaultCountTotal = 0;
+	osMetricsStart.Clear();
+	osMetricsTotal.Clear();
+	allocationCount = 0;
+	allocatedByteCount = 0;
+	freedByteCount = 0;
 	processedByteCount = 0;
+	flopCount = 0;
+	value = 0;
+	valueSum = 0;
+	minValue = 0;
+	maxValue = 0;
 }
 
-void Profile::ProfileBlockResult::Capture(ProfileBlockRecorder& _record, NB_TRACKS_TYPE _trackIdx,
+void Profile::ProfileBlockResult::Capture(ProfileBlockRecorder& _record, u32 _trackIdx,
 	NB_TIMINGS_TYPE _profileBlockRecorderIdx, u64 _trackElapsedReference, u64 _totalElapsedReference) noexcept
 {
 	trackIdx = _trackIdx;
 	profileBlockRecorderIdx = _profileBlockRecorderIdx;
 	blockName = _record.blockName;
+	fileName = _record.fileName;
+	lineNumber = _record.lineNumber;
 	elapsed = _record.elapsed;
 	elapsedSec = (f64)_record.elapsed / (f64)Timer::GetEstimatedCPUFreq();
 	hitCount = _record.hitCount;
 	pageFaultCountTotal = _record.pageFaultCountTotal;
+	osMetricsTotal = _record.osMetricsTotal;
+	allocationCount = _record.allocationCount;
+	allocatedByteCount = _record.allocatedByteCount;
+	freedByteCount = _record.freedByteCount;
 	processedByteCount = _record.processedByteCount;
+	flopCount = _record.flopCount;
+	kind = _record.kind;
+	keyKind = _record.keyKind;
+	key = _record.key;
+	keyName = _record.keyName;
+	value = _record.value;
+	valueSum = _record.valueSum;
+	minValue = _record.minValue;
+	maxValue = _record.maxValue;
 	proportionInTrack = _trackElapsedReference == 0 ? 0 : 100.0f * (f64)_record.elapsed / (f64)_trackElapsedReference;
 	proportionInTotal = _totalElapsedReference == 0 ? 0 : 100.0f * (f64)_record.elapsed / (f64)_totalElapsedReference;
-	bandwidthInB = _trackElapsedReference == 0 ? 0 : _record.processedByteCount / (((f64)_record.elapsed / (f64)_trackElapsedReference) * elapsedSec);
+	bandwidthInB = _trackElapsedReference == 0 || _record.elapsed == 0 ? 0 : _record.processedByteCount / (((f64)_record.elapsed / (f64)_trackElapsedReference) * elapsedSec);
 }
 
 void Profile::ProfileBlockResult::Clear() noexcept
@@ -70,7 +524,16 @@ void Profile::ProfileBlockResult::Clear() noexcept
 	elapsedSec = 0.0;
 	hitCount = 0;
 	pageFaultCountTotal = 0;
+	osMetricsTotal.Clear();
+	allocationCount = 0;
+	allocatedByteCount = 0;
+	freedByteCount = 0;
 	processedByteCount = 0;
+	flopCount = 0;
+	value = 0;
+	valueSum = 0;
+	minValue = 0;
+	maxValue = 0;
 	proportionInTrack = 0.f;
 	proportionInTotal = 0.f;
 	bandwidthInB = 0;
@@ -78,6 +541,12 @@ void Profile::ProfileBlockResult::Clear() noexcept
 
 void Profile::ProfileBlockResult::Report() noexcept
 {
+	if (kind != RecorderKind_Block)
+	{
+		ReportValue(blockName, kind, hitCount, value, valueSum, minValue, maxValue);
+		return;
+	}
+
 	printf("%s[%llu]: %llu (%.2f%% of track; %.2f%% of total",
 		blockName, hitCount, elapsed, proportionInTrack,proportionInTotal);
 	if (processedByteCount > 0)
@@ -90,6 +559,14 @@ void Profile::ProfileBlockResult::Report() noexcept
 		printf("; %llu PF (%0.4fKB/fault); Page size is %llu bytes", pageFaultCountTotal, (f64)processedByteCount / ((f64)pageFaultCountTotal * 1024.0), Surveyor::GetOSPageSize());
 	}
 
+	if (allocationCount > 0 || freedByteCount > 0)
+	{
+		printf("; %llu allocs (%.2fKB allocated; %.2fKB freed)", allocationCount, (f64)allocatedByteCount / 1024.0, (f64)freedByteCount / 1024.0);
+	}
+
+	ReportOSMetrics(osMetricsTotal, elapsed);
+	ReportRoofline(processedByteCount, flopCount, elapsedSec);
+
 	printf(")\n");
 }
 
@@ -98,7 +575,17 @@ void Profile::ProfileBlockResult::Reset() noexcept
 	elapsed = 0;
 	elapsedSec = 0.0;
 	hitCount = 0;
+	pageFaultCountTotal = 0;
+	osMetricsTotal.Clear();
+	allocationCount = 0;
+	allocatedByteCount = 0;
+	freedByteCount = 0;
 	processedByteCount = 0;
+	flopCount = 0;
+	value = 0;
+	valueSum = 0;
+	minValue = 0;
+	maxValue = 0;
 	proportionInTrack = 0.f;
 	proportionInTotal = 0.f;
 	bandwidthInB = 0;
@@ -111,16 +598,27 @@ void Profile::ProfileTrackResult::Capture(ProfileTrack& _track, u64 _trackIdx, u
 	elapsedSec = (f64)_track.elapsed / (f64)Timer::GetEstimatedCPUFreq();
 	proportionInTotal = _totalElapsedReference == 0 ? 0 : 100.0f * (f64)_track.elapsed / (f64)_totalElapsedReference;
 	blockCount = 0;
+	std::array<NB_TIMINGS_TYPE, NB_TIMINGS> resultIdx = {};
 	NB_TIMINGS_TYPE _profileBlockRecorderIdx = 0;
 	for (ProfileBlockRecorder record : _track.timings)
 	{
 		if (record.hitCount)
 		{
 			timings[blockCount].Capture(record, _trackIdx, _profileBlockRecorderIdx, _track.elapsed, _totalElapsedReference);
+			resultIdx[_profileBlockRecorderIdx] = (NB_TIMINGS_TYPE)blockCount;
 			blockCount++;
 		}
 		_profileBlockRecorderIdx++;
 	}
+
+	//The nodes point to the packed ::timings rather than to the slots of the track
+	callTree.nodeCount = _track.callTree.nodeCount;
+	callTree.droppedCount = _track.callTree.droppedCount;
+	for (CALL_NODES_TYPE i = 0; i < callTree.nodeCount; ++i)
+	{
+		callTree.nodes[i] = _track.callTree.nodes[i];
+		callTree.nodes[i].profileBlockRecorderIdx = resultIdx[_track.callTree.nodes[i].profileBlockRecorderIdx];
+	}
 }
 
 void Profile::ProfileTrackResult::Clear() noexcept
@@ -134,20 +632,237 @@ void Profile::ProfileTrackResult::Clear() noexcept
 		timings[i].Clear();
 	}
 	blockCount = 0;
+	callTree.Clear();
+}
+
+bool Profile::ProfileTrack::CaptureConsistent(ProfileTrack& _copy, u32 _maxRetryCount) const noexcept
+{
+	//Only the slots used in a copy hold values: clear those of the previous copy
+	for (IT_TIMINGS_TYPE i = 0; i < _copy.usedTimingCount; ++i)
+	{
+		_copy.timings[_copy.usedTimings[i]] = ProfileBlockRecorder();
+	}
+	_copy.usedTimingCount = 0;
+
+	//Only read here; std::atomic_ref of a const object requires C++26
+	std::atomic_ref<u64> sequenceRef(const_cast<u64&>(sequence));
+	for (u32 attempt = 0; attempt < _maxRetryCount; ++attempt)
+	{
+		u64 sequenceBefore = sequenceRef.load(std::memory_order_acquire);
+		if (sequenceBefore & 1)
+		{
+			//The owner is in the middle of an update: let it finish
+			std::this_thread::yield();
+			continue;
+		}
+
+		u64 now = Timer::GetCPUTimer();
+		//Only the used slots are copied: most of the ::timings and the
+		//call tree nodes are usually empty. The slots are only ever added
+		//to ::usedTimings, so a retry overwrites all the slots copied before.
+		_copy.hasBlock = hasBlock;
+		memcpy(_copy.name, name, sizeof(name));
+		_copy.elapsed = elapsed;
+		_copy.sequence = sequenceBefore;
+		_copy.usedTimingCount = std::min<IT_TIMINGS_TYPE>(usedTimingCount, NB_TIMINGS);
+		for (IT_TIMINGS_TYPE i = 0; i < _copy.usedTimingCount; ++i)
+		{
+			NB_TIMINGS_TYPE profileBlockRecorderIdx = usedTimings[i];
+			_copy.usedTimings[i] = profileBlockRecorderIdx;
+			memcpy((void*)&_copy.timings[profileBlockRecorderIdx], (const void*)&timings[profileBlockRecorderIdx], sizeof(ProfileBlockRecorder));
+		}
+		_copy.callTree.nodeCount = callTree.nodeCount;
+		_copy.callTree.currentNodeIdx = callTree.currentNodeIdx;
+		_copy.callTree.droppedDepth = callTree.droppedDepth;
+		_copy.callTree.droppedCount = callTree.droppedCount;
+		memcpy((void*)_copy.callTree.nodes.data(), (const void*)callTree.nodes.data(),
+			std::min<u64>(_copy.callTree.nodeCount, NB_CALL_NODES) * sizeof(CallTreeNode));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sequenceRef.load(std::memory_order_relaxed) != sequenceBefore)
+		{
+			continue;
+		}
+
+		//Close the blocks still open at the time of the copy
+		for (IT_TIMINGS_TYPE i = 0; i < _copy.usedTimingCount; ++i)
+		{
+			ProfileBlockRecorder& record = _copy.timings[_copy.usedTimings[i]];
+			if (record.openCount && now > record.start)
+			{
+				u64 inProgress = now - record.start;
+				record.elapsed += inProgress;
+				_copy.elapsed += inProgress;
+			}
+		}
+		for (CALL_NODES_TYPE i = 0; i < _copy.callTree.nodeCount; ++i)
+		{
+			CallTreeNode& node = _copy.callTree.nodes[i];
+			if (node.openCount && now > node.start)
+			{
+				node.elapsed += now - node.start;
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+Profile::u64 Profile::CallTree::GetSelfElapsed(CALL_NODES_TYPE _nodeIdx) const noexcept
+{
+	//The children of a node are always after it
+	u64 childrenElapsed = 0;
+	for (CALL_NODES_TYPE i = _nodeIdx + 1; i < nodeCount; ++i)
+	{
+		if (nodes[i].parentIdx == _nodeIdx)
+		{
+			childrenElapsed += nodes[i].elapsed;
+		}
+	}
+	return nodes[_nodeIdx].elapsed > childrenElapsed ? nodes[_nodeIdx].elapsed - childrenElapsed : 0;
+}
+
+/*!
+@brief Outputs a node of a call tree and, recursively, its children.
+@param _tree The call tree.
+@param _children The children of every node, sorted by decreasing elapsed time.
+@param _nodeIdx The index of the node to output.
+@param _depth The depth of the node, for the indentation.
+@param _timings The blocks of the track, for their names.
+@param _trackElapsed The elapsed time of the track.
+*/
+static void ReportCallTreeNode(const Profile::CallTree& _tree, const std::vector<std::vector<CALL_NODES_TYPE>>& _children,
+	CALL_NODES_TYPE _nodeIdx, Profile::u32 _depth, const std::array<Profile::ProfileBlockRecorder, NB_TIMINGS>& _timings, Profile::u64 _trackElapsed)
+{
+	using namespace Profile;
+
+	const CallTreeNode& node = _tree.nodes[_nodeIdx];
+	f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	printf("%*s%s[%llu]: %fms (%.2f%% of track); self %fms\n", 2 * _depth, "",
+		_timings[node.profileBlockRecorderIdx].blockName, node.hitCount, 1000.0 * (f64)node.elapsed / cpuFreq,
+		_trackElapsed == 0 ? 0 : 100.0f * (f64)node.elapsed / (f64)_trackElapsed,
+		1000.0 * (f64)_tree.GetSelfElapsed(_nodeIdx) / cpuFreq);
+
+	for (CALL_NODES_TYPE childIdx : _children[_nodeIdx])
+	{
+		ReportCallTreeNode(_tree, _children, childIdx, _depth + 1, _timings, _trackElapsed);
+	}
+}
+
+void Profile::CallTree::Report(const std::array<ProfileBlockRecorder, NB_TIMINGS>& _timings, u64 _trackElapsed) const
+{
+	std::vector<std::vector<CALL_NODES_TYPE>> children((u64)rootIdx + 1);
+	for (CALL_NODES_TYPE i = 0; i < nodeCount; ++i)
+	{
+		children[nodes[i].parentIdx].push_back(i);
+	}
+	for (std::vector<CALL_NODES_TYPE>& siblings : children)
+	{
+		std::sort(siblings.begin(), siblings.end(),
+			[this](CALL_NODES_TYPE _a, CALL_NODES_TYPE _b) { return nodes[_a].elapsed > nodes[_b].elapsed; });
+	}
+
+	for (CALL_NODES_TYPE childIdx : children[rootIdx])
+	{
+		ReportCallTreeNode(*this, children, childIdx, 0, _timings, _trackElapsed);
+	}
+	if (droppedCount)
+	{
+		printf("(%llu block execution(s) not in the tree: more than %d call paths)\n", droppedCount, NB_CALL_NODES);
+	}
+}
+
+/*!
+@brief Writes a frame of a folded stack, replacing the characters of the
+		format (the separator of the frames and the line break).
+*/
+static void WriteFoldedFrame(FILE* _file, const char* _frame)
+{
+	for (const char* c = _frame; *c; ++c)
+	{
+		fputc(*c == ';' || *c == '\n' ? '_' : *c, _file);
+	}
+}
+
+void Profile::CallTree::WriteFoldedStacks(FILE* _file, const char* _rootName, const std::array<ProfileBlockRecorder, NB_TIMINGS>& _timings) const
+{
+	f64 nanosecondsPerTick = 1e9 / (f64)Timer::GetEstimatedCPUFreq();
+	std::vector<CALL_NODES_TYPE> path;
+	for (CALL_NODES_TYPE i = 0; i < nodeCount; ++i)
+	{
+		u64 selfInNs = (u64)((f64)GetSelfElapsed(i) * nanosecondsPerTick + 0.5);
+		if (selfInNs == 0)
+		{
+			continue;
+		}
+
+		path.clear();
+		for (CALL_NODES_TYPE nodeIdx = i; nodeIdx != rootIdx; nodeIdx = nodes[nodeIdx].parentIdx)
+		{
+			path.push_back(nodeIdx);
+		}
+
+		if (_rootName)
+		{
+			WriteFoldedFrame(_file, _rootName);
+		}
+		for (u64 j = path.size(); j-- > 0;)
+		{
+			if (_rootName || j + 1 != path.size())
+			{
+				fputc(';', _file);
+			}
+			WriteFoldedFrame(_file, _timings[nodes[path[j]].profileBlockRecorderIdx].blockName);
+		}
+		fprintf(_file, " %llu\n", selfInNs);
+	}
+}
+
+void Profile::CallTree::Reset() noexcept
+{
+	for (CALL_NODES_TYPE i = 0; i < nodeCount; ++i)
+	{
+		nodes[i].hitCount = 0;
+		nodes[i].elapsed = 0;
+	}
+	droppedCount = 0;
+}
+
+void Profile::CallTree::Clear() noexcept
+{
+	for (CALL_NODES_TYPE i = 0; i < nodeCount; ++i)
+	{
+		nodes[i] = CallTreeNode();
+	}
+	table.fill(0);
+	nodeCount = 0;
+	currentNodeIdx = rootIdx;
+	droppedDepth = 0;
+	droppedCount = 0;
 }
 
 void Profile::ProfileTrack::Report(u64 _totalElapsedReference) noexcept
 {
 	f64 elapsedSec = (f64)elapsed / (f64)Timer::GetEstimatedCPUFreq();
-	printf("---- Profile Track: %s (%fms; %.2f%% of total) ----\n", name, 1000 * elapsedSec,
+	printf("---- Profile Track: %s (%fms; %.2f%% of total", name, 1000 * elapsedSec,
 		_totalElapsedReference == 0 ? 0 : 100.0f * (f64)elapsed / (f64)_totalElapsedReference);
+	f64 offCPUPercentage = ComputeTrackOffCPUPercentage(timings, elapsed);
+	if (offCPUPercentage >= 0.0)
+	{
+		printf("; %.1f%% off-CPU", offCPUPercentage);
+	}
+	printf(") ----\n");
 	
 	static f64 megaByte = 1<<20;
 	static f64 gigaByte = 1<<30;
 
 	for (ProfileBlockRecorder& record : timings)
 	{
-		if (record.hitCount)
+		if (record.hitCount && record.kind != RecorderKind_Block)
+		{
+			ReportValue(record.blockName, record.kind, record.hitCount, record.value, record.valueSum, record.minValue, record.maxValue);
+		}
+		else if (record.hitCount && record.keyKind == BlockKeyKind_None)
 		{
 			printf("%s[%llu]: %llu (%.2f%% of track; %.2f%% of total",
 				record.blockName, record.hitCount, record.elapsed, elapsed == 0 ? 0 : 100.0f * (f64)record.elapsed / (f64)elapsed,
@@ -163,9 +878,18 @@ void Profile::ProfileTrack::Report(u64 _totalElapsedReference) noexcept
 				printf("; %llu PF (%0.4fKB/fault); Page size is %llu bytes", record.pageFaultCountTotal, (f64)record.processedByteCount / ((f64)record.pageFaultCountTotal * 1024.0), Surveyor::GetOSPageSize());
 			}
 
+			if (record.allocationCount > 0 || record.freedByteCount > 0)
+			{
+				printf("; %llu allocs (%.2fKB allocated; %.2fKB freed)", record.allocationCount, (f64)record.allocatedByteCount / 1024.0, (f64)record.freedByteCount / 1024.0);
+			}
+
+			ReportOSMetrics(record.osMetricsTotal, record.elapsed);
+			ReportRoofline(record.processedByteCount, record.flopCount, (f64)record.elapsed / (f64)Timer::GetEstimatedCPUFreq());
+
 			printf(")\n");
 		}
 	}
+	ReportKeyedBlocks(timings, elapsed);
 }
 
 void Profile::ProfileTrack::Clear() noexcept
@@ -178,6 +902,7 @@ void Profile::ProfileTrack::Clear() noexcept
 void Profile::ProfileTrack::ClearTimings() noexcept
 {
 	hasBlock = false;
+	callTree.Clear();
 	for (ProfileBlockRecorder& record : timings)
 	{
 		if (record.blockName != nullptr)
@@ -187,6 +912,32 @@ void Profile::ProfileTrack::ClearTimings() noexcept
 	}
 }
 
+NB_TIMINGS_TYPE Profile::ProfileTrack::RegisterBlockRecorder(NB_TIMINGS_TYPE _preferredRecorderIdx,
+	const char* _blockName, const char* _fileName, u32 _lineNumber) noexcept
+{
+	for (IT_TIMINGS_TYPE i = 0; i < NB_TIMINGS; ++i)
+	{
+		NB_TIMINGS_TYPE profileBlockRecorderIdx = (NB_TIMINGS_TYPE)((_preferredRecorderIdx + i) % NB_TIMINGS);
+		ProfileBlockRecorder& record = timings[profileBlockRecorderIdx];
+		if (record.lineNumber == _lineNumber && record.fileName == _fileName)
+		{
+			return profileBlockRecorderIdx;
+		}
+		if (record.blockName == nullptr)
+		{
+			BeginUpdate();
+			AddUsedTiming(profileBlockRecorderIdx);
+			record.blockName = _blockName;
+			record.fileName = _fileName;
+			record.lineNumber = _lineNumber;
+			EndUpdate();
+			return profileBlockRecorderIdx;
+		}
+	}
+	//The track is full: the block shares the statistics of the one in its slot
+	return _preferredRecorderIdx;
+}
+
 void Profile::ProfileTrack::Reset() noexcept
 {
 	elapsed = 0;
@@ -195,6 +946,7 @@ void Profile::ProfileTrack::Reset() noexcept
 
 void Profile::ProfileTrack::ResetTimings() noexcept
 {
+	callTree.Reset();
 	for (ProfileBlockRecorder& record : timings)
 	{
 		if (record.hitCount)
@@ -206,14 +958,21 @@ void Profile::ProfileTrack::ResetTimings() noexcept
 
 void Profile::ProfileTrackResult::Report() noexcept
 {
-	printf("---- Profile Track Results: %s (%fms; %.2f%% of total) ----\n", name, 1000 * elapsedSec, proportionInTotal);
+	printf("---- Profile Track Results: %s (%fms; %.2f%% of total", name, 1000 * elapsedSec, proportionInTotal);
+	f64 offCPUPercentage = ComputeTrackOffCPUPercentage(timings, elapsed);
+	if (offCPUPercentage >= 0.0)
+	{
+		printf("; %.1f%% off-CPU", offCPUPercentage);
+	}
+	printf(") ----\n");
 	for (ProfileBlockResult& record : timings)
 	{
-		if (record.hitCount)
+		if (record.hitCount && record.keyKind == BlockKeyKind_None)
 		{
 			record.Report();
 		}
 	}
+	ReportKeyedBlocks(timings, elapsed);
 }
 
 void Profile::ProfileTrackResult::Reset() noexcept
@@ -226,28 +985,198 @@ void Profile::ProfileTrackResult::Reset() noexcept
 	elapsedSec = 0.0;
 	proportionInTotal = 0.0;
 	blockCount = 0;
+	callTree.Clear();
+}
+
+Profile::DynamicTracks::DynamicTracks(const DynamicTracks& _other)
+{
+	*this = _other;
+}
+
+Profile::DynamicTracks& Profile::DynamicTracks::operator=(const DynamicTracks& _other)
+{
+	if (this != &_other)
+	{
+		u32 otherCount = _other.GetCount();
+		while (GetCount() < otherCount)
+		{
+			Add();
+		}
+		for (u32 i = 0; i < otherCount; ++i)
+		{
+			*Get(i) = *_other.Get(i);
+		}
+		//The tracks beyond the ones of _other are kept registered, but emptied
+		for (u32 i = otherCount; i < GetCount(); ++i)
+		{
+			Get(i)->Reset();
+		}
+	}
+	return *this;
+}
+
+Profile::DynamicTracks::~DynamicTracks()
+{
+	for (ProfileTrack* chunk : chunks)
+	{
+		delete[] chunk;
+	}
+}
+
+Profile::ProfileTrack* Profile::DynamicTracks::Add()
+{
+	u32 idx = count.load(std::memory_order_relaxed);
+	if (idx >= NB_DYNAMIC_TRACKS)
+	{
+		return nullptr;
+	}
+	if (chunks[idx / chunkSize] == nullptr)
+	{
+		chunks[idx / chunkSize] = new ProfileTrack[chunkSize];
+	}
+	//Publishes the chunk along with the track
+	count.store(idx + 1, std::memory_order_release);
+	return &chunks[idx / chunkSize][idx % chunkSize];
 }
 
 NB_TIMINGS_TYPE Profile::Profiler::GetProfileBlockRecorderIndex(NB_TRACKS_TYPE _trackIdx,
 	const char* _fileName, u32 _lineNumber, const char* _blockName)
 {
-	NB_TIMINGS_TYPE profileBlockRecorderIndex = Hash(_fileName, _lineNumber) % NB_TIMINGS;
+	NB_TIMINGS_TYPE preferredRecorderIdx = Hash(_fileName, _lineNumber) % NB_TIMINGS;
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = preferredRecorderIdx;
+	{
+		std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+		for (IT_TIMINGS_TYPE i = 0; i < NB_TIMINGS; ++i)
+		{
+			profileBlockRecorderIdx = (NB_TIMINGS_TYPE)((preferredRecorderIdx + i) % NB_TIMINGS);
+			CallSite& site = s_CallSites[_trackIdx][profileBlockRecorderIdx];
+			if (site.name == nullptr)
+			{
+				site.name = _blockName;
+				site.fileName = _fileName;
+				site.lineNumber = _lineNumber;
+				site.kind = RecorderKind_Block;
+				break;
+			}
+			if (site.kind == RecorderKind_Block && site.keyKind == BlockKeyKind_None && site.lineNumber == _lineNumber && site.fileName == _fileName)
+			{
+				//The same call site, in another instantiation of a template or inline function
+				break;
+			}
+			if (i + 1 == NB_TIMINGS)
+			{
+				printf("Warning: The track %u has no free slot left for the block %s. Increase NB_TIMINGS.\n", (u32)_trackIdx, _blockName);
+				profileBlockRecorderIdx = preferredRecorderIdx;
+			}
+		}
+	}
+	BindCallSite(GetCurrentProfiler()->tracks[_trackIdx], _trackIdx, profileBlockRecorderIdx);
+	return profileBlockRecorderIdx;
+}
+
+NB_TIMINGS_TYPE Profile::Profiler::GetValueRecorderIndex(NB_TRACKS_TYPE _trackIdx,
+	const char* _fileName, u32 _lineNumber, const char* _name, RecorderKind _kind)
+{
+	NB_TIMINGS_TYPE preferredRecorderIdx = Hash(_name, _kind) % NB_TIMINGS;
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = preferredRecorderIdx;
+	{
+		std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+		for (IT_TIMINGS_TYPE i = 0; i < NB_TIMINGS; ++i)
+		{
+			profileBlockRecorderIdx = (NB_TIMINGS_TYPE)((preferredRecorderIdx + i) % NB_TIMINGS);
+			CallSite& site = s_CallSites[_trackIdx][profileBlockRecorderIdx];
+			if (site.name == nullptr)
+			{
+				site.name = _name;
+				site.fileName = _fileName;
+				site.lineNumber = _lineNumber;
+				site.kind = _kind;
+				break;
+			}
+			if (site.kind == _kind && strcmp(site.name, _name) == 0)
+			{
+				break;
+			}
+			if (i + 1 == NB_TIMINGS)
+			{
+				printf("Warning: The track %u has no free slot left for the %s %s. Increase NB_TIMINGS.\n", (u32)_trackIdx, GetRecorderKindName(_kind), _name);
+				profileBlockRecorderIdx = preferredRecorderIdx;
+			}
+		}
+	}
+	BindCallSite(GetCurrentProfiler()->tracks[_trackIdx], _trackIdx, profileBlockRecorderIdx);
+	return profileBlockRecorderIdx;
+}
+
+NB_TIMINGS_TYPE Profile::Profiler::GetKeyedBlockRecorderIndex(NB_TRACKS_TYPE _trackIdx,
+	BlockKeySite& _site, u64 _key, const char* _keyName)
+{
+	std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+	NB_TIMINGS_TYPE profileBlockRecorderIdx = 0;
+	if (_site.FindRecorderIndex(_key, profileBlockRecorderIdx))
+	{
+		//Registered by another thread in the meantime
+		return profileBlockRecorderIdx;
+	}
 
-	ProfileBlockRecorder* profileBlockRecorder = &s_Profiler->tracks[_trackIdx].timings[profileBlockRecorderIndex];
-	ProfileBlockRecorder* InitialprofileBlockRecorder = profileBlockRecorder;
+	BlockKeyKind keyKind = _keyName ? BlockKeyKind_String : BlockKeyKind_Integer;
+	if (_site.keyCount == NB_BLOCK_KEYS)
+	{
+		keyKind = BlockKeyKind_Overflow;
+		_key = 0;
+		_keyName = nullptr;
+	}
 
-	while (profileBlockRecorder->hitCount)
+	NB_TIMINGS_TYPE preferredRecorderIdx = (Hash(_site.fileName, _site.lineNumber) ^ (_key * 11400714819323198485ull)) % NB_TIMINGS;
+	profileBlockRecorderIdx = preferredRecorderIdx;
+	for (IT_TIMINGS_TYPE i = 0; i < NB_TIMINGS; ++i)
 	{
-		profileBlockRecorderIndex = (profileBlockRecorderIndex + 1) % NB_TIMINGS;
-		profileBlockRecorder = &s_Profiler->tracks[_trackIdx].timings[profileBlockRecorderIndex];
+		profileBlockRecorderIdx = (NB_TIMINGS_TYPE)((preferredRecorderIdx + i) % NB_TIMINGS);
+		CallSite& site = s_CallSites[_trackIdx][profileBlockRecorderIdx];
+		if (site.name == nullptr)
+		{
+			site.name = _site.blockName;
+			site.fileName = _site.fileName;
+			site.lineNumber = _site.lineNumber;
+			site.kind = RecorderKind_Block;
+			site.keyKind = keyKind;
+			site.key = _key;
+			site.keyName = _keyName;
+			break;
+		}
+		if (site.keyKind == keyKind && site.key == _key && site.lineNumber == _site.lineNumber && site.fileName == _site.fileName)
+		{
+			//The same call site, in another instantiation of a template
+			break;
+		}
+		if (i + 1 == NB_TIMINGS)
+		{
+			printf("Warning: The track %u has no free slot left for a key of the block %s. Increase NB_TIMINGS.\n", (u32)_trackIdx, _site.blockName);
+			profileBlockRecorderIdx = preferredRecorderIdx;
+		}
+	}
 
-		// if we examined every entry in hash table that means hash table has less entries
-		// than debug records we are putting in source code! Increase MAX_DEBUG_RECORD_COUNT!
-		//Assert(profileBlockRecorder != InitialprofileBlockRecorder);
+	if (keyKind == BlockKeyKind_Overflow)
+	{
+		_site.overflowRecorderIdx = profileBlockRecorderIdx;
+		_site.hasOverflow.store(true, std::memory_order_release);
+		return profileBlockRecorderIdx;
 	}
-	profileBlockRecorder->blockName = _blockName;
 
-	return profileBlockRecorderIndex;
+	u32 preferredEntryIdx = BlockKeySite::GetPreferredEntryIdx(_key);
+	for (u32 i = 0; i < NB_BLOCK_KEYS; ++i)
+	{
+		BlockKeySite::BlockKeyEntry& entry = _site.entries[(preferredEntryIdx + i) % NB_BLOCK_KEYS];
+		if (!entry.isUsed.load(std::memory_order_relaxed))
+		{
+			entry.key = _key;
+			entry.profileBlockRecorderIdx = profileBlockRecorderIdx;
+			entry.isUsed.store(true, std::memory_order_release);
+			_site.keyCount++;
+			break;
+		}
+	}
+	return profileBlockRecorderIdx;
 }
 
 void Profile::Profiler::SetProfilerNameFmt(const char* _fmt, ...)
@@ -301,19 +1230,56 @@ void Profile::Profiler::Clear() noexcept
 	start = 0;
 	elapsed = 0;
 	ClearTracks();
+	for (SpanRecorder& span : spans)
+	{
+		span.Clear();
+	}
 }
 
 void Profile::Profiler::ClearTracks() noexcept
 {
-	for (ProfileTrack& track : tracks)
+	for (u32 i = 0; i < GetTrackCount(); ++i)
 	{
-		if (track.hasBlock)
+		ProfileTrack& track = *GetTrack(i);
+		if (track.hasBlock && i < NB_TRACKS)
 		{
 			track.Clear();
 		}
+		else if (track.hasBlock)
+		{
+			//The name of a dynamic track identifies it (see ::RegisterTrack)
+			track.elapsed = 0;
+			track.ClearTimings();
+		}
 	}
 }
 
+void Profile::Profiler::ExportFoldedStacks([[maybe_unused]] const char* _path) noexcept
+{
+#if PROFILER_ENABLED
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting profiler call trees to %s\n", _path);
+		for (u32 i = 0; i < GetTrackCount(); ++i)
+		{
+			ProfileTrack& track = *GetTrack(i);
+			if (track.hasBlock)
+			{
+				track.callTree.WriteFoldedStacks(file, track.name, track.timings);
+			}
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+#else
+	printf("Profiler export as folded stacks was called but it is disabled. The profiler is therefore empty and the export will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
+
 void Profile::Profiler::ExportToCSV(const char* _fileName) noexcept
 {
 #if PROFILER_ENABLED
@@ -328,16 +1294,18 @@ void Profile::Profiler::ExportToCSV(const char* _fileName) noexcept
 		elapsed, //Total Elapsed
 		(f64)elapsed / (f64)Timer::GetEstimatedCPUFreq() //Total Time in Seconds
 		);
-		fprintf(file, "Track Name,Track Elapsed,Track Elapsed in Secconds,Track Proportion in Total,Block Name,Block Hit Count,Block Elapsed,Block Elapsed in Seconds,Block Proportion in Track,Block Proportion in Total,Block Associated Page Faults Count,Block Processed Byte Count,Block Bandwidth In Bytes\n");
-		for (ProfileTrack& track : tracks)
+		fprintf(file, "Track Name,Track Elapsed,Track Elapsed in Secconds,Track Proportion in Total,Block Name,Block Hit Count,Block Elapsed,Block Elapsed in Seconds,Block Proportion in Track,Block Proportion in Total,Block Associated Page Faults Count,Block Allocation Count,Block Allocated Byte Count,Block Freed Byte Count,Block Minor Page Faults Count,Block Major Page Faults Count,Block Voluntary Context Switches Count,Block Involuntary Context Switches Count,Block User Time In Microseconds,Block System Time In Microseconds,Block Resident Set Size In Bytes,Block Peak Resident Set Size In Bytes,Block Thread CPU Time In Nanoseconds,Block Processed Byte Count,Block Flop Count,Block Bandwidth In Bytes,Block Kind,Block Value,Block Value Sum,Block Value Min,Block Value Max,Block Key\n");
+		for (u32 i = 0; i < GetTrackCount(); ++i)
 		{
+			ProfileTrack& track = *GetTrack(i);
 			if (track.hasBlock)
 			{
 				for (ProfileBlockRecorder& record : track.timings)
 				{
 					if (record.hitCount)
 					{
-						fprintf(file, "%s,%llu,%f,%f,%s,%llu,%llu,%f,%f,%f,%llu,%llu,%f\n",
+						char keyBuffer[24];
+						fprintf(file, "%s,%llu,%f,%f,%s,%llu,%llu,%f,%f,%f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%f,%s,%lld,%lld,%lld,%lld,%s\n",
 							track.name, //Track Name
 							track.elapsed, //Track Elapsed
 							(f64)track.elapsed / (f64)Timer::GetEstimatedCPUFreq(), //Track Elapsed in Seconds
@@ -349,8 +1317,27 @@ void Profile::Profiler::ExportToCSV(const char* _fileName) noexcept
 							100.0 * (f64)record.elapsed / (f64)track.elapsed, //Block Proportion in Track
 							100.0 * (f64)record.elapsed / (f64)elapsed, //Block Proportion in Total
 							record.pageFaultCountTotal, //Block Associated Page Faults Count
+							record.allocationCount, //Block Allocation Count
+							record.allocatedByteCount, //Block Allocated Byte Count
+							record.freedByteCount, //Block Freed Byte Count
+							record.osMetricsTotal.minorPageFaultCount, //Block Minor Page Faults Count
+							record.osMetricsTotal.majorPageFaultCount, //Block Major Page Faults Count
+							record.osMetricsTotal.voluntaryContextSwitchCount, //Block Voluntary Context Switches Count
+							record.osMetricsTotal.involuntaryContextSwitchCount, //Block Involuntary Context Switches Count
+							record.osMetricsTotal.userTimeInUs, //Block User Time In Microseconds
+							record.osMetricsTotal.systemTimeInUs, //Block System Time In Microseconds
+							record.osMetricsTotal.residentSetSizeInB, //Block Resident Set Size In Bytes
+							record.osMetricsTotal.peakResidentSetSizeInB, //Block Peak Resident Set Size In Bytes
+							record.osMetricsTotal.threadCPUTimeInNs, //Block Thread CPU Time In Nanoseconds
 							record.processedByteCount, //Block Processed Byte Count
-							record.processedByteCount / (((f64)record.elapsed / (f64)track.elapsed) * (f64)track.elapsed / (f64)Timer::GetEstimatedCPUFreq()) //Block Bandwidth In Bytes
+							record.flopCount, //Block Flop Count
+							record.elapsed == 0 ? 0.0 : record.processedByteCount / (((f64)record.elapsed / (f64)track.elapsed) * (f64)track.elapsed / (f64)Timer::GetEstimatedCPUFreq()), //Block Bandwidth In Bytes
+							GetRecorderKindName(record.kind), //Block Kind
+							record.value, //Block Value
+							record.valueSum, //Block Value Sum
+							record.minValue, //Block Value Min
+							record.maxValue, //Block Value Max
+							FormatBlockKey(record.keyKind, record.key, record.keyName, keyBuffer) //Block Key
 							);
 					}
 				}
@@ -378,21 +1365,72 @@ void Profile::Profiler::Initialize() noexcept
 	start = Timer::GetCPUTimer();
 }
 
+Profile::TrackHandle Profile::Profiler::RegisterTrack(const char* _name)
+{
+	std::lock_guard<std::mutex> lock(s_TrackRegistrationMutex);
+	TrackHandle handle;
+	//A name too long for the buffer matches the track it was truncated in
+	std::string_view name(_name, strnlen(_name, sizeof(ProfileTrack::name) - 1));
+	for (u32 i = 0; i < dynamicTracks.GetCount(); ++i)
+	{
+		if (std::string_view(dynamicTracks.Get(i)->name) == name)
+		{
+			handle.trackIdx = NB_TRACKS + i;
+			return handle;
+		}
+	}
+
+	ProfileTrack* track = dynamicTracks.Add();
+	if (track == nullptr)
+	{
+		printf("Warning: Could not register the track %s: %u tracks were already registered. Increase NB_DYNAMIC_TRACKS.\n", _name, (u32)NB_DYNAMIC_TRACKS);
+		return handle;
+	}
+	if (strlen(_name) >= sizeof(track->name))
+	{
+		printf("Warning: Tried to register a track name that is too long for the buffer: %s. The name will be truncated.\n", _name);
+	}
+	snprintf(track->name, sizeof(track->name), "%s", _name);
+	handle.trackIdx = NB_TRACKS + dynamicTracks.GetCount() - 1;
+	return handle;
+}
+
 void Profile::Profiler::Report() noexcept
 {
 #if PROFILER_ENABLED
 	printf("\n---- Estimated CPU Frequency: %llu ----\n", Timer::GetEstimatedCPUFreq());
 	printf("---- Profiler Report: %s (%fms) ----\n", name, 1000 * (f64)elapsed / (f64)Timer::GetEstimatedCPUFreq());
 
-	for (ProfileTrack& track : tracks)
+	for (u32 i = 0; i < GetTrackCount(); ++i)
+	{
+		ProfileTrack& track = *GetTrack(i);
+		if (track.hasBlock)
+		{
+			track.Report(elapsed);
+		}
+	}
+	ReportSpans();
+#else
+	printf("Profiler report was called but it is disabled. Report is therefore empty and will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
+
+void Profile::Profiler::ReportCallTree() noexcept
+{
+#if PROFILER_ENABLED
+	printf("\n---- Call Tree Report: %s (%fms) ----\n", name, 1000 * (f64)elapsed / (f64)Timer::GetEstimatedCPUFreq());
+
+	for (u32 i = 0; i < GetTrackCount(); ++i)
 	{
+		ProfileTrack& track = *GetTrack(i);
 		if (track.hasBlock)
 		{
-			track.Report(elapsed);
+			printf("---- Call Tree of Track: %s ----\n", track.name);
+			track.callTree.Report(track.timings, track.elapsed);
 		}
 	}
 #else
-	printf("Profiler report was called but it is disabled. Report is therefore empty and will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+	printf("Profiler call tree report was called but it is disabled. Report is therefore empty and will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
 #endif
 }
 
@@ -401,12 +1439,17 @@ void Profile::Profiler::Reset() noexcept
 	start = 0;
 	elapsed = 0;
 	ResetTracks();
+	for (SpanRecorder& span : spans)
+	{
+		span.Reset();
+	}
 }
 
 void Profile::Profiler::ResetTracks() noexcept
 {
-	for (ProfileTrack& track : tracks)
+	for (u32 i = 0; i < GetTrackCount(); ++i)
 	{
+		ProfileTrack& track = *GetTrack(i);
 		if (track.hasBlock)
 		{
 			track.Reset();
@@ -420,24 +1463,51 @@ void Profile::ProfilerResults::Capture(Profiler* _profiler) noexcept
 	elapsed = _profiler->elapsed;
 	elapsedSec = (f64)_profiler->elapsed / (f64)Timer::GetEstimatedCPUFreq();
 	trackCount = 0;
-	NB_TRACKS_TYPE trackIdx = 0;
-	for (ProfileTrack& track : _profiler->tracks)
+	ReserveTracks(_profiler->GetTrackCount());
+	for (u32 trackIdx = 0; trackIdx < _profiler->GetTrackCount(); ++trackIdx)
 	{
+		ProfileTrack& track = *_profiler->GetTrack(trackIdx);
 		if (track.hasBlock)
 		{
 			tracks[trackCount].Capture(track, trackIdx, _profiler->elapsed);
 			trackCount++;
 		}
-		trackIdx++;
 	}
 }
 
+bool Profile::ProfilerResults::CaptureLive(const Profiler* _profiler, u32 _maxRetryCount) noexcept
+{
+	//The copies are too large for the stack of the threads calling this
+	std::unique_ptr<ProfileTrack> copy = std::make_unique<ProfileTrack>();
+	bool consistent = true;
+
+	name = _profiler->name;
+	elapsed = _profiler->start ? Timer::GetCPUTimer() - _profiler->start : 0;
+	elapsedSec = (f64)elapsed / (f64)Timer::GetEstimatedCPUFreq();
+	trackCount = 0;
+	//Tracks registered during the capture are left for the next one
+	u32 profilerTrackCount = _profiler->GetTrackCount();
+	ReserveTracks(profilerTrackCount);
+	for (u32 trackIdx = 0; trackIdx < profilerTrackCount; ++trackIdx)
+	{
+		const ProfileTrack& track = *_profiler->GetTrack(trackIdx);
+		if (track.hasBlock)
+		{
+			consistent = track.CaptureConsistent(*copy, _maxRetryCount) && consistent;
+			tracks[trackCount].Capture(*copy, trackIdx, elapsed);
+			tracks[trackCount].name = track.name; //not the name of the copy
+			trackCount++;
+		}
+	}
+	return consistent;
+}
+
 void Profile::ProfilerResults::Clear() noexcept
 {
 	name = nullptr;
 	elapsed = 0;
 	elapsedSec = 0.0;
-	for (IT_TRACKS_TYPE i = 0; i < trackCount; ++i)
+	for (u32 i = 0; i < trackCount; ++i)
 	{
 		tracks[i].Clear();
 	}
@@ -458,12 +1528,13 @@ void Profile::ProfilerResults::ExportToCSV(const char* _path) noexcept
 		elapsed, //Total Elapsed
 		elapsedSec //Total Time in Seconds
 		);
-        fprintf(file, "Track Name,Track Elapsed,Track Elapsed in Seconds,Track Proportion in Total,Block Name,Block Hit Count,Block Elapsed,Block Elapsed in Seconds,Block Proportion in Track,Block Proportion in Total,Block Associated Page Faults Count,Block Processed Byte Count,Block Bandwidth In Bytes\n");
-        for (IT_TRACKS_TYPE i = 0; i < trackCount; ++i)
+        fprintf(file, "Track Name,Track Elapsed,Track Elapsed in Seconds,Track Proportion in Total,Block Name,Block Hit Count,Block Elapsed,Block Elapsed in Seconds,Block Proportion in Track,Block Proportion in Total,Block Associated Page Faults Count,Block Allocation Count,Block Allocated Byte Count,Block Freed Byte Count,Block Minor Page Faults Count,Block Major Page Faults Count,Block Voluntary Context Switches Count,Block Involuntary Context Switches Count,Block User Time In Microseconds,Block System Time In Microseconds,Block Resident Set Size In Bytes,Block Peak Resident Set Size In Bytes,Block Thread CPU Time In Nanoseconds,Block Processed Byte Count,Block Flop Count,Block Bandwidth In Bytes,Block Kind,Block Value,Block Value Sum,Block Value Min,Block Value Max,Block Key\n");
+        for (u32 i = 0; i < trackCount; ++i)
         {
             for (IT_TIMINGS_TYPE j = 0; j < tracks[i].blockCount; ++j)
             {
-                fprintf(file, "%s,%llu,%f,%f,%s,%llu,%llu,%f,%f,%f,%llu,%llu,%f\n",
+				char keyBuffer[24];
+                fprintf(file, "%s,%llu,%f,%f,%s,%llu,%llu,%f,%f,%f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%f,%s,%lld,%lld,%lld,%lld,%s\n",
 					tracks[i].name, //Track Name
 					tracks[i].elapsed, //Track Elapsed
 					tracks[i].elapsedSec, //Track Elapsed in Seconds
@@ -475,8 +1546,27 @@ void Profile::ProfilerResults::ExportToCSV(const char* _path) noexcept
 					100.0 * (f64)tracks[i].timings[j].elapsed / (f64)tracks[i].elapsed, //Block Proportion in Track
 					100.0 * (f64)tracks[i].timings[j].elapsed / (f64)elapsed, //Block Proportion in Total
 					tracks[i].timings[j].pageFaultCountTotal, //Block Associated Page Faults Count
+					tracks[i].timings[j].allocationCount, //Block Allocation Count
+					tracks[i].timings[j].allocatedByteCount, //Block Allocated Byte Count
+					tracks[i].timings[j].freedByteCount, //Block Freed Byte Count
+					tracks[i].timings[j].osMetricsTotal.minorPageFaultCount, //Block Minor Page Faults Count
+					tracks[i].timings[j].osMetricsTotal.majorPageFaultCount, //Block Major Page Faults Count
+					tracks[i].timings[j].osMetricsTotal.voluntaryContextSwitchCount, //Block Voluntary Context Switches Count
+					tracks[i].timings[j].osMetricsTotal.involuntaryContextSwitchCount, //Block Involuntary Context Switches Count
+					tracks[i].timings[j].osMetricsTotal.userTimeInUs, //Block User Time In Microseconds
+					tracks[i].timings[j].osMetricsTotal.systemTimeInUs, //Block System Time In Microseconds
+					tracks[i].timings[j].osMetricsTotal.residentSetSizeInB, //Block Resident Set Size In Bytes
+					tracks[i].timings[j].osMetricsTotal.peakResidentSetSizeInB, //Block Peak Resident Set Size In Bytes
+					tracks[i].timings[j].osMetricsTotal.threadCPUTimeInNs, //Block Thread CPU Time In Nanoseconds
 					tracks[i].timings[j].processedByteCount, //Block Processed Byte Count
-					(f64)tracks[i].timings[j].processedByteCount / (((f64)tracks[i].timings[j].elapsed / (f64)tracks[i].elapsed) * ((f64)tracks[i].elapsed / (f64)Timer::GetEstimatedCPUFreq())) //Block Bandwidth In Bytes
+					tracks[i].timings[j].flopCount, //Block Flop Count
+					tracks[i].timings[j].elapsed == 0 ? 0.0 : (f64)tracks[i].timings[j].processedByteCount / (((f64)tracks[i].timings[j].elapsed / (f64)tracks[i].elapsed) * ((f64)tracks[i].elapsed / (f64)Timer::GetEstimatedCPUFreq())), //Block Bandwidth In Bytes
+					GetRecorderKindName(tracks[i].timings[j].kind), //Block Kind
+					tracks[i].timings[j].value, //Block Value
+					tracks[i].timings[j].valueSum, //Block Value Sum
+					tracks[i].timings[j].minValue, //Block Value Min
+					tracks[i].timings[j].maxValue, //Block Value Max
+					FormatBlockKey(tracks[i].timings[j].keyKind, tracks[i].timings[j].key, tracks[i].timings[j].keyName, keyBuffer) //Block Key
 					);
             }
         }
@@ -495,7 +1585,7 @@ void Profile::ProfilerResults::Report() noexcept
 {
 	printf("---- ProfilerResults: %s (%fms) ----\n", name, 1000 * elapsedSec);
 	
-	for (IT_TRACKS_TYPE i = 0; i < trackCount; ++i)
+	for (u32 i = 0; i < trackCount; ++i)
 	{
 		tracks[i].Report();
 	}
@@ -503,7 +1593,7 @@ void Profile::ProfilerResults::Report() noexcept
 
 void Profile::ProfilerResults::Reset() noexcept
 {
-	for (IT_TRACKS_TYPE i = 0; i < trackCount; ++i)
+	for (u32 i = 0; i < trackCount; ++i)
 	{
 		tracks[i].Reset();
 	}
@@ -517,6 +1607,7 @@ void Profile::RepetitionProfiler::Clear(u64 _repetitionCount) noexcept
 	maxResults.Clear();
 	minResults.Clear();
 	varianceResults.Clear();
+	ClearRobustStatistics();
 	for (u64 i = 0; i < _repetitionCount; ++i)
 	{
 		ptr_repetitionResults[i].Clear();
@@ -531,8 +1622,9 @@ void Profile::RepetitionProfiler::ComputeAverageResults(u64 _repetitionCount) no
 		averageResults.elapsedSec += ptr_repetitionResults[i].elapsedSec;
 		if (averageResults.trackCount < ptr_repetitionResults[i].trackCount)
 			averageResults.trackCount = ptr_repetitionResults[i].trackCount;
+		averageResults.ReserveTracks(ptr_repetitionResults[i].trackCount);
 
-		for (IT_TRACKS_TYPE j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
+		for (u32 j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
 		{
 			averageResults.tracks[j].name = ptr_repetitionResults[i].tracks[j].name;
 			averageResults.tracks[j].elapsed += ptr_repetitionResults[i].tracks[j].elapsed;
@@ -548,10 +1640,32 @@ void Profile::RepetitionProfiler::ComputeAverageResults(u64 _repetitionCount) no
 				averageResults.tracks[j].timings[k].elapsedSec += ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec;
 				averageResults.tracks[j].timings[k].hitCount += ptr_repetitionResults[i].tracks[j].timings[k].hitCount;
 				averageResults.tracks[j].timings[k].pageFaultCountTotal += ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal;
+				averageResults.tracks[j].timings[k].osMetricsTotal.mask |= ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.mask;
+				averageResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.minorPageFaultCount;
+				averageResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.majorPageFaultCount;
+				averageResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount;
+				averageResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount;
+				averageResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.userTimeInUs;
+				averageResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.systemTimeInUs;
+				averageResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.residentSetSizeInB;
+				averageResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB;
+				averageResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs += ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs;
+				averageResults.tracks[j].timings[k].allocationCount += ptr_repetitionResults[i].tracks[j].timings[k].allocationCount;
+				averageResults.tracks[j].timings[k].allocatedByteCount += ptr_repetitionResults[i].tracks[j].timings[k].allocatedByteCount;
+				averageResults.tracks[j].timings[k].freedByteCount += ptr_repetitionResults[i].tracks[j].timings[k].freedByteCount;
 				averageResults.tracks[j].timings[k].processedByteCount += ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount;
+				averageResults.tracks[j].timings[k].flopCount += ptr_repetitionResults[i].tracks[j].timings[k].flopCount;
 				averageResults.tracks[j].timings[k].proportionInTrack += ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack;
 				averageResults.tracks[j].timings[k].proportionInTotal += ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal;
 				averageResults.tracks[j].timings[k].bandwidthInB += ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB;
+				averageResults.tracks[j].timings[k].kind = ptr_repetitionResults[i].tracks[j].timings[k].kind;
+				averageResults.tracks[j].timings[k].keyKind = ptr_repetitionResults[i].tracks[j].timings[k].keyKind;
+				averageResults.tracks[j].timings[k].key = ptr_repetitionResults[i].tracks[j].timings[k].key;
+				averageResults.tracks[j].timings[k].keyName = ptr_repetitionResults[i].tracks[j].timings[k].keyName;
+				averageResults.tracks[j].timings[k].value += ptr_repetitionResults[i].tracks[j].timings[k].value;
+				averageResults.tracks[j].timings[k].valueSum += ptr_repetitionResults[i].tracks[j].timings[k].valueSum;
+				averageResults.tracks[j].timings[k].minValue += ptr_repetitionResults[i].tracks[j].timings[k].minValue;
+				averageResults.tracks[j].timings[k].maxValue += ptr_repetitionResults[i].tracks[j].timings[k].maxValue;
 			}
 		}
 	}
@@ -559,7 +1673,7 @@ void Profile::RepetitionProfiler::ComputeAverageResults(u64 _repetitionCount) no
 	// finish the average calculation for the whole profiler
 	averageResults.elapsed /= _repetitionCount;
 	averageResults.elapsedSec /= _repetitionCount;
-	for (IT_TRACKS_TYPE j = 0; j < averageResults.trackCount; ++j)
+	for (u32 j = 0; j < averageResults.trackCount; ++j)
 	{
 		// finish the average calculation for the current track
 		averageResults.tracks[j].elapsed /= _repetitionCount;
@@ -572,10 +1686,85 @@ void Profile::RepetitionProfiler::ComputeAverageResults(u64 _repetitionCount) no
 			averageResults.tracks[j].timings[k].elapsedSec /= _repetitionCount;
 			averageResults.tracks[j].timings[k].hitCount /= _repetitionCount;
 			averageResults.tracks[j].timings[k].pageFaultCountTotal /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB /= _repetitionCount;
+			averageResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs /= _repetitionCount;
+			averageResults.tracks[j].timings[k].allocationCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].allocatedByteCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].freedByteCount /= _repetitionCount;
 			averageResults.tracks[j].timings[k].processedByteCount /= _repetitionCount;
+			averageResults.tracks[j].timings[k].flopCount /= _repetitionCount;
 			averageResults.tracks[j].timings[k].proportionInTrack /= _repetitionCount;
 			averageResults.tracks[j].timings[k].proportionInTotal /= _repetitionCount;
 			averageResults.tracks[j].timings[k].bandwidthInB /= _repetitionCount;
+			averageResults.tracks[j].timings[k].value /= (s64)_repetitionCount;
+			averageResults.tracks[j].timings[k].valueSum /= (s64)_repetitionCount;
+			averageResults.tracks[j].timings[k].minValue /= (s64)_repetitionCount;
+			averageResults.tracks[j].timings[k].maxValue /= (s64)_repetitionCount;
+		}
+	}
+}
+
+void Profile::RepetitionProfiler::ComputeRobustStatistics(u64 _repetitionCount) noexcept
+{
+	statisticsSamples.resize(_repetitionCount);
+	statisticsScratch.resize(_repetitionCount);
+	statisticsGenerator = RandomGenerator(_repetitionCount);
+	outlierRepetitions.assign(_repetitionCount, false);
+
+	// The whole profiler
+	u32 trackCount = 0;
+	for (u64 i = 0; i < _repetitionCount; ++i)
+	{
+		statisticsSamples[i] = (f64)ptr_repetitionResults[i].elapsed;
+		if (trackCount < ptr_repetitionResults[i].trackCount)
+			trackCount = ptr_repetitionResults[i].trackCount;
+	}
+	if (trackElapsedStatistics.size() < trackCount)
+	{
+		trackElapsedStatistics.resize(trackCount);
+		blockElapsedStatistics.resize(trackCount);
+	}
+	elapsedStatistics.Compute(statisticsSamples.data(), _repetitionCount, statisticsScratch.data(), statisticsGenerator);
+	for (u64 i = 0; i < _repetitionCount; ++i)
+	{
+		outlierRepetitions[i] = elapsedStatistics.IsOutlier((f64)ptr_repetitionResults[i].elapsed);
+	}
+
+	for (u32 j = 0; j < trackCount; ++j)
+	{
+		// The current track
+		u64 sampleCount = 0;
+		NB_TIMINGS_TYPE blockCount = 0;
+		for (u64 i = 0; i < _repetitionCount; ++i)
+		{
+			if (j < ptr_repetitionResults[i].trackCount)
+			{
+				statisticsSamples[sampleCount++] = (f64)ptr_repetitionResults[i].tracks[j].elapsed;
+				if (blockCount < ptr_repetitionResults[i].tracks[j].blockCount)
+					blockCount = ptr_repetitionResults[i].tracks[j].blockCount;
+			}
+		}
+		trackElapsedStatistics[j].Compute(statisticsSamples.data(), sampleCount, statisticsScratch.data(), statisticsGenerator);
+
+		for (IT_TIMINGS_TYPE k = 0; k < blockCount; ++k)
+		{
+			// The current block
+			sampleCount = 0;
+			for (u64 i = 0; i < _repetitionCount; ++i)
+			{
+				if (j < ptr_repetitionResults[i].trackCount && k < ptr_repetitionResults[i].tracks[j].blockCount)
+				{
+					statisticsSamples[sampleCount++] = (f64)ptr_repetitionResults[i].tracks[j].timings[k].elapsed;
+				}
+			}
+			blockElapsedStatistics[j][k].Compute(statisticsSamples.data(), sampleCount, statisticsScratch.data(), statisticsGenerator);
 		}
 	}
 }
@@ -586,55 +1775,56 @@ void Profile::RepetitionProfiler::ComputeVarianceResults(u64 _repetitionCount) n
 
 	for (u64 i = 0; i < _repetitionCount; ++i)
 	{
-		varianceResults.elapsed += (ptr_repetitionResults[i].elapsed - averageResults.elapsed) * (ptr_repetitionResults[i].elapsed - averageResults.elapsed);
-		varianceResults.elapsedSec += (ptr_repetitionResults[i].elapsedSec - averageResults.elapsedSec) * (ptr_repetitionResults[i].elapsedSec - averageResults.elapsedSec);
+		AccumulateSquaredDifference(varianceResults.elapsed, ptr_repetitionResults[i].elapsed, averageResults.elapsed, _repetitionCount);
+		AccumulateSquaredDifference(varianceResults.elapsedSec, ptr_repetitionResults[i].elapsedSec, averageResults.elapsedSec, _repetitionCount);
 		if (varianceResults.trackCount < ptr_repetitionResults[i].trackCount)
 			varianceResults.trackCount = ptr_repetitionResults[i].trackCount;
-		for (IT_TRACKS_TYPE j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
+		varianceResults.ReserveTracks(ptr_repetitionResults[i].trackCount);
+		for (u32 j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
 		{
 			varianceResults.tracks[j].name = ptr_repetitionResults[i].tracks[j].name;
-			varianceResults.tracks[j].elapsed += (ptr_repetitionResults[i].tracks[j].elapsed - averageResults.tracks[j].elapsed) * (ptr_repetitionResults[i].tracks[j].elapsed - averageResults.tracks[j].elapsed);
-			varianceResults.tracks[j].elapsedSec += (ptr_repetitionResults[i].tracks[j].elapsedSec - averageResults.tracks[j].elapsedSec) * (ptr_repetitionResults[i].tracks[j].elapsedSec - averageResults.tracks[j].elapsedSec);
-			varianceResults.tracks[j].proportionInTotal += (ptr_repetitionResults[i].tracks[j].proportionInTotal - averageResults.tracks[j].proportionInTotal) * (ptr_repetitionResults[i].tracks[j].proportionInTotal - averageResults.tracks[j].proportionInTotal);
+			AccumulateSquaredDifference(varianceResults.tracks[j].elapsed, ptr_repetitionResults[i].tracks[j].elapsed, averageResults.tracks[j].elapsed, _repetitionCount);
+			AccumulateSquaredDifference(varianceResults.tracks[j].elapsedSec, ptr_repetitionResults[i].tracks[j].elapsedSec, averageResults.tracks[j].elapsedSec, _repetitionCount);
+			AccumulateSquaredDifference(varianceResults.tracks[j].proportionInTotal, ptr_repetitionResults[i].tracks[j].proportionInTotal, averageResults.tracks[j].proportionInTotal, _repetitionCount);
 			if (varianceResults.tracks[j].blockCount < ptr_repetitionResults[i].tracks[j].blockCount)
 				varianceResults.tracks[j].blockCount = ptr_repetitionResults[i].tracks[j].blockCount;
 			for (IT_TIMINGS_TYPE k = 0; k < ptr_repetitionResults[i].tracks[j].blockCount; ++k)
 			{
 				varianceResults.tracks[j].timings[k].blockName = ptr_repetitionResults[i].tracks[j].timings[k].blockName;
-				varianceResults.tracks[j].timings[k].elapsed += (ptr_repetitionResults[i].tracks[j].timings[k].elapsed - averageResults.tracks[j].timings[k].elapsed) * (ptr_repetitionResults[i].tracks[j].timings[k].elapsed - averageResults.tracks[j].timings[k].elapsed);
-				varianceResults.tracks[j].timings[k].elapsedSec += (ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec - averageResults.tracks[j].timings[k].elapsedSec) * (ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec - averageResults.tracks[j].timings[k].elapsedSec);
-				varianceResults.tracks[j].timings[k].hitCount += (ptr_repetitionResults[i].tracks[j].timings[k].hitCount - averageResults.tracks[j].timings[k].hitCount) * (ptr_repetitionResults[i].tracks[j].timings[k].hitCount - averageResults.tracks[j].timings[k].hitCount);
-				varianceResults.tracks[j].timings[k].pageFaultCountTotal += (ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal - averageResults.tracks[j].timings[k].pageFaultCountTotal) * (ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal - averageResults.tracks[j].timings[k].pageFaultCountTotal);
-				varianceResults.tracks[j].timings[k].processedByteCount += (ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount - averageResults.tracks[j].timings[k].processedByteCount) * (ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount - averageResults.tracks[j].timings[k].processedByteCount);
-				varianceResults.tracks[j].timings[k].proportionInTrack += (ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack - averageResults.tracks[j].timings[k].proportionInTrack) * (ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack - averageResults.tracks[j].timings[k].proportionInTrack);
-				varianceResults.tracks[j].timings[k].proportionInTotal += (ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal - averageResults.tracks[j].timings[k].proportionInTotal) * (ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal - averageResults.tracks[j].timings[k].proportionInTotal);
-				varianceResults.tracks[j].timings[k].bandwidthInB += (ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB - averageResults.tracks[j].timings[k].bandwidthInB) * (ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB - averageResults.tracks[j].timings[k].bandwidthInB);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].elapsed, ptr_repetitionResults[i].tracks[j].timings[k].elapsed, averageResults.tracks[j].timings[k].elapsed, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].elapsedSec, ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec, averageResults.tracks[j].timings[k].elapsedSec, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].hitCount, ptr_repetitionResults[i].tracks[j].timings[k].hitCount, averageResults.tracks[j].timings[k].hitCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].pageFaultCountTotal, ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal, averageResults.tracks[j].timings[k].pageFaultCountTotal, _repetitionCount);
+				varianceResults.tracks[j].timings[k].osMetricsTotal.mask |= ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.mask;
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.minorPageFaultCount, averageResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.majorPageFaultCount, averageResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount, averageResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount, averageResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.userTimeInUs, averageResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.systemTimeInUs, averageResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.residentSetSizeInB, averageResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB, averageResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs, averageResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].allocationCount, ptr_repetitionResults[i].tracks[j].timings[k].allocationCount, averageResults.tracks[j].timings[k].allocationCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].allocatedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].allocatedByteCount, averageResults.tracks[j].timings[k].allocatedByteCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].freedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].freedByteCount, averageResults.tracks[j].timings[k].freedByteCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].processedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount, averageResults.tracks[j].timings[k].processedByteCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].flopCount, ptr_repetitionResults[i].tracks[j].timings[k].flopCount, averageResults.tracks[j].timings[k].flopCount, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].proportionInTrack, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack, averageResults.tracks[j].timings[k].proportionInTrack, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].proportionInTotal, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal, averageResults.tracks[j].timings[k].proportionInTotal, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].bandwidthInB, ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB, averageResults.tracks[j].timings[k].bandwidthInB, _repetitionCount);
+				varianceResults.tracks[j].timings[k].kind = ptr_repetitionResults[i].tracks[j].timings[k].kind;
+				varianceResults.tracks[j].timings[k].keyKind = ptr_repetitionResults[i].tracks[j].timings[k].keyKind;
+				varianceResults.tracks[j].timings[k].key = ptr_repetitionResults[i].tracks[j].timings[k].key;
+				varianceResults.tracks[j].timings[k].keyName = ptr_repetitionResults[i].tracks[j].timings[k].keyName;
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].value, ptr_repetitionResults[i].tracks[j].timings[k].value, averageResults.tracks[j].timings[k].value, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].valueSum, ptr_repetitionResults[i].tracks[j].timings[k].valueSum, averageResults.tracks[j].timings[k].valueSum, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].minValue, ptr_repetitionResults[i].tracks[j].timings[k].minValue, averageResults.tracks[j].timings[k].minValue, _repetitionCount);
+				AccumulateSquaredDifference(varianceResults.tracks[j].timings[k].maxValue, ptr_repetitionResults[i].tracks[j].timings[k].maxValue, averageResults.tracks[j].timings[k].maxValue, _repetitionCount);
 			}
 		}
 	}
-
-	// finish the standard deviation calculation for the whole profiler
-	varianceResults.elapsed /= _repetitionCount;
-	varianceResults.elapsedSec /= _repetitionCount;
-	for (IT_TRACKS_TYPE j = 0; j < varianceResults.trackCount; ++j)
-	{
-		// finish the standard deviation calculation for the current track
-		varianceResults.tracks[j].elapsed /= _repetitionCount;
-		varianceResults.tracks[j].elapsedSec /= _repetitionCount;
-		varianceResults.tracks[j].proportionInTotal /= _repetitionCount;
-		for (IT_TIMINGS_TYPE k = 0; k < varianceResults.tracks[j].blockCount; ++k)
-		{
-			// finish the standard deviation calculation for the current block
-			varianceResults.tracks[j].timings[k].elapsed /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].elapsedSec /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].hitCount /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].pageFaultCountTotal /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].processedByteCount /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].proportionInTrack /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].proportionInTotal /= _repetitionCount;
-			varianceResults.tracks[j].timings[k].bandwidthInB /= _repetitionCount;
-		}
-	}
+	//The squared differences are divided by _repetitionCount as they are accumulated
 }
 
 void Profile::RepetitionProfiler::FindMaxResults(u64 _repetitionCount) noexcept
@@ -645,7 +1835,8 @@ void Profile::RepetitionProfiler::FindMaxResults(u64 _repetitionCount) noexcept
 		MaxAssign(maxResults.elapsedSec, ptr_repetitionResults[i].elapsedSec);
 		if (maxResults.trackCount < ptr_repetitionResults[i].trackCount)
 			maxResults.trackCount = ptr_repetitionResults[i].trackCount;
-		for (IT_TRACKS_TYPE j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
+		maxResults.ReserveTracks(ptr_repetitionResults[i].trackCount);
+		for (u32 j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
 		{
 			maxResults.tracks[j].name = ptr_repetitionResults[i].tracks[j].name;
 			MaxAssign(maxResults.tracks[j].elapsed, ptr_repetitionResults[i].tracks[j].elapsed);
@@ -660,10 +1851,32 @@ void Profile::RepetitionProfiler::FindMaxResults(u64 _repetitionCount) noexcept
 				MaxAssign(maxResults.tracks[j].timings[k].elapsedSec, ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec);
 				MaxAssign(maxResults.tracks[j].timings[k].hitCount, ptr_repetitionResults[i].tracks[j].timings[k].hitCount);
 				MaxAssign(maxResults.tracks[j].timings[k].pageFaultCountTotal, ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal);
+				maxResults.tracks[j].timings[k].osMetricsTotal.mask |= ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.mask;
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.minorPageFaultCount);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.majorPageFaultCount);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.userTimeInUs);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.systemTimeInUs);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.residentSetSizeInB);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB);
+				MaxAssign(maxResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs);
+				MaxAssign(maxResults.tracks[j].timings[k].allocationCount, ptr_repetitionResults[i].tracks[j].timings[k].allocationCount);
+				MaxAssign(maxResults.tracks[j].timings[k].allocatedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].allocatedByteCount);
+				MaxAssign(maxResults.tracks[j].timings[k].freedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].freedByteCount);
 				MaxAssign(maxResults.tracks[j].timings[k].processedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount);
+				MaxAssign(maxResults.tracks[j].timings[k].flopCount, ptr_repetitionResults[i].tracks[j].timings[k].flopCount);
 				MaxAssign(maxResults.tracks[j].timings[k].proportionInTrack, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack);
 				MaxAssign(maxResults.tracks[j].timings[k].proportionInTotal, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal);
 				MaxAssign(maxResults.tracks[j].timings[k].bandwidthInB, ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB);
+				maxResults.tracks[j].timings[k].kind = ptr_repetitionResults[i].tracks[j].timings[k].kind;
+				maxResults.tracks[j].timings[k].keyKind = ptr_repetitionResults[i].tracks[j].timings[k].keyKind;
+				maxResults.tracks[j].timings[k].key = ptr_repetitionResults[i].tracks[j].timings[k].key;
+				maxResults.tracks[j].timings[k].keyName = ptr_repetitionResults[i].tracks[j].timings[k].keyName;
+				MaxAssign(maxResults.tracks[j].timings[k].value, ptr_repetitionResults[i].tracks[j].timings[k].value);
+				MaxAssign(maxResults.tracks[j].timings[k].valueSum, ptr_repetitionResults[i].tracks[j].timings[k].valueSum);
+				MaxAssign(maxResults.tracks[j].timings[k].minValue, ptr_repetitionResults[i].tracks[j].timings[k].minValue);
+				MaxAssign(maxResults.tracks[j].timings[k].maxValue, ptr_repetitionResults[i].tracks[j].timings[k].maxValue);
 			}
 		}
 	}
@@ -677,7 +1890,8 @@ void Profile::RepetitionProfiler::FindMinResults(u64 _repetitionCount) noexcept
 		MinAssign(minResults.elapsedSec, ptr_repetitionResults[i].elapsedSec);
 		if (minResults.trackCount < ptr_repetitionResults[i].trackCount)
 			minResults.trackCount = ptr_repetitionResults[i].trackCount;
-		for (IT_TRACKS_TYPE j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
+		minResults.ReserveTracks(ptr_repetitionResults[i].trackCount);
+		for (u32 j = 0; j < ptr_repetitionResults[i].trackCount; ++j)
 		{
 			minResults.tracks[j].name = ptr_repetitionResults[i].tracks[j].name;
 			MinAssign(minResults.tracks[j].elapsed, ptr_repetitionResults[i].tracks[j].elapsed);
@@ -692,10 +1906,32 @@ void Profile::RepetitionProfiler::FindMinResults(u64 _repetitionCount) noexcept
 				MinAssign(minResults.tracks[j].timings[k].elapsedSec, ptr_repetitionResults[i].tracks[j].timings[k].elapsedSec);
 				MinAssign(minResults.tracks[j].timings[k].hitCount, ptr_repetitionResults[i].tracks[j].timings[k].hitCount);
 				MinAssign(minResults.tracks[j].timings[k].pageFaultCountTotal, ptr_repetitionResults[i].tracks[j].timings[k].pageFaultCountTotal);
+				minResults.tracks[j].timings[k].osMetricsTotal.mask |= ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.mask;
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.minorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.minorPageFaultCount);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.majorPageFaultCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.majorPageFaultCount);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.voluntaryContextSwitchCount);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.involuntaryContextSwitchCount);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.userTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.userTimeInUs);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.systemTimeInUs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.systemTimeInUs);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.residentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.residentSetSizeInB);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.peakResidentSetSizeInB);
+				MinAssign(minResults.tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs, ptr_repetitionResults[i].tracks[j].timings[k].osMetricsTotal.threadCPUTimeInNs);
+				MinAssign(minResults.tracks[j].timings[k].allocationCount, ptr_repetitionResults[i].tracks[j].timings[k].allocationCount);
+				MinAssign(minResults.tracks[j].timings[k].allocatedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].allocatedByteCount);
+				MinAssign(minResults.tracks[j].timings[k].freedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].freedByteCount);
 				MinAssign(minResults.tracks[j].timings[k].processedByteCount, ptr_repetitionResults[i].tracks[j].timings[k].processedByteCount);
+				MinAssign(minResults.tracks[j].timings[k].flopCount, ptr_repetitionResults[i].tracks[j].timings[k].flopCount);
 				MinAssign(minResults.tracks[j].timings[k].proportionInTrack, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTrack);
 				MinAssign(minResults.tracks[j].timings[k].proportionInTotal, ptr_repetitionResults[i].tracks[j].timings[k].proportionInTotal);
 				MinAssign(minResults.tracks[j].timings[k].bandwidthInB, ptr_repetitionResults[i].tracks[j].timings[k].bandwidthInB);
+				minResults.tracks[j].timings[k].kind = ptr_repetitionResults[i].tracks[j].timings[k].kind;
+				minResults.tracks[j].timings[k].keyKind = ptr_repetitionResults[i].tracks[j].timings[k].keyKind;
+				minResults.tracks[j].timings[k].key = ptr_repetitionResults[i].tracks[j].timings[k].key;
+				minResults.tracks[j].timings[k].keyName = ptr_repetitionResults[i].tracks[j].timings[k].keyName;
+				MinAssign(minResults.tracks[j].timings[k].value, ptr_repetitionResults[i].tracks[j].timings[k].value);
+				MinAssign(minResults.tracks[j].timings[k].valueSum, ptr_repetitionResults[i].tracks[j].timings[k].valueSum);
+				MinAssign(minResults.tracks[j].timings[k].minValue, ptr_repetitionResults[i].tracks[j].timings[k].minValue);
+				MinAssign(minResults.tracks[j].timings[k].maxValue, ptr_repetitionResults[i].tracks[j].timings[k].maxValue);
 			}
 		}
 	}
@@ -735,9 +1971,9 @@ void Profile::RepetitionProfiler::BestPerfSearchRepetitionTesting(u16 _repetitio
 					ptr_profiler->Clear();
 					Clear(repetitionTestsCount);
 
-					if (repetitionTests[i]->name)
+					if (repetitionTests[i].name)
 					{
-						ptr_profiler->SetProfilerName(repetitionTests[i]->name);
+						ptr_profiler->SetProfilerName(repetitionTests[i].name);
 					}
 					else
 					{
@@ -758,9 +1994,7 @@ void Profile::RepetitionProfiler::BestPerfSearchRepetitionTesting(u16 _repetitio
 				while (Timer::GetCPUTimer() < nextTestTimeOut)
 				{
 					ptr_profiler->ResetTracks();
-					ptr_profiler->Initialize();
-					(*repetitionTests[i])();
-					ptr_profiler->End();
+					repetitionTests[i].Run(ptr_profiler);
 
 					// If we find a better performance
 					if (ptr_profiler->elapsed < bestPerfs[i])
@@ -808,6 +2042,75 @@ void Profile::RepetitionProfiler::ExportToCSV(const char* _path, u64 _repetition
 	sprintf(path, "%s/Summary/Variance.csv", _path);
 	varianceResults.ExportToCSV(path);
 
+	// Export the robust statistics of the blocks to a CSV file
+	sprintf(path, "%s/Summary/RobustStatistics.csv", _path);
+	FILE* file = fopen(path, "w");
+	if (file)
+	{
+		printf("Exporting repetition profiler robust statistics to %s\n", path);
+		fprintf(file, "Track Name,Block Name,Sample Count,Mean,Standard Deviation,Min,Max,Median,Median Absolute Deviation,Percentile 5,Percentile 25,Percentile 75,Percentile 95,Percentile 99,Trimmed Mean,Median Confidence Low,Median Confidence High,Outlier Count\n");
+		for (u32 i = 0; i < averageResults.trackCount; ++i)
+		{
+			//The statistics of the track come first, with an empty block name
+			for (s64 j = -1; j < (s64)averageResults.tracks[i].blockCount; ++j)
+			{
+				if (j < 0 && i >= trackElapsedStatistics.size())
+				{
+					continue;
+				}
+				RobustStatistics& statistics = j < 0 ? trackElapsedStatistics[i] : blockElapsedStatistics[i][j];
+				fprintf(file, "%s,%s,%llu,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%llu\n",
+					averageResults.tracks[i].name, //Track Name
+					j < 0 ? "" : averageResults.tracks[i].timings[j].blockName, //Block Name
+					statistics.sampleCount, //Sample Count
+					statistics.mean, //Mean
+					statistics.standardDeviation, //Standard Deviation
+					statistics.min, //Min
+					statistics.max, //Max
+					statistics.median, //Median
+					statistics.medianAbsoluteDeviation, //Median Absolute Deviation
+					statistics.percentile5, //Percentile 5
+					statistics.percentile25, //Percentile 25
+					statistics.percentile75, //Percentile 75
+					statistics.percentile95, //Percentile 95
+					statistics.percentile99, //Percentile 99
+					statistics.trimmedMean, //Trimmed Mean
+					statistics.confidenceLow, //Median Confidence Low
+					statistics.confidenceHigh, //Median Confidence High
+					statistics.outlierCount //Outlier Count
+					);
+			}
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", path);
+	}
+
+	// Export the elapsed time of every repetition with its outlier flag to a CSV file
+	sprintf(path, "%s/Summary/Repetitions.csv", _path);
+	file = fopen(path, "w");
+	if (file)
+	{
+		printf("Exporting repetition profiler outlier flags to %s\n", path);
+		fprintf(file, "Repetition,Elapsed,Elapsed in Seconds,Is Outlier\n");
+		for (u64 i = 0; i < _repetitionCount; ++i)
+		{
+			fprintf(file, "%llu,%llu,%f,%d\n",
+				i, //Repetition
+				ptr_repetitionResults[i].elapsed, //Elapsed
+				ptr_repetitionResults[i].elapsedSec, //Elapsed in Seconds
+				i < outlierRepetitions.size() && outlierRepetitions[i] ? 1 : 0 //Is Outlier
+				);
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", path);
+	}
+
 	// Export the repetition results to a CSV file
 	for (u64 i = 0; i < _repetitionCount; ++i)
 	{
@@ -816,6 +2119,425 @@ void Profile::RepetitionProfiler::ExportToCSV(const char* _path, u64 _repetition
 	}
 }
 
+void Profile::RepetitionProfiler::ExportComparisonToCSV(const char* _path) noexcept
+{
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting repetition profiler comparison to %s\n", _path);
+		fprintf(file, "Test Name,Baseline Name,Rounds,Elapsed Median,Elapsed Median Absolute Deviation,Elapsed Median Confidence Low,Elapsed Median Confidence High,Speedup Median,Speedup Median Confidence Low,Speedup Median Confidence High,Speedup Trimmed Mean,Verdict\n");
+		for (RepetitionComparison& comparison : comparisons)
+		{
+			fprintf(file, "%s,%s,%llu,%f,%f,%f,%f,%f,%f,%f,%f,%d\n",
+				repetitionTests[comparison.testIdx].name ? repetitionTests[comparison.testIdx].name : "", //Test Name
+				repetitionTests[comparison.baselineIdx].name ? repetitionTests[comparison.baselineIdx].name : "", //Baseline Name
+				comparison.elapsedStatistics.sampleCount, //Rounds
+				comparison.elapsedStatistics.median, //Elapsed Median
+				comparison.elapsedStatistics.medianAbsoluteDeviation, //Elapsed Median Absolute Deviation
+				comparison.elapsedStatistics.confidenceLow, //Elapsed Median Confidence Low
+				comparison.elapsedStatistics.confidenceHigh, //Elapsed Median Confidence High
+				comparison.speedupStatistics.median, //Speedup Median
+				comparison.speedupStatistics.confidenceLow, //Speedup Median Confidence Low
+				comparison.speedupStatistics.confidenceHigh, //Speedup Median Confidence High
+				comparison.speedupStatistics.trimmedMean, //Speedup Trimmed Mean
+				comparison.Verdict() //Verdict
+				);
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+}
+
+void Profile::RepetitionProfiler::ExportScalingToCSV(const char* _path) noexcept
+{
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting repetition profiler scaling to %s\n", _path);
+		fprintf(file, "Thread Count,Repetitions,Wall Time In Seconds,Min Wall Time In Seconds,Thread Elapsed In Seconds,Max Thread Elapsed In Seconds,Throughput,Speedup,Efficiency,Block Name,Block Hit Count,Block Elapsed,Block Processed Byte Count,Block Aggregate Bandwidth In Bytes,Block Per Thread Bandwidth In Bytes\n");
+		for (ScalingResult& result : scalingResults)
+		{
+			ScalingBlockResult emptyBlock;
+			u64 blockCount = result.blocks.empty() ? 1 : result.blocks.size();
+			for (u64 i = 0; i < blockCount; ++i)
+			{
+				ScalingBlockResult& block = result.blocks.empty() ? emptyBlock : result.blocks[i];
+				fprintf(file, "%u,%llu,%f,%f,%f,%f,%f,%f,%f,%s,%llu,%llu,%llu,%f,%f\n",
+					result.threadCount, //Thread Count
+					result.repetitionCount, //Repetitions
+					result.wallSec, //Wall Time In Seconds
+					result.minWallSec, //Min Wall Time In Seconds
+					result.threadElapsedSec, //Thread Elapsed In Seconds
+					result.maxThreadElapsedSec, //Max Thread Elapsed In Seconds
+					result.throughput, //Throughput
+					result.speedup, //Speedup
+					result.efficiency, //Efficiency
+					block.blockName ? block.blockName : "", //Block Name
+					block.hitCount, //Block Hit Count
+					block.elapsed, //Block Elapsed
+					block.processedByteCount, //Block Processed Byte Count
+					block.aggregateBandwidthInB, //Block Aggregate Bandwidth In Bytes
+					block.perThreadBandwidthInB //Block Per Thread Bandwidth In Bytes
+					);
+			}
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+}
+
+void Profile::RepetitionProfiler::InterleavedRepetitionTesting(u64 _roundCount, u16 _baselineIdx, bool _randomizeOrder)
+{
+	Profiler* ptr_profiler = GetProfiler();
+
+	//The tests are indexed on 16 bits (see RepetitionComparison::testIdx)
+	if (repetitionTests.size() > 0xFFFF)
+	{
+		printf("ERROR: InterleavedRepetitionTesting supports up to 65535 tests, not %llu.\n", (u64)repetitionTests.size());
+		return;
+	}
+	u16 repetitionTestsCount = (u16)repetitionTests.size();
+	if (repetitionTestsCount == 0 || _roundCount == 0 || _baselineIdx >= repetitionTestsCount)
+	{
+		printf("ERROR: InterleavedRepetitionTesting needs at least one test, one round and a valid baseline index.\n");
+		return;
+	}
+
+	Reset(repetitionTestsCount * _roundCount);
+	ptr_profiler->Reset();
+
+	//Give default names to the tracks in the profiler
+	for (NB_TRACKS_TYPE i = 0; i < NB_TRACKS; i++)
+	{
+		ptr_profiler->SetTrackNameFmt(i, "Track %d", i);
+	}
+
+	std::vector<u16> order(repetitionTestsCount);
+	for (u16 i = 0; i < repetitionTestsCount; ++i)
+	{
+		order[i] = i;
+	}
+	RandomGenerator orderGenerator(Timer::GetCPUTimer());
+
+	for (u64 r = 0; r < _roundCount; ++r)
+	{
+		if (_randomizeOrder)
+		{
+			// Fisher-Yates shuffle
+			for (u16 i = repetitionTestsCount - 1; i > 0; --i)
+			{
+				u16 j = (u16)orderGenerator.NextBounded(i + 1);
+				u16 tmp = order[i];
+				order[i] = order[j];
+				order[j] = tmp;
+			}
+		}
+		else
+		{
+			for (u16 i = 0; i < repetitionTestsCount; ++i)
+			{
+				order[i] = (u16)((i + r) % repetitionTestsCount);
+			}
+		}
+
+		for (u16 t : order)
+		{
+			repetitionTests[t].Run(ptr_profiler);
+			ptr_repetitionResults[t * _roundCount + r].Capture(ptr_profiler);
+			ptr_profiler->ResetTracks();
+		}
+	}
+
+	// Report every test on its own slice of the results
+	ProfilerResults* ptr_allResults = ptr_repetitionResults;
+	for (u16 t = 0; t < repetitionTestsCount; ++t)
+	{
+		if (repetitionTests[t].name)
+		{
+			ptr_profiler->SetProfilerName(repetitionTests[t].name);
+		}
+		else
+		{
+			ptr_profiler->SetProfilerNameFmt("Interleaved Repetition Test %d", t);
+		}
+		Reset(0);
+		averageResults.name = ptr_profiler->name;
+		maxResults.name = ptr_profiler->name;
+		minResults.name = ptr_profiler->name;
+		varianceResults.name = ptr_profiler->name;
+		ptr_repetitionResults = ptr_allResults + t * _roundCount;
+		Report(_roundCount);
+	}
+	ptr_repetitionResults = ptr_allResults;
+
+	// Paired comparisons against the baseline
+	comparisons.resize(repetitionTestsCount);
+	statisticsSamples.resize(_roundCount);
+	statisticsScratch.resize(_roundCount);
+	statisticsGenerator = RandomGenerator(_roundCount);
+	for (u16 t = 0; t < repetitionTestsCount; ++t)
+	{
+		RepetitionComparison& comparison = comparisons[t];
+		comparison.testIdx = t;
+		comparison.baselineIdx = _baselineIdx;
+
+		for (u64 r = 0; r < _roundCount; ++r)
+		{
+			statisticsSamples[r] = (f64)ptr_repetitionResults[t * _roundCount + r].elapsed;
+		}
+		comparison.elapsedStatistics.Compute(statisticsSamples.data(), _roundCount, statisticsScratch.data(), statisticsGenerator);
+
+		for (u64 r = 0; r < _roundCount; ++r)
+		{
+			u64 testElapsed = ptr_repetitionResults[t * _roundCount + r].elapsed;
+			u64 baselineElapsed = ptr_repetitionResults[_baselineIdx * _roundCount + r].elapsed;
+			statisticsSamples[r] = testElapsed == 0 ? 0.0 : (f64)baselineElapsed / (f64)testElapsed;
+		}
+		comparison.speedupStatistics.Compute(statisticsSamples.data(), _roundCount, statisticsScratch.data(), statisticsGenerator);
+	}
+
+	ReportComparison();
+}
+
+void Profile::RepetitionProfiler::ReportComparison() noexcept
+{
+	if (comparisons.empty())
+	{
+		return;
+	}
+
+	const char* baselineName = repetitionTests[comparisons[0].baselineIdx].name;
+	printf("\n---- Interleaved Comparison against baseline: %s ----\n", baselineName ? baselineName : "(unnamed)");
+	for (RepetitionComparison& comparison : comparisons)
+	{
+		const char* testName = repetitionTests[comparison.testIdx].name;
+		printf("%s[%llu rounds]: median %.0f cycles (%.0f%% CI [%.0f, %.0f]); speedup x%.3f (%.0f%% CI [%.3f, %.3f]) -> %s\n",
+			testName ? testName : "(unnamed)", comparison.elapsedStatistics.sampleCount,
+			comparison.elapsedStatistics.median, 100.0 * RobustStatistics::confidenceLevel,
+			comparison.elapsedStatistics.confidenceLow, comparison.elapsedStatistics.confidenceHigh,
+			comparison.speedupStatistics.median, 100.0 * RobustStatistics::confidenceLevel,
+			comparison.speedupStatistics.confidenceLow, comparison.speedupStatistics.confidenceHigh,
+			comparison.testIdx == comparison.baselineIdx ? "baseline" :
+			comparison.Verdict() > 0 ? "faster" : comparison.Verdict() < 0 ? "slower" : "no significant difference");
+	}
+}
+
+void Profile::RepetitionProfiler::ReportScaling() noexcept
+{
+	if (scalingResults.empty())
+	{
+		return;
+	}
+
+	printf("\n---- Scaling Report: %s (%llu repetitions per thread count) ----\n",
+		GetProfiler()->name, scalingResults[0].repetitionCount);
+	printf("Threads | Wall (ms) | Min Wall (ms) | Thread (ms) | Slowest Thread (ms) | Throughput (calls/s) | Speedup | Efficiency\n");
+	for (ScalingResult& result : scalingResults)
+	{
+		printf("%7u | %9.4f | %13.4f | %11.4f | %19.4f | %20.2f | x%6.3f | %9.2f%%\n",
+			result.threadCount, 1000 * result.wallSec, 1000 * result.minWallSec,
+			1000 * result.threadElapsedSec, 1000 * result.maxThreadElapsedSec,
+			result.throughput, result.speedup, 100.0 * result.efficiency);
+		for (ScalingBlockResult& block : result.blocks)
+		{
+			if (block.processedByteCount > 0)
+			{
+				printf("\t%s: %.3fGB/s aggregate, %.3fGB/s per thread\n", block.blockName,
+					block.aggregateBandwidthInB / (1 << 30), block.perThreadBandwidthInB / (1 << 30));
+			}
+		}
+	}
+
+	//Draw the speedup against the ideal (linear) speedup.
+	const u32 maxThreadCount = scalingResults.back().threadCount;
+	const u32 width = 50;
+	printf("Speedup curve ('#' measured, '|' ideal):\n");
+	for (ScalingResult& result : scalingResults)
+	{
+		u32 measured = (u32)(result.speedup / (f64)maxThreadCount * width + 0.5);
+		u32 ideal = (u32)((f64)result.threadCount / (f64)maxThreadCount * width + 0.5);
+		printf("%3u ", result.threadCount);
+		for (u32 i = 1; i <= width && (i <= measured || i <= ideal); ++i)
+		{
+			printf("%c", i == ideal ? '|' : i <= measured ? '#' : ' ');
+		}
+		printf(" x%.2f\n", result.speedup);
+	}
+}
+
+void Profile::RepetitionProfiler::ScalingRepetitionTesting(u16 _testIdx, u32 _maxThreadCount, u64 _repetitionCount, bool _pinThreads)
+{
+	scalingResults.clear();
+	if (_testIdx >= repetitionTests.size() || _maxThreadCount == 0 || _repetitionCount == 0)
+	{
+		printf("ERROR: ScalingRepetitionTesting needs a valid test index, at least one thread and one repetition.\n");
+		return;
+	}
+
+	Profiler* ptr_profiler = GetProfiler();
+	RepetitionTestFunction& test = repetitionTests[_testIdx];
+	if (test.name)
+	{
+		ptr_profiler->SetProfilerName(test.name);
+	}
+	else
+	{
+		ptr_profiler->SetProfilerNameFmt("Scaling Repetition Test %d", _testIdx);
+	}
+
+	//Warm up on the calling thread. This also registers the blocks of the test
+	//so that the profilers of the threads, copied from this one, know them.
+	ptr_profiler->ResetTracks();
+	test.Run(ptr_profiler);
+	ptr_profiler->ResetTracks();
+
+	std::vector<Profiler*> threadProfilers(_maxThreadCount);
+	for (u32 k = 0; k < _maxThreadCount; ++k)
+	{
+		threadProfilers[k] = new Profiler(*ptr_profiler);
+	}
+
+	const f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	const u32 trackCount = ptr_profiler->GetTrackCount();
+	std::vector<ScalingBlockResult> blockTotals((u64)trackCount * NB_TIMINGS);
+	std::vector<u64> threadElapsed(_maxThreadCount);
+
+	for (u32 threadCount = 1; threadCount <= _maxThreadCount; ++threadCount)
+	{
+		std::fill(blockTotals.begin(), blockTotals.end(), ScalingBlockResult());
+		std::fill(threadElapsed.begin(), threadElapsed.end(), 0);
+		u64 wallTotal = 0;
+		u64 wallMin = ~0ull;
+
+		//Three synchronization points per repetition: all threads are set up,
+		//all threads are done with the body, the results have been gathered.
+		std::barrier<> sync(threadCount + 1);
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (u32 k = 0; k < threadCount; ++k)
+		{
+			threads.emplace_back([&, k]()
+			{
+				if (_pinThreads)
+				{
+					Surveyor::PinCurrentThreadToCore(k);
+				}
+				Profiler* ptr_threadProfiler = threadProfilers[k];
+				SetThreadProfiler(ptr_threadProfiler);
+				for (u64 r = 0; r < _repetitionCount; ++r)
+				{
+					ptr_threadProfiler->ResetTracks();
+					test.Setup(k);
+					sync.arrive_and_wait();
+					test.RunTimed(ptr_threadProfiler, k);
+					sync.arrive_and_wait();
+					sync.arrive_and_wait();
+					test.Teardown(k);
+				}
+				SetThreadProfiler(nullptr);
+			});
+		}
+
+		for (u64 r = 0; r < _repetitionCount; ++r)
+		{
+			sync.arrive_and_wait();
+			sync.arrive_and_wait();
+
+			//The wall time goes from the first thread entering the body to the
+			//last one leaving it, as timed by their own profilers.
+			u64 wallStart = ~0ull;
+			u64 wallEnd = 0;
+			for (u32 k = 0; k < threadCount; ++k)
+			{
+				Profiler* ptr_threadProfiler = threadProfilers[k];
+				u64 threadEnd = ptr_threadProfiler->start + ptr_threadProfiler->elapsed;
+				wallStart = ptr_threadProfiler->start < wallStart ? ptr_threadProfiler->start : wallStart;
+				wallEnd = threadEnd > wallEnd ? threadEnd : wallEnd;
+			}
+			u64 wall = wallEnd - wallStart;
+			wallTotal += wall;
+			wallMin = wall < wallMin ? wall : wallMin;
+
+			for (u32 k = 0; k < threadCount; ++k)
+			{
+				Profiler* ptr_threadProfiler = threadProfilers[k];
+				threadElapsed[k] += ptr_threadProfiler->elapsed;
+				for (u32 i = 0; i < trackCount; ++i)
+				{
+					ProfileTrack* ptr_track = ptr_threadProfiler->GetTrack(i);
+					if (ptr_track == nullptr || !ptr_track->hasBlock)
+					{
+						continue;
+					}
+					for (IT_TIMINGS_TYPE j = 0; j < NB_TIMINGS; ++j)
+					{
+						ProfileBlockRecorder& recorder = ptr_track->timings[j];
+						if (recorder.hitCount > 0)
+						{
+							ScalingBlockResult& total = blockTotals[(u64)i * NB_TIMINGS + j];
+							total.trackIdx = i;
+							total.profileBlockRecorderIdx = (NB_TIMINGS_TYPE)j;
+							total.blockName = recorder.blockName;
+							total.hitCount += recorder.hitCount;
+							total.elapsed += recorder.elapsed;
+							total.processedByteCount += recorder.processedByteCount;
+						}
+					}
+				}
+			}
+			sync.arrive_and_wait();
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		ScalingResult result;
+		result.threadCount = threadCount;
+		result.repetitionCount = _repetitionCount;
+		result.wallSec = (f64)wallTotal / ((f64)_repetitionCount * cpuFreq);
+		result.minWallSec = (f64)wallMin / cpuFreq;
+		u64 threadElapsedTotal = 0;
+		u64 threadElapsedMax = 0;
+		for (u32 k = 0; k < threadCount; ++k)
+		{
+			threadElapsedTotal += threadElapsed[k];
+			threadElapsedMax = threadElapsed[k] > threadElapsedMax ? threadElapsed[k] : threadElapsedMax;
+		}
+		result.threadElapsedSec = (f64)threadElapsedTotal / ((f64)threadCount * (f64)_repetitionCount * cpuFreq);
+		result.maxThreadElapsedSec = (f64)threadElapsedMax / ((f64)_repetitionCount * cpuFreq);
+		result.throughput = result.wallSec > 0.0 ? (f64)threadCount / result.wallSec : 0.0;
+		result.speedup = scalingResults.empty() ? 1.0 :
+			scalingResults[0].throughput > 0.0 ? result.throughput / scalingResults[0].throughput : 0.0;
+		result.efficiency = result.speedup / (f64)threadCount;
+		for (ScalingBlockResult& total : blockTotals)
+		{
+			if (total.hitCount > 0)
+			{
+				f64 wallTotalSec = (f64)wallTotal / cpuFreq;
+				total.aggregateBandwidthInB = wallTotalSec > 0.0 ? (f64)total.processedByteCount / wallTotalSec : 0.0;
+				total.perThreadBandwidthInB = total.elapsed > 0 ? (f64)total.processedByteCount * cpuFreq / (f64)total.elapsed : 0.0;
+				result.blocks.push_back(total);
+			}
+		}
+		scalingResults.push_back(std::move(result));
+	}
+
+	for (Profiler* ptr_threadProfiler : threadProfilers)
+	{
+		delete ptr_threadProfiler;
+	}
+
+	ReportScaling();
+}
+
 void Profile::RepetitionProfiler::FixedCountRepetitionTesting(u64 _repetitionCount, bool _reset, bool _clear)
 {
 	Profiler* ptr_profiler = GetProfiler();
@@ -832,9 +2554,9 @@ void Profile::RepetitionProfiler::FixedCountRepetitionTesting(u64 _repetitionCou
 			ptr_profiler->Clear();
 			Clear(_repetitionCount);
 
-			if (repetitionTests[i]->name)
+			if (repetitionTests[i].name)
 			{
-				ptr_profiler->SetProfilerName(repetitionTests[i]->name);
+				ptr_profiler->SetProfilerName(repetitionTests[i].name);
 			}
 			else
 			{
@@ -855,9 +2577,7 @@ void Profile::RepetitionProfiler::FixedCountRepetitionTesting(u64 _repetitionCou
 
 		for (u64 j = 0; j < _repetitionCount; ++j)
 		{
-			ptr_profiler->Initialize();
-			(*repetitionTests[i])();
-			ptr_profiler->End();
+			repetitionTests[i].Run(ptr_profiler);
 			ptr_repetitionResults[j].Capture(ptr_profiler);
 			ptr_profiler->ResetTracks();
 		}
@@ -876,28 +2596,71 @@ void Profile::RepetitionProfiler::Report(u64 _repetitionCount) noexcept
 
 	FindMinResults(_repetitionCount);
 
+	ComputeRobustStatistics(_repetitionCount);
+
 	//go through all blocks and all tracks and print the average results with the
 	//standard deviation, the minimum and the maximum values
 	printf("\n---- Estimated CPU Frequency: %llu ----\n", Timer::GetEstimatedCPUFreq());
 	printf("---- Repetition Profiler Report: %s ({%f, %f(+/-)%f, %f}ms) ----\n",
 		averageResults.name,
 		1000 * minResults.elapsedSec, 1000 * averageResults.elapsedSec, 1000 * std::sqrt(varianceResults.elapsedSec), 1000 * maxResults.elapsedSec);
-	for (IT_TRACKS_TYPE i = 0; i < averageResults.trackCount; ++i)
+	printf("Robust elapsed: ");
+	elapsedStatistics.Report(1000.0 / (f64)Timer::GetEstimatedCPUFreq(), "ms");
+	printf("\n");
+	if (elapsedStatistics.outlierCount)
+	{
+		printf("Repetitions flagged as outliers (likely disturbed by interrupts or context switches):");
+		for (u64 i = 0; i < outlierRepetitions.size(); ++i)
+		{
+			if (outlierRepetitions[i])
+			{
+				printf(" %llu (%llu)", i, ptr_repetitionResults[i].elapsed);
+			}
+		}
+		printf("\n");
+	}
+	for (u32 i = 0; i < averageResults.trackCount; ++i)
 	{
 		if (averageResults.tracks[i].name != nullptr)
 		{
-			printf("---- Profile Track Results : % s({% f,% f(+/ -) % f,% f}ms; { % .2f, % .2f(+/ -) % .2f, % .2f }%% of total) ----\n",
+			printf("---- Profile Track Results : % s({% f,% f(+/ -) % f,% f}ms; { % .2f, % .2f(+/ -) % .2f, % .2f }%% of total",
 				averageResults.tracks[i].name,
 				1000 * minResults.tracks[i].elapsedSec, 1000 * averageResults.tracks[i].elapsedSec,	1000 * std::sqrt(varianceResults.tracks[i].elapsedSec), 1000 * maxResults.tracks[i].elapsedSec,
 				minResults.tracks[i].proportionInTotal, averageResults.tracks[i].proportionInTotal,	std::sqrt(varianceResults.tracks[i].proportionInTotal), maxResults.tracks[i].proportionInTotal);
+			f64 offCPUPercentage = ComputeTrackOffCPUPercentage(averageResults.tracks[i].timings, averageResults.tracks[i].elapsed);
+			if (offCPUPercentage >= 0.0)
+			{
+				printf("; %.1f%% average off-CPU", offCPUPercentage);
+			}
+			printf(") ----\n");
+			if (i < trackElapsedStatistics.size())
+			{
+				printf("Robust track elapsed: ");
+				trackElapsedStatistics[i].Report(1000.0 / (f64)Timer::GetEstimatedCPUFreq(), "ms");
+				printf("\n");
+			}
 
 			for (IT_TIMINGS_TYPE j = 0; j < averageResults.tracks[i].blockCount; ++j)
 			{
-				if (averageResults.tracks[i].timings[j].hitCount > 0)
+				if (averageResults.tracks[i].timings[j].hitCount > 0 && averageResults.tracks[i].timings[j].kind != RecorderKind_Block)
 				{
-					printf("%s[{%llu, %llu(+/-)%f, %llu}]: {%llu, %llu(+/-)%f, %llu} ({%.2f, %.2f(+/-)%.2f, %.2f}%% of track; {%.2f, %.2f(+/-)%.2f, %.2f}%% of total",
+					printf("%s[{%llu, %llu(+/-)%f, %llu}]: %s {%lld, %lld(+/-)%f, %lld} (updates in {%lld, %lld(+/-)%f, %lld}..{%lld, %lld(+/-)%f, %lld})\n",
 						averageResults.tracks[i].timings[j].blockName,
 						minResults.tracks[i].timings[j].hitCount, averageResults.tracks[i].timings[j].hitCount, std::sqrt(varianceResults.tracks[i].timings[j].hitCount), maxResults.tracks[i].timings[j].hitCount,
+						GetRecorderKindName(averageResults.tracks[i].timings[j].kind),
+						minResults.tracks[i].timings[j].value, averageResults.tracks[i].timings[j].value, std::sqrt((f64)varianceResults.tracks[i].timings[j].value), maxResults.tracks[i].timings[j].value,
+						minResults.tracks[i].timings[j].minValue, averageResults.tracks[i].timings[j].minValue, std::sqrt((f64)varianceResults.tracks[i].timings[j].minValue), maxResults.tracks[i].timings[j].minValue,
+						minResults.tracks[i].timings[j].maxValue, averageResults.tracks[i].timings[j].maxValue, std::sqrt((f64)varianceResults.tracks[i].timings[j].maxValue), maxResults.tracks[i].timings[j].maxValue);
+				}
+				else if (averageResults.tracks[i].timings[j].hitCount > 0)
+				{
+					//The keys of a keyed block follow its name
+					char keyBuffer[24];
+					const ProfileBlockResult& block = averageResults.tracks[i].timings[j];
+					printf("%s%s%s%s[{%llu, %llu(+/-)%f, %llu}]: {%llu, %llu(+/-)%f, %llu} ({%.2f, %.2f(+/-)%.2f, %.2f}%% of track; {%.2f, %.2f(+/-)%.2f, %.2f}%% of total",
+						block.blockName, block.keyKind == BlockKeyKind_None ? "" : " (",
+						FormatBlockKey(block.keyKind, block.key, block.keyName, keyBuffer), block.keyKind == BlockKeyKind_None ? "" : ")",
+						minResults.tracks[i].timings[j].hitCount, averageResults.tracks[i].timings[j].hitCount, std::sqrt(varianceResults.tracks[i].timings[j].hitCount), maxResults.tracks[i].timings[j].hitCount,
 						minResults.tracks[i].timings[j].elapsed, averageResults.tracks[i].timings[j].elapsed, std::sqrt(varianceResults.tracks[i].timings[j].elapsed), maxResults.tracks[i].timings[j].elapsed,
 						minResults.tracks[i].timings[j].proportionInTrack, averageResults.tracks[i].timings[j].proportionInTrack, std::sqrt(varianceResults.tracks[i].timings[j].proportionInTrack), maxResults.tracks[i].timings[j].proportionInTrack,
 						minResults.tracks[i].timings[j].proportionInTotal, averageResults.tracks[i].timings[j].proportionInTotal, std::sqrt(varianceResults.tracks[i].timings[j].proportionInTotal), maxResults.tracks[i].timings[j].proportionInTotal);
@@ -915,7 +2678,19 @@ void Profile::RepetitionProfiler::Report(u64 _repetitionCount) noexcept
 							(f64)minResults.tracks[i].timings[j].processedByteCount / ((f64)minResults.tracks[i].timings[j].pageFaultCountTotal * 1024.0), (f64)averageResults.tracks[i].timings[j].processedByteCount / ((f64)averageResults.tracks[i].timings[j].pageFaultCountTotal * 1024.0), varianceResults.tracks[i].timings[j].pageFaultCountTotal == 0 ? 0.0 :std::sqrt((f64)varianceResults.tracks[i].timings[j].processedByteCount / ((f64)varianceResults.tracks[i].timings[j].pageFaultCountTotal * 1024.0)), (f64)maxResults.tracks[i].timings[j].processedByteCount / ((f64)maxResults.tracks[i].timings[j].pageFaultCountTotal * 1024.0),
 							Surveyor::GetOSPageSize());
 					}
+					if (averageResults.tracks[i].timings[j].allocationCount > 0 || averageResults.tracks[i].timings[j].freedByteCount > 0)
+					{
+						printf("; {%llu, %llu(+/-)%.f, %llu} allocs ({%.2f, %.2f(+/-)%.2f, %.2f}KB allocated; {%.2f, %.2f(+/-)%.2f, %.2f}KB freed)",
+							minResults.tracks[i].timings[j].allocationCount, averageResults.tracks[i].timings[j].allocationCount, std::sqrt(varianceResults.tracks[i].timings[j].allocationCount), maxResults.tracks[i].timings[j].allocationCount,
+							(f64)minResults.tracks[i].timings[j].allocatedByteCount / 1024.0, (f64)averageResults.tracks[i].timings[j].allocatedByteCount / 1024.0, std::sqrt(varianceResults.tracks[i].timings[j].allocatedByteCount) / 1024.0, (f64)maxResults.tracks[i].timings[j].allocatedByteCount / 1024.0,
+							(f64)minResults.tracks[i].timings[j].freedByteCount / 1024.0, (f64)averageResults.tracks[i].timings[j].freedByteCount / 1024.0, std::sqrt(varianceResults.tracks[i].timings[j].freedByteCount) / 1024.0, (f64)maxResults.tracks[i].timings[j].freedByteCount / 1024.0);
+					}
+					ReportOSMetrics(averageResults.tracks[i].timings[j].osMetricsTotal, averageResults.tracks[i].timings[j].elapsed);
+					ReportRoofline(averageResults.tracks[i].timings[j].processedByteCount, averageResults.tracks[i].timings[j].flopCount, averageResults.tracks[i].timings[j].elapsedSec);
 					printf(")\n");
+					printf("\tRobust elapsed: ");
+					blockElapsedStatistics[i][j].Report(1000.0 / (f64)Timer::GetEstimatedCPUFreq(), "ms");
+					printf("\n");
 				}
 			}
 		}
@@ -931,8 +2706,26 @@ void Profile::RepetitionProfiler::Reset(u64 _repetitionCount) noexcept
 	varianceResults.Reset();
 	maxResults.Reset();
 	minResults.Reset();
+	ClearRobustStatistics();
 	for (u64 i = 0; i < _repetitionCount; ++i)
 	{
 		ptr_repetitionResults[i].Reset();
 	}
+}
+
+void Profile::RepetitionProfiler::ClearRobustStatistics() noexcept
+{
+	elapsedStatistics.Clear();
+	for (u64 i = 0; i < trackElapsedStatistics.size(); ++i)
+	{
+		trackElapsedStatistics[i].Clear();
+		for (RobustStatistics& statistics : blockElapsedStatistics[i])
+		{
+			if (statistics.sampleCount)
+			{
+				statistics.Clear();
+			}
+		}
+	}
+	outlierRepetitions.clear();
 }
\ No newline at end of file
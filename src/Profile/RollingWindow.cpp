@@ -0,0 +1,505 @@
+#include <algorithm> //for std::sort, std::find_if, std::fill and std::nth_element
+#include <atomic> //for std::atomic_ref
+#include <stdio.h> //for FILE
+#include "Profile/RollingWindow.hpp"
+#include "Profile/Profiler.hpp"
+
+/*!
+@brief Reads the cumulative counters of a block.
+*/
+static Profile::WindowBlockCounters GetCounters(const Profile::ProfileBlockRecorder& _record)
+{
+	Profile::WindowBlockCounters counters;
+	counters.hitCount = _record.hitCount;
+	counters.elapsed = _record.elapsed;
+	counters.processedByteCount = _record.processedByteCount;
+	counters.flopCount = _record.flopCount;
+	counters.allocationCount = _record.allocationCount;
+	counters.allocatedByteCount = _record.allocatedByteCount;
+	counters.pageFaultCount = _record.pageFaultCountTotal;
+	return counters;
+}
+
+/*!
+@brief Whether a track may have recorded something since its sequence was read.
+@details The sequence of a track changes whenever a block opens or closes in it
+		 or a value is recorded in it. A track with a block open is also
+		 considered changed, since the time of the open blocks is counted up
+		 to the copy of the track.
+@param _track The track.
+@param _sequence The sequence of the track when its counters were read.
+*/
+static bool HasTrackChanged(const Profile::ProfileTrack& _track, Profile::u64 _sequence)
+{
+	//Only read here; std::atomic_ref of a const object requires C++26
+	std::atomic_ref<Profile::u64> sequenceRef(const_cast<Profile::u64&>(_track.sequence));
+	if (sequenceRef.load(std::memory_order_acquire) != _sequence)
+	{
+		return true;
+	}
+	return _track.callTree.currentNodeIdx != Profile::CallTree::rootIdx || _track.callTree.droppedDepth != 0;
+}
+
+/*!
+@brief Reads the cumulative counters of the used blocks of the tracks of a
+		profiler that changed since they were read, and appends the blocks
+		whose counters changed.
+@details Only the tracks whose sequence changed are copied (see HasTrackChanged),
+		 and only their used slots (see ProfileTrack::usedTimings) are read.
+		 A track that could not be copied consistently keeps its counters, so
+		 its activity is found at the next update.
+@param _profiler The profiler to read.
+@param _trackCopy Receives the consistent copy of every track in turn.
+@param _previousCounters The counters previously read, indexed by
+		trackIdx * NB_TIMINGS + recorderIdx. Updated to the current ones.
+@param _previousSequences The sequence of every track when its counters were
+		read, or ~0 if they were not. Updated to the current ones.
+@param _blocks Receives the difference of the counters of the blocks that
+		changed, or nullptr to only read the counters.
+*/
+static void UpdateCounters(const Profile::Profiler& _profiler, Profile::ProfileTrack& _trackCopy,
+	std::vector<Profile::WindowBlockCounters>& _previousCounters, std::vector<Profile::u64>& _previousSequences,
+	std::vector<Profile::WindowBlockDelta>* _blocks)
+{
+	//The tracks registered since the counters were read start from zero
+	Profile::u32 trackCount = _profiler.GetTrackCount();
+	if (_previousCounters.size() < (Profile::u64)trackCount * NB_TIMINGS)
+	{
+		_previousCounters.resize((Profile::u64)trackCount * NB_TIMINGS);
+	}
+	if (_previousSequences.size() < trackCount)
+	{
+		_previousSequences.resize(trackCount, ~0ull);
+	}
+	for (Profile::u32 i = 0; i < trackCount; ++i)
+	{
+		const Profile::ProfileTrack& track = *_profiler.GetTrack(i);
+		if (!track.hasBlock || !HasTrackChanged(track, _previousSequences[i]) || !track.CaptureConsistent(_trackCopy))
+		{
+			continue;
+		}
+		_previousSequences[i] = _trackCopy.sequence;
+
+		Profile::WindowBlockCounters* counters = _previousCounters.data() + (Profile::u64)i * NB_TIMINGS;
+		for (IT_TIMINGS_TYPE k = 0; k < _trackCopy.usedTimingCount; ++k)
+		{
+			NB_TIMINGS_TYPE j = _trackCopy.usedTimings[k];
+			const Profile::ProfileBlockRecorder& record = _trackCopy.timings[j];
+			Profile::WindowBlockCounters current = GetCounters(record);
+			Profile::WindowBlockCounters& previous = counters[j];
+			if (current.hitCount < previous.hitCount || current.elapsed < previous.elapsed)
+			{
+				//The track was reset since the counters were read
+				previous = Profile::WindowBlockCounters();
+			}
+
+			if (_blocks && (current.hitCount != previous.hitCount || current.elapsed != previous.elapsed))
+			{
+				Profile::WindowBlockDelta& block = _blocks->emplace_back();
+				block.blockName = record.blockName;
+				block.trackIdx = i;
+				block.recorderIdx = j;
+				block.delta.hitCount = current.hitCount - previous.hitCount;
+				block.delta.elapsed = current.elapsed - previous.elapsed;
+				block.delta.processedByteCount = current.processedByteCount - previous.processedByteCount;
+				block.delta.flopCount = current.flopCount - previous.flopCount;
+				block.delta.allocationCount = current.allocationCount - previous.allocationCount;
+				block.delta.allocatedByteCount = current.allocatedByteCount - previous.allocatedByteCount;
+				block.delta.pageFaultCount = current.pageFaultCount - previous.pageFaultCount;
+			}
+			previous = current;
+		}
+	}
+}
+
+Profile::f64 Profile::WindowInterval::GetDurationSec() const noexcept
+{
+	return (f64)(end - start) / (f64)Timer::GetEstimatedCPUFreq();
+}
+
+Profile::RollingWindow::RollingWindow(u32 _intervalInMs, u32 _capacity) :
+	intervalDuration(Timer::GetEstimatedCPUFreq() * _intervalInMs / 1000), capacity(_capacity ? _capacity : 1),
+	intervals(capacity), previousCounters((u64)NB_TRACKS * NB_TIMINGS), previousSequences(NB_TRACKS, ~0ull), ptr_trackCopy(new ProfileTrack())
+{
+
+}
+
+Profile::RollingWindow::~RollingWindow()
+{
+	delete ptr_trackCopy;
+}
+
+void Profile::RollingWindow::Start(const Profiler& _profiler) noexcept
+{
+	intervalCount = 0;
+	nextIntervalIdx = 0;
+	std::fill(previousCounters.begin(), previousCounters.end(), WindowBlockCounters());
+	std::fill(previousSequences.begin(), previousSequences.end(), ~0ull);
+	UpdateCounters(_profiler, *ptr_trackCopy, previousCounters, previousSequences, nullptr);
+	previousRotation = Timer::GetCPUTimer();
+}
+
+bool Profile::RollingWindow::Update(const Profiler& _profiler) noexcept
+{
+	if (Timer::GetCPUTimer() - previousRotation < intervalDuration)
+	{
+		return false;
+	}
+	Rotate(_profiler);
+	return true;
+}
+
+void Profile::RollingWindow::Rotate(const Profiler& _profiler) noexcept
+{
+	WindowInterval& interval = intervals[nextIntervalIdx];
+	interval.blocks.clear();
+	interval.start = previousRotation;
+
+	UpdateCounters(_profiler, *ptr_trackCopy, previousCounters, previousSequences, &interval.blocks);
+
+	interval.end = Timer::GetCPUTimer();
+	previousRotation = interval.end;
+	nextIntervalIdx = (nextIntervalIdx + 1) % capacity;
+	intervalCount = intervalCount < capacity ? intervalCount + 1 : capacity;
+}
+
+const Profile::WindowInterval& Profile::RollingWindow::GetInterval(u32 _age) const noexcept
+{
+	return intervals[(nextIntervalIdx + capacity - 1 - _age) % capacity];
+}
+
+Profile::u64 Profile::RollingWindow::Aggregate(u32 _intervalCount, std::vector<WindowBlockDelta>& _blocks) const
+{
+	_blocks.clear();
+	u64 duration = 0;
+	for (u32 age = 0; age < _intervalCount && age < intervalCount; ++age)
+	{
+		const WindowInterval& interval = GetInterval(age);
+		duration += interval.end - interval.start;
+		for (const WindowBlockDelta& block : interval.blocks)
+		{
+			auto it = std::find_if(_blocks.begin(), _blocks.end(), [&block](const WindowBlockDelta& _block)
+				{ return _block.trackIdx == block.trackIdx && _block.recorderIdx == block.recorderIdx; });
+			if (it == _blocks.end())
+			{
+				_blocks.push_back(block);
+			}
+			else
+			{
+				it->delta.Accumulate(block.delta);
+			}
+		}
+	}
+	return duration;
+}
+
+void Profile::RollingWindow::Report(u32 _intervalCount) const
+{
+	std::vector<WindowBlockDelta> blocks;
+	u64 duration = Aggregate(_intervalCount, blocks);
+	f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	f64 durationSec = (f64)duration / cpuFreq;
+	printf("---- Rolling Window: last %fs (%u interval(s) of %fs) ----\n",
+		durationSec, _intervalCount < intervalCount ? _intervalCount : intervalCount, (f64)intervalDuration / cpuFreq);
+	if (duration == 0)
+	{
+		return;
+	}
+
+	//The trend compares the time share of a block in the last interval to its share over the window
+	const WindowInterval& lastInterval = GetInterval(0);
+	f64 lastDuration = (f64)(lastInterval.end - lastInterval.start);
+
+	std::sort(blocks.begin(), blocks.end(),
+		[](const WindowBlockDelta& _a, const WindowBlockDelta& _b) { return _a.delta.elapsed > _b.delta.elapsed; });
+	for (const WindowBlockDelta& block : blocks)
+	{
+		f64 elapsedSec = (f64)block.delta.elapsed / cpuFreq;
+		f64 share = (f64)block.delta.elapsed / (f64)duration;
+		printf("%s (track %u): %.1f hits/s; %.2f%% of the time; %.3fus/hit",
+			block.blockName, block.trackIdx, (f64)block.delta.hitCount / durationSec, 100.0 * share,
+			block.delta.hitCount ? 1e6 * elapsedSec / (f64)block.delta.hitCount : 0.0);
+		if (block.delta.processedByteCount > 0 && elapsedSec > 0.0)
+		{
+			printf("; %.2fGB/s", (f64)block.delta.processedByteCount / elapsedSec / (f64)(1 << 30));
+		}
+		if (block.delta.allocationCount > 0)
+		{
+			printf("; %.1f allocs/s", (f64)block.delta.allocationCount / durationSec);
+		}
+
+		u64 lastElapsed = 0;
+		for (const WindowBlockDelta& lastBlock : lastInterval.blocks)
+		{
+			if (lastBlock.trackIdx == block.trackIdx && lastBlock.recorderIdx == block.recorderIdx)
+			{
+				lastElapsed = lastBlock.delta.elapsed;
+				break;
+			}
+		}
+		if (lastDuration > 0.0 && share > 0.0)
+		{
+			printf("; trend %+.1f%%", 100.0 * ((f64)lastElapsed / lastDuration / share - 1.0));
+		}
+		printf("\n");
+	}
+}
+
+void Profile::RollingWindow::ExportToCSV(const char* _path) const
+{
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting rolling window to %s\n", _path);
+		fprintf(file, "Interval Start,Interval Duration In Seconds,Track Index,Block Name,Block Hit Count,Block Elapsed,Block Elapsed In Seconds,Block Processed Byte Count,Block Flop Count,Block Allocation Count,Block Allocated Byte Count,Block Page Fault Count\n");
+		f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+		for (u32 age = intervalCount; age-- > 0;)
+		{
+			const WindowInterval& interval = GetInterval(age);
+			for (const WindowBlockDelta& block : interval.blocks)
+			{
+				fprintf(file, "%llu,%f,%u,%s,%llu,%llu,%f,%llu,%llu,%llu,%llu,%llu\n",
+					interval.start, //Interval Start
+					interval.GetDurationSec(), //Interval Duration In Seconds
+					block.trackIdx, //Track Index
+					block.blockName, //Block Name
+					block.delta.hitCount, //Block Hit Count
+					block.delta.elapsed, //Block Elapsed
+					(f64)block.delta.elapsed / cpuFreq, //Block Elapsed In Seconds
+					block.delta.processedByteCount, //Block Processed Byte Count
+					block.delta.flopCount, //Block Flop Count
+					block.delta.allocationCount, //Block Allocation Count
+					block.delta.allocatedByteCount, //Block Allocated Byte Count
+					block.delta.pageFaultCount); //Block Page Fault Count
+			}
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+}
+
+/*!
+@brief Writes one line per block and frame of a ring of frames in a CSV file,
+		from the oldest frame to the most recent one.
+@param _path The path of the CSV file.
+@param _frames The ring of frames.
+@param _frameCount The number of frames in the ring.
+@param _nextFrameIdx The index in the ring where the next frame is stored.
+*/
+static void ExportFramesToCSV(const char* _path, const std::vector<Profile::ProfileFrame>& _frames, Profile::u32 _frameCount, Profile::u32 _nextFrameIdx)
+{
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting frames to %s\n", _path);
+		fprintf(file, "Frame Index,Frame Start,Frame Duration In Seconds,Frame Median Duration In Seconds,Frame Is Spike,Track Index,Block Name,Block Hit Count,Block Elapsed,Block Elapsed In Seconds,Block Processed Byte Count,Block Flop Count,Block Allocation Count,Block Allocated Byte Count,Block Page Fault Count\n");
+		Profile::f64 cpuFreq = (Profile::f64)Profile::Timer::GetEstimatedCPUFreq();
+		Profile::u32 capacity = (Profile::u32)_frames.size();
+		for (Profile::u32 age = _frameCount; age-- > 0;)
+		{
+			const Profile::ProfileFrame& frame = _frames[(_nextFrameIdx + capacity - 1 - age) % capacity];
+			for (const Profile::WindowBlockDelta& block : frame.blocks)
+			{
+				fprintf(file, "%llu,%llu,%f,%f,%d,%u,%s,%llu,%llu,%f,%llu,%llu,%llu,%llu,%llu\n",
+					frame.frameIdx, //Frame Index
+					frame.start, //Frame Start
+					frame.GetDurationSec(), //Frame Duration In Seconds
+					(Profile::f64)frame.medianDuration / cpuFreq, //Frame Median Duration In Seconds
+					frame.isSpike ? 1 : 0, //Frame Is Spike
+					block.trackIdx, //Track Index
+					block.blockName, //Block Name
+					block.delta.hitCount, //Block Hit Count
+					block.delta.elapsed, //Block Elapsed
+					(Profile::f64)block.delta.elapsed / cpuFreq, //Block Elapsed In Seconds
+					block.delta.processedByteCount, //Block Processed Byte Count
+					block.delta.flopCount, //Block Flop Count
+					block.delta.allocationCount, //Block Allocation Count
+					block.delta.allocatedByteCount, //Block Allocated Byte Count
+					block.delta.pageFaultCount); //Block Page Fault Count
+			}
+		}
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+}
+
+Profile::f64 Profile::ProfileFrame::GetDurationSec() const noexcept
+{
+	return (f64)(end - start) / (f64)Timer::GetEstimatedCPUFreq();
+}
+
+Profile::FrameProfiler::FrameProfiler(u32 _capacity, f64 _budgetInMs, f64 _medianFactor, u32 _spikeCapacity) :
+	budget((u64)((f64)Timer::GetEstimatedCPUFreq() * _budgetInMs / 1000.0)), medianFactor(_medianFactor),
+	capacity(_capacity ? _capacity : 1), frames(capacity), spikeCapacity(_spikeCapacity ? _spikeCapacity : 1), spikes(spikeCapacity),
+	previousCounters((u64)NB_TRACKS * NB_TIMINGS), previousSequences(NB_TRACKS, ~0ull), ptr_trackCopy(new ProfileTrack())
+{
+	durations.reserve(capacity);
+}
+
+Profile::FrameProfiler::~FrameProfiler()
+{
+	delete ptr_trackCopy;
+}
+
+void Profile::FrameProfiler::Start() noexcept
+{
+	frameCount = 0;
+	nextFrameIdx = 0;
+	spikeCount = 0;
+	nextSpikeIdx = 0;
+	totalFrameCount = 0;
+	totalSpikeCount = 0;
+	frameStart = 0;
+	std::fill(previousCounters.begin(), previousCounters.end(), WindowBlockCounters());
+	std::fill(previousSequences.begin(), previousSequences.end(), ~0ull);
+}
+
+void Profile::FrameProfiler::BeginFrame(const Profiler& _profiler) noexcept
+{
+	UpdateCounters(_profiler, *ptr_trackCopy, previousCounters, previousSequences, nullptr);
+	frameStart = Timer::GetCPUTimer();
+}
+
+bool Profile::FrameProfiler::EndFrame(const Profiler& _profiler) noexcept
+{
+	//Read first so that the work of the profiler below is not part of the frame
+	u64 frameEnd = Timer::GetCPUTimer();
+
+	//The median is the one of the frames before this one, so that a spike does not raise it
+	u64 medianDuration = frameCount >= (minMedianFrameCount < capacity ? minMedianFrameCount : capacity) ? ComputeMedianDuration() : 0;
+
+	ProfileFrame& frame = frames[nextFrameIdx];
+	frame.blocks.clear();
+	frame.frameIdx = totalFrameCount;
+	frame.start = frameStart;
+	frame.end = frameEnd;
+	UpdateCounters(_profiler, *ptr_trackCopy, previousCounters, previousSequences, &frame.blocks);
+	frame.medianDuration = medianDuration;
+
+	u64 duration = frame.end - frame.start;
+	frame.isSpike = (budget > 0 && duration > budget) ||
+		(medianFactor > 0.0 && medianDuration > 0 && (f64)duration > medianFactor * (f64)medianDuration);
+	if (frame.isSpike)
+	{
+		//Copied in place to reuse the memory of the dropped spike
+		ProfileFrame& spike = spikes[nextSpikeIdx];
+		spike.frameIdx = frame.frameIdx;
+		spike.start = frame.start;
+		spike.end = frame.end;
+		spike.medianDuration = frame.medianDuration;
+		spike.isSpike = true;
+		spike.blocks.assign(frame.blocks.begin(), frame.blocks.end());
+		nextSpikeIdx = (nextSpikeIdx + 1) % spikeCapacity;
+		spikeCount = spikeCount < spikeCapacity ? spikeCount + 1 : spikeCapacity;
+		++totalSpikeCount;
+	}
+
+	nextFrameIdx = (nextFrameIdx + 1) % capacity;
+	frameCount = frameCount < capacity ? frameCount + 1 : capacity;
+	++totalFrameCount;
+	frameStart = 0;
+	return frame.isSpike;
+}
+
+bool Profile::FrameProfiler::NextFrame(const Profiler& _profiler) noexcept
+{
+	bool isSpike = EndFrame(_profiler);
+	//The counters read at the end of the frame are the start of the next one, which
+	//starts after reading them, like in BeginFrame
+	frameStart = Timer::GetCPUTimer();
+	return isSpike;
+}
+
+const Profile::ProfileFrame& Profile::FrameProfiler::GetFrame(u32 _age) const noexcept
+{
+	return frames[(nextFrameIdx + capacity - 1 - _age) % capacity];
+}
+
+const Profile::ProfileFrame& Profile::FrameProfiler::GetSpike(u32 _age) const noexcept
+{
+	return spikes[(nextSpikeIdx + spikeCapacity - 1 - _age) % spikeCapacity];
+}
+
+Profile::u64 Profile::FrameProfiler::ComputeMedianDuration() noexcept
+{
+	if (frameCount == 0)
+	{
+		return 0;
+	}
+	durations.clear();
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		durations.push_back(frames[i].end - frames[i].start);
+	}
+	std::nth_element(durations.begin(), durations.begin() + frameCount / 2, durations.end());
+	return durations[frameCount / 2];
+}
+
+void Profile::FrameProfiler::Report()
+{
+	f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	u64 medianDuration = ComputeMedianDuration();
+	u64 minDuration = ~0ull;
+	u64 maxDuration = 0;
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		u64 duration = frames[i].end - frames[i].start;
+		minDuration = duration < minDuration ? duration : minDuration;
+		maxDuration = duration > maxDuration ? duration : maxDuration;
+	}
+	printf("---- Frames: last %u of %llu frame(s); %llu spike(s) ----\n", frameCount, totalFrameCount, totalSpikeCount);
+	if (frameCount == 0)
+	{
+		return;
+	}
+	printf("Duration: min %.3fms; median %.3fms; max %.3fms (budget %.3fms; spike above %.2fx the median)\n",
+		1000.0 * (f64)minDuration / cpuFreq, 1000.0 * (f64)medianDuration / cpuFreq, 1000.0 * (f64)maxDuration / cpuFreq,
+		1000.0 * (f64)budget / cpuFreq, medianFactor);
+
+	for (u32 age = spikeCount; age-- > 0;)
+	{
+		const ProfileFrame& spike = GetSpike(age);
+		u64 duration = spike.end - spike.start;
+		printf("Spike at frame %llu: %.3fms", spike.frameIdx, 1000.0 * (f64)duration / cpuFreq);
+		if (spike.medianDuration > 0)
+		{
+			printf(" (%.2fx the median)", (f64)duration / (f64)spike.medianDuration);
+		}
+		printf("\n");
+
+		std::vector<WindowBlockDelta> blocks = spike.blocks;
+		std::sort(blocks.begin(), blocks.end(),
+			[](const WindowBlockDelta& _a, const WindowBlockDelta& _b) { return _a.delta.elapsed > _b.delta.elapsed; });
+		for (const WindowBlockDelta& block : blocks)
+		{
+			printf("\t%s (track %u)[%llu]: %.3fms (%.2f%% of the frame)",
+				block.blockName, block.trackIdx, block.delta.hitCount, 1000.0 * (f64)block.delta.elapsed / cpuFreq,
+				duration ? 100.0 * (f64)block.delta.elapsed / (f64)duration : 0.0);
+			if (block.delta.allocationCount > 0)
+			{
+				printf("; %llu allocs", block.delta.allocationCount);
+			}
+			if (block.delta.pageFaultCount > 0)
+			{
+				printf("; %llu PF", block.delta.pageFaultCount);
+			}
+			printf("\n");
+		}
+	}
+}
+
+void Profile::FrameProfiler::ExportToCSV(const char* _path) const
+{
+	ExportFramesToCSV(_path, frames, frameCount, nextFrameIdx);
+}
+
+void Profile::FrameProfiler::ExportSpikesToCSV(const char* _path) const
+{
+	ExportFramesToCSV(_path, spikes, spikeCount, nextSpikeIdx);
+}
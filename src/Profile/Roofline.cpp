@@ -0,0 +1,234 @@
+#include <cstdio> //for printf and FILE
+#include <cstring> //for strcmp and strcpy
+#include <new> //for the aligned operator new
+#include "Profile/Kernels.hpp"
+#include "Profile/OSStatistics.hpp"
+#include "Profile/Roofline.hpp"
+
+static const Profile::MachinePeaks* s_MachinePeaks = nullptr;
+
+/*!
+@brief Receives the results of the kernels so that they cannot be optimized away.
+*/
+static volatile Profile::f64 s_KernelSink = 0.0;
+
+void Profile::SetMachinePeaks(const MachinePeaks* _machinePeaks)
+{
+	s_MachinePeaks = _machinePeaks;
+}
+
+const Profile::MachinePeaks* Profile::GetMachinePeaks()
+{
+	return s_MachinePeaks;
+}
+
+void Profile::ReportRoofline(u64 _processedByteCount, u64 _flopCount, f64 _elapsedSec)
+{
+	const MachinePeaks* ptr_machinePeaks = s_MachinePeaks;
+	if (ptr_machinePeaks == nullptr || !ptr_machinePeaks->IsValid() || _elapsedSec <= 0.0)
+	{
+		return;
+	}
+
+	if (_processedByteCount > 0)
+	{
+		printf("; %.1f%% of peak bandwidth", ptr_machinePeaks->GetPercentOfPeakBandwidth(_processedByteCount, _elapsedSec));
+	}
+
+	if (_flopCount > 0)
+	{
+		f64 flops = (f64)_flopCount / _elapsedSec;
+		printf("; %.3fGFLOP/s (%.1f%% of peak)", flops / 1e9, 100.0 * flops / ptr_machinePeaks->GetPeakFlops());
+		if (_processedByteCount > 0)
+		{
+			f64 arithmeticIntensity = (f64)_flopCount / (f64)_processedByteCount;
+			printf("; %.3fFLOP/B at %.1f%% of roofline, %s-bound", arithmeticIntensity,
+				ptr_machinePeaks->GetPercentOfRoofline(_processedByteCount, _flopCount, _elapsedSec),
+				arithmeticIntensity < ptr_machinePeaks->GetRidgePoint() ? "memory" : "compute");
+		}
+	}
+}
+
+Profile::f64 Profile::MachinePeaks::GetPeakBandwidthInB() const noexcept
+{
+	f64 peak = readBandwidthInB > writeBandwidthInB ? readBandwidthInB : writeBandwidthInB;
+	return copyBandwidthInB > peak ? copyBandwidthInB : peak;
+}
+
+Profile::f64 Profile::MachinePeaks::GetPeakFlops() const noexcept
+{
+	return simdFlops > scalarFlops ? simdFlops : scalarFlops;
+}
+
+Profile::f64 Profile::MachinePeaks::GetRidgePoint() const noexcept
+{
+	f64 peakBandwidth = GetPeakBandwidthInB();
+	return peakBandwidth == 0.0 ? 0.0 : GetPeakFlops() / peakBandwidth;
+}
+
+Profile::f64 Profile::MachinePeaks::GetAttainableFlops(f64 _arithmeticIntensity) const noexcept
+{
+	f64 memoryRoof = _arithmeticIntensity * GetPeakBandwidthInB();
+	return memoryRoof < GetPeakFlops() ? memoryRoof : GetPeakFlops();
+}
+
+Profile::f64 Profile::MachinePeaks::GetPercentOfPeakBandwidth(u64 _processedByteCount, f64 _elapsedSec) const noexcept
+{
+	if (!IsValid() || _processedByteCount == 0 || _elapsedSec <= 0.0)
+	{
+		return 0.0;
+	}
+	return 100.0 * (f64)_processedByteCount / _elapsedSec / GetPeakBandwidthInB();
+}
+
+Profile::f64 Profile::MachinePeaks::GetPercentOfRoofline(u64 _processedByteCount, u64 _flopCount, f64 _elapsedSec) const noexcept
+{
+	if (!IsValid() || _processedByteCount == 0 || _flopCount == 0 || _elapsedSec <= 0.0)
+	{
+		return 0.0;
+	}
+	f64 arithmeticIntensity = (f64)_flopCount / (f64)_processedByteCount;
+	return 100.0 * (f64)_flopCount / _elapsedSec / GetAttainableFlops(arithmeticIntensity);
+}
+
+bool Profile::MachinePeaks::LoadFromFile(const char* _path) noexcept
+{
+	FILE* file = fopen(_path, "r");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	char header[256];
+	MachinePeaks loaded;
+	bool success = fgets(header, sizeof(header), file) != nullptr &&
+		fscanf(file, "%48[^,],%llu,%lf,%lf,%lf,%lf,%lf",
+			loaded.cpuBrand, //CPU Brand
+			&loaded.bufferByteCount, //Buffer Byte Count
+			&loaded.readBandwidthInB, //Read Bandwidth In Bytes
+			&loaded.writeBandwidthInB, //Write Bandwidth In Bytes
+			&loaded.copyBandwidthInB, //Copy Bandwidth In Bytes
+			&loaded.scalarFlops, //Scalar Flops
+			&loaded.simdFlops //SIMD Flops
+			) == 7;
+	fclose(file);
+
+	if (!success || !loaded.IsValid() || strcmp(loaded.cpuBrand, CPUFeatures::Get().brand) != 0)
+	{
+		return false;
+	}
+
+	*this = loaded;
+	return true;
+}
+
+void Profile::MachinePeaks::LoadOrMeasure(const char* _path, u64 _bufferByteCount) noexcept
+{
+	//Measure() rounds the buffer size the same way
+	u64 bufferByteCountToMeasure = _bufferByteCount < 256 ? 256 : _bufferByteCount & ~255ull;
+	if (LoadFromFile(_path) && bufferByteCount == bufferByteCountToMeasure)
+	{
+		return;
+	}
+
+	printf("Measuring the peaks of the machine (no valid cache in %s)...\n", _path);
+	Measure(_bufferByteCount);
+	SaveToFile(_path);
+}
+
+void Profile::MachinePeaks::Measure(u64 _bufferByteCount, u32 _repetitionCount) noexcept
+{
+	strcpy(cpuBrand, CPUFeatures::Get().brand);
+	bufferByteCount = _bufferByteCount < 256 ? 256 : _bufferByteCount & ~255ull;
+	_repetitionCount = _repetitionCount ? _repetitionCount : 1;
+
+	u8* source = (u8*)operator new(bufferByteCount, std::align_val_t(64));
+	u8* destination = (u8*)operator new(bufferByteCount, std::align_val_t(64));
+
+	//Touch the buffers first so that the page faults are not measured
+	Kernels::Write(source, bufferByteCount, 1);
+	Kernels::Write(destination, bufferByteCount, 2);
+
+	const f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	u64 bestRead = ~0ull;
+	u64 bestWrite = ~0ull;
+	u64 bestCopy = ~0ull;
+	u64 checksum = 0;
+	for (u32 i = 0; i < _repetitionCount; ++i)
+	{
+		u64 start = Timer::GetCPUTimer();
+		checksum += Kernels::Read(source, bufferByteCount);
+		u64 elapsed = Timer::GetCPUTimer() - start;
+		bestRead = elapsed < bestRead ? elapsed : bestRead;
+
+		start = Timer::GetCPUTimer();
+		Kernels::Write(destination, bufferByteCount, i);
+		elapsed = Timer::GetCPUTimer() - start;
+		bestWrite = elapsed < bestWrite ? elapsed : bestWrite;
+
+		start = Timer::GetCPUTimer();
+		Kernels::Copy(destination, source, bufferByteCount);
+		elapsed = Timer::GetCPUTimer() - start;
+		bestCopy = elapsed < bestCopy ? elapsed : bestCopy;
+	}
+	checksum += destination[bufferByteCount / 2];
+	readBandwidthInB = (f64)bufferByteCount * cpuFreq / (f64)bestRead;
+	writeBandwidthInB = (f64)bufferByteCount * cpuFreq / (f64)bestWrite;
+	copyBandwidthInB = 2.0 * (f64)bufferByteCount * cpuFreq / (f64)bestCopy;
+
+	operator delete(source, std::align_val_t(64));
+	operator delete(destination, std::align_val_t(64));
+
+	const u64 iterationCount = 1 << 22;
+	u64 bestScalar = ~0ull;
+	u64 bestSIMD = ~0ull;
+	f64 result = (f64)checksum;
+	for (u32 i = 0; i < _repetitionCount; ++i)
+	{
+		u64 start = Timer::GetCPUTimer();
+		result += Kernels::ScalarFlops(iterationCount);
+		u64 elapsed = Timer::GetCPUTimer() - start;
+		bestScalar = elapsed < bestScalar ? elapsed : bestScalar;
+
+		start = Timer::GetCPUTimer();
+		result += Kernels::SIMDFlops(iterationCount);
+		elapsed = Timer::GetCPUTimer() - start;
+		bestSIMD = elapsed < bestSIMD ? elapsed : bestSIMD;
+	}
+	s_KernelSink = result;
+	scalarFlops = (f64)(iterationCount * Kernels::ScalarFlopsPerIteration()) * cpuFreq / (f64)bestScalar;
+	simdFlops = (f64)(iterationCount * Kernels::SIMDFlopsPerIteration()) * cpuFreq / (f64)bestSIMD;
+}
+
+void Profile::MachinePeaks::Report() const noexcept
+{
+	printf("\n---- Machine Peaks: %s (%lluMB buffer) ----\n", cpuBrand, bufferByteCount >> 20);
+	printf("Read %.3fGB/s | Write %.3fGB/s | Copy %.3fGB/s\n",
+		readBandwidthInB / (1 << 30), writeBandwidthInB / (1 << 30), copyBandwidthInB / (1 << 30));
+	printf("Scalar %.3fGFLOP/s | SIMD %.3fGFLOP/s | Ridge point %.3fFLOP/B\n",
+		scalarFlops / 1e9, simdFlops / 1e9, GetRidgePoint());
+}
+
+bool Profile::MachinePeaks::SaveToFile(const char* _path) const noexcept
+{
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting machine peaks to %s\n", _path);
+		fprintf(file, "CPU Brand,Buffer Byte Count,Read Bandwidth In Bytes,Write Bandwidth In Bytes,Copy Bandwidth In Bytes,Scalar Flops,SIMD Flops\n");
+		fprintf(file, "%s,%llu,%f,%f,%f,%f,%f\n",
+			cpuBrand, //CPU Brand
+			bufferByteCount, //Buffer Byte Count
+			readBandwidthInB, //Read Bandwidth In Bytes
+			writeBandwidthInB, //Write Bandwidth In Bytes
+			copyBandwidthInB, //Copy Bandwidth In Bytes
+			scalarFlops, //Scalar Flops
+			simdFlops //SIMD Flops
+			);
+		fclose(file);
+		return true;
+	}
+
+	printf("Error: Could not open file %s for writing.\n", _path);
+	return false;
+}
@@ -0,0 +1,166 @@
+#include <cstdlib> //for getenv and strtoul
+#include <cstring> //for strcmp and memset
+#include "Profile/Profiler.hpp"
+
+#if !_WIN32
+#include <signal.h> //for sigaction
+#endif
+
+static_assert(std::atomic<Profile::u8>::is_always_lock_free, "The runtime switch is toggled from a signal handler.");
+
+alignas(64) std::array<std::atomic<Profile::u8>, NB_TRACKS> Profile::RuntimeSwitch::trackFlags = {};
+std::atomic<bool> Profile::RuntimeSwitch::enabled = true;
+
+/*!
+@brief Applies the PROFILER_RUNTIME environment variable when the library is loaded.
+@details Defined after the flags so that they are initialized first.
+*/
+static const bool s_IsConfiguredFromEnvironment = Profile::RuntimeSwitch::ConfigureFromEnvironment();
+
+#if !_WIN32
+static void OnToggleSignal(int)
+{
+	Profile::RuntimeSwitch::Toggle();
+}
+#endif
+
+bool Profile::RuntimeSwitch::IsTrackEnabled(NB_TRACKS_TYPE _trackIdx) noexcept
+{
+	return (trackFlags[_trackIdx].load(std::memory_order_relaxed) & trackDisabledFlag) == 0;
+}
+
+/*!
+@brief Sets the globally disabled bit of every track from Profile::RuntimeSwitch::enabled.
+@details The bits are set again until ::enabled did not change while they were
+		 set: when the switch is toggled concurrently (e.g., from a signal
+		 handler), the last caller to set a bit reads the final value of
+		 ::enabled afterwards, and sets the bits again if it was not the one
+		 it set.
+*/
+static void ApplyGlobalSwitch() noexcept
+{
+	bool isEnabled = Profile::RuntimeSwitch::enabled.load();
+	while (true)
+	{
+		for (std::atomic<Profile::u8>& flags : Profile::RuntimeSwitch::trackFlags)
+		{
+			if (isEnabled)
+			{
+				flags.fetch_and((Profile::u8)~Profile::RuntimeSwitch::globallyDisabledFlag);
+			}
+			else
+			{
+				flags.fetch_or(Profile::RuntimeSwitch::globallyDisabledFlag);
+			}
+		}
+
+		bool currentIsEnabled = Profile::RuntimeSwitch::enabled.load();
+		if (currentIsEnabled == isEnabled)
+		{
+			break;
+		}
+		isEnabled = currentIsEnabled;
+	}
+}
+
+void Profile::RuntimeSwitch::SetEnabled(bool _enabled) noexcept
+{
+	enabled.store(_enabled);
+	ApplyGlobalSwitch();
+}
+
+void Profile::RuntimeSwitch::SetTrackEnabled(NB_TRACKS_TYPE _trackIdx, bool _enabled) noexcept
+{
+	if (_enabled)
+	{
+		trackFlags[_trackIdx].fetch_and((u8)~trackDisabledFlag, std::memory_order_relaxed);
+	}
+	else
+	{
+		trackFlags[_trackIdx].fetch_or(trackDisabledFlag, std::memory_order_relaxed);
+	}
+}
+
+void Profile::RuntimeSwitch::Toggle() noexcept
+{
+	//A single read-modify-write, so that concurrent toggles are not lost
+	bool wasEnabled = enabled.load();
+	while (!enabled.compare_exchange_weak(wasEnabled, !wasEnabled))
+	{
+	}
+	ApplyGlobalSwitch();
+}
+
+bool Profile::RuntimeSwitch::ConfigureFromEnvironment(const char* _variableName) noexcept
+{
+	const char* value = getenv(_variableName);
+	if (value == nullptr || *value == '\0')
+	{
+		return false;
+	}
+	if (strcmp(value, "0") == 0 || strcmp(value, "off") == 0 || strcmp(value, "false") == 0)
+	{
+		SetEnabled(false);
+		return true;
+	}
+	if (strcmp(value, "1") == 0 || strcmp(value, "on") == 0 || strcmp(value, "true") == 0)
+	{
+		for (IT_TRACKS_TYPE i = 0; i < NB_TRACKS; ++i)
+		{
+			SetTrackEnabled((NB_TRACKS_TYPE)i, true);
+		}
+		SetEnabled(true);
+		return true;
+	}
+
+	//A list of track indices: validate it entirely before changing anything
+	bool enabledTracks[NB_TRACKS] = { false };
+	for (const char* c = value; *c;)
+	{
+		char* end = nullptr;
+		unsigned long trackIdx = strtoul(c, &end, 10);
+		if (end == c || trackIdx >= NB_TRACKS || (*end != ',' && *end != '\0'))
+		{
+			printf("Warning: Ignored the invalid value \"%s\" of %s. Expected 0, 1, off, on, false, true or a comma-separated list of track indices less than %u.\n",
+				value, _variableName, (u32)NB_TRACKS);
+			return false;
+		}
+		enabledTracks[trackIdx] = true;
+		c = *end == ',' ? end + 1 : end;
+	}
+	for (IT_TRACKS_TYPE i = 0; i < NB_TRACKS; ++i)
+	{
+		SetTrackEnabled((NB_TRACKS_TYPE)i, enabledTracks[i]);
+	}
+	SetEnabled(true);
+	return true;
+}
+
+int Profile::RuntimeSwitch::GetDefaultSignal() noexcept
+{
+#if _WIN32
+	return 0;
+#else
+	return SIGUSR2;
+#endif
+}
+
+bool Profile::RuntimeSwitch::InstallToggleSignal(int _signalNumber) noexcept
+{
+#if _WIN32
+	printf("Error: The profiling cannot be toggled by signal on Windows.\n");
+	return false;
+#else
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = OnToggleSignal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(_signalNumber, &action, nullptr) != 0)
+	{
+		printf("Error: Could not install the handler of signal %d.\n", _signalNumber);
+		return false;
+	}
+	return true;
+#endif
+}
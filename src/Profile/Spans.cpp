@@ -0,0 +1,648 @@
+#include <algorithm> //for std::sort
+#include <cstring> //for memset
+#include <memory> //for std::unique_ptr
+#include <mutex> //for the table of the asynchronous spans in flight and the tail captures
+#include <stdio.h> //for printf
+#include <unordered_map> //for the table of the asynchronous spans in flight
+#include "Profile/Spans.hpp"
+#include "Profile/Profiler.hpp"
+
+static_assert(alignof(Profile::u64) >= std::atomic_ref<Profile::u64>::required_alignment, "The counters of the spans are updated through std::atomic_ref.");
+
+/*!
+@brief Reads a counter of a span that may be updated concurrently.
+*/
+static inline Profile::u64 LoadCounter(const Profile::u64& _counter) noexcept
+{
+	return std::atomic_ref<Profile::u64>(const_cast<Profile::u64&>(_counter)).load(std::memory_order_relaxed);
+}
+
+/*
+The asynchronous spans in flight are kept in a table split in shards, each with
+its own lock, so that the threads beginning and ending spans of different IDs
+rarely contend. The spans that ended are stored in a ring of NB_ASYNC_SPAN_EVENTS
+events, claimed with an atomic counter and published with a sequence number so
+that Profiler::ExportTimeline can skip the events overwritten while it reads.
+
+The tail captures are recorded by each thread in its own ring, only read by
+the thread itself, and copied in a store shared by all the threads (with a
+lock) only when a watched block was slow.
+*/
+
+namespace Profile
+{
+	/*!
+	@brief The ring of the last blocks closed by a thread while a
+			Profile::TailCaptureScope is open.
+	*/
+	struct TailEventBuffer
+	{
+		TailEvent events[NB_TAIL_EVENTS];
+
+		/*!
+		@brief The number of blocks recorded since the outermost scope opened.
+		*/
+		u64 eventCount = 0;
+	};
+
+	/*!
+	@brief The ring of the current thread while a Profile::TailCaptureScope is
+			open, nullptr otherwise.
+	@details Checked by Profile::ProfileBlock::Close on every block.
+	*/
+	thread_local TailEventBuffer* t_TailEventBuffer = nullptr;
+
+	/*!
+	@brief Appends a block that just closed to the ring of the current thread.
+	@details Only called while t_TailEventBuffer is set.
+	@param _blockName The name of the block.
+	@param _start The time the block was opened on the CPU timer.
+	*/
+	void RecordTailEvent(const char* _blockName, u64 _start) noexcept
+	{
+		TailEvent& event = t_TailEventBuffer->events[t_TailEventBuffer->eventCount++ % NB_TAIL_EVENTS];
+		event.blockName = _blockName;
+		event.start = _start;
+		event.end = Timer::GetCPUTimer();
+	}
+}
+
+namespace
+{
+	using namespace Profile;
+
+	/*!
+	@brief An asynchronous span that began and did not end yet.
+	*/
+	struct AsyncSpanInFlight
+	{
+		SpanRecorder* ptr_recorder = nullptr;
+		u64 start = 0;
+		u32 beginThreadIdx = 0;
+	};
+
+	struct AsyncSpanShard
+	{
+		std::mutex mutex;
+		std::unordered_map<u64, AsyncSpanInFlight> spans;
+	};
+
+	/*!
+	@brief An asynchronous span that ended, as shown in the timeline.
+	*/
+	struct AsyncSpanEvent
+	{
+		/*!
+		@brief The index of the event in the ring plus 1 once it is written,
+				0 before, and ~0 while it is written.
+		*/
+		u64 sequence = 0;
+		const SpanRecorder* ptr_recorder = nullptr;
+		u64 id = 0;
+		u64 start = 0;
+		u64 end = 0;
+		u32 beginThreadIdx = 0;
+		u32 endThreadIdx = 0;
+	};
+
+	constexpr u32 s_AsyncSpanShardCount = 16;
+	AsyncSpanShard s_AsyncSpanShards[s_AsyncSpanShardCount];
+
+	AsyncSpanEvent s_AsyncSpanEvents[NB_ASYNC_SPAN_EVENTS];
+	std::atomic<u64> s_AsyncSpanEventCount = 0;
+
+	/*!
+	@brief The ring of the current thread, allocated by its first
+			Profile::TailCaptureScope and kept until the thread exits.
+	*/
+	thread_local std::unique_ptr<TailEventBuffer> t_OwnedTailEventBuffer;
+
+	/*!
+	@brief A call site of a span registered in a slot of Profiler::spans,
+			shared by all the profilers (see Profile::Profiler::GetSpanRecorderIndex).
+	*/
+	struct SpanSite
+	{
+		const char* name = nullptr;
+		const char* fileName = nullptr;
+		u32 lineNumber = 0;
+	};
+
+	SpanSite s_SpanSites[NB_SPANS];
+	std::mutex s_SpanSiteMutex;
+
+	/*!
+	@brief Names a slot of the spans of a profiler after the call site
+			registered in it, the first time the profiler records in it.
+	@details Spans of the same type may begin concurrently: the slot is named
+			 by the thread setting its name atomically.
+	*/
+	inline void BindSpanSite(SpanRecorder& _spanRecorder, u32 _spanRecorderIdx) noexcept
+	{
+		const SpanSite& site = s_SpanSites[_spanRecorderIdx];
+		const char* expectedName = nullptr;
+		if (std::atomic_ref<const char*>(_spanRecorder.spanName).compare_exchange_strong(expectedName, site.name))
+		{
+			_spanRecorder.fileName = site.fileName;
+			_spanRecorder.lineNumber = site.lineNumber;
+		}
+	}
+
+	/*!
+	@brief Gets the statistics of a span in a profiler, naming them if needed.
+	*/
+	inline SpanRecorder* GetSpanRecorder(Profiler* _profiler, u32 _spanRecorderIdx) noexcept
+	{
+		SpanRecorder* ptr_spanRecorder = &_profiler->spans[_spanRecorderIdx];
+		if (std::atomic_ref<const char*>(ptr_spanRecorder->spanName).load(std::memory_order_relaxed) == nullptr)
+		{
+			BindSpanSite(*ptr_spanRecorder, _spanRecorderIdx);
+		}
+		return ptr_spanRecorder;
+	}
+
+	std::mutex s_TailCaptureMutex;
+	TailCapture s_TailCaptures[NB_TAIL_CAPTURES];
+	u64 s_TailCaptureCount = 0;
+
+	std::atomic<u32> s_ThreadCount = 0;
+	thread_local u32 t_ThreadIdx = 0;
+
+	/*!
+	@brief Returns the index of the current thread in the timeline, from 1.
+	*/
+	inline u32 GetThreadIdx() noexcept
+	{
+		if (t_ThreadIdx == 0)
+		{
+			t_ThreadIdx = s_ThreadCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+		return t_ThreadIdx;
+	}
+
+	inline AsyncSpanShard& GetShard(u64 _id) noexcept
+	{
+		//Fibonacci hashing: the IDs are often consecutive
+		return s_AsyncSpanShards[(_id * 0x9E3779B97F4A7C15ull) >> 60];
+	}
+	static_assert(s_AsyncSpanShardCount == 16, "GetShard keeps the 4 high bits of the hash.");
+
+	void PushAsyncSpanEvent(const AsyncSpanInFlight& _span, u64 _id, u64 _end) noexcept
+	{
+		u64 eventIdx = s_AsyncSpanEventCount.fetch_add(1, std::memory_order_relaxed);
+		AsyncSpanEvent& event = s_AsyncSpanEvents[eventIdx % NB_ASYNC_SPAN_EVENTS];
+		std::atomic_ref<u64> sequence(event.sequence);
+		sequence.store(~0ull, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		event.ptr_recorder = _span.ptr_recorder;
+		event.id = _id;
+		event.start = _span.start;
+		event.end = _end;
+		event.beginThreadIdx = _span.beginThreadIdx;
+		event.endThreadIdx = GetThreadIdx();
+		sequence.store(eventIdx + 1, std::memory_order_release);
+	}
+
+#if PROFILER_ENABLED
+	/*!
+	@brief Writes a string in a JSON file, escaping the characters that need it.
+	*/
+	void WriteJsonString(FILE* _file, const char* _string)
+	{
+		fputc('"', _file);
+		for (const char* c = _string ? _string : ""; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', _file);
+				fputc(*c, _file);
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				fprintf(_file, "\\u%04x", (unsigned)(unsigned char)*c);
+			}
+			else
+			{
+				fputc(*c, _file);
+			}
+		}
+		fputc('"', _file);
+	}
+#endif
+}
+
+bool Profile::BeginAsyncSpan(u32 _spanRecorderIdx, u64 _id)
+{
+	Profiler* ptr_profiler = RuntimeSwitch::IsEnabled() ? GetProfiler() : nullptr;
+	if (ptr_profiler == nullptr)
+	{
+		return false;
+	}
+
+	AsyncSpanInFlight span;
+	span.ptr_recorder = GetSpanRecorder(ptr_profiler, _spanRecorderIdx);
+	span.beginThreadIdx = GetThreadIdx();
+	AsyncSpanShard& shard = GetShard(_id);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		span.start = Timer::GetCPUTimer();
+		if (!shard.spans.emplace(_id, span).second)
+		{
+			return false;
+		}
+		//Opened under the lock so that an EndAsyncSpan on another thread cannot record it first
+		span.ptr_recorder->Open();
+	}
+	return true;
+}
+
+bool Profile::EndAsyncSpan(u64 _id)
+{
+	AsyncSpanInFlight span;
+	u64 end = 0;
+	AsyncSpanShard& shard = GetShard(_id);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.spans.find(_id);
+		if (it == shard.spans.end())
+		{
+			return false;
+		}
+		end = Timer::GetCPUTimer();
+		span = it->second;
+		shard.spans.erase(it);
+	}
+
+	span.ptr_recorder->Record(end - span.start, 0, 0);
+	PushAsyncSpanEvent(span, _id, end);
+	return true;
+}
+
+Profile::u64 Profile::SpanRecorder::GetElapsedPercentile(f64 _percentile) const noexcept
+{
+	u64 count = LoadCounter(hitCount);
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	u64 rank = (u64)(_percentile / 100.0 * (f64)count);
+	rank = rank < count ? rank : count - 1;
+	u64 maxValue = LoadCounter(maxElapsed);
+	u64 cumulativeCount = 0;
+	for (u32 i = 0; i < histogramBucketCount; ++i)
+	{
+		cumulativeCount += LoadCounter(histogram[i]);
+		if (cumulativeCount > rank)
+		{
+			u64 upperBound = i == 0 ? 0 : (i < 64 ? (1ull << i) - 1 : ~0ull);
+			return upperBound < maxValue ? upperBound : maxValue;
+		}
+	}
+	return maxValue;
+}
+
+void Profile::SpanRecorder::Report() const noexcept
+{
+	u64 count = LoadCounter(hitCount);
+	u64 total = LoadCounter(elapsed);
+	u64 suspended = LoadCounter(suspendedElapsed);
+	u64 active = total > suspended ? total - suspended : 0;
+	f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+
+	printf("%s[%llu]: total %fms", spanName, count, 1000.0 * (f64)total / cpuFreq);
+	//Only the spans of the coroutines are suspended, the asynchronous ones are only in flight
+	u64 suspensions = LoadCounter(suspendCount);
+	if (suspensions)
+	{
+		printf("; active %fms (%.2f%%); suspended %fms in %llu suspension(s)", 1000.0 * (f64)active / cpuFreq,
+			total ? 100.0 * (f64)active / (f64)total : 0.0, 1000.0 * (f64)suspended / cpuFreq, suspensions);
+	}
+	u64 open = LoadCounter(openCount);
+	if (open)
+	{
+		printf("; %llu in flight", open);
+	}
+	printf("; p50 %.3fus p90 %.3fus p99 %.3fus max %.3fus\n",
+		1e6 * (f64)GetElapsedPercentile(50.0) / cpuFreq, 1e6 * (f64)GetElapsedPercentile(90.0) / cpuFreq,
+		1e6 * (f64)GetElapsedPercentile(99.0) / cpuFreq, 1e6 * (f64)LoadCounter(maxElapsed) / cpuFreq);
+}
+
+void Profile::SpanRecorder::Clear() noexcept
+{
+	spanName = nullptr;
+	fileName = nullptr;
+	lineNumber = 0;
+	openCount = 0;
+	Reset();
+}
+
+void Profile::SpanRecorder::Reset() noexcept
+{
+	hitCount = 0;
+	elapsed = 0;
+	suspendedElapsed = 0;
+	suspendCount = 0;
+	maxElapsed = 0;
+	memset(histogram.data(), 0, sizeof(histogram));
+}
+
+Profile::ProfileSpan::ProfileSpan(u32 _spanRecorderIdx) noexcept
+{
+	Profiler* ptr_profiler = RuntimeSwitch::IsEnabled() ? GetProfiler() : nullptr;
+	if (ptr_profiler)
+	{
+		ptr_recorder = GetSpanRecorder(ptr_profiler, _spanRecorderIdx);
+		ptr_recorder->Open();
+		start = Timer::GetCPUTimer();
+	}
+}
+
+Profile::ProfileSpan::~ProfileSpan() noexcept
+{
+	if (ptr_recorder)
+	{
+		u64 end = Timer::GetCPUTimer();
+		if (pauseStart)
+		{
+			suspendedElapsed += end - pauseStart;
+		}
+		ptr_recorder->Record(end - start, suspendedElapsed, suspendCount);
+	}
+}
+
+void Profile::ProfileSpan::Pause() noexcept
+{
+	if (ptr_recorder && pauseStart == 0)
+	{
+		pauseStart = Timer::GetCPUTimer();
+		suspendCount++;
+	}
+}
+
+void Profile::ProfileSpan::Resume() noexcept
+{
+	if (pauseStart)
+	{
+		suspendedElapsed += Timer::GetCPUTimer() - pauseStart;
+		pauseStart = 0;
+	}
+}
+
+Profile::TailCaptureScope::TailCaptureScope(const char* _blockName, u32 _trackIdx, u64 _threshold) noexcept :
+	blockName(_blockName), threshold(_threshold)
+{
+	if (!RuntimeSwitch::IsTrackActive((NB_TRACKS_TYPE)_trackIdx))
+	{
+		return;
+	}
+	isActive = true;
+	isOutermost = t_TailEventBuffer == nullptr;
+	if (isOutermost)
+	{
+		if (!t_OwnedTailEventBuffer)
+		{
+			t_OwnedTailEventBuffer = std::make_unique<TailEventBuffer>();
+		}
+		t_TailEventBuffer = t_OwnedTailEventBuffer.get();
+		t_TailEventBuffer->eventCount = 0;
+	}
+	firstEventIdx = t_TailEventBuffer->eventCount;
+	start = Timer::GetCPUTimer();
+}
+
+Profile::TailCaptureScope::~TailCaptureScope() noexcept
+{
+	if (!isActive)
+	{
+		return;
+	}
+
+	u64 end = Timer::GetCPUTimer();
+	if (end - start > threshold)
+	{
+		const TailEventBuffer& buffer = *t_TailEventBuffer;
+		u64 keptEventIdx = buffer.eventCount - firstEventIdx > NB_TAIL_EVENTS ? buffer.eventCount - NB_TAIL_EVENTS : firstEventIdx;
+
+		std::lock_guard<std::mutex> lock(s_TailCaptureMutex);
+		//Copied in place to reuse the memory of the dropped capture
+		TailCapture& capture = s_TailCaptures[s_TailCaptureCount++ % NB_TAIL_CAPTURES];
+		capture.blockName = blockName;
+		capture.ptr_profiler = GetProfiler();
+		capture.threadIdx = GetThreadIdx();
+		capture.start = start;
+		capture.end = end;
+		capture.threshold = threshold;
+		capture.droppedEventCount = keptEventIdx - firstEventIdx;
+		capture.events.clear();
+		for (u64 eventIdx = keptEventIdx; eventIdx < buffer.eventCount; ++eventIdx)
+		{
+			capture.events.push_back(buffer.events[eventIdx % NB_TAIL_EVENTS]);
+		}
+	}
+
+	if (isOutermost)
+	{
+		t_TailEventBuffer = nullptr;
+	}
+}
+
+Profile::u64 Profile::GetTailCaptures(std::vector<TailCapture>& _captures)
+{
+	std::lock_guard<std::mutex> lock(s_TailCaptureMutex);
+	_captures.clear();
+	u64 firstCaptureIdx = s_TailCaptureCount > NB_TAIL_CAPTURES ? s_TailCaptureCount - NB_TAIL_CAPTURES : 0;
+	for (u64 captureIdx = firstCaptureIdx; captureIdx < s_TailCaptureCount; ++captureIdx)
+	{
+		_captures.push_back(s_TailCaptures[captureIdx % NB_TAIL_CAPTURES]);
+	}
+	return s_TailCaptureCount;
+}
+
+void Profile::ClearTailCaptures() noexcept
+{
+	std::lock_guard<std::mutex> lock(s_TailCaptureMutex);
+	s_TailCaptureCount = 0;
+}
+
+Profile::u32 Profile::Profiler::GetSpanRecorderIndex(const char* _fileName, u32 _lineNumber, const char* _spanName)
+{
+	u32 preferredSpanRecorderIdx = (u32)(Hash(_fileName, _lineNumber) % NB_SPANS);
+	u32 spanRecorderIdx = preferredSpanRecorderIdx;
+	{
+		//Coroutines of different threads may register their spans at the same time
+		std::lock_guard<std::mutex> lock(s_SpanSiteMutex);
+		for (u32 i = 0; i < NB_SPANS; ++i)
+		{
+			spanRecorderIdx = (preferredSpanRecorderIdx + i) % NB_SPANS;
+			SpanSite& site = s_SpanSites[spanRecorderIdx];
+			if (site.name == nullptr)
+			{
+				site.name = _spanName;
+				site.fileName = _fileName;
+				site.lineNumber = _lineNumber;
+				break;
+			}
+			if (site.lineNumber == _lineNumber && site.fileName == _fileName)
+			{
+				//The same call site, in another instantiation of a template or inline function
+				break;
+			}
+			if (i + 1 == NB_SPANS)
+			{
+				printf("Warning: More spans than NB_SPANS (%u) were registered. The span %s will share the statistics of %s.\n",
+					(u32)NB_SPANS, _spanName, s_SpanSites[preferredSpanRecorderIdx].name);
+				spanRecorderIdx = preferredSpanRecorderIdx;
+			}
+		}
+	}
+	BindSpanSite(GetProfiler()->spans[spanRecorderIdx], spanRecorderIdx);
+	return spanRecorderIdx;
+}
+
+void Profile::Profiler::ReportSpans() noexcept
+{
+#if PROFILER_ENABLED
+	bool hasSpan = false;
+	for (const SpanRecorder& span : spans)
+	{
+		if (span.spanName && LoadCounter(span.hitCount))
+		{
+			if (!hasSpan)
+			{
+				printf("---- Spans of Profiler: %s ----\n", name);
+				hasSpan = true;
+			}
+			span.Report();
+		}
+	}
+#else
+	printf("Profiler spans report was called but it is disabled. Report is therefore empty and will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
+
+void Profile::Profiler::ReportTailCaptures() noexcept
+{
+#if PROFILER_ENABLED
+	std::vector<TailCapture> captures;
+	u64 captureCount = GetTailCaptures(captures);
+	f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+	printf("---- Tail Captures of Profiler: %s (last %llu of %llu) ----\n", name, (u64)captures.size(), captureCount);
+	for (TailCapture& capture : captures)
+	{
+		if (capture.ptr_profiler != this)
+		{
+			continue;
+		}
+		u64 duration = capture.end - capture.start;
+		printf("%s on thread %u: %.3fms (threshold %.3fms)", capture.blockName, capture.threadIdx,
+			1000.0 * (f64)duration / cpuFreq, 1000.0 * (f64)capture.threshold / cpuFreq);
+		if (capture.droppedEventCount)
+		{
+			printf("; %llu oldest block(s) dropped", capture.droppedEventCount);
+		}
+		printf("\n");
+
+		std::sort(capture.events.begin(), capture.events.end(),
+			[](const TailEvent& _a, const TailEvent& _b) { return _a.end - _a.start > _b.end - _b.start; });
+		for (const TailEvent& event : capture.events)
+		{
+			printf("\t%s: %.3fms at +%.3fms\n", event.blockName, 1000.0 * (f64)(event.end - event.start) / cpuFreq,
+				1000.0 * ((f64)event.start - (f64)capture.start) / cpuFreq);
+		}
+	}
+#else
+	printf("Profiler tail captures report was called but it is disabled. Report is therefore empty and will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
+
+void Profile::Profiler::ExportTimeline([[maybe_unused]] const char* _path) noexcept
+{
+#if PROFILER_ENABLED
+	FILE* file = fopen(_path, "w");
+	if (file)
+	{
+		printf("Exporting profiler timeline to %s\n", _path);
+		fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":");
+		WriteJsonString(file, name);
+		fprintf(file, "}}");
+
+		f64 cpuFreq = (f64)Timer::GetEstimatedCPUFreq();
+		u64 eventCount = s_AsyncSpanEventCount.load(std::memory_order_acquire);
+		u64 firstEventIdx = eventCount > NB_ASYNC_SPAN_EVENTS ? eventCount - NB_ASYNC_SPAN_EVENTS : 0;
+		for (u64 eventIdx = firstEventIdx; eventIdx < eventCount; ++eventIdx)
+		{
+			const AsyncSpanEvent& slot = s_AsyncSpanEvents[eventIdx % NB_ASYNC_SPAN_EVENTS];
+			std::atomic_ref<u64> sequence(const_cast<u64&>(slot.sequence));
+			if (sequence.load(std::memory_order_acquire) != eventIdx + 1)
+			{
+				continue;
+			}
+			AsyncSpanEvent event = slot;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) != eventIdx + 1)
+			{
+				//Overwritten by a more recent span while it was read
+				continue;
+			}
+			if (event.ptr_recorder < spans.data() || event.ptr_recorder >= spans.data() + NB_SPANS)
+			{
+				//A span of another profiler
+				continue;
+			}
+
+			f64 beginInUs = 1e6 * ((f64)event.start - (f64)start) / cpuFreq;
+			f64 endInUs = 1e6 * ((f64)event.end - (f64)start) / cpuFreq;
+			//The async slice, from the beginning to the end of the span
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, event.ptr_recorder->spanName);
+			fprintf(file, ",\"cat\":\"async\",\"ph\":\"b\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", event.id, event.beginThreadIdx, beginInUs);
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, event.ptr_recorder->spanName);
+			fprintf(file, ",\"cat\":\"async\",\"ph\":\"e\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", event.id, event.endThreadIdx, endInUs);
+			//The flow from the thread that began the span to the one that ended it.
+			//The flow events bind to slices, so a zero-length slice marks both ends.
+			const char* phases[2] = { "Begin", "End" };
+			const u32 threadIdxs[2] = { event.beginThreadIdx, event.endThreadIdx };
+			const f64 timesInUs[2] = { beginInUs, endInUs };
+			for (u32 i = 0; i < 2; ++i)
+			{
+				fprintf(file, ",\n{\"name\":");
+				WriteJsonString(file, phases[i]);
+				fprintf(file, ",\"cat\":\"async\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":0}", threadIdxs[i], timesInUs[i]);
+				fprintf(file, ",\n{\"name\":");
+				WriteJsonString(file, event.ptr_recorder->spanName);
+				fprintf(file, ",\"cat\":\"flow\",\"ph\":\"%s\",%s\"id\":%llu,\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+					i == 0 ? "s" : "f", i == 0 ? "" : "\"bp\":\"e\",", eventIdx, threadIdxs[i], timesInUs[i]);
+			}
+		}
+
+		//The blocks of the slow executions of the watched blocks
+		std::vector<TailCapture> captures;
+		GetTailCaptures(captures);
+		for (const TailCapture& capture : captures)
+		{
+			if (capture.ptr_profiler != this)
+			{
+				continue;
+			}
+			for (const TailEvent& event : capture.events)
+			{
+				fprintf(file, ",\n{\"name\":");
+				WriteJsonString(file, event.blockName);
+				fprintf(file, ",\"cat\":\"tail\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", capture.threadIdx,
+					1e6 * ((f64)event.start - (f64)start) / cpuFreq, 1e6 * (f64)(event.end - event.start) / cpuFreq);
+			}
+		}
+		fprintf(file, "\n]}\n");
+		fclose(file);
+	}
+	else
+	{
+		printf("Error: Could not open file %s for writing.\n", _path);
+	}
+#else
+	printf("Profiler timeline export was called but it is disabled. The profiler is therefore empty and the export will be skipped.\nThe profiler can be enabled by defining _PROFILER_ENABLED in the compiler options.\n");
+#endif
+}
@@ -0,0 +1,184 @@
+#include <algorithm> //for std::sort and std::nth_element
+#include <cmath> //for std::sqrt and std::fabs
+#include <cstdio> //for printf
+#include <vector> //for the bootstrap medians
+#include "Profile/Statistics.hpp"
+
+/*!
+@brief Returns the median of a buffer by partially sorting it in place.
+*/
+static Profile::f64 MedianInPlace(Profile::f64* _values, Profile::u64 _count) noexcept
+{
+	Profile::u64 half = _count / 2;
+	std::nth_element(_values, _values + half, _values + _count);
+	Profile::f64 upper = _values[half];
+	if (_count % 2)
+	{
+		return upper;
+	}
+	Profile::f64 lower = *std::max_element(_values, _values + half);
+	return 0.5 * (lower + upper);
+}
+
+void Profile::RobustStatistics::Clear() noexcept
+{
+	sampleCount = 0;
+	mean = 0.0;
+	standardDeviation = 0.0;
+	min = 0.0;
+	max = 0.0;
+	median = 0.0;
+	medianAbsoluteDeviation = 0.0;
+	meanAbsoluteDeviation = 0.0;
+	percentile5 = 0.0;
+	percentile25 = 0.0;
+	percentile75 = 0.0;
+	percentile95 = 0.0;
+	percentile99 = 0.0;
+	trimmedMean = 0.0;
+	confidenceLow = 0.0;
+	confidenceHigh = 0.0;
+	outlierCount = 0;
+}
+
+void Profile::RobustStatistics::Compute(f64* _samples, u64 _sampleCount, f64* _scratch, RandomGenerator& _generator) noexcept
+{
+	Clear();
+	if (_sampleCount == 0)
+	{
+		return;
+	}
+
+	sampleCount = _sampleCount;
+	std::sort(_samples, _samples + _sampleCount);
+
+	f64 sum = 0.0;
+	for (u64 i = 0; i < _sampleCount; ++i)
+	{
+		sum += _samples[i];
+	}
+	mean = sum / (f64)_sampleCount;
+
+	// Two-pass variance in floating point: no cancellation and no unsigned underflow.
+	f64 squaredSum = 0.0;
+	for (u64 i = 0; i < _sampleCount; ++i)
+	{
+		f64 diff = _samples[i] - mean;
+		squaredSum += diff * diff;
+	}
+	standardDeviation = std::sqrt(squaredSum / (f64)_sampleCount);
+
+	min = _samples[0];
+	max = _samples[_sampleCount - 1];
+	median = Percentile(_samples, _sampleCount, 50.0);
+	percentile5 = Percentile(_samples, _sampleCount, 5.0);
+	percentile25 = Percentile(_samples, _sampleCount, 25.0);
+	percentile75 = Percentile(_samples, _sampleCount, 75.0);
+	percentile95 = Percentile(_samples, _sampleCount, 95.0);
+	percentile99 = Percentile(_samples, _sampleCount, 99.0);
+	trimmedMean = TrimmedMean(_samples, _sampleCount, trimFraction);
+
+	f64 absoluteDeviationSum = 0.0;
+	for (u64 i = 0; i < _sampleCount; ++i)
+	{
+		_scratch[i] = std::fabs(_samples[i] - median);
+		absoluteDeviationSum += _scratch[i];
+	}
+	meanAbsoluteDeviation = absoluteDeviationSum / (f64)_sampleCount;
+	medianAbsoluteDeviation = MedianInPlace(_scratch, _sampleCount);
+
+	for (u64 i = 0; i < _sampleCount; ++i)
+	{
+		if (IsOutlier(_samples[i]))
+		{
+			outlierCount++;
+		}
+	}
+
+	BootstrapMedianConfidenceInterval(_samples, _sampleCount, _scratch, _generator,
+		bootstrapResampleCount, confidenceLevel, confidenceLow, confidenceHigh);
+}
+
+bool Profile::RobustStatistics::IsOutlier(f64 _value) const noexcept
+{
+	f64 deviation = std::fabs(_value - median);
+	if (medianAbsoluteDeviation == 0.0)
+	{
+		//Most samples are on the median: fall back to the spread of the others
+		if (meanAbsoluteDeviation == 0.0)
+		{
+			return false; //All the samples are equal
+		}
+		return deviation / (1.253314 * meanAbsoluteDeviation) > outlierThreshold;
+	}
+	return 0.6745 * deviation / medianAbsoluteDeviation > outlierThreshold;
+}
+
+void Profile::RobustStatistics::Report(f64 _scale, const char* _unit) const noexcept
+{
+	printf("median %.4f%s (MAD %.4f%s; %.0f%% CI [%.4f, %.4f]%s); p5/p25/p75/p95/p99 {%.4f, %.4f, %.4f, %.4f, %.4f}%s; %.0f%% trimmed mean %.4f%s; %llu outlier(s) out of %llu",
+		_scale * median, _unit, _scale * medianAbsoluteDeviation, _unit,
+		100.0 * confidenceLevel, _scale * confidenceLow, _scale * confidenceHigh, _unit,
+		_scale * percentile5, _scale * percentile25, _scale * percentile75, _scale * percentile95, _scale * percentile99, _unit,
+		100.0 * trimFraction, _scale * trimmedMean, _unit,
+		outlierCount, sampleCount);
+}
+
+Profile::f64 Profile::RobustStatistics::Percentile(const f64* _sortedSamples, u64 _sampleCount, f64 _percentile) noexcept
+{
+	if (_sampleCount == 0)
+	{
+		return 0.0;
+	}
+
+	f64 rank = _percentile / 100.0 * (f64)(_sampleCount - 1);
+	u64 lowerIdx = (u64)rank;
+	if (lowerIdx + 1 >= _sampleCount)
+	{
+		return _sortedSamples[_sampleCount - 1];
+	}
+	f64 weight = rank - (f64)lowerIdx;
+	return _sortedSamples[lowerIdx] + weight * (_sortedSamples[lowerIdx + 1] - _sortedSamples[lowerIdx]);
+}
+
+Profile::f64 Profile::RobustStatistics::TrimmedMean(const f64* _sortedSamples, u64 _sampleCount, f64 _fraction) noexcept
+{
+	u64 trimmedCount = (u64)(_fraction * (f64)_sampleCount);
+	if (2 * trimmedCount >= _sampleCount)
+	{
+		return Percentile(_sortedSamples, _sampleCount, 50.0);
+	}
+
+	f64 sum = 0.0;
+	for (u64 i = trimmedCount; i < _sampleCount - trimmedCount; ++i)
+	{
+		sum += _sortedSamples[i];
+	}
+	return sum / (f64)(_sampleCount - 2 * trimmedCount);
+}
+
+void Profile::RobustStatistics::BootstrapMedianConfidenceInterval(const f64* _samples, u64 _sampleCount, f64* _scratch,
+	RandomGenerator& _generator, u32 _resampleCount, f64 _confidenceLevel, f64& _low, f64& _high) noexcept
+{
+	if (_sampleCount == 0 || _resampleCount == 0)
+	{
+		_low = 0.0;
+		_high = 0.0;
+		return;
+	}
+
+	std::vector<f64> medians(_resampleCount);
+	for (u32 r = 0; r < _resampleCount; ++r)
+	{
+		for (u64 i = 0; i < _sampleCount; ++i)
+		{
+			_scratch[i] = _samples[_generator.NextBounded(_sampleCount)];
+		}
+		medians[r] = MedianInPlace(_scratch, _sampleCount);
+	}
+
+	std::sort(medians.begin(), medians.end());
+	f64 alpha = 0.5 * (1.0 - _confidenceLevel);
+	_low = Percentile(medians.data(), _resampleCount, 100.0 * alpha);
+	_high = Percentile(medians.data(), _resampleCount, 100.0 * (1.0 - alpha));
+}
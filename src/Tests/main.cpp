@@ -1,5 +1,22 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <csignal>
+#include <cstring>
 #include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Profile/LiveSnapshot.hpp"
+#include "Profile/MemoryBenchmarks.hpp"
+#include "Profile/ProfileDumper.hpp"
 #include "Profile/Profiler.hpp"
+#include "Profile/RollingWindow.hpp"
 
 /*!
 @brief Tests the macro time profiling macro on track 0: PROFILE_FUNCTION_TIME(0).
@@ -82,6 +99,381 @@ void TestFunction_Bandwidth(Profile::u64 _arr[], Profile::u64 _count)
 	}
 }
 
+/*!
+@brief Tests the attribution of heap allocations to the innermost open block.
+@details Only the allocations of the inner block should be reported on it when
+		 PROFILER_TRACK_ALLOCATIONS is enabled, and none otherwise; the outer
+		 block only gets the last release.
+@param _count The number of allocations.
+@return Whether the inner block recorded exactly its allocations.
+*/
+bool TestFunction_Allocations(Profile::u64 _count)
+{
+	PROFILE_FUNCTION_TIME(0);
+
+	const Profile::u64 byteCount = 128;
+	std::vector<void*> pointers(_count);
+	{
+		PROFILE_BLOCK_TIME(TestFunction_Allocations_Inner, 0);
+		for (Profile::u64 i = 0; i < _count; ++i)
+		{
+			pointers[i] = malloc(byteCount);
+		}
+		for (Profile::u64 i = 0; i < _count; ++i)
+		{
+			free(pointers[i]);
+		}
+	}
+
+	//Only checked if the block was recorded, i.e., if the profiler is enabled
+	bool success = true;
+	for (const Profile::ProfileBlockRecorder& record : Profile::GetProfiler()->tracks[0].timings)
+	{
+		if (record.blockName != nullptr && strcmp(record.blockName, "TestFunction_Allocations_Inner") == 0)
+		{
+			Profile::u64 expectedCount = PROFILER_TRACK_ALLOCATIONS ? record.hitCount * _count : 0;
+			//The allocator may give more than what was requested, but frees as much as it gave
+			success = record.allocationCount == expectedCount && record.allocatedByteCount >= expectedCount * byteCount &&
+				record.freedByteCount == record.allocatedByteCount && (PROFILER_TRACK_ALLOCATIONS || record.allocatedByteCount == 0);
+			if (!success)
+			{
+				printf("ERROR: The block recorded %llu allocations (%llu bytes allocated; %llu bytes freed) instead of %llu (%llu bytes).\n",
+					record.allocationCount, record.allocatedByteCount, record.freedByteCount, expectedCount, expectedCount * byteCount);
+			}
+		}
+	}
+	return success;
+}
+
+/*!
+@brief Reads a protobuf varint.
+@param _data The encoded message.
+@param _offset The offset of the varint, moved past it.
+@return The value read.
+*/
+Profile::u64 ReadVarint(const std::vector<Profile::u8>& _data, Profile::u64& _offset)
+{
+	Profile::u64 value = 0;
+	for (Profile::u32 shift = 0; _offset < _data.size() && shift < 64; shift += 7)
+	{
+		Profile::u8 byte = _data[_offset++];
+		value |= (Profile::u64)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			break;
+		}
+	}
+	return value;
+}
+
+/*!
+@brief Tests Profile::ProfilerResults::ExportToPprof by reading the file back.
+@details The gzip container must start with its magic bytes and hold stored
+		 deflate blocks, and the profile must have one sample per call path,
+		 one location per distinct block and track, and a total time equal to
+		 the self times of the paths. No file is written when the profiler is
+		 disabled.
+@param _results The results to export.
+@param _path The path of the file.
+@return Whether the file matches the results.
+*/
+bool TestFunction_Pprof(Profile::ProfilerResults& _results, const char* _path)
+{
+	std::filesystem::remove(_path);
+	_results.ExportToPprof(_path);
+
+	Profile::u64 expectedSampleCount = 0;
+	Profile::u64 expectedElapsed = 0;
+	std::set<std::string> locations;
+	for (Profile::u32 i = 0; i < _results.trackCount; ++i)
+	{
+		const Profile::ProfileTrackResult& track = _results.tracks[i];
+		locations.insert(std::string(track.name ? track.name : "") + '\0' + '\0' + "0");
+		for (CALL_NODES_TYPE j = 0; j < track.callTree.nodeCount; ++j)
+		{
+			const Profile::ProfileBlockResult& block = track.timings[track.callTree.nodes[j].profileBlockRecorderIdx];
+			expectedSampleCount++;
+			expectedElapsed += track.callTree.GetSelfElapsed(j);
+			locations.insert(std::string(block.blockName ? block.blockName : "") + '\0' +
+				(block.fileName ? block.fileName : "") + '\0' + std::to_string(block.lineNumber));
+		}
+	}
+
+	FILE* file = fopen(_path, "rb");
+	if (file == nullptr)
+	{
+		if (expectedSampleCount)
+		{
+			printf("ERROR: The pprof file %s was not written.\n", _path);
+			return false;
+		}
+		return true;
+	}
+	std::vector<Profile::u8> gzip;
+	Profile::u8 buffer[4096];
+	for (size_t readCount = 0; (readCount = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+	{
+		gzip.insert(gzip.end(), buffer, buffer + readCount);
+	}
+	fclose(file);
+
+	if (gzip.size() < 18 || gzip[0] != 0x1F || gzip[1] != 0x8B || gzip[2] != 8)
+	{
+		printf("ERROR: The pprof file %s does not start with the gzip magic bytes.\n", _path);
+		return false;
+	}
+
+	//Unpack the stored deflate blocks
+	std::vector<Profile::u8> message;
+	Profile::u64 offset = 10;
+	bool isFinal = false;
+	while (!isFinal && offset + 5 <= gzip.size())
+	{
+		isFinal = gzip[offset] & 1;
+		Profile::u64 blockByteCount = gzip[offset + 1] | (Profile::u64)gzip[offset + 2] << 8;
+		offset += 5;
+		if (offset + blockByteCount > gzip.size())
+		{
+			break;
+		}
+		message.insert(message.end(), gzip.begin() + offset, gzip.begin() + offset + blockByteCount);
+		offset += blockByteCount;
+	}
+	Profile::u64 trailerByteCount = offset + 8 <= gzip.size() ?
+		gzip[offset + 4] | (Profile::u64)gzip[offset + 5] << 8 | (Profile::u64)gzip[offset + 6] << 16 | (Profile::u64)gzip[offset + 7] << 24 : 0;
+	if (!isFinal || trailerByteCount != message.size())
+	{
+		printf("ERROR: The gzip container of %s is truncated.\n", _path);
+		return false;
+	}
+
+	//Count the samples (field 2) and the locations (field 4) of the profile,
+	//and sum the first value (field 2 of a sample) of the samples
+	Profile::u64 sampleCount = 0;
+	Profile::u64 locationCount = 0;
+	Profile::u64 elapsed = 0;
+	offset = 0;
+	while (offset < message.size())
+	{
+		Profile::u64 tag = ReadVarint(message, offset);
+		if ((tag & 7) == 2)
+		{
+			Profile::u64 byteCount = ReadVarint(message, offset);
+			for (Profile::u64 sampleOffset = offset; (tag >> 3) == 2 && sampleOffset < offset + byteCount;)
+			{
+				Profile::u64 sampleTag = ReadVarint(message, sampleOffset);
+				Profile::u64 fieldByteCount = ReadVarint(message, sampleOffset);
+				Profile::u64 fieldEnd = sampleOffset + fieldByteCount;
+				if ((sampleTag >> 3) == 2)
+				{
+					elapsed += ReadVarint(message, sampleOffset);
+				}
+				sampleOffset = fieldEnd;
+			}
+			offset += byteCount;
+		}
+		else
+		{
+			ReadVarint(message, offset);
+		}
+		sampleCount += (tag >> 3) == 2 ? 1 : 0;
+		locationCount += (tag >> 3) == 4 ? 1 : 0;
+	}
+
+	printf("\n---- Pprof: %llu sample(s) and %llu location(s) in %s ----\n", sampleCount, locationCount, _path);
+	if (sampleCount != expectedSampleCount || locationCount != locations.size() || elapsed != expectedElapsed)
+	{
+		printf("ERROR: The pprof file has %llu sample(s), %llu location(s) and %llu cycles instead of %llu, %llu and %llu.\n",
+			sampleCount, locationCount, elapsed, expectedSampleCount, (Profile::u64)locations.size(), expectedElapsed);
+		return false;
+	}
+	return true;
+}
+
+/*!
+@brief Tests the capture of all the OS metrics in the profile blocks.
+@details The first block touches newly allocated memory (page faults and resident
+		 set size growth), the second one sleeps (voluntary context switch with
+		 little CPU time). Both must have captured every requested metric, and
+		 the ones they exercise must not be 0.
+@return Whether the metrics were captured with the expected values.
+*/
+bool TestFunction_OSMetrics()
+{
+	Profile::u32 previousMask = Profile::Surveyor::GetOSMetricsMask();
+	Profile::Surveyor::SetOSMetricsMask(Profile::OSMetric_All);
+
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetTrackName(0, "OS Metrics");
+	profiler->Initialize();
+	{
+		PROFILE_BLOCK_TIME(TestFunction_OSMetrics_Touch, 0);
+		Profile::u64 count = 4 * 1024 * 1024 / sizeof(Profile::u64);
+		Profile::u64* arr = (Profile::u64*)malloc(sizeof(Profile::u64) * count);
+		for (Profile::u64 i = 0; i < count; ++i)
+		{
+			arr[i] = i;
+		}
+		free(arr);
+	}
+	{
+		PROFILE_BLOCK_TIME(TestFunction_OSMetrics_Sleep, 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	profiler->End();
+	profiler->Report();
+
+	//Only checked if the blocks were recorded, i.e., if the profiler is enabled
+	bool success = true;
+	for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+	{
+		if (record.blockName == nullptr || record.hitCount == 0)
+		{
+			continue;
+		}
+		const Profile::OSMetricsSnapshot& metrics = record.osMetricsTotal;
+		success = success && (metrics.mask & Profile::OSMetric_All) == Profile::OSMetric_All;
+		if (strcmp(record.blockName, "TestFunction_OSMetrics_Touch") == 0)
+		{
+			success = success && metrics.minorPageFaultCount + metrics.majorPageFaultCount > 0 &&
+				metrics.userTimeInUs + metrics.systemTimeInUs > 0 && metrics.threadCPUTimeInNs > 0 &&
+				metrics.residentSetSizeInB > 0 && metrics.peakResidentSetSizeInB > 0;
+		}
+#if !_WIN32 //Windows does not count the context switches of a thread
+		else if (strcmp(record.blockName, "TestFunction_OSMetrics_Sleep") == 0)
+		{
+			success = success && metrics.voluntaryContextSwitchCount > 0;
+		}
+#endif
+	}
+	if (!success)
+	{
+		printf("ERROR: The OS metrics of the blocks are missing or 0.\n");
+	}
+	profiler->ClearTracks();
+
+	Profile::Surveyor::SetOSMetricsMask(previousMask);
+	return success;
+}
+
+/*!
+@brief Tests the thread CPU time of the blocks with a block that sleeps and a
+		block that spins for the same wall time.
+@details The sleeping block must be mostly off-CPU, and the spinning one almost
+		 never (with a margin for the preemptions on a loaded machine).
+@return Whether the off-CPU percentages of the blocks are the expected ones.
+*/
+bool TestFunction_OffCPU()
+{
+	Profile::u32 previousMask = Profile::Surveyor::GetOSMetricsMask();
+	Profile::Surveyor::SetOSMetricsMask(Profile::OSMetric_ThreadCPUTime);
+
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetTrackName(0, "Off-CPU");
+	profiler->Initialize();
+	{
+		PROFILE_BLOCK_TIME(TestFunction_OffCPU_Sleep, 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+	{
+		PROFILE_BLOCK_TIME(TestFunction_OffCPU_Spin, 0);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+		while (std::chrono::steady_clock::now() < end)
+		{
+		}
+	}
+	profiler->End();
+	profiler->Report();
+
+	//Only checked if the blocks were recorded with their thread CPU time
+	bool success = true;
+	for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+	{
+		if (record.blockName == nullptr || record.hitCount == 0 || !(record.osMetricsTotal.mask & Profile::OSMetric_ThreadCPUTime))
+		{
+			continue;
+		}
+		Profile::f64 wallInNs = 1e9 * (Profile::f64)record.elapsed / (Profile::f64)Profile::Timer::GetEstimatedCPUFreq();
+		Profile::f64 offCPUPercentage = 100.0 * (1.0 - (Profile::f64)record.osMetricsTotal.threadCPUTimeInNs / wallInNs);
+		if (strcmp(record.blockName, "TestFunction_OffCPU_Sleep") == 0 && offCPUPercentage < 80.0)
+		{
+			printf("ERROR: The sleeping block is only %.1f%% off-CPU.\n", offCPUPercentage);
+			success = false;
+		}
+		else if (strcmp(record.blockName, "TestFunction_OffCPU_Spin") == 0 && offCPUPercentage > 50.0)
+		{
+			printf("ERROR: The spinning block is %.1f%% off-CPU.\n", offCPUPercentage);
+			success = false;
+		}
+	}
+	profiler->ClearTracks();
+
+	Profile::Surveyor::SetOSMetricsMask(previousMask);
+	return success;
+}
+
+/*!
+@brief Tests placing a block on the roofline of the machine.
+@details Measures the peaks of the machine on a buffer of the size of one array,
+		 so that the kernels are never less cache friendly than the block, and
+		 profiles a multiply-add over two arrays: 2 floating point operations for
+		 24 bytes read or written. The block must be memory-bound, below its
+		 roofline but not at 0. The peaks are measured again rather than loaded
+		 from a cache, with enough runs to get one without contention, since a
+		 cached measurement taken on a loaded machine would stay too low.
+@param _count The number of elements of the arrays.
+@return Whether the percentages of the peaks were computed and are in (0, 100].
+*/
+bool TestFunction_Roofline(Profile::u64 _count)
+{
+	Profile::MachinePeaks machinePeaks;
+	machinePeaks.Measure(sizeof(Profile::f64) * _count, 20);
+	machinePeaks.SaveToFile("./ProfileResults/MachinePeaks.txt");
+	machinePeaks.Report();
+	Profile::SetMachinePeaks(&machinePeaks);
+
+	std::vector<Profile::f64> x(_count, 1.0);
+	std::vector<Profile::f64> y(_count, 2.0);
+
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetTrackName(0, "Roofline");
+	profiler->Initialize();
+	{
+		PROFILE_BLOCK_TIME_BANDWIDTH_FLOPS("TestFunction_Roofline_Daxpy", 0, 3 * sizeof(Profile::f64) * _count, 2 * _count);
+		for (Profile::u64 i = 0; i < _count; ++i)
+		{
+			y[i] = 3.0 * x[i] + y[i];
+		}
+	}
+	profiler->End();
+	profiler->Report();
+
+	//Only checked if the block was recorded, i.e., if the profiler is enabled
+	bool success = machinePeaks.IsValid();
+	for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+	{
+		if (record.blockName == nullptr || record.hitCount == 0)
+		{
+			continue;
+		}
+		Profile::f64 elapsedSec = (Profile::f64)record.elapsed / (Profile::f64)Profile::Timer::GetEstimatedCPUFreq();
+		Profile::f64 percentOfBandwidth = machinePeaks.GetPercentOfPeakBandwidth(record.processedByteCount, elapsedSec);
+		Profile::f64 percentOfRoofline = machinePeaks.GetPercentOfRoofline(record.processedByteCount, record.flopCount, elapsedSec);
+		success = success && percentOfBandwidth > 0.0 && percentOfBandwidth <= 100.0 &&
+			percentOfRoofline > 0.0 && percentOfRoofline <= 100.0 &&
+			(Profile::f64)record.flopCount / (Profile::f64)record.processedByteCount < machinePeaks.GetRidgePoint();
+	}
+	if (!success)
+	{
+		printf("ERROR: The block is not placed in (0, 100]%% of the peaks of the machine.\n");
+	}
+	profiler->ClearTracks();
+
+	Profile::SetMachinePeaks(nullptr);
+	printf("Daxpy checksum: %f\n", y[_count / 2]);
+	return success;
+}
+
 /*!
 @brief A wrapper around the TestFunction_Bandwidth when it will be used in repetition tester.
 @details In this one we are consistently reallocating a new array of 1MB at the
@@ -211,73 +603,1698 @@ void TestFunction_FixedRepetitionTesting()
 	free(arr);
 }
 
-int main()
+/*!
+@brief Tests the FixedCountRepetitionTesting function of the RepetitionProfiler
+		with lambdas instead of Profile::RepetitionTest wrappers.
+@details The second test allocates its array in the setup and frees it in the
+		 teardown. Both must run once per repetition, the setup before the timed
+		 region starts and the teardown after it ends.
+@return Whether the setup and the teardown ran once per repetition, untimed.
+*/
+bool TestFunction_LambdaRepetitionTesting()
 {
-	Profile::u64 testArraySize = 1024 * 1024;
+	Profile::u64 count = 8192;
+	Profile::u64* arr = (Profile::u64*)malloc(sizeof(Profile::u64) * count);
 
-	Profile::Profiler* profiler = new Profile::Profiler();
-	profiler->SetProfilerName("Tests");
+	Profile::u16 repetitionCount = 10;
+	Profile::ProfilerResults* results = new Profile::ProfilerResults[repetitionCount];
+	Profile::RepetitionProfiler* repetitionProfiler = new Profile::RepetitionProfiler();
 
-	Profile::SetProfiler(profiler);
-	profiler->SetTrackName(0, "Main");
-	profiler->Initialize();
-	Profile::u64* arr = (Profile::u64*)malloc(sizeof(Profile::u64) * testArraySize);
+	repetitionProfiler->PushBackRepetitionTest("Lambda", [arr, count]() { TestFunction_ProfileFunction(arr, count); });
 
-	TestFunction_ProfileFunction(arr, testArraySize);
-	TestFunction_ProfileBlock(arr, testArraySize);
-	TestFunction_Bandwidth(arr, testArraySize);
-	TestFunction_PageFaultCounter();
+	//The times of the setups, of the timed regions and of the teardowns of every repetition
+	struct
+	{
+		Profile::u64* pageFaultArr = nullptr;
+		std::vector<Profile::u64> setupTimes;
+		std::vector<Profile::u64> timedStarts;
+		std::vector<Profile::u64> timedEnds;
+		std::vector<Profile::u64> teardownTimes;
+	} state;
+	Profile::u64 arraySize = 1024 * 1024;
+	repetitionProfiler->PushBackRepetitionTest("Lambda with setup and teardown",
+		[&state, arraySize]()
+		{
+			state.timedStarts.push_back(Profile::GetProfiler()->start);
+			TestFunction_Bandwidth(state.pageFaultArr, arraySize);
+		},
+		[&state, arraySize]()
+		{
+			state.pageFaultArr = (Profile::u64*)malloc(sizeof(Profile::u64) * arraySize);
+			state.setupTimes.push_back(Profile::Timer::GetCPUTimer());
+		},
+		[&state]()
+		{
+			state.timedEnds.push_back(Profile::GetProfiler()->start + Profile::GetProfiler()->elapsed);
+			state.teardownTimes.push_back(Profile::Timer::GetCPUTimer());
+			free(state.pageFaultArr);
+			state.pageFaultArr = nullptr;
+		});
 
-	profiler->End();
-	profiler->Report();
-	profiler->ClearTracks();
+	repetitionProfiler->SetRepetitionResults(results);
+	repetitionProfiler->FixedCountRepetitionTesting(repetitionCount, false, true);
 
-	profiler->SetTrackName(1, "SubTrack");
-	profiler->Initialize();
-	TestFunction_Track2(arr, testArraySize);
+	bool success = state.setupTimes.size() == repetitionCount && state.timedStarts.size() == repetitionCount &&
+		state.timedEnds.size() == repetitionCount && state.teardownTimes.size() == repetitionCount;
+	for (Profile::u16 i = 0; success && i < repetitionCount; ++i)
+	{
+		success = state.setupTimes[i] <= state.timedStarts[i] && state.timedEnds[i] <= state.teardownTimes[i];
+	}
+	if (!success)
+	{
+		printf("ERROR: The setup and the teardown did not run once per repetition outside of the timed region.\n");
+	}
 
-	profiler->End();
-	profiler->Report();
-	profiler->ClearTracks();
+	delete[] results;
+	delete repetitionProfiler;
+	free(arr);
+	return success;
+}
 
-	profiler->SetTrackName(0, "Main");
-	profiler->Initialize();
+/*!
+@brief Tests the ScalingRepetitionTesting function of the RepetitionProfiler.
+@details Every thread fills its own array so that the aggregated bandwidth can
+		 be compared to the bandwidth of a single thread. There must be one
+		 result per number of threads, the first one with a speedup of 1.
+@return Whether the results cover every number of threads.
+*/
+bool TestFunction_ScalingRepetitionTesting()
+{
+	Profile::u32 maxThreadCount = Profile::Surveyor::GetOSLogicalCoreCount();
+	maxThreadCount = maxThreadCount < 4 ? (maxThreadCount ? maxThreadCount : 1) : 4;
 
-	TestFunction_ProfileFunction(arr, testArraySize);
-	TestFunction_ProfileBlock(arr, testArraySize);
-	TestFunction_Bandwidth(arr, testArraySize);
+	Profile::u64 count = 1024 * 1024;
+	std::vector<Profile::u64*> arrays(maxThreadCount);
+	for (Profile::u64*& threadArr : arrays)
+	{
+		threadArr = (Profile::u64*)malloc(sizeof(Profile::u64) * count);
+	}
 
-	profiler->End();
-	profiler->Report();
+	Profile::RepetitionProfiler* repetitionProfiler = new Profile::RepetitionProfiler();
+	repetitionProfiler->PushBackRepetitionTest("Bandwidth scaling",
+		[&arrays, count](Profile::u32 _threadIdx) { TestFunction_Bandwidth(arrays[_threadIdx], count); });
+
+	repetitionProfiler->ScalingRepetitionTesting(0, maxThreadCount, 10);
 
-	//Test exporting as CSV
-	//Create file directory ./ProfileResults/TestResults.csv
 	if (std::filesystem::create_directories("./ProfileResults"))
 	{
 		printf("\nCreating directory ./ProfileResults\n");
 	}
-	else
+	repetitionProfiler->ExportScalingToCSV("./ProfileResults/Scaling.csv");
+
+	const std::vector<Profile::ScalingResult>& scalingResults = repetitionProfiler->scalingResults;
+	bool success = scalingResults.size() == maxThreadCount && scalingResults[0].speedup == 1.0;
+	for (Profile::u32 i = 0; success && i < maxThreadCount; ++i)
 	{
-		printf("\nDirectory ./ProfileResults already exists\n");
+		success = scalingResults[i].threadCount == i + 1 && scalingResults[i].repetitionCount == 10;
+	}
+	if (!success)
+	{
+		printf("ERROR: The scaling results do not cover 1 to %u threads with a speedup of 1 on one thread.\n", maxThreadCount);
 	}
 
-	//Export
-	profiler->ExportToCSV("./ProfileResults/TestResults.csv");
+	delete repetitionProfiler;
+	for (Profile::u64* threadArr : arrays)
+	{
+		free(threadArr);
+	}
+	return success;
+}
 
-	profiler->ClearTracks();
+/*!
+@brief Checks that a memory benchmark ran its kernel in every repetition.
+@details The kernel is profiled as the only block of track 0, named after the
+		 function wrapping it, so the minimum results must hold this block once
+		 with the bytes of the kernel and a non-zero bandwidth.
+@param _repetitionProfiler The repetition profiler that ran the benchmark alone.
+@param _blockName The name of the block of the kernel.
+@param _byteCount The number of bytes the kernel processes per repetition.
+@return Whether the block was recorded with a non-zero bandwidth, or true if the
+		profiler is disabled.
+*/
+bool CheckMemoryBenchmark(const Profile::RepetitionProfiler* _repetitionProfiler, const char* _blockName, Profile::u64 _byteCount)
+{
+	const Profile::ProfileTrackResult& track = _repetitionProfiler->minResults.tracks[0];
+	if (track.blockCount == 0)
+	{
+		return true;
+	}
 
-	TestFunction_FixedRepetitionTesting();
+	bool success = track.blockCount == 1 && track.timings[0].blockName != nullptr &&
+		strcmp(track.timings[0].blockName, _blockName) == 0 && track.timings[0].hitCount == 1 &&
+		track.timings[0].processedByteCount == _byteCount && track.timings[0].elapsedSec > 0.0;
+	if (!success)
+	{
+		printf("ERROR: The memory benchmark %s did not run with a non-zero bandwidth.\n", _repetitionProfiler->minResults.name);
+	}
+	return success;
+}
 
-	// Run the repetition profiling a second time to check that the internal 
-	// reset works appropriately. The profiling results should be close to the
-	// first run.
-	TestFunction_FixedRepetitionTesting();
+/*!
+@brief Tests the built-in memory benchmarks on small buffers.
+@details Runs every sequential operation with every supported instruction set,
+		 then a random pointer chase in a working set that fits in the L2 cache.
+		 Every benchmark runs alone so that its results can be checked.
+@return Whether every kernel was dispatched and had a non-zero bandwidth.
+*/
+bool TestFunction_MemoryBenchmarks()
+{
+	const char* blockNames[Profile::MemoryOperation_Count] = { "SequentialRead", "SequentialWrite", "SequentialCopy", "SequentialWriteNonTemporal" };
+	Profile::u64 byteCount = 64 * 1024;
 
-	TestFunction_BestPerfSearch();
+	Profile::u16 repetitionCount = 3;
+	Profile::ProfilerResults* results = new Profile::ProfilerResults[repetitionCount];
+	Profile::RepetitionProfiler* repetitionProfiler = new Profile::RepetitionProfiler();
+	repetitionProfiler->SetRepetitionResults(results);
 
-	
-	free(arr);
-	delete profiler;
+	bool success = true;
+	for (Profile::u8 operation = 0; operation < Profile::MemoryOperation_Count; ++operation)
+	{
+		for (Profile::u8 isa = 0; isa < Profile::KernelISA_Count; ++isa)
+		{
+			if (!Profile::Kernels::IsSupported((Profile::KernelISA)isa))
+			{
+				continue;
+			}
 
-	return 0;
+			Profile::SequentialMemoryTest memoryTest((Profile::MemoryOperation)operation, (Profile::KernelISA)isa, byteCount);
+			repetitionProfiler->ClearRepetitionTests();
+			repetitionProfiler->PushBackRepetitionTest(&memoryTest);
+			repetitionProfiler->FixedCountRepetitionTesting(repetitionCount, false, true);
+			success = CheckMemoryBenchmark(repetitionProfiler, blockNames[operation],
+				operation == Profile::MemoryOperation_Copy ? 2 * byteCount : byteCount) && success;
+		}
+	}
+
+	Profile::PointerChaseTest chaseTest(byteCount, 64, true, 1 << 14);
+	repetitionProfiler->ClearRepetitionTests();
+	repetitionProfiler->PushBackRepetitionTest(&chaseTest);
+	repetitionProfiler->FixedCountRepetitionTesting(repetitionCount, false, true);
+	success = CheckMemoryBenchmark(repetitionProfiler, "PointerChase", chaseTest.stepCount * sizeof(void*)) && success;
+
+	const Profile::ProfileTrackResult& track = repetitionProfiler->minResults.tracks[0];
+	if (track.blockCount)
+	{
+		printf("%s: %.2fns per load\n", chaseTest.label, chaseTest.GetLatencyInNs(track.timings[0].elapsedSec));
+	}
+
+	delete[] results;
+	delete repetitionProfiler;
+	return success;
+}
+
+/*!
+@brief Tests the InterleavedRepetitionTesting function of the RepetitionProfiler.
+@details Compares the profiling of a whole function against the profiling of
+		 every iteration of its loop, the latter being the baseline. Every test
+		 must get one sample per round, and the baseline a speedup of exactly 1
+		 in every round.
+@return Whether every test got its samples and the baseline its speedups.
+*/
+bool TestFunction_InterleavedRepetitionTesting()
+{
+	Profile::u64* arr = (Profile::u64*)malloc(sizeof(Profile::u64) * 8192);
+
+	Profile::u16 roundCount = 10;
+	Profile::ProfilerResults* results = new Profile::ProfilerResults[2 * roundCount];
+	Profile::RepetitionProfiler* repetitionProfiler = new Profile::RepetitionProfiler();
+
+	RepetitionTest_TestFunction_ProfileBlock repetitiontest("Profile every iteration", arr, 8192);
+	RepetitionTest_TestFunction_ProfileFunction repetitiontest2("Profile the function", arr, 8192);
+	repetitionProfiler->PushBackRepetitionTest(&repetitiontest);
+	repetitionProfiler->PushBackRepetitionTest(&repetitiontest2);
+
+	repetitionProfiler->SetRepetitionResults(results);
+	repetitionProfiler->InterleavedRepetitionTesting(roundCount, 0);
+
+	if (std::filesystem::create_directories("./ProfileResults"))
+	{
+		printf("\nCreating directory ./ProfileResults\n");
+	}
+	repetitionProfiler->ExportComparisonToCSV("./ProfileResults/Comparison.csv");
+
+	bool success = repetitionProfiler->comparisons.size() == 2;
+	for (const Profile::RepetitionComparison& comparison : repetitionProfiler->comparisons)
+	{
+		success = success && comparison.elapsedStatistics.sampleCount == roundCount && comparison.speedupStatistics.sampleCount == roundCount;
+		if (comparison.testIdx == comparison.baselineIdx)
+		{
+			success = success && comparison.speedupStatistics.min == 1.0 && comparison.speedupStatistics.max == 1.0;
+		}
+	}
+	if (!success)
+	{
+		printf("ERROR: The interleaved tests did not get one sample per round, or the baseline a speedup of 1.\n");
+	}
+
+	delete[] results;
+	delete repetitionProfiler;
+	free(arr);
+	return success;
+}
+
+/*!
+@brief Tests the robust statistics used by the RepetitionProfiler on a known series.
+@details The series has one sample far away from the others that must be flagged
+		 as an outlier, while the median must not move. A series with more than
+		 half of equal samples has a MAD of 0, and must still flag its 30% spike,
+		 but not the samples next to the median. Equal samples have no outlier.
+@return Whether the statistics are the expected ones.
+*/
+bool TestFunction_RobustStatistics()
+{
+	Profile::f64 samples[] = { 104.0, 100.0, 101.0, 99.0, 100.0, 102.0, 98.0, 100.0, 5000.0, 101.0, 99.0 };
+	Profile::f64 scratch[sizeof(samples) / sizeof(samples[0])];
+	Profile::u64 sampleCount = sizeof(samples) / sizeof(samples[0]);
+
+	Profile::RandomGenerator generator(42);
+	Profile::RobustStatistics statistics;
+	statistics.Compute(samples, sampleCount, scratch, generator);
+
+	printf("\n---- Robust statistics test ----\n");
+	statistics.Report(1.0, " cycles");
+	printf("\n");
+
+	bool success = statistics.median == 100.0 && statistics.outlierCount == 1 &&
+		statistics.confidenceLow <= statistics.median && statistics.median <= statistics.confidenceHigh &&
+		statistics.trimmedMean < statistics.mean;
+
+	Profile::f64 constantSamples[] = { 100.0, 100.0, 100.0, 100.0, 100.0, 100.0, 101.0, 99.0, 130.0 };
+	statistics.Compute(constantSamples, sizeof(constantSamples) / sizeof(constantSamples[0]), scratch, generator);
+	success = success && statistics.medianAbsoluteDeviation == 0.0 && statistics.outlierCount == 1 &&
+		statistics.IsOutlier(130.0) && !statistics.IsOutlier(101.0);
+
+	Profile::f64 equalSamples[] = { 100.0, 100.0, 100.0, 100.0 };
+	statistics.Compute(equalSamples, sizeof(equalSamples) / sizeof(equalSamples[0]), scratch, generator);
+	success = success && statistics.outlierCount == 0;
+	if (!success)
+	{
+		printf("ERROR: Unexpected robust statistics.\n");
+	}
+	return success;
+}
+
+/*!
+@brief Tests publishing the profiler in a shared memory segment and reading it back.
+@details The blocks read back from the segment must match the ones of the profiler.
+@return Whether the snapshot matches the profiler.
+*/
+bool TestFunction_LiveSnapshot(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Live Snapshot Test");
+	profiler->SetTrackName(0, "Live");
+	profiler->Initialize();
+	TestFunction_ProfileFunction(_arr, _count);
+	TestFunction_Bandwidth(_arr, _count);
+
+	Profile::LiveSnapshotPublisher publisher;
+	Profile::LiveSnapshotReader reader;
+	bool success = publisher.Open("/CppProfiler_Tests");
+	if (!success)
+	{
+		printf("ERROR: Could not open the live snapshot segment.\n");
+	}
+	else
+	{
+		success = publisher.Publish(*profiler);
+		if (!success)
+		{
+			printf("ERROR: Could not publish a consistent copy of every track.\n");
+		}
+		success = success && reader.Attach("/CppProfiler_Tests") && reader.Read();
+	}
+
+	if (success)
+	{
+		Profile::u32 blockCount = 0;
+		for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+		{
+			blockCount += record.hitCount ? 1 : 0;
+		}
+		const Profile::LiveTrackSnapshot* track = reader.GetTrack(0);
+		success = track->blockCount == blockCount;
+		printf("\n---- Live Snapshot: %s (%llu publication(s)) ----\n", reader.GetHeader()->profilerName, reader.GetHeader()->publishCount);
+		for (Profile::u32 i = 0; i < track->blockCount; ++i)
+		{
+			const Profile::LiveBlockSnapshot* block = reader.GetBlock(0, i);
+			const Profile::ProfileBlockRecorder& record = profiler->tracks[0].timings[block->recorderIdx];
+			success = success && block->hitCount == record.hitCount && block->elapsed == record.elapsed;
+			printf("%s[%llu]: %llu\n", block->name, block->hitCount, block->elapsed);
+		}
+		if (!success)
+		{
+			printf("ERROR: The live snapshot does not match the profiler.\n");
+		}
+	}
+
+	profiler->End();
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief Tests Profile::ProfilerResults::CaptureLive while a worker thread keeps
+		opening and closing blocks on its own profiler.
+@details The worker keeps an outer block open for the whole test and profiles
+		 the writes of an array in inner blocks. In a consistent capture, the
+		 elapsed time of the track is the sum of the elapsed time of its blocks,
+		 the open outer block included, and the counts never go backwards.
+@param _arr The array written by the worker.
+@param _count The number of elements of the array.
+@return Whether all the captures were consistent.
+*/
+bool TestFunction_ConcurrentCapture(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* workerProfiler = new Profile::Profiler();
+	workerProfiler->SetProfilerName("Concurrent Capture Test");
+	workerProfiler->SetTrackName(0, "Worker");
+	workerProfiler->Initialize();
+
+	std::atomic<bool> stop = false;
+	std::thread worker([&]()
+	{
+		Profile::SetThreadProfiler(workerProfiler);
+		PROFILE_BLOCK_TIME(TestFunction_ConcurrentCapture_Outer, 0);
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			PROFILE_BLOCK_TIME(TestFunction_ConcurrentCapture_Inner, 0);
+			for (Profile::u64 i = 0; i < _count / 64; ++i)
+			{
+				_arr[i] = i;
+			}
+		}
+	});
+
+	Profile::ProfilerResults* results = new Profile::ProfilerResults();
+	bool success = true;
+	Profile::u64 previousElapsed = 0;
+	Profile::u64 previousHitCount = 0;
+	for (int capture = 0; capture < 20 && success; ++capture)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		success = results->CaptureLive(workerProfiler);
+
+		for (Profile::u32 i = 0; i < results->trackCount && success; ++i)
+		{
+			const Profile::ProfileTrackResult& track = results->tracks[i];
+			Profile::u64 blockElapsed = 0;
+			Profile::u64 hitCount = 0;
+			for (Profile::u32 j = 0; j < track.blockCount; ++j)
+			{
+				blockElapsed += track.timings[j].elapsed;
+				hitCount += track.timings[j].hitCount;
+			}
+			success = track.elapsed == blockElapsed && track.elapsed >= previousElapsed && hitCount >= previousHitCount;
+			previousElapsed = track.elapsed;
+			previousHitCount = hitCount;
+		}
+	}
+
+	stop = true;
+	worker.join();
+
+	printf("\n---- Concurrent Capture: %llu block execution(s) captured over %fms ----\n",
+		previousHitCount, 1000.0 * results->elapsedSec);
+	if (!success)
+	{
+		printf("ERROR: A live capture was not consistent.\n");
+	}
+
+	delete results;
+	delete workerProfiler;
+	return success;
+}
+
+/*!
+@brief Tests Profile::RollingWindow by rotating it by hand after a known
+		number of executions of TestFunction_ProfileFunction.
+@details Every interval must hold exactly the executions that happened
+		 since the previous rotation, and the ring must keep only the most
+		 recent intervals.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the intervals match the executions.
+*/
+bool TestFunction_RollingWindow(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Rolling Window Test");
+	profiler->SetTrackName(0, "Window");
+	profiler->Initialize();
+	TestFunction_ProfileFunction(_arr, _count);
+
+	Profile::RollingWindow window(1000, 3);
+	window.Start(*profiler);
+
+	bool success = true;
+	std::vector<Profile::u64> hitCounts;
+	for (Profile::u32 rotation = 1; rotation <= 5; ++rotation)
+	{
+		Profile::u64 hitCountBefore = 0;
+		for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+		{
+			hitCountBefore += record.hitCount;
+		}
+		for (Profile::u32 i = 0; i < rotation; ++i)
+		{
+			TestFunction_ProfileFunction(_arr, _count / 16);
+		}
+		Profile::u64 hitCountAfter = 0;
+		for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+		{
+			hitCountAfter += record.hitCount;
+		}
+		hitCounts.push_back(hitCountAfter - hitCountBefore);
+		window.Rotate(*profiler);
+	}
+
+	success = window.intervalCount == 3;
+	for (Profile::u32 age = 0; age < window.intervalCount && success; ++age)
+	{
+		Profile::u64 hitCount = 0;
+		for (const Profile::WindowBlockDelta& block : window.GetInterval(age).blocks)
+		{
+			hitCount += block.delta.hitCount;
+		}
+		success = hitCount == hitCounts[hitCounts.size() - 1 - age] && window.GetInterval(age).end >= window.GetInterval(age).start;
+	}
+
+	printf("\n");
+	window.Report(window.intervalCount);
+	window.ExportToCSV("./ProfileResults/RollingWindow.csv");
+	if (!success)
+	{
+		printf("ERROR: The intervals of the rolling window do not match the executions.\n");
+	}
+
+	profiler->End();
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief A leaf of the call tree test, reached through two paths.
+*/
+void TestFunction_CallTree_Parse(Profile::u64 _arr[], Profile::u64 _count)
+{
+	PROFILE_FUNCTION_TIME(0);
+
+	for (Profile::u64 i = 0; i < _count; ++i)
+	{
+		_arr[i] = i;
+	}
+}
+
+/*!
+@brief Calls TestFunction_CallTree_Parse on the whole array.
+*/
+void TestFunction_CallTree_LoadConfig(Profile::u64 _arr[], Profile::u64 _count)
+{
+	PROFILE_FUNCTION_TIME(0);
+	TestFunction_CallTree_Parse(_arr, _count);
+}
+
+/*!
+@brief Calls TestFunction_CallTree_Parse on a part of the array, several times.
+*/
+void TestFunction_CallTree_Update(Profile::u64 _arr[], Profile::u64 _count)
+{
+	PROFILE_FUNCTION_TIME(0);
+	for (int i = 0; i < 4; ++i)
+	{
+		TestFunction_CallTree_Parse(_arr, _count / 16);
+	}
+}
+
+/*!
+@brief Tests the call tree of a track and its reports.
+@details Every execution of a block must be in exactly one node of the tree:
+		 for every block, the sums of the hit counts and of the elapsed times
+		 of its nodes are the ones of the block.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the tree matches the blocks.
+*/
+bool TestFunction_CallTree(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Call Tree Test");
+	profiler->SetTrackName(0, "Calls");
+	profiler->Initialize();
+	TestFunction_CallTree_LoadConfig(_arr, _count);
+	for (int i = 0; i < 3; ++i)
+	{
+		TestFunction_CallTree_Update(_arr, _count);
+	}
+	profiler->End();
+
+	bool success = true;
+	const Profile::ProfileTrack& track = profiler->tracks[0];
+	for (Profile::u32 j = 0; j < NB_TIMINGS && success; ++j)
+	{
+		Profile::u64 hitCount = 0;
+		Profile::u64 elapsed = 0;
+		for (Profile::u32 i = 0; i < track.callTree.nodeCount; ++i)
+		{
+			if (track.callTree.nodes[i].profileBlockRecorderIdx == j)
+			{
+				hitCount += track.callTree.nodes[i].hitCount;
+				elapsed += track.callTree.nodes[i].elapsed;
+			}
+		}
+		success = hitCount == track.timings[j].hitCount && elapsed == track.timings[j].elapsed;
+	}
+
+	profiler->ReportCallTree();
+	profiler->ExportFoldedStacks("./ProfileResults/CallTree.folded");
+	if (!success)
+	{
+		printf("ERROR: The call tree does not match the blocks of the track.\n");
+	}
+
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief Waits for a Profile::ProfileDumper to reach a number of dumps.
+@param _dumper The dumper.
+@param _dumpCount The number of dumps to wait for.
+@return Whether the dumps were taken within 5 seconds.
+*/
+bool WaitForDumps(const Profile::ProfileDumper& _dumper, Profile::u64 _dumpCount)
+{
+	for (int i = 0; i < 500 && _dumper.dumpCount.load(std::memory_order_acquire) < _dumpCount; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return _dumper.dumpCount.load(std::memory_order_acquire) >= _dumpCount;
+}
+
+/*!
+@brief Tests Profile::ProfileDumper: a dump requested by signal (on POSIX
+		systems), one requested from the code and the periodic ones, along
+		with a direct dump. A second dumper may not listen to the signal.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether all the dumps were taken.
+*/
+bool TestFunction_ProfileDumper(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Dumper Test");
+	profiler->SetTrackName(0, "Dumped");
+	profiler->Initialize();
+	TestFunction_ProfileFunction(_arr, _count);
+
+	Profile::ProfileDumper dumper;
+	bool success = dumper.Start(profiler, "./ProfileResults/Dumps");
+	if (success)
+	{
+		Profile::u64 dumpCount = 0;
+		if (dumper.signalNumber)
+		{
+			raise(dumper.signalNumber);
+			success = WaitForDumps(dumper, ++dumpCount);
+
+			Profile::ProfileDumper otherDumper;
+			if (otherDumper.Start(profiler, "./ProfileResults/Dumps"))
+			{
+				printf("ERROR: Two profile dumpers listen to the same signal.\n");
+				otherDumper.Stop();
+				success = false;
+			}
+		}
+		dumper.RequestDump();
+		success = WaitForDumps(dumper, ++dumpCount) && success;
+		printf("\n---- Profile Dumper: %llu dump(s) requested; last one in %s ----\n", dumpCount, dumper.lastDumpPath);
+		dumper.Stop();
+
+		if (dumper.Start(profiler, "./ProfileResults/Dumps", 0, 20))
+		{
+			//Concurrent with the periodic dumps; the file is not written when the profiler is disabled
+			dumper.Dump();
+			success = WaitForDumps(dumper, 3) && success;
+			dumper.Stop();
+		}
+		else
+		{
+			success = false;
+		}
+	}
+	if (!success)
+	{
+		printf("ERROR: The profile dumper did not take the dumps requested.\n");
+	}
+
+	profiler->End();
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief A minimal scheduler resuming the coroutines after a delay on a pool of
+		threads, so that a coroutine may be resumed on another thread than the
+		one it was suspended on.
+*/
+struct TestScheduler
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct PendingResume
+	{
+		Clock::time_point wakeUpTime;
+		std::coroutine_handle<> handle;
+	};
+
+	/*!
+	@brief The awaiter suspending a coroutine for a duration.
+	*/
+	struct SleepAwaiter
+	{
+		TestScheduler* ptr_scheduler = nullptr;
+		Clock::duration duration;
+
+		bool await_ready() { return false; }
+
+		void await_suspend(std::coroutine_handle<> _handle)
+		{
+			{
+				std::lock_guard<std::mutex> lock(ptr_scheduler->mutex);
+				ptr_scheduler->pendingResumes.push_back({ Clock::now() + duration, _handle });
+			}
+			ptr_scheduler->wakeUp.notify_one();
+		}
+
+		void await_resume() {}
+	};
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::vector<PendingResume> pendingResumes;
+	bool stopRequested = false;
+	std::vector<std::thread> threads;
+
+	TestScheduler(Profile::u32 _threadCount)
+	{
+		for (Profile::u32 i = 0; i < _threadCount; ++i)
+		{
+			threads.emplace_back([this]() { Run(); });
+		}
+	}
+
+	~TestScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopRequested = true;
+		}
+		wakeUp.notify_all();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	SleepAwaiter Sleep(std::chrono::milliseconds _duration)
+	{
+		return SleepAwaiter{ this, _duration };
+	}
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stopRequested)
+		{
+			auto next = std::min_element(pendingResumes.begin(), pendingResumes.end(),
+				[](const PendingResume& _a, const PendingResume& _b) { return _a.wakeUpTime < _b.wakeUpTime; });
+			if (next == pendingResumes.end())
+			{
+				wakeUp.wait(lock);
+			}
+			else if (next->wakeUpTime > Clock::now())
+			{
+				wakeUp.wait_until(lock, next->wakeUpTime);
+			}
+			else
+			{
+				std::coroutine_handle<> handle = next->handle;
+				pendingResumes.erase(next);
+				lock.unlock();
+				handle.resume();
+				lock.lock();
+			}
+		}
+	}
+};
+
+/*!
+@brief A fire-and-forget coroutine: it starts immediately and destroys itself
+		when it ends.
+*/
+struct TestTask
+{
+	struct promise_type
+	{
+		TestTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+/*!
+@brief A coroutine processing a request: it fills the array and waits for
+		the scheduler between the steps, in a span paused while it waits.
+@param _scheduler The scheduler resuming the coroutine.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@param _stepCount The number of steps (and suspensions) of the request.
+@param _doneCount Incremented once the span ended.
+*/
+TestTask TestFunction_Coroutine_Request(TestScheduler& _scheduler, Profile::u64 _arr[], Profile::u64 _count,
+	Profile::u32 _stepCount, std::atomic<Profile::u32>& _doneCount)
+{
+	{
+		PROFILE_SPAN(span, "TestFunction_Coroutine_Request");
+		for (Profile::u32 step = 0; step < _stepCount; ++step)
+		{
+			for (Profile::u64 i = 0; i < _count; ++i)
+			{
+				_arr[i] = i + step;
+			}
+			co_await span.Await(_scheduler.Sleep(std::chrono::milliseconds(5)));
+		}
+	}
+	_doneCount.fetch_add(1, std::memory_order_release);
+}
+
+/*!
+@brief Tests Profile::ProfileSpan with coroutines resumed on a pool of threads.
+@details Every suspension must be counted and last at least the duration of
+		 the sleep, and the active time of the spans must be less than their
+		 total time.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the spans recorded the suspensions.
+*/
+bool TestFunction_CoroutineSpans(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Coroutine Spans Test");
+
+	const Profile::u32 coroutineCount = 8;
+	const Profile::u32 stepCount = 3;
+	std::atomic<Profile::u32> doneCount = 0;
+	{
+		TestScheduler scheduler(2);
+		Profile::u64 sliceCount = _count / coroutineCount;
+		for (Profile::u32 i = 0; i < coroutineCount; ++i)
+		{
+			TestFunction_Coroutine_Request(scheduler, _arr + i * sliceCount, sliceCount, stepCount, doneCount);
+		}
+		for (int i = 0; i < 500 && doneCount.load(std::memory_order_acquire) < coroutineCount; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	bool success = doneCount.load(std::memory_order_acquire) == coroutineCount;
+
+	//The span is only registered when the profiler is enabled
+	for (Profile::SpanRecorder& span : profiler->spans)
+	{
+		if (span.spanName && strcmp(span.spanName, "TestFunction_Coroutine_Request") == 0)
+		{
+			Profile::u64 minSuspendedElapsed = coroutineCount * stepCount * Profile::Timer::GetEstimatedCPUFreq() * 5 / 1000;
+			success = success && span.hitCount == coroutineCount && span.suspendCount == coroutineCount * stepCount &&
+				span.suspendedElapsed >= minSuspendedElapsed && span.suspendedElapsed < span.elapsed;
+			profiler->ReportSpans();
+			span.Reset();
+		}
+	}
+	if (!success)
+	{
+		printf("ERROR: The spans of the coroutines do not match their suspensions.\n");
+	}
+	return success;
+}
+
+/*!
+@brief Begins the asynchronous span of a request of TestFunction_AsyncSpans.
+@details A template, as a span site in a header would be: every instantiation
+		 has its own static index, but they must all share the statistics of
+		 the call site.
+@param _id The ID of the request.
+*/
+template<typename Request>
+void TestFunction_AsyncSpans_Enqueue([[maybe_unused]] Profile::u64 _id) //Unused when the profiler is disabled
+{
+	PROFILE_ASYNC_SPAN_BEGIN("TestFunction_AsyncSpans_Queue", _id);
+}
+
+/*!
+@brief Tests the asynchronous spans with a queue: the requests are enqueued by
+		the main thread and dequeued by a worker, the span of a request measuring
+		its time in the queue.
+@details All the spans must end once, none must remain in flight and ending
+		 an unknown ID must fail. The spans are begun by two instantiations of
+		 the same template, which must share one slot. The timeline of the spans
+		 is exported with a flow from the main thread to the worker for every request.
+@return Whether the spans match the requests.
+*/
+bool TestFunction_AsyncSpans()
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Async Spans Test");
+	profiler->Initialize();
+
+	const Profile::u64 requestCount = 64;
+	std::mutex mutex;
+	std::condition_variable available;
+	std::vector<Profile::u64> queue;
+	std::thread worker([&]()
+		{
+			for (Profile::u64 processedCount = 0; processedCount < requestCount; ++processedCount)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				available.wait(lock, [&queue]() { return !queue.empty(); });
+				[[maybe_unused]] Profile::u64 id = queue.front(); //Unused when the profiler is disabled
+				queue.erase(queue.begin());
+				lock.unlock();
+				PROFILE_ASYNC_SPAN_END(id);
+			}
+		});
+	for (Profile::u64 id = 1; id <= requestCount; ++id)
+	{
+		if (id % 2)
+		{
+			TestFunction_AsyncSpans_Enqueue<Profile::u32>(id);
+		}
+		else
+		{
+			TestFunction_AsyncSpans_Enqueue<Profile::u64>(id);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(id);
+		}
+		available.notify_one();
+		if (id % 8 == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	worker.join();
+	profiler->End();
+
+	bool success = !Profile::EndAsyncSpan(requestCount + 1);
+
+	//The span is only registered when the profiler is enabled
+	Profile::u32 slotCount = 0;
+	for (Profile::SpanRecorder& span : profiler->spans)
+	{
+		if (span.spanName && strcmp(span.spanName, "TestFunction_AsyncSpans_Queue") == 0)
+		{
+			++slotCount;
+			Profile::u64 histogramCount = 0;
+			for (Profile::u64 count : span.histogram)
+			{
+				histogramCount += count;
+			}
+			success = success && span.hitCount == requestCount && span.openCount == 0 && histogramCount == requestCount;
+			profiler->ReportSpans();
+			profiler->ExportTimeline("./ProfileResults/Timeline.json");
+			span.Reset();
+		}
+	}
+	success = success && slotCount <= 1;
+	if (!success)
+	{
+		printf("ERROR: The asynchronous spans do not match the requests of the queue.\n");
+	}
+	return success;
+}
+
+/*!
+@brief The body of the runtime switch benchmark, profiled.
+*/
+void TestFunction_RuntimeSwitch_Instrumented(Profile::u64& _state, Profile::u64 _i)
+{
+	PROFILE_BLOCK_TIME(TestFunction_RuntimeSwitch_Block, 0);
+	_state = _state * 3 + _i;
+}
+
+/*!
+@brief The body of the runtime switch benchmark, as if the profiling was compiled out.
+*/
+void TestFunction_RuntimeSwitch_CompiledOut(Profile::u64& _state, Profile::u64 _i)
+{
+	_state = _state * 3 + _i;
+}
+
+/*!
+@brief Measures the best time per call of a benchmark body over several runs.
+@param _body The body, called with the state of the benchmark and the iteration index.
+@param _count The number of calls per run.
+@return The best time per call in CPU timer units.
+*/
+template<typename Body>
+Profile::f64 TestFunction_RuntimeSwitch_Measure(Body _body, Profile::u64 _count)
+{
+	Profile::u64 bestElapsed = ~0ull;
+	Profile::u64 state = 0;
+	for (int run = 0; run < 10; ++run)
+	{
+		Profile::u64 start = Profile::Timer::GetCPUTimer();
+		for (Profile::u64 i = 0; i < _count; ++i)
+		{
+			_body(state, i);
+		}
+		Profile::u64 elapsed = Profile::Timer::GetCPUTimer() - start;
+		bestElapsed = elapsed < bestElapsed ? elapsed : bestElapsed;
+	}
+	//Keeps the state alive so that the loop is not optimized away
+	if (state == 1)
+	{
+		printf("\n");
+	}
+	return (Profile::f64)bestElapsed / (Profile::f64)_count;
+}
+
+/*!
+@brief Tests Profile::RuntimeSwitch and benchmarks the cost of a block
+		disabled at runtime against the same code without the block.
+@details The blocks of a track must not be recorded when the track or the
+		 profiling is disabled, the signal (on POSIX systems) must toggle
+		 the profiling, concurrent toggles must not be lost, and a disabled
+		 block must cost at most a few CPU timer ticks.
+@return Whether the switch behaves as expected.
+*/
+bool TestFunction_RuntimeSwitch()
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Runtime Switch Test");
+	profiler->SetTrackName(0, "Switched");
+	profiler->Initialize();
+
+	Profile::u64 state = 0;
+	const Profile::u64 callCount = 1000;
+	auto callInstrumented = [&state, callCount]()
+		{
+			for (Profile::u64 i = 0; i < callCount; ++i)
+			{
+				TestFunction_RuntimeSwitch_Instrumented(state, i);
+			}
+		};
+	auto getHitCount = [profiler]()
+		{
+			Profile::u64 hitCount = 0;
+			for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+			{
+				hitCount += record.hitCount;
+			}
+			return hitCount;
+		};
+
+	callInstrumented();
+	Profile::u64 hitCount = getHitCount();
+	Profile::RuntimeSwitch::SetTrackEnabled(0, false);
+	callInstrumented();
+	bool success = getHitCount() == hitCount && !Profile::RuntimeSwitch::IsTrackActive(0);
+	Profile::RuntimeSwitch::SetTrackEnabled(0, true);
+	Profile::RuntimeSwitch::SetEnabled(false);
+	callInstrumented();
+	success = success && getHitCount() == hitCount && !Profile::RuntimeSwitch::IsTrackActive(0);
+
+	int signalNumber = Profile::RuntimeSwitch::GetDefaultSignal();
+	if (signalNumber && Profile::RuntimeSwitch::InstallToggleSignal(signalNumber))
+	{
+		raise(signalNumber);
+		success = success && Profile::RuntimeSwitch::IsEnabled();
+		raise(signalNumber);
+		success = success && !Profile::RuntimeSwitch::IsEnabled();
+	}
+
+	//An even number of toggles from each thread leaves the profiling disabled
+	std::vector<std::thread> togglers;
+	for (Profile::u32 i = 0; i < 4; ++i)
+	{
+		togglers.emplace_back([]()
+			{
+				for (Profile::u32 j = 0; j < 1000; ++j)
+				{
+					Profile::RuntimeSwitch::Toggle();
+				}
+			});
+	}
+	for (std::thread& toggler : togglers)
+	{
+		toggler.join();
+	}
+	success = success && !Profile::RuntimeSwitch::IsEnabled() && !Profile::RuntimeSwitch::IsTrackActive(0);
+	if (!success)
+	{
+		printf("ERROR: The runtime switch did not stop the profiling.\n");
+	}
+
+	const Profile::u64 benchmarkCount = 1 << 20;
+	//The lambdas let the bodies be inlined in the loops of the benchmark
+	auto instrumented = [](Profile::u64& _state, Profile::u64 _i) { TestFunction_RuntimeSwitch_Instrumented(_state, _i); };
+	auto compiledOut = [](Profile::u64& _state, Profile::u64 _i) { TestFunction_RuntimeSwitch_CompiledOut(_state, _i); };
+	Profile::f64 disabledTime = TestFunction_RuntimeSwitch_Measure(instrumented, benchmarkCount);
+	Profile::RuntimeSwitch::SetEnabled(true);
+	Profile::f64 enabledTime = TestFunction_RuntimeSwitch_Measure(instrumented, benchmarkCount);
+	Profile::f64 compiledOutTime = TestFunction_RuntimeSwitch_Measure(compiledOut, benchmarkCount);
+	printf("\n---- Runtime Switch: %.2f CPU timer ticks per call compiled out, %.2f disabled at runtime (+%.2f), %.2f enabled ----\n",
+		compiledOutTime, disabledTime, disabledTime - compiledOutTime, enabledTime);
+	//A load and a branch, with a wide margin for the noise of the measure
+	const Profile::f64 maxDisabledOverhead = 20.0;
+	if (disabledTime - compiledOutTime > maxDisabledOverhead)
+	{
+		printf("ERROR: A block disabled at runtime costs more than %.0f CPU timer ticks.\n", maxDisabledOverhead);
+		success = false;
+	}
+
+	profiler->End();
+	profiler->ClearTracks();
+	return success;
+}
+
+void TestFunction_DynamicTracks_Work([[maybe_unused]] Profile::TrackHandle _track, Profile::u64 _arr[], Profile::u64 _count)
+{
+	PROFILE_FUNCTION_TIME_IN_TRACK(_track);
+	PROFILE_BLOCK_TIME_IN_TRACK(Slice, _track); //A second block in the same scope
+	for (Profile::u64 i = 0; i < _count; ++i)
+	{
+		PROFILE_BLOCK_TIME_IN_TRACK(Element, _track);
+		_arr[i] = _arr[i] * 3 + i;
+	}
+}
+
+bool TestFunction_DynamicTracks(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Dynamic Tracks Test");
+	profiler->Initialize();
+
+	//More workers than static tracks, each with its own track
+	const Profile::u32 workerCount = NB_TRACKS + 4;
+	std::vector<Profile::TrackHandle> handles(workerCount);
+	bool success = true;
+	for (Profile::u32 i = 0; i < workerCount; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "Worker %u", i);
+		handles[i] = profiler->RegisterTrack(name);
+		success = success && handles[i].IsValid() && profiler->RegisterTrack(name).trackIdx == handles[i].trackIdx;
+	}
+	//A name too long for the buffer is found again in the track it was truncated in
+	const char* longName = "Worker whose name is too long for the buffer of a track";
+	success = success && profiler->RegisterTrack(longName).trackIdx == profiler->RegisterTrack(longName).trackIdx;
+
+	Profile::u64 sliceCount = _count / workerCount;
+	std::vector<std::thread> workers;
+	for (Profile::u32 i = 0; i < workerCount; ++i)
+	{
+		workers.emplace_back(TestFunction_DynamicTracks_Work, handles[i], _arr + i * sliceCount, sliceCount);
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	profiler->End();
+
+	Profile::ProfilerResults* results = new Profile::ProfilerResults();
+	results->Capture(profiler);
+	for (Profile::u32 i = 0; i < results->trackCount; ++i)
+	{
+		const Profile::ProfileTrackResult& track = results->tracks[i];
+		for (Profile::u32 j = 0; j < track.blockCount; ++j)
+		{
+			if (strcmp(track.timings[j].blockName, "Element") == 0)
+			{
+				success = success && track.timings[j].hitCount == sliceCount && track.timings[j].trackIdx >= NB_TRACKS;
+			}
+			else if (strcmp(track.timings[j].blockName, "Slice") == 0)
+			{
+				success = success && track.timings[j].hitCount == 1 && track.timings[j].trackIdx >= NB_TRACKS;
+			}
+		}
+	}
+	results->Report();
+	results->ExportToCSV("./ProfileResults/DynamicTracks.csv");
+	delete results;
+
+	if (!success)
+	{
+		printf("ERROR: The blocks of the tracks registered at runtime were not recorded in their tracks.\n");
+	}
+	profiler->ClearTracks();
+	return success;
+}
+
+bool TestFunction_CountersAndGauges(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Counters And Gauges Test");
+	profiler->SetTrackName(0, "Main");
+	profiler->Initialize();
+
+	Profile::s64 queueDepth = 0;
+	for (Profile::u64 i = 0; i < _count; ++i)
+	{
+		PROFILE_BLOCK_TIME(Element, 0);
+		_arr[i] = _arr[i] * 5 + i;
+		PROFILE_COUNTER_INCREMENT(ProcessedElements, 0);
+		if (i % 4 == 0)
+		{
+			PROFILE_COUNTER_ADD(ProcessedQuads, 0, 4);
+			queueDepth += 3;
+		}
+		else
+		{
+			queueDepth -= 1;
+		}
+		PROFILE_GAUGE_SET(QueueDepth, 0, queueDepth);
+	}
+	profiler->End();
+
+	Profile::ProfilerResults* results = new Profile::ProfilerResults();
+	results->Capture(profiler);
+	bool success = true;
+	const Profile::ProfileTrackResult& track = results->tracks[0];
+	for (Profile::u32 j = 0; j < track.blockCount; ++j)
+	{
+		const Profile::ProfileBlockResult& block = track.timings[j];
+		if (block.blockName == nullptr)
+		{
+			continue;
+		}
+		if (strcmp(block.blockName, "ProcessedElements") == 0)
+		{
+			success = success && block.kind == Profile::RecorderKind_Counter && block.value == (Profile::s64)_count && block.hitCount == _count;
+		}
+		else if (strcmp(block.blockName, "ProcessedQuads") == 0)
+		{
+			success = success && block.kind == Profile::RecorderKind_Counter && block.value == (Profile::s64)((_count + 3) / 4 * 4);
+		}
+		else if (strcmp(block.blockName, "QueueDepth") == 0)
+		{
+			success = success && block.kind == Profile::RecorderKind_Gauge && block.value == queueDepth && block.maxValue >= block.value && block.minValue <= block.value;
+		}
+	}
+	results->Report();
+	results->ExportToCSV("./ProfileResults/CountersAndGauges.csv");
+	delete results;
+
+	if (!success)
+	{
+		printf("ERROR: The counters and gauges did not record the expected values.\n");
+	}
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief Tests Profile::FrameProfiler with frames of equal work followed by a
+		frame with much more work.
+@details The last frame must be detected as a spike and kept with the blocks
+		 executed during it, and only those. A frame without work must have
+		 no block.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the spike was detected and kept.
+*/
+bool TestFunction_FrameProfiler(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Frame Profiler Test");
+	profiler->SetTrackName(0, "Frames");
+	profiler->Initialize();
+
+	const Profile::u32 frameCount = 16;
+	Profile::FrameProfiler frames(frameCount, 0.0, 4.0, 4);
+	frames.Start();
+	frames.BeginFrame(*profiler);
+	for (Profile::u32 i = 0; i < frameCount; ++i)
+	{
+		TestFunction_ProfileFunction(_arr, _count / 64);
+		frames.NextFrame(*profiler);
+	}
+	TestFunction_ProfileFunction(_arr, _count);
+	bool isSpike = frames.EndFrame(*profiler);
+
+	Profile::u64 hitCount = 0;
+	for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+	{
+		hitCount += record.kind == Profile::RecorderKind_Block ? record.hitCount : 0;
+	}
+	bool success = isSpike && frames.spikeCount > 0 && frames.GetSpike(0).frameIdx == frameCount && frames.frameCount == frameCount;
+	if (success)
+	{
+		//Every frame executed the same blocks, once per frame
+		Profile::u64 frameHitCount = 0;
+		for (const Profile::WindowBlockDelta& block : frames.GetSpike(0).blocks)
+		{
+			frameHitCount += block.delta.hitCount;
+		}
+		success = frameHitCount * (frameCount + 1) == hitCount;
+	}
+	//A frame without work has no block
+	frames.BeginFrame(*profiler);
+	frames.EndFrame(*profiler);
+	success = success && frames.GetFrame(0).blocks.empty();
+
+	printf("\n");
+	frames.Report();
+	frames.ExportToCSV("./ProfileResults/Frames.csv");
+	frames.ExportSpikesToCSV("./ProfileResults/FrameSpikes.csv");
+	if (!success)
+	{
+		printf("ERROR: The slow frame was not kept as a spike.\n");
+	}
+
+	profiler->End();
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief A request handler watched by a tail capture, slow when asked to.
+*/
+void TestFunction_TailCapture_Handler(Profile::u64 _arr[], Profile::u64 _count, bool _isSlow)
+{
+	PROFILE_FUNCTION_TIME_TAIL_CAPTURE(0, 2000);
+	TestFunction_ProfileFunction(_arr, _count);
+	if (_isSlow)
+	{
+		PROFILE_BLOCK_TIME(TestFunction_TailCapture_Wait, 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+/*!
+@brief Tests Profile::TailCaptureScope with fast requests and one slow request.
+@details Only the slow request must be captured, with the blocks it executed
+		 and the handler itself as the last one. Two tail captures in the same
+		 scope must both be captured.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the slow request, and only it, was captured.
+*/
+bool TestFunction_TailCapture(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Tail Capture Test");
+	profiler->SetTrackName(0, "Requests");
+	profiler->Initialize();
+	Profile::ClearTailCaptures();
+
+	const Profile::u32 requestCount = 64;
+	for (Profile::u32 i = 0; i < requestCount; ++i)
+	{
+		TestFunction_TailCapture_Handler(_arr, _count / 1024, i == requestCount / 2);
+	}
+	profiler->End();
+
+	bool success = true;
+	std::vector<Profile::TailCapture> captures;
+	Profile::GetTailCaptures(captures);
+	for (const Profile::TailCapture& capture : captures)
+	{
+		//Fast requests may be captured too if the thread was preempted
+		bool hasWait = false;
+		for (const Profile::TailEvent& event : capture.events)
+		{
+			hasWait = hasWait || strcmp(event.blockName, "TestFunction_TailCapture_Wait") == 0;
+		}
+		success = success && !capture.events.empty() && capture.events.back().blockName == capture.blockName &&
+			capture.end - capture.start > capture.threshold;
+		if (hasWait)
+		{
+			success = success && capture.events.size() == 3 && capture.droppedEventCount == 0;
+		}
+	}
+
+	//Two tail captures in the same scope: the inner one ends, and is captured, first
+	Profile::u64 captureCount = Profile::GetTailCaptures(captures);
+	{
+		PROFILE_BLOCK_TIME_TAIL_CAPTURE(TestFunction_TailCapture_Outer, 0, 0);
+		PROFILE_BLOCK_TIME_TAIL_CAPTURE(TestFunction_TailCapture_Inner, 0, 0);
+		TestFunction_ProfileFunction(_arr, _count / 1024);
+	}
+	Profile::u64 newCaptureCount = Profile::GetTailCaptures(captures) - captureCount;
+	if (newCaptureCount) //None when the profiler is disabled
+	{
+		success = success && newCaptureCount == 2 && captures.size() >= 2 &&
+			strcmp(captures[captures.size() - 2].blockName, "TestFunction_TailCapture_Inner") == 0 &&
+			strcmp(captures.back().blockName, "TestFunction_TailCapture_Outer") == 0;
+	}
+
+	printf("\n");
+	profiler->ReportTailCaptures();
+	profiler->ExportTimeline("./ProfileResults/TailCaptures.json");
+	if (!success)
+	{
+		printf("ERROR: The tail captures do not match the slow requests.\n");
+	}
+	Profile::ClearTailCaptures();
+	profiler->ClearTracks();
+	return success;
+}
+
+/*!
+@brief Tests the types of Profile::ProfilerSizes and that the test was compiled
+		with the same sizes as the profiling library.
+@return Whether the sizes of the test and of the library match.
+*/
+bool TestFunction_ProfilerSizes()
+{
+	using TinySizes = Profile::ProfilerSizes<1, 256, 16, 16, 255>;
+	using LargeSizes = Profile::ProfilerSizes<300, 65537, 64, 64, 1 << 16>;
+	static_assert(std::is_same_v<TinySizes::TrackIdx, Profile::u8> && std::is_same_v<TinySizes::TimingIdx, Profile::u8>
+		&& std::is_same_v<TinySizes::TimingIt, Profile::u16> && std::is_same_v<TinySizes::CallNodeIdx, Profile::u8>);
+	static_assert(std::is_same_v<LargeSizes::TrackIdx, Profile::u16> && std::is_same_v<LargeSizes::TimingIdx, Profile::u32>
+		&& std::is_same_v<LargeSizes::CallNodeIdx, Profile::u32> && TinySizes::hash != LargeSizes::hash);
+	static_assert(std::is_same_v<NB_TIMINGS_TYPE, Profile::DefaultProfilerSizes::TimingIdx>);
+
+	if (!Profile::s_IsLibraryConfigurationChecked)
+	{
+		printf("ERROR: The test was compiled with other sizes than the profiling library.\n");
+		return false;
+	}
+	return true;
+}
+
+/*!
+@brief Sums the hits of a block in the first track of a profiler.
+*/
+Profile::u64 TestFunction_ProfilerInstances_HitCount(const Profile::Profiler& _profiler, const char* _blockName)
+{
+	for (const Profile::ProfileBlockRecorder& record : _profiler.tracks[0].timings)
+	{
+		if (record.blockName != nullptr && strcmp(record.blockName, _blockName) == 0)
+		{
+			return record.hitCount;
+		}
+	}
+	return 0;
+}
+
+/*!
+@brief Tests two independent profilers bound to the main thread with nested
+		Profile::ProfilerScope, created after the blocks were first executed.
+@details Every profiler must only hold the blocks executed while it was bound,
+		 named after their call site, and the previous profiler must be bound
+		 again at the end of a scope.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the blocks were recorded in the profiler bound at the time.
+*/
+bool TestFunction_ProfilerInstances(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* globalProfiler = Profile::GetProfiler();
+	Profile::Profiler* tenantProfiler = new Profile::Profiler();
+	Profile::Profiler* benchmarkProfiler = new Profile::Profiler();
+	tenantProfiler->SetProfilerName("Tenant");
+	tenantProfiler->SetTrackName(0, "Tenant Main");
+	benchmarkProfiler->SetProfilerName("Nested Benchmark");
+	benchmarkProfiler->SetTrackName(0, "Benchmark Main");
+
+	bool success = true;
+	{
+		Profile::ProfilerScope tenantScope(tenantProfiler);
+		tenantProfiler->Initialize();
+		TestFunction_ProfileFunction(_arr, _count / 16);
+		{
+			Profile::ProfilerScope benchmarkScope(benchmarkProfiler);
+			benchmarkProfiler->Initialize();
+			for (Profile::u32 i = 0; i < 3; ++i)
+			{
+				TestFunction_ProfileFunction(_arr, _count / 16);
+				TestFunction_ProfileBlock(_arr, _count / 16);
+			}
+			benchmarkProfiler->End();
+			success = Profile::GetProfiler() == benchmarkProfiler;
+		}
+		TestFunction_ProfileFunction(_arr, _count / 16);
+		tenantProfiler->End();
+		success = success && Profile::GetProfiler() == tenantProfiler && Profile::GetThreadProfiler() == tenantProfiler;
+	}
+	success = success && Profile::GetProfiler() == globalProfiler && Profile::GetThreadProfiler() == nullptr;
+
+	//Only checked if the blocks were recorded, i.e., if the profiler is enabled
+	Profile::u64 tenantHitCount = TestFunction_ProfilerInstances_HitCount(*tenantProfiler, "TestFunction_ProfileFunction");
+	if (tenantHitCount > 0)
+	{
+		success = success && tenantHitCount == 2 &&
+			TestFunction_ProfilerInstances_HitCount(*benchmarkProfiler, "TestFunction_ProfileFunction") == 3 &&
+			TestFunction_ProfilerInstances_HitCount(*tenantProfiler, "TestFunction_ProfileBlock") == 0;
+	}
+
+	tenantProfiler->Report();
+	benchmarkProfiler->Report();
+	if (!success)
+	{
+		printf("ERROR: The blocks were not recorded in the profiler bound to the thread.\n");
+	}
+	delete benchmarkProfiler;
+	delete tenantProfiler;
+	return success;
+}
+
+/*!
+@brief The types of request of TestFunction_KeyedBlocks_Dispatch.
+*/
+enum class TestRequestType : Profile::u8
+{
+	Read = 0,
+	Write,
+	Delete
+};
+
+/*!
+@brief A request dispatcher profiled with a key per type of request, doing more
+		work for the writes.
+*/
+void TestFunction_KeyedBlocks_Dispatch(Profile::u64 _arr[], Profile::u64 _count, TestRequestType _requestType)
+{
+	PROFILE_FUNCTION_TIME_KEYED(0, _requestType);
+	Profile::u64 count = _requestType == TestRequestType::Write ? _count : _count / 8;
+	for (Profile::u64 i = 0; i < count; ++i)
+	{
+		_arr[i] = _arr[i] * 3 + (Profile::u64)_requestType;
+	}
+}
+
+/*!
+@brief Tests the keyed blocks with the types of request of a dispatcher, named
+		keys next to another keyed block in the same scope, and more size
+		buckets than NB_BLOCK_KEYS.
+@details Every type of request must have its own statistics, and the size
+		 buckets beyond the NB_BLOCK_KEYS first ones must share the overflow slot.
+@param _arr The array to fill.
+@param _count The number of elements of the array.
+@return Whether the keys were recorded in their own slots.
+*/
+bool TestFunction_KeyedBlocks(Profile::u64 _arr[], Profile::u64 _count)
+{
+	Profile::Profiler* profiler = Profile::GetProfiler();
+	profiler->SetProfilerName("Keyed Blocks Test");
+	profiler->SetTrackName(0, "Main");
+	profiler->Initialize();
+
+	for (Profile::u32 i = 0; i < 12; ++i)
+	{
+		TestFunction_KeyedBlocks_Dispatch(_arr, _count / 16, (TestRequestType)(i % 3));
+	}
+	static const char* const tenants[2] = { "small tenant", "large tenant" };
+	for (Profile::u32 i = 0; i < 4; ++i)
+	{
+		PROFILE_BLOCK_TIME_KEYED_NAME(Tenant, 0, tenants[i % 2]);
+		PROFILE_BLOCK_TIME_KEYED(TenantShard, 0, i % 2); //A second keyed block in the same scope
+		_arr[i] += i;
+	}
+	for (Profile::u64 i = 0; i < NB_BLOCK_KEYS + 4; ++i)
+	{
+		PROFILE_BLOCK_TIME_KEYED(SizeBucket, 0, i);
+		_arr[i] += i;
+	}
+	profiler->End();
+
+	//Only checked if the blocks were recorded, i.e., if the profiler is enabled
+	bool success = true;
+	Profile::u64 requestTypeCount = 0;
+	Profile::u64 bucketCount = 0;
+	Profile::u64 overflowHitCount = 0;
+	Profile::u64 shardCount = 0;
+	for (const Profile::ProfileBlockRecorder& record : profiler->tracks[0].timings)
+	{
+		if (record.hitCount == 0 || record.blockName == nullptr)
+		{
+			continue;
+		}
+		if (strcmp(record.blockName, "TestFunction_KeyedBlocks_Dispatch") == 0)
+		{
+			requestTypeCount++;
+			success = success && record.keyKind == Profile::BlockKeyKind_Integer && record.key < 3 && record.hitCount == 4;
+		}
+		else if (strcmp(record.blockName, "Tenant") == 0)
+		{
+			success = success && record.keyKind == Profile::BlockKeyKind_String && record.hitCount == 2 &&
+				(record.keyName == tenants[0] || record.keyName == tenants[1]);
+		}
+		else if (strcmp(record.blockName, "TenantShard") == 0)
+		{
+			shardCount++;
+			success = success && record.keyKind == Profile::BlockKeyKind_Integer && record.key < 2 && record.hitCount == 2;
+		}
+		else if (strcmp(record.blockName, "SizeBucket") == 0)
+		{
+			bucketCount++;
+			if (record.keyKind == Profile::BlockKeyKind_Overflow)
+			{
+				overflowHitCount = record.hitCount;
+			}
+		}
+	}
+	if (requestTypeCount > 0)
+	{
+		success = success && requestTypeCount == 3 && bucketCount == NB_BLOCK_KEYS + 1 && overflowHitCount == 4 && shardCount == 2;
+	}
+
+	profiler->Report();
+	Profile::ProfilerResults* results = new Profile::ProfilerResults();
+	results->Capture(profiler);
+	results->Report();
+	results->ExportToCSV("./ProfileResults/KeyedBlocks.csv");
+	delete results;
+
+	if (!success)
+	{
+		printf("ERROR: The keyed blocks were not recorded per key.\n");
+	}
+	profiler->ClearTracks();
+	return success;
+}
+
+int main()
+{
+#if PROFILER_TEST_CONFIGURATION_MISMATCH
+	//Compiled on purpose with other sizes than the library: the check must fail
+	//and nothing else may run on a profiler the library lays out differently.
+	if (Profile::s_IsLibraryConfigurationChecked)
+	{
+		printf("ERROR: The check missed that the test was compiled with other sizes than the profiling library.\n");
+		return 1;
+	}
+	printf("The check reported the mismatch as expected.\n");
+	return 0;
+#else
+	Profile::u64 testArraySize = 1024 * 1024;
+
+	Profile::Profiler* profiler = new Profile::Profiler();
+	profiler->SetProfilerName("Tests");
+
+	Profile::SetProfiler(profiler);
+	profiler->SetTrackName(0, "Main");
+	profiler->Initialize();
+	Profile::u64* arr = (Profile::u64*)malloc(sizeof(Profile::u64) * testArraySize);
+
+	TestFunction_ProfileFunction(arr, testArraySize);
+	TestFunction_ProfileBlock(arr, testArraySize);
+	TestFunction_Bandwidth(arr, testArraySize);
+	TestFunction_PageFaultCounter();
+
+	profiler->End();
+	profiler->Report();
+	profiler->ClearTracks();
+
+	profiler->SetTrackName(1, "SubTrack");
+	profiler->Initialize();
+	TestFunction_Track2(arr, testArraySize);
+
+	profiler->End();
+	profiler->Report();
+	profiler->ClearTracks();
+
+	profiler->SetTrackName(0, "Main");
+	profiler->Initialize();
+
+	TestFunction_ProfileFunction(arr, testArraySize);
+	TestFunction_ProfileBlock(arr, testArraySize);
+	TestFunction_Bandwidth(arr, testArraySize);
+	bool success = TestFunction_Allocations(64);
+
+	profiler->End();
+	profiler->Report();
+
+	//Test exporting as CSV
+	//Create file directory ./ProfileResults/TestResults.csv
+	if (std::filesystem::create_directories("./ProfileResults"))
+	{
+		printf("\nCreating directory ./ProfileResults\n");
+	}
+	else
+	{
+		printf("\nDirectory ./ProfileResults already exists\n");
+	}
+
+	//Export
+	profiler->ExportToCSV("./ProfileResults/TestResults.csv");
+
+	Profile::ProfilerResults* testResults = new Profile::ProfilerResults();
+	testResults->Capture(profiler);
+	success = TestFunction_Pprof(*testResults, "./ProfileResults/TestResults.pb.gz") && success;
+	delete testResults;
+
+	profiler->ClearTracks();
+
+	success = TestFunction_OSMetrics() && success;
+
+	success = TestFunction_Roofline(testArraySize) && success;
+
+	TestFunction_FixedRepetitionTesting();
+
+	// Run the repetition profiling a second time to check that the internal 
+	// reset works appropriately. The profiling results should be close to the
+	// first run.
+	TestFunction_FixedRepetitionTesting();
+
+	TestFunction_BestPerfSearch();
+
+	success = TestFunction_LambdaRepetitionTesting() && success;
+
+	success = TestFunction_InterleavedRepetitionTesting() && success;
+
+	success = TestFunction_ScalingRepetitionTesting() && success;
+
+	success = TestFunction_MemoryBenchmarks() && success;
+
+	success = TestFunction_RobustStatistics() && success;
+	success = TestFunction_OffCPU() && success;
+
+	success = TestFunction_LiveSnapshot(arr, testArraySize) && success;
+	success = TestFunction_ConcurrentCapture(arr, testArraySize) && success;
+	success = TestFunction_RollingWindow(arr, testArraySize) && success;
+	success = TestFunction_ProfileDumper(arr, testArraySize) && success;
+	success = TestFunction_CallTree(arr, testArraySize) && success;
+	success = TestFunction_CoroutineSpans(arr, testArraySize) && success;
+	success = TestFunction_AsyncSpans() && success;
+	success = TestFunction_RuntimeSwitch() && success;
+	success = TestFunction_DynamicTracks(arr, testArraySize) && success;
+	success = TestFunction_CountersAndGauges(arr, testArraySize) && success;
+	success = TestFunction_FrameProfiler(arr, testArraySize) && success;
+	success = TestFunction_TailCapture(arr, testArraySize) && success;
+	success = TestFunction_ProfilerSizes() && success;
+	success = TestFunction_ProfilerInstances(arr, testArraySize) && success;
+	success = TestFunction_KeyedBlocks(arr, testArraySize) && success;
+	
+	free(arr);
+	delete profiler;
+
+	return success ? 0 : 1;
+#endif
 }
\ No newline at end of file
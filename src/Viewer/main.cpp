@@ -0,0 +1,145 @@
+#include <algorithm> //for std::sort
+#include <chrono>
+#include <cstdio>
+#include <cstdlib> //for strtoul
+#include <thread>
+#include <vector>
+#include "Profile/LiveSnapshot.hpp"
+
+/*
+Attaches to the shared memory segment of a process publishing its profiler with
+Profile::LiveSnapshotPublisher and shows the hottest blocks of every track, like
+top. The rates are computed between two refreshes from the publication times of
+the instrumented process, so they do not depend on the refresh period of the viewer.
+
+Usage: CppProfiler_Viewer [segmentName=/CppProfiler] [refreshPeriodInMs=1000] [topCount=10] [refreshCount=0 (until interrupted)]
+*/
+
+/*!
+@brief The activity of a block between two refreshes.
+*/
+struct BlockActivity
+{
+	const Profile::LiveBlockSnapshot* ptr_block = nullptr;
+	Profile::u64 hitCount = 0;
+	Profile::u64 elapsed = 0;
+	Profile::u64 processedByteCount = 0;
+	Profile::u64 allocationCount = 0;
+};
+
+int main(int _argc, char** _argv)
+{
+	const char* segmentName = _argc > 1 ? _argv[1] : Profile::LiveSnapshotPublisher::defaultSegmentName;
+	Profile::u32 refreshPeriodInMs = _argc > 2 ? (Profile::u32)strtoul(_argv[2], nullptr, 10) : 1000;
+	Profile::u32 topCount = _argc > 3 ? (Profile::u32)strtoul(_argv[3], nullptr, 10) : 10;
+	Profile::u32 refreshCount = _argc > 4 ? (Profile::u32)strtoul(_argv[4], nullptr, 10) : 0;
+
+	Profile::LiveSnapshotReader reader;
+
+	//The state of every block at the previous refresh, indexed by track and recorder index
+	std::vector<Profile::LiveBlockSnapshot> previousBlocks;
+	Profile::u64 previousPublishTime = 0;
+	Profile::u64 previousPublishCount = 0;
+
+	for (Profile::u32 refresh = 0; refreshCount == 0 || refresh < refreshCount; ++refresh)
+	{
+		if (refresh)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(refreshPeriodInMs));
+		}
+
+		if (reader.ptr_mapping == nullptr && !reader.Attach(segmentName))
+		{
+			printf("Waiting for the segment %s...\n", segmentName);
+			continue;
+		}
+
+		if (!reader.Read())
+		{
+			printf("Could not take a consistent snapshot of %s, retrying.\n", segmentName);
+			continue;
+		}
+
+		const Profile::LiveSnapshotHeader* header = reader.GetHeader();
+		if (header->publishCount < previousPublishCount)
+		{
+			//The publisher reopened the segment: start over
+			previousBlocks.clear();
+			previousPublishTime = 0;
+		}
+		previousBlocks.resize((Profile::u64)header->trackCount * header->blockCapacity);
+
+		//The first refresh shows the rates since the initialization of the profiler
+		Profile::u64 startTime = previousPublishTime ? previousPublishTime : header->publishTime - header->elapsed;
+		Profile::f64 intervalSec = header->cpuFreq ? (Profile::f64)(header->publishTime - startTime) / (Profile::f64)header->cpuFreq : 0.0;
+
+		printf("\033[H\033[2J");
+		printf("---- %s: %s (%llu publication(s); %.3fs since the profiler started; rates over %.3fs) ----\n",
+			segmentName, header->profilerName, header->publishCount, (Profile::f64)header->elapsed / (Profile::f64)header->cpuFreq, intervalSec);
+		bool hasNewPublication = header->publishCount != previousPublishCount;
+		if (!hasNewPublication)
+		{
+			printf("(no new publication since the last refresh)\n");
+		}
+
+		std::vector<BlockActivity> activities;
+		for (Profile::u32 i = 0; i < header->trackCount; ++i)
+		{
+			const Profile::LiveTrackSnapshot* track = reader.GetTrack(i);
+			if (track->blockCount == 0)
+			{
+				continue;
+			}
+
+			activities.clear();
+			for (Profile::u32 j = 0; j < track->blockCount; ++j)
+			{
+				const Profile::LiveBlockSnapshot* block = reader.GetBlock(i, j);
+				Profile::LiveBlockSnapshot& previous = previousBlocks[(Profile::u64)i * header->blockCapacity + block->recorderIdx];
+				if (previous.hitCount > block->hitCount)
+				{
+					//The tracks were reset in the meantime
+					previous = Profile::LiveBlockSnapshot();
+				}
+
+				BlockActivity& activity = activities.emplace_back();
+				activity.ptr_block = block;
+				activity.hitCount = block->hitCount - previous.hitCount;
+				activity.elapsed = block->elapsed - previous.elapsed;
+				activity.processedByteCount = block->processedByteCount - previous.processedByteCount;
+				activity.allocationCount = block->allocationCount - previous.allocationCount;
+				previous = *block;
+			}
+
+			std::sort(activities.begin(), activities.end(),
+				[](const BlockActivity& _a, const BlockActivity& _b) { return _a.elapsed > _b.elapsed; });
+
+			printf("\n-- Track %u: %s --\n", i, track->name);
+			printf("%-40s %12s %8s %14s %12s %12s\n", "Block", "Hits/s", "Time%", "Time/Hit(us)", "GB/s", "Allocs/s");
+			for (Profile::u32 j = 0; j < activities.size() && j < topCount; ++j)
+			{
+				const BlockActivity& activity = activities[j];
+				Profile::f64 elapsedSec = (Profile::f64)activity.elapsed / (Profile::f64)header->cpuFreq;
+				printf("%-40.40s %12.1f %7.2f%% %14.3f %12.3f %12.1f\n",
+					activity.ptr_block->name,
+					intervalSec > 0.0 ? activity.hitCount / intervalSec : 0.0,
+					intervalSec > 0.0 ? 100.0 * elapsedSec / intervalSec : 0.0,
+					activity.hitCount ? 1e6 * elapsedSec / activity.hitCount : 0.0,
+					elapsedSec > 0.0 ? activity.processedByteCount / elapsedSec / (1 << 30) : 0.0,
+					intervalSec > 0.0 ? activity.allocationCount / intervalSec : 0.0);
+			}
+		}
+		fflush(stdout);
+
+		previousPublishTime = header->publishTime;
+		previousPublishCount = header->publishCount;
+
+		if (!hasNewPublication)
+		{
+			//The publisher may have stopped or reopened a new segment with the same name
+			reader.Detach();
+		}
+	}
+
+	return 0;
+}